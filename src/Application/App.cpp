@@ -48,6 +48,8 @@
 #include "Graphics/Palette/PaletteManager.h"
 #include "Graphics/SImage/SIFormat.h"
 #include "MainEditor/MainEditor.h"
+#include "MapEditor/MapBackupManager.h"
+#include "MapEditor/MapEditor.h"
 #include "MapEditor/NodeBuilders.h"
 #include "OpenGL/Drawing.h"
 #include "UI/TextEditor/TextLanguage.h"
@@ -420,6 +422,9 @@ bool App::init()
 	// Init nodebuilders
 	NodeBuilders::init();
 
+	// Remove old cached thumbnails
+	Misc::pruneThumbCache();
+
 	// Init game executables
 	Executables::init();
 
@@ -564,6 +569,9 @@ void App::exit(bool save_config)
 		Game::saveCustomSpecialPresets();
 	}
 
+	// Finish writing any pending map backups
+	MapEditor::backupManager().finishWrites();
+
 	// Close all open archives
 	archive_manager.closeAll();
 
@@ -5,7 +5,11 @@
 class WadDataFormat : public EntryDataFormat
 {
 public:
-	WadDataFormat() : EntryDataFormat("archive_wad") {};
+	WadDataFormat() : EntryDataFormat("archive_wad")
+	{
+		addMagic("IWAD", 4);
+		addMagic("PWAD", 4);
+	}
 	~WadDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -17,7 +21,10 @@ public:
 class ZipDataFormat : public EntryDataFormat
 {
 public:
-	ZipDataFormat() : EntryDataFormat("archive_zip") {};
+	ZipDataFormat() : EntryDataFormat("archive_zip")
+	{
+		addMagic("PK\x03\x04", 4);
+	}
 	~ZipDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -53,7 +60,10 @@ public:
 class ResDataFormat : public EntryDataFormat
 {
 public:
-	ResDataFormat() : EntryDataFormat("archive_res") {};
+	ResDataFormat() : EntryDataFormat("archive_res")
+	{
+		addMagic("Res!", 4);
+	}
 	~ResDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -65,7 +75,10 @@ public:
 class PakDataFormat : public EntryDataFormat
 {
 public:
-	PakDataFormat() : EntryDataFormat("archive_pak") {};
+	PakDataFormat() : EntryDataFormat("archive_pak")
+	{
+		addMagic("PACK", 4);
+	}
 	~PakDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -89,7 +102,11 @@ public:
 class Wad2DataFormat : public EntryDataFormat
 {
 public:
-	Wad2DataFormat() : EntryDataFormat("archive_wad2") {}
+	Wad2DataFormat() : EntryDataFormat("archive_wad2")
+	{
+		addMagic("WAD2", 4);
+		addMagic("WAD3", 4);
+	}
 	~Wad2DataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -101,7 +118,11 @@ public:
 class WadJDataFormat : public EntryDataFormat
 {
 public:
-	WadJDataFormat() : EntryDataFormat("archive_wadj") {}
+	WadJDataFormat() : EntryDataFormat("archive_wadj")
+	{
+		addMagic("IWAD", 4);
+		addMagic("PWAD", 4);
+	}
 	~WadJDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -113,7 +134,10 @@ public:
 class GrpDataFormat : public EntryDataFormat
 {
 public:
-	GrpDataFormat() : EntryDataFormat("archive_grp") {};
+	GrpDataFormat() : EntryDataFormat("archive_grp")
+	{
+		addMagic("KenSilverman", 12);
+	}
 	~GrpDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -125,7 +149,10 @@ public:
 class RffDataFormat : public EntryDataFormat
 {
 public:
-	RffDataFormat() : EntryDataFormat("archive_rff") {};
+	RffDataFormat() : EntryDataFormat("archive_rff")
+	{
+		addMagic("RFF\x1A", 4);
+	}
 	~RffDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -137,7 +164,10 @@ public:
 class GobDataFormat : public EntryDataFormat
 {
 public:
-	GobDataFormat() : EntryDataFormat("archive_gob") {};
+	GobDataFormat() : EntryDataFormat("archive_gob")
+	{
+		addMagic("GOB\x0A", 4);
+	}
 	~GobDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -149,7 +179,10 @@ public:
 class LfdDataFormat : public EntryDataFormat
 {
 public:
-	LfdDataFormat() : EntryDataFormat("archive_lfd") {};
+	LfdDataFormat() : EntryDataFormat("archive_lfd")
+	{
+		addMagic("RMAP", 4);
+	}
 	~LfdDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -161,7 +194,10 @@ public:
 class ADatDataFormat : public EntryDataFormat
 {
 public:
-	ADatDataFormat() : EntryDataFormat("archive_adat") {};
+	ADatDataFormat() : EntryDataFormat("archive_adat")
+	{
+		addMagic("ADAT", 4);
+	}
 	~ADatDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -173,7 +209,10 @@ public:
 class HogDataFormat : public EntryDataFormat
 {
 public:
-	HogDataFormat() : EntryDataFormat("archive_hog") {};
+	HogDataFormat() : EntryDataFormat("archive_hog")
+	{
+		addMagic("DHF", 3);
+	}
 	~HogDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -197,7 +236,10 @@ public:
 class GZipDataFormat : public EntryDataFormat
 {
 public:
-	GZipDataFormat() : EntryDataFormat("archive_gzip") {};
+	GZipDataFormat() : EntryDataFormat("archive_gzip")
+	{
+		addMagic("\x1F\x8B\x08", 3);
+	}
 	~GZipDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -209,7 +251,10 @@ public:
 class BZip2DataFormat : public EntryDataFormat
 {
 public:
-	BZip2DataFormat() : EntryDataFormat("archive_bz2") {};
+	BZip2DataFormat() : EntryDataFormat("archive_bz2")
+	{
+		addMagic("BZh", 3);
+	}
 	~BZip2DataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -270,7 +315,10 @@ class SinArchiveDataFormat : public EntryDataFormat
 {
 public:
 	SinArchiveDataFormat()
-	: EntryDataFormat("archive_sin") {};
+	: EntryDataFormat("archive_sin")
+	{
+		addMagic("SPAK", 4);
+	}
 
 	int isThisFormat(MemChunk& mc)
 	{
@@ -60,7 +60,10 @@ size_t checkForTags(MemChunk& mc)
 class MUSDataFormat : public EntryDataFormat
 {
 public:
-	MUSDataFormat() : EntryDataFormat("midi_mus") {};
+	MUSDataFormat() : EntryDataFormat("midi_mus")
+	{
+		addMagic("MUS\x1A", 4);
+	}
 	~MUSDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -80,7 +83,10 @@ public:
 class MIDIDataFormat : public EntryDataFormat
 {
 public:
-	MIDIDataFormat() : EntryDataFormat("midi_smf") {};
+	MIDIDataFormat() : EntryDataFormat("midi_smf")
+	{
+		addMagic("MThd", 4);
+	}
 	~MIDIDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -100,7 +106,10 @@ public:
 class XMIDataFormat : public EntryDataFormat
 {
 public:
-	XMIDataFormat() : EntryDataFormat("midi_xmi") {};
+	XMIDataFormat() : EntryDataFormat("midi_xmi")
+	{
+		addMagic("FORM", 4);
+	}
 	~XMIDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -128,7 +137,10 @@ public:
 class HMIDataFormat : public EntryDataFormat
 {
 public:
-	HMIDataFormat() : EntryDataFormat("midi_hmi") {};
+	HMIDataFormat() : EntryDataFormat("midi_hmi")
+	{
+		addMagic("HMI-MIDI", 8);
+	}
 	~HMIDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -149,7 +161,10 @@ public:
 class HMPDataFormat : public EntryDataFormat
 {
 public:
-	HMPDataFormat() : EntryDataFormat("midi_hmp") {};
+	HMPDataFormat() : EntryDataFormat("midi_hmp")
+	{
+		addMagic("HMIMIDIP", 8);
+	}
 	~HMPDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -170,7 +185,13 @@ public:
 class GMIDDataFormat : public EntryDataFormat
 {
 public:
-	GMIDDataFormat() : EntryDataFormat("midi_gmid") {};
+	GMIDDataFormat() : EntryDataFormat("midi_gmid")
+	{
+		addMagic("MIDI", 4);
+		addMagic("GMD ", 4);
+		addMagic("ADL ", 4);
+		addMagic("ROL ", 4);
+	}
 	~GMIDDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -194,7 +215,10 @@ public:
 class RMIDDataFormat : public EntryDataFormat
 {
 public:
-	RMIDDataFormat() : EntryDataFormat("midi_rmid") {};
+	RMIDDataFormat() : EntryDataFormat("midi_rmid")
+	{
+		addMagic("RIFF", 4);
+	}
 	~RMIDDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -219,7 +243,10 @@ public:
 class ITModuleDataFormat : public EntryDataFormat
 {
 public:
-	ITModuleDataFormat() : EntryDataFormat("mod_it") {};
+	ITModuleDataFormat() : EntryDataFormat("mod_it")
+	{
+		addMagic("IMPM", 4);
+	}
 	~ITModuleDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -317,7 +344,10 @@ public:
 class OKTModuleDataFormat : public EntryDataFormat
 {
 public:
-	OKTModuleDataFormat() : EntryDataFormat("mod_okt") {};
+	OKTModuleDataFormat() : EntryDataFormat("mod_okt")
+	{
+		addMagic("OKTASONG", 8);
+	}
 	~OKTModuleDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -342,7 +372,10 @@ public:
 class IMFDataFormat : public EntryDataFormat
 {
 public:
-	IMFDataFormat() : EntryDataFormat("opl_imf") {};
+	IMFDataFormat() : EntryDataFormat("opl_imf")
+	{
+		addMagic("ADLIB\x01", 6);
+	}
 	~IMFDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -428,7 +461,10 @@ public:
 class DRODataFormat : public EntryDataFormat
 {
 public:
-	DRODataFormat() : EntryDataFormat("opl_dro") {};
+	DRODataFormat() : EntryDataFormat("opl_dro")
+	{
+		addMagic("DBRAWOPL", 8);
+	}
 	~DRODataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -454,7 +490,10 @@ public:
 class RAWDataFormat : public EntryDataFormat
 {
 public:
-	RAWDataFormat() : EntryDataFormat("opl_raw") {};
+	RAWDataFormat() : EntryDataFormat("opl_raw")
+	{
+		addMagic("RAWADATA", 8);
+	}
 	~RAWDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -662,7 +701,10 @@ public:
 class OggDataFormat : public EntryDataFormat
 {
 public:
-	OggDataFormat() : EntryDataFormat("snd_ogg") {};
+	OggDataFormat() : EntryDataFormat("snd_ogg")
+	{
+		addMagic("OggS", 4);
+	}
 	~OggDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -687,7 +729,10 @@ public:
 class FLACDataFormat : public EntryDataFormat
 {
 public:
-	FLACDataFormat() : EntryDataFormat("snd_flac") {};
+	FLACDataFormat() : EntryDataFormat("snd_flac")
+	{
+		addMagic("fLaC", 4);
+	}
 	~FLACDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -909,7 +954,10 @@ public:
 class SunSoundDataFormat : public EntryDataFormat
 {
 public:
-	SunSoundDataFormat() : EntryDataFormat("snd_sun") {};
+	SunSoundDataFormat() : EntryDataFormat("snd_sun")
+	{
+		addMagic(".snd", 4);
+	}
 	~SunSoundDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -943,7 +991,10 @@ CVAR(Bool, debugaiff, false, 0)
 class AIFFSoundDataFormat : public EntryDataFormat
 {
 public:
-	AIFFSoundDataFormat() : EntryDataFormat("snd_aiff") {};
+	AIFFSoundDataFormat() : EntryDataFormat("snd_aiff")
+	{
+		addMagic("FORM", 4);
+	}
 	~AIFFSoundDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -990,7 +1041,10 @@ public:
 class AYDataFormat : public EntryDataFormat
 {
 public:
-	AYDataFormat() : EntryDataFormat("gme_ay") {};
+	AYDataFormat() : EntryDataFormat("gme_ay")
+	{
+		addMagic("ZXAYEMUL", 8);
+	}
 	~AYDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -1009,7 +1063,10 @@ public:
 class GBSDataFormat : public EntryDataFormat
 {
 public:
-	GBSDataFormat() : EntryDataFormat("gme_gbs") {};
+	GBSDataFormat() : EntryDataFormat("gme_gbs")
+	{
+		addMagic("GBS\x01", 4);
+	}
 	~GBSDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -1028,7 +1085,10 @@ public:
 class GYMDataFormat : public EntryDataFormat
 {
 public:
-	GYMDataFormat() : EntryDataFormat("gme_gym") {};
+	GYMDataFormat() : EntryDataFormat("gme_gym")
+	{
+		addMagic("GYMX", 4);
+	}
 	~GYMDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -1047,7 +1107,10 @@ public:
 class HESDataFormat : public EntryDataFormat
 {
 public:
-	HESDataFormat() : EntryDataFormat("gme_hes") {};
+	HESDataFormat() : EntryDataFormat("gme_hes")
+	{
+		addMagic("HESM", 4);
+	}
 	~HESDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -1066,7 +1129,11 @@ public:
 class KSSDataFormat : public EntryDataFormat
 {
 public:
-	KSSDataFormat() : EntryDataFormat("gme_kss") {};
+	KSSDataFormat() : EntryDataFormat("gme_kss")
+	{
+		addMagic("KSCC", 4);
+		addMagic("KSSX", 4);
+	}
 	~KSSDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -1087,7 +1154,10 @@ public:
 class NSFDataFormat : public EntryDataFormat
 {
 public:
-	NSFDataFormat() : EntryDataFormat("gme_nsf") {};
+	NSFDataFormat() : EntryDataFormat("gme_nsf")
+	{
+		addMagic("NESM\x1A", 5);
+	}
 	~NSFDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -1106,7 +1176,10 @@ public:
 class NSFEDataFormat : public EntryDataFormat
 {
 public:
-	NSFEDataFormat() : EntryDataFormat("gme_nsfe") {};
+	NSFEDataFormat() : EntryDataFormat("gme_nsfe")
+	{
+		addMagic("NESM\x1A", 5);
+	}
 	~NSFEDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -1125,7 +1198,10 @@ public:
 class SAPDataFormat : public EntryDataFormat
 {
 public:
-	SAPDataFormat() : EntryDataFormat("gme_sap") {};
+	SAPDataFormat() : EntryDataFormat("gme_sap")
+	{
+		addMagic("SAP\x0D\x0A", 5);
+	}
 	~SAPDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -1145,7 +1221,10 @@ public:
 class SPCDataFormat : public EntryDataFormat
 {
 public:
-	SPCDataFormat() : EntryDataFormat("gme_spc") {};
+	SPCDataFormat() : EntryDataFormat("gme_spc")
+	{
+		addMagic("SNES-SPC700", 11);
+	}
 	~SPCDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -1164,7 +1243,10 @@ public:
 class VGMDataFormat : public EntryDataFormat
 {
 public:
-	VGMDataFormat() : EntryDataFormat("gme_vgm") {};
+	VGMDataFormat() : EntryDataFormat("gme_vgm")
+	{
+		addMagic("Vgm ", 4);
+	}
 	~VGMDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -1185,7 +1267,10 @@ public:
 class VGZDataFormat : public EntryDataFormat
 {
 public:
-	VGZDataFormat() : EntryDataFormat("gme_vgz") {};
+	VGZDataFormat() : EntryDataFormat("gme_vgz")
+	{
+		addMagic("\x1F\x8B\x08\0", 4);
+	}
 	~VGZDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -4,7 +4,10 @@
 class PNGDataFormat : public EntryDataFormat
 {
 public:
-	PNGDataFormat() : EntryDataFormat("img_png") {}
+	PNGDataFormat() : EntryDataFormat("img_png")
+	{
+		addMagic("\x89PNG\r\n\x1A\n", 8);
+	}
 	~PNGDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -27,7 +30,10 @@ public:
 class BMPDataFormat : public EntryDataFormat
 {
 public:
-	BMPDataFormat() : EntryDataFormat("img_bmp") {};
+	BMPDataFormat() : EntryDataFormat("img_bmp")
+	{
+		addMagic("BM", 2);
+	}
 	~BMPDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -59,7 +65,10 @@ public:
 class GIFDataFormat : public EntryDataFormat
 {
 public:
-	GIFDataFormat() : EntryDataFormat("img_gif") {};
+	GIFDataFormat() : EntryDataFormat("img_gif")
+	{
+		addMagic("GIF8", 4);
+	}
 	~GIFDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -80,7 +89,10 @@ public:
 class PCXDataFormat : public EntryDataFormat
 {
 public:
-	PCXDataFormat() : EntryDataFormat("img_pcx") {};
+	PCXDataFormat() : EntryDataFormat("img_pcx")
+	{
+		addMagic("\x0A", 1);
+	}
 	~PCXDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -196,7 +208,11 @@ public:
 class TIFFDataFormat : public EntryDataFormat
 {
 public:
-	TIFFDataFormat() : EntryDataFormat("img_tiff") {};
+	TIFFDataFormat() : EntryDataFormat("img_tiff")
+	{
+		addMagic("II", 2);
+		addMagic("MM", 2);
+	}
 	~TIFFDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -239,7 +255,10 @@ public:
 class JPEGDataFormat : public EntryDataFormat
 {
 public:
-	JPEGDataFormat() : EntryDataFormat("img_jpeg") {};
+	JPEGDataFormat() : EntryDataFormat("img_jpeg")
+	{
+		addMagic("\xFF\xD8\xFF", 3);
+	}
 	~JPEGDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -265,7 +284,10 @@ public:
 class ILBMDataFormat : public EntryDataFormat
 {
 public:
-	ILBMDataFormat() : EntryDataFormat("img_ilbm") {};
+	ILBMDataFormat() : EntryDataFormat("img_ilbm")
+	{
+		addMagic("FORM", 4);
+	}
 	~ILBMDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -677,7 +699,10 @@ public:
 class IMGZDataFormat : public EntryDataFormat
 {
 public:
-	IMGZDataFormat() : EntryDataFormat("img_imgz") {};
+	IMGZDataFormat() : EntryDataFormat("img_imgz")
+	{
+		addMagic("IMGZ", 4);
+	}
 	~IMGZDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -739,7 +764,10 @@ public:
 class QuakeSpriteDataFormat : public EntryDataFormat
 {
 public:
-	QuakeSpriteDataFormat() : EntryDataFormat("img_qspr") {};
+	QuakeSpriteDataFormat() : EntryDataFormat("img_qspr")
+	{
+		addMagic("IDSP", 4);
+	}
 	~QuakeSpriteDataFormat() {}
 
 	// A Quake sprite can contain several frames and each frame may contain several pictures.
@@ -1357,7 +1385,10 @@ public:
 class JediBMFormat : public EntryDataFormat
 {
 public:
-	JediBMFormat() : EntryDataFormat("img_jedi_bm") {};
+	JediBMFormat() : EntryDataFormat("img_jedi_bm")
+	{
+		addMagic("BM \x1E", 4);
+	}
 	~JediBMFormat() {}
 
 	// Jedi engine bitmap format
@@ -1496,7 +1527,10 @@ public:
 class Font1DataFormat : public EntryDataFormat
 {
 public:
-	Font1DataFormat() : EntryDataFormat("font_zd_console") {};
+	Font1DataFormat() : EntryDataFormat("font_zd_console")
+	{
+		addMagic("FON1", 4);
+	}
 	~Font1DataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -1515,7 +1549,10 @@ public:
 class Font2DataFormat : public EntryDataFormat
 {
 public:
-	Font2DataFormat() : EntryDataFormat("font_zd_big") {};
+	Font2DataFormat() : EntryDataFormat("font_zd_big")
+	{
+		addMagic("FON2", 4);
+	}
 	~Font2DataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -1534,7 +1571,10 @@ public:
 class BMFontDataFormat : public EntryDataFormat
 {
 public:
-	BMFontDataFormat() : EntryDataFormat("font_bmf") {};
+	BMFontDataFormat() : EntryDataFormat("font_bmf")
+	{
+		addMagic("\xE1\xE6\xD5\x1A", 4);
+	}
 	~BMFontDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -1585,7 +1625,10 @@ public:
 class JediFNTFormat : public EntryDataFormat
 {
 public:
-	JediFNTFormat() : EntryDataFormat("font_jedi_fnt") {};
+	JediFNTFormat() : EntryDataFormat("font_jedi_fnt")
+	{
+		addMagic("FNT\x15", 4);
+	}
 	~JediFNTFormat() {}
 
 	// Jedi engine fnt format
@@ -89,7 +89,10 @@ public:
 class ZNodesDataFormat : public EntryDataFormat
 {
 public:
-	ZNodesDataFormat() : EntryDataFormat("znod") {};
+	ZNodesDataFormat() : EntryDataFormat("znod")
+	{
+		addMagic("ZGLN", 4);
+	}
 	~ZNodesDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -108,7 +111,10 @@ public:
 class ZGLNodesDataFormat : public EntryDataFormat
 {
 public:
-	ZGLNodesDataFormat() : EntryDataFormat("zgln") {};
+	ZGLNodesDataFormat() : EntryDataFormat("zgln")
+	{
+		addMagic("ZGLN", 4);
+	}
 	~ZGLNodesDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -127,7 +133,10 @@ public:
 class ZGLNodes2DataFormat : public EntryDataFormat
 {
 public:
-	ZGLNodes2DataFormat() : EntryDataFormat("zgl2") {};
+	ZGLNodes2DataFormat() : EntryDataFormat("zgl2")
+	{
+		addMagic("ZGL2", 4);
+	}
 	~ZGLNodes2DataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -146,7 +155,10 @@ public:
 class XNodesDataFormat : public EntryDataFormat
 {
 public:
-	XNodesDataFormat() : EntryDataFormat("xnod") {};
+	XNodesDataFormat() : EntryDataFormat("xnod")
+	{
+		addMagic("XGLN", 4);
+	}
 	~XNodesDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -165,7 +177,10 @@ public:
 class XGLNodesDataFormat : public EntryDataFormat
 {
 public:
-	XGLNodesDataFormat() : EntryDataFormat("xgln") {};
+	XGLNodesDataFormat() : EntryDataFormat("xgln")
+	{
+		addMagic("XGLN", 4);
+	}
 	~XGLNodesDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -184,7 +199,10 @@ public:
 class XGLNodes2DataFormat : public EntryDataFormat
 {
 public:
-	XGLNodes2DataFormat() : EntryDataFormat("xgl2") {};
+	XGLNodes2DataFormat() : EntryDataFormat("xgl2")
+	{
+		addMagic("XGL2", 4);
+	}
 	~XGLNodes2DataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -203,7 +221,10 @@ public:
 class ACS0DataFormat : public EntryDataFormat
 {
 public:
-	ACS0DataFormat() : EntryDataFormat("acs0") {};
+	ACS0DataFormat() : EntryDataFormat("acs0")
+	{
+		addMagic("ACS\0", 4);
+	}
 	~ACS0DataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -232,7 +253,10 @@ public:
 class ACSeDataFormat : public EntryDataFormat
 {
 public:
-	ACSeDataFormat() : EntryDataFormat("acsl") {};
+	ACSeDataFormat() : EntryDataFormat("acsl")
+	{
+		addMagic("ACS", 3);
+	}
 	~ACSeDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -268,7 +292,10 @@ public:
 class ACSEDataFormat : public EntryDataFormat
 {
 public:
-	ACSEDataFormat() : EntryDataFormat("acse") {};
+	ACSEDataFormat() : EntryDataFormat("acse")
+	{
+		addMagic("ACS", 3);
+	}
 	~ACSEDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -4,7 +4,10 @@
 class RLE0DataFormat : public EntryDataFormat
 {
 public:
-	RLE0DataFormat() : EntryDataFormat("misc_rle0") {};
+	RLE0DataFormat() : EntryDataFormat("misc_rle0")
+	{
+		addMagic("RLE0", 4);
+	}
 	~RLE0DataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
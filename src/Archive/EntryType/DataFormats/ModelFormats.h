@@ -4,7 +4,10 @@
 class DMDModelDataFormat : public EntryDataFormat
 {
 public:
-	DMDModelDataFormat() : EntryDataFormat("mesh_dmd") {};
+	DMDModelDataFormat() : EntryDataFormat("mesh_dmd")
+	{
+		addMagic("DMDM", 4);
+	}
 	~DMDModelDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -23,7 +26,10 @@ public:
 class MDLModelDataFormat : public EntryDataFormat
 {
 public:
-	MDLModelDataFormat() : EntryDataFormat("mesh_mdl") {};
+	MDLModelDataFormat() : EntryDataFormat("mesh_mdl")
+	{
+		addMagic("IDPO", 4);
+	}
 	~MDLModelDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -42,7 +48,10 @@ public:
 class MD2ModelDataFormat : public EntryDataFormat
 {
 public:
-	MD2ModelDataFormat() : EntryDataFormat("mesh_md2") {};
+	MD2ModelDataFormat() : EntryDataFormat("mesh_md2")
+	{
+		addMagic("IDP2", 4);
+	}
 	~MD2ModelDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
@@ -61,7 +70,10 @@ public:
 class MD3ModelDataFormat : public EntryDataFormat
 {
 public:
-	MD3ModelDataFormat() : EntryDataFormat("mesh_md3") {};
+	MD3ModelDataFormat() : EntryDataFormat("mesh_md3")
+	{
+		addMagic("IDP3", 4);
+	}
 	~MD3ModelDataFormat() {}
 
 	int isThisFormat(MemChunk& mc)
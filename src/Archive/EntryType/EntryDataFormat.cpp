@@ -84,6 +84,36 @@ void EntryDataFormat::copyToFormat(EntryDataFormat& target)
 {
 	target.patterns = patterns;
 	target.size_min = size_min;
+	target.magic = magic;
+}
+
+/* EntryDataFormat::addMagic
+ * Adds a magic signature of [length] [bytes] to the format. Should
+ * only be used where isThisFormat can never succeed unless the data
+ * begins with one of the format's signatures, since entry type
+ * detection uses them to skip checking the format entirely
+ *******************************************************************/
+void EntryDataFormat::addMagic(const char* bytes, unsigned length)
+{
+	magic.push_back(std::string(bytes, length));
+}
+
+/* EntryDataFormat::matchesMagic
+ * Returns true if [data] begins with one of the format's magic
+ * signatures, or if the format has none
+ *******************************************************************/
+bool EntryDataFormat::matchesMagic(const uint8_t* data, unsigned size)
+{
+	if (magic.empty())
+		return true;
+
+	for (unsigned a = 0; a < magic.size(); a++)
+	{
+		if (size >= magic[a].size() && memcmp(data, magic[a].data(), magic[a].size()) == 0)
+			return true;
+	}
+
+	return false;
 }
 
 
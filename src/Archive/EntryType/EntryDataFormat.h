@@ -44,9 +44,13 @@ private:
 	// Detection
 	unsigned				size_min;
 	vector<byte_pattern_t>	patterns;
+	vector<std::string>		magic;
 	// Also needed:
 	// Some way to check more complex values (eg. multiply byte 0 and 1, result must be in a certain range)
 
+protected:
+	void	addMagic(const char* bytes, unsigned length);
+
 public:
 	EntryDataFormat(string id);
 	virtual ~EntryDataFormat();
@@ -56,6 +60,11 @@ public:
 	virtual int		isThisFormat(MemChunk& mc);
 	void			copyToFormat(EntryDataFormat& target);
 
+	// Magic signatures (data must begin with one of these to match the format, if any are given)
+	bool						hasMagic() { return !magic.empty(); }
+	const vector<std::string>&	getMagic() { return magic; }
+	bool						matchesMagic(const uint8_t* data, unsigned size);
+
 	static void				initBuiltinFormats();
 	static bool				readDataFormatDefinition(MemChunk& mc);
 	static EntryDataFormat*	getFormat(string id);
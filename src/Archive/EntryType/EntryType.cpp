@@ -50,6 +50,19 @@ EntryType			etype_folder;	// Folder entry type
 EntryType			etype_marker;	// Marker entry type
 EntryType			etype_map;		// Map marker type
 
+// Detection dispatch index: for each possible first byte of entry data,
+// the (ordered) indices of all types that could match it. Types with a
+// data format that has magic signatures only appear under the first
+// bytes of those signatures. The index is built once all types are
+// loaded, and is only read after that (detection can happen on
+// background threads)
+vector<uint16_t>	etype_dispatch[256];
+bool				etype_dispatch_enabled = true;
+
+// Size classes each type can match (by index), bit n is set if the type
+// can match entries of size 2^n to 2^(n+1)-1 (see sizeClass)
+vector<uint32_t>	etype_size_classes;
+
 
 /*******************************************************************
  * ENTRYTYPE CLASS FUNCTIONS
@@ -589,6 +602,7 @@ bool EntryType::loadEntryTypes()
 	if (!res_archive)
 	{
 		LOG_MESSAGE(1, "Error: No resource archive open!");
+		buildDispatchIndex();
 		return false;
 	}
 
@@ -599,6 +613,7 @@ bool EntryType::loadEntryTypes()
 	if (!et_dir)
 	{
 		LOG_MESSAGE(1, "Error: config/entry_types does not exist in slade.pk3");
+		buildDispatchIndex();
 		return false;
 	}
 
@@ -641,9 +656,83 @@ bool EntryType::loadEntryTypes()
 		files = res_dir.GetNext(&filename);
 	}
 
+	// All types are loaded, build the detection index
+	buildDispatchIndex();
+
 	return true;
 }
 
+/* sizeClass
+ * Returns the size class of [size] (the index of its highest set bit)
+ *******************************************************************/
+static int sizeClass(unsigned size)
+{
+	int c = 0;
+	while (size >>= 1)
+		c++;
+	return c;
+}
+
+/* EntryType::buildDispatchIndex
+ * (Re)builds the entry type detection dispatch index and size
+ * classes. Must be called after types are added to the list
+ *******************************************************************/
+void EntryType::buildDispatchIndex()
+{
+	for (unsigned b = 0; b < 256; b++)
+		etype_dispatch[b].clear();
+	etype_size_classes.clear();
+
+	for (size_t a = 0; a < entry_types.size(); a++)
+	{
+		EntryType* type = entry_types[a];
+
+		// Get the size classes the type can match, from its exact sizes
+		// or size limits
+		unsigned min = type->size_limit[0] > 0 ? type->size_limit[0] : 1;
+		unsigned max = type->size_limit[1] >= 0 ? type->size_limit[1] : UINT_MAX;
+		uint32_t classes = 0;
+		if (!type->match_size.empty())
+		{
+			for (unsigned s = 0; s < type->match_size.size(); s++)
+			{
+				unsigned size = type->match_size[s];
+				if (size >= min && size <= max)
+					classes |= 1u << sizeClass(size);
+			}
+		}
+		else if (min <= max)
+		{
+			for (int c = sizeClass(min); c <= sizeClass(max); c++)
+				classes |= 1u << c;
+		}
+		etype_size_classes.push_back(classes);
+
+		EntryDataFormat* format = entry_types[a]->format;
+		if (format && format->hasMagic())
+		{
+			// Add to the list for the first byte of each signature
+			bool added[256] = {};
+			const vector<std::string>& magic = format->getMagic();
+			for (unsigned m = 0; m < magic.size(); m++)
+			{
+				uint8_t first = magic[m].empty() ? 0 : (uint8_t)magic[m][0];
+				if (!added[first])
+				{
+					etype_dispatch[first].push_back((uint16_t)a);
+					added[first] = true;
+				}
+			}
+		}
+		else
+		{
+			// No signature, could be anything
+			for (unsigned b = 0; b < 256; b++)
+				etype_dispatch[b].push_back((uint16_t)a);
+		}
+	}
+}
+
 /* EntryType::detectEntryType
  * Attempts to detect the given entry's type
  *******************************************************************/
@@ -663,6 +752,45 @@ bool EntryType::detectEntryType(ArchiveEntry* entry)
 	// Reset entry type
 	entry->setType(&etype_unknown);
 
+	// Get types to check from the dispatch index, depending on the
+	// first byte of the entry data
+	const uint8_t* data = entry->getData();
+	if (data && etype_dispatch_enabled)
+	{
+		const vector<uint16_t>& candidates = etype_dispatch[data[0]];
+		uint32_t size_class = 1u << sizeClass(entry->getSize());
+		for (size_t a = 0; a < candidates.size(); a++)
+		{
+			// Skip if the type can't match an entry of this size
+			if (!(etype_size_classes[candidates[a]] & size_class))
+				continue;
+
+			EntryType* type = entry_types[candidates[a]];
+
+			// If the current type is more 'reliable' than this one, skip it
+			if (entry->getTypeReliability() >= type->getReliability())
+				continue;
+
+			// Skip if the data doesn't begin with one of the format's signatures
+			if (!type->format->matchesMagic(data, entry->getSize()))
+				continue;
+
+			// Check for possible type match
+			int r = type->isThisType(entry);
+			if (r > 0)
+			{
+				// Type matches, set it
+				entry->setType(type, r);
+
+				// No need to continue if the identification is 100% reliable
+				if (entry->getTypeReliability() >= 255)
+					return true;
+			}
+		}
+
+		return entry->getType() != &etype_unknown;
+	}
+
 	// Go through all registered types
 	size_t entry_types_size = entry_types.size();
 	for (size_t a = 0; a < entry_types_size; a++)
@@ -755,6 +883,10 @@ void EntryType::cleanupEntryTypes()
 		if (e != &etype_unknown && e != &etype_folder && e != &etype_marker && e != &etype_map)
 			delete entry_types[a];
 	}
+
+	for (unsigned b = 0; b < 256; b++)
+		etype_dispatch[b].clear();
+	etype_size_classes.clear();
 }
 
 /* EntryType::allTypes
@@ -875,3 +1007,47 @@ CONSOLE_COMMAND (size, 0, true)
 	}
 	LOG_MESSAGE(1, "%s: %i bytes", meep->getName().mb_str(), meep->getSize());
 }
+
+CONSOLE_COMMAND(test_detect_speed, 0, false)
+{
+	Archive* archive = MainEditor::currentArchive();
+	if (!archive)
+	{
+		Log::console("No archive open");
+		return;
+	}
+
+	// Get all entries, make sure their data is loaded before timing
+	vector<ArchiveEntry*> entries;
+	archive->getEntryTreeAsList(entries);
+	for (unsigned a = 0; a < entries.size(); a++)
+		entries[a]->getData();
+
+	// Detect all entry types with a full scan, then using the dispatch index
+	double times[2];
+	vector<EntryType*> types[2];
+	for (unsigned pass = 0; pass < 2; pass++)
+	{
+		etype_dispatch_enabled = (pass == 1);
+		wxStopWatch sw;
+		for (unsigned a = 0; a < entries.size(); a++)
+			EntryType::detectEntryType(entries[a]);
+		times[pass] = sw.TimeInMicro().ToDouble();
+
+		for (unsigned a = 0; a < entries.size(); a++)
+			types[pass].push_back(entries[a]->getType());
+	}
+	etype_dispatch_enabled = true;
+
+	// Check both give the same results
+	int mismatches = 0;
+	for (unsigned a = 0; a < entries.size(); a++)
+	{
+		if (types[0][a] != types[1][a])
+			mismatches++;
+	}
+
+	double count = entries.empty() ? 1 : entries.size();
+	Log::console(S_FMT("%lu entries: %1.2fus/entry (full scan), %1.2fus/entry (indexed), %d mismatched",
+		entries.size(), times[0] / count, times[1] / count, mismatches));
+}
@@ -43,6 +43,8 @@ private:
 										// folder in a zip
 	vector<string>	match_archive;		// The types of archive the entry can be found in (e.g., wad or zip)
 
+	static void	buildDispatchIndex();
+
 public:
 	EntryType(string id = "Unknown");
 	~EntryType();
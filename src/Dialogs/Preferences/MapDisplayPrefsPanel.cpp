@@ -62,6 +62,7 @@ EXTERN_CVAR(Float, arrow_alpha)
 EXTERN_CVAR(Bool, action_lines)
 EXTERN_CVAR(Bool, map_show_help)
 EXTERN_CVAR(Int, map_tex_filter)
+EXTERN_CVAR(Bool, map_tex_atlas)
 EXTERN_CVAR(Bool, use_zeth_icons)
 EXTERN_CVAR(Int, halo_width)
 EXTERN_CVAR(Int, grid_64_style)
@@ -289,6 +290,10 @@ void MapDisplayPrefsPanel::setupThingsTab()
 	cb_use_zeth_icons = new wxCheckBox(panel, -1, "Use ZETH thing type icons");
 	gb_sizer->Add(cb_use_zeth_icons, wxGBPosition(row++, 0), wxGBSpan(1, 2), wxEXPAND);
 
+	// Sprite atlas
+	cb_tex_atlas = new wxCheckBox(panel, -1, "Pack thing sprites into shared textures (faster with many sprites)");
+	gb_sizer->Add(cb_tex_atlas, wxGBPosition(row++, 0), wxGBSpan(1, 2), wxEXPAND);
+
 	gb_sizer->AddGrowableCol(1, 1);
 }
 
@@ -362,6 +367,7 @@ void MapDisplayPrefsPanel::init()
 	cb_show_help->SetValue(map_show_help);
 	choice_tex_filter->Select(map_tex_filter);
 	cb_use_zeth_icons->SetValue(use_zeth_icons);
+	cb_tex_atlas->SetValue(map_tex_atlas);
 	slider_halo_width->SetValue(halo_width);
 	choice_grid_64->SetSelection(grid_64_style);
 }
@@ -399,6 +405,7 @@ void MapDisplayPrefsPanel::applyPreferences()
 	map_show_help = cb_show_help->GetValue();
 	map_tex_filter = choice_tex_filter->GetSelection();
 	use_zeth_icons = cb_use_zeth_icons->GetValue();
+	map_tex_atlas = cb_tex_atlas->GetValue();
 	halo_width = slider_halo_width->GetValue();
 	grid_64_style = choice_grid_64->GetSelection();
 }
@@ -38,6 +38,7 @@ private:
 	wxSlider*	slider_thing_shadow;
 	wxSlider*	slider_thing_arrow_alpha;
 	wxCheckBox*	cb_use_zeth_icons;
+	wxCheckBox*	cb_tex_atlas;
 	wxSlider*	slider_halo_width;
 
 	wxSlider*	slider_flat_brightness;
@@ -1005,14 +1005,13 @@ bool Configuration::openConfig(string game, string port, uint8_t format)
 // ----------------------------------------------------------------------------
 const ActionSpecial& Configuration::actionSpecial(unsigned id)
 {
-	auto& as = action_specials_[id];
-
 	// Defined Action Special
-	if (as.defined())
-		return as;
+	auto as = action_specials_.find(id);
+	if (as != action_specials_.end() && as->second.defined())
+		return as->second;
 
 	// Boom Generalised Special
-	if (supported_features_[Feature::Boom] && id >= 0x2f80)
+	if (featureSupported(Feature::Boom) && id >= 0x2f80)
 	{
 		if ((id & 7) >= 6)
 			return ActionSpecial::generalManual();
@@ -1037,9 +1036,10 @@ string Configuration::actionSpecialName(int special)
 	else if (special == 0)
 		return "None";
 
-	if (action_specials_[special].defined())
-		return action_specials_[special].name();
-	else if (special >= 0x2F80 && supported_features_[Feature::Boom])
+	auto as = action_specials_.find(special);
+	if (as != action_specials_.end() && as->second.defined())
+		return as->second.name();
+	else if (special >= 0x2F80 && featureSupported(Feature::Boom))
 		return BoomGenLineSpecial::parseLineType(special);
 	else
 		return "Unknown";
@@ -1052,9 +1052,9 @@ string Configuration::actionSpecialName(int special)
 // ----------------------------------------------------------------------------
 const ThingType& Configuration::thingType(unsigned type)
 {
-	auto& ttype = thing_types_[type];
-	if (ttype.defined())
-		return ttype;
+	auto ttype = thing_types_.find(type);
+	if (ttype != thing_types_.end() && ttype->second.defined())
+		return ttype->second;
 	else
 		return ThingType::unknown();
 }
@@ -1171,7 +1171,7 @@ bool Configuration::thingBasicFlagSet(string flag, MapThing* thing, int map_form
 		if (hexen)
 			return !!(flags & 512);
 		// *Not* Not In Coop
-		else if (supported_features_[Feature::Boom])
+		else if (featureSupported(Feature::Boom))
 			return !(flags & 64);
 		else
 			return true;
@@ -1182,7 +1182,7 @@ bool Configuration::thingBasicFlagSet(string flag, MapThing* thing, int map_form
 		if (hexen)
 			return !!(flags & 1024);
 		// *Not* Not In DM
-		else if (supported_features_[Feature::Boom])
+		else if (featureSupported(Feature::Boom))
 			return !(flags & 32);
 		else
 			return true;
@@ -1352,7 +1352,7 @@ void Configuration::setThingBasicFlag(string flag, MapThing* thing, int map_form
 		if (hexen)
 			flag_val = 512;
 		// *Not* Not In Coop
-		else if (supported_features_[Feature::Boom])
+		else if (featureSupported(Feature::Boom))
 		{
 			flag_val = 64;
 			set = !set;
@@ -1367,7 +1367,7 @@ void Configuration::setThingBasicFlag(string flag, MapThing* thing, int map_form
 		if (hexen)
 			flag_val = 1024;
 		// *Not* Not In DM
-		else if (supported_features_[Feature::Boom])
+		else if (featureSupported(Feature::Boom))
 		{
 			flag_val = 32;
 			set = !set;
@@ -1814,22 +1814,31 @@ string Configuration::spacTriggerUDMFName(unsigned trigger_index)
 // ----------------------------------------------------------------------------
 // Configuration::getUDMFProperty
 //
-// Returns the UDMF property definition matching [name] for MapObject [type]
+// Returns the UDMF property definition matching [name] for MapObject [type],
+// or nullptr if no such property is defined
 // ----------------------------------------------------------------------------
 UDMFProperty* Configuration::getUDMFProperty(string name, int type)
 {
+	UDMFPropMap* props;
 	if (type == MOBJ_VERTEX)
-		return &udmf_vertex_props_[name];
+		props = &udmf_vertex_props_;
 	else if (type == MOBJ_LINE)
-		return &udmf_linedef_props_[name];
+		props = &udmf_linedef_props_;
 	else if (type == MOBJ_SIDE)
-		return &udmf_sidedef_props_[name];
+		props = &udmf_sidedef_props_;
 	else if (type == MOBJ_SECTOR)
-		return &udmf_sector_props_[name];
+		props = &udmf_sector_props_;
 	else if (type == MOBJ_THING)
-		return &udmf_thing_props_[name];
+		props = &udmf_thing_props_;
 	else
 		return nullptr;
+
+	// Don't use operator[] here, this is called from map check threads
+	auto prop = props->find(name);
+	if (prop == props->end())
+		return nullptr;
+
+	return &prop->second;
 }
 
 // ----------------------------------------------------------------------------
@@ -1880,35 +1889,45 @@ void Configuration::cleanObjectUDMFProps(MapObject* object)
 	else
 		return;
 
-	// Go through properties
-	for (auto& i : *map)
+	// Go through the object's properties (rather than every property in the
+	// configuration, most objects only have a few)
+	vector<string> defaults;
+	for (auto& prop : object->props().allProperties())
 	{
-		// Check if the object even has this property
-		if (!object->hasProp(i.first))
+		// Check the property has a value and is defined in the configuration
+		if (!prop.value.hasValue())
+			continue;
+		auto def = map->find(prop.name());
+		if (def == map->end())
 			continue;
 
-		// Remove the property from the object if it is the default value
-		if (i.second.defaultValue().getType() == PROP_BOOL)
+		// Check if it is the default value
+		const Property& def_val = def->second.defaultValue();
+		if (def_val.getType() == PROP_BOOL)
 		{
-			if (i.second.defaultValue().getBoolValue() == object->boolProperty(i.first))
-				object->props().removeProperty(i.first);
+			if (def_val.getBoolValue() == object->boolProperty(prop.name()))
+				defaults.push_back(prop.name());
 		}
-		else if (i.second.defaultValue().getType() == PROP_INT)
+		else if (def_val.getType() == PROP_INT)
 		{
-			if (i.second.defaultValue().getIntValue() == object->intProperty(i.first))
-				object->props().removeProperty(i.first);
+			if (def_val.getIntValue() == object->intProperty(prop.name()))
+				defaults.push_back(prop.name());
 		}
-		else if (i.second.defaultValue().getType() == PROP_FLOAT)
+		else if (def_val.getType() == PROP_FLOAT)
 		{
-			if (i.second.defaultValue().getFloatValue() == object->floatProperty(i.first))
-				object->props().removeProperty(i.first);
+			if (def_val.getFloatValue() == object->floatProperty(prop.name()))
+				defaults.push_back(prop.name());
 		}
-		else if (i.second.defaultValue().getType() == PROP_STRING)
+		else if (def_val.getType() == PROP_STRING)
 		{
-			if (i.second.defaultValue().getStringValue() == object->stringProperty(i.first))
-				object->props().removeProperty(i.first);
+			if (def_val.getStringValue() == object->stringProperty(prop.name()))
+				defaults.push_back(prop.name());
 		}
 	}
+
+	// Remove default value properties
+	for (auto& name : defaults)
+		object->props().removeProperty(name);
 }
 
 // ----------------------------------------------------------------------------
@@ -1964,7 +1983,10 @@ string Configuration::sectorTypeName(int type)
 	}
 
 	// Get base type name
-	string name = sector_types_[type];
+	string name;
+	auto stype = sector_types_.find(type);
+	if (stype != sector_types_.end())
+		name = stype->second;
 	if (name.empty())
 		name = "Unknown";
 
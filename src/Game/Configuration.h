@@ -85,9 +85,17 @@ namespace Game
 		const std::map<int, ThingType>&		allThingTypes() const { return thing_types_; }
 		const std::map<int, string>&		allSectorTypes() const { return sector_types_; }
 
-		// Feature Support
-		bool	featureSupported(Feature feature) { return supported_features_[feature]; }
-		bool	featureSupported(UDMFFeature feature) { return udmf_features_[feature]; }
+		// Feature Support (doesn't modify the feature maps, so can be called from other threads)
+		bool	featureSupported(Feature feature) const
+		{
+			auto f = supported_features_.find(feature);
+			return f != supported_features_.end() && f->second;
+		}
+		bool	featureSupported(UDMFFeature feature) const
+		{
+			auto f = udmf_features_.find(feature);
+			return f != udmf_features_.end() && f->second;
+		}
 
 		// Configuration reading
 		void	readActionSpecials(
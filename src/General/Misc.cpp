@@ -30,6 +30,7 @@
  * INCLUDES
  *******************************************************************/
 #include "Main.h"
+#include "App.h"
 #include "General/Misc.h"
 #include "Graphics/SImage/SImage.h"
 #include "Archive/Archive.h"
@@ -49,6 +50,9 @@
  *******************************************************************/
 CVAR(Bool, size_as_string, true, CVAR_SAVE)
 CVAR(Bool, percent_encoding, false, CVAR_SAVE)
+CVAR(Int, thumb_cache_max_size, 256, CVAR_SAVE)	// In MB, oldest thumbnails are removed beyond this (0 = no limit)
+CVAR(Int, thumb_cache_max_age, 60, CVAR_SAVE)	// In days (0 = no limit)
+CVAR(Bool, thumb_cache_clear, false, CVAR_SAVE)	// Remove all cached thumbnails on next startup
 EXTERN_CVAR(Float, col_cie_tristim_x)
 EXTERN_CVAR(Float, col_cie_tristim_z)
 namespace Misc
@@ -750,3 +754,72 @@ void Misc::writeWindowInfo(wxFile& file)
 	for (unsigned a = 0; a < window_info.size(); a++)
 		file.Write(S_FMT("\t%s %d %d %d %d\n", window_info[a].id, window_info[a].width, window_info[a].height, window_info[a].left, window_info[a].top));
 }
+
+/* Misc::pruneThumbCache
+ * Removes cached thumbnails (from browser and map previews) that
+ * haven't been used in thumb_cache_max_age days, then the oldest
+ * ones until the cache is within thumb_cache_max_size MB. Removes
+ * all of them if thumb_cache_clear is set. Called at startup, before
+ * anything is reading from or writing to the cache
+ *******************************************************************/
+void Misc::pruneThumbCache()
+{
+	string dir = App::path("thumbcache", App::Dir::User);
+	if (!wxDirExists(dir))
+		return;
+
+	// Get cached thumbnails with their sizes and modification times
+	// (which are updated when a thumbnail is read from the cache).
+	// Everything in the directory is included, so any temp files left
+	// behind by an interrupted write are cleaned up too
+	struct thumb_t
+	{
+		string		path;
+		uint64_t	size;
+		time_t		time;
+		bool operator<(const thumb_t& other) const { return time < other.time; }
+	};
+	vector<thumb_t> thumbs;
+	wxArrayString files;
+	wxDir::GetAllFiles(dir, &files, wxEmptyString, wxDIR_FILES);
+	for (unsigned a = 0; a < files.size(); a++)
+	{
+		wxFileName fn(files[a]);
+		thumb_t thumb;
+		thumb.path = files[a];
+		thumb.size = fn.GetSize().GetValue();
+		thumb.time = fn.GetModificationTime().GetTicks();
+		thumbs.push_back(thumb);
+	}
+	std::sort(thumbs.begin(), thumbs.end());
+
+	// Get total size (in bytes) and oldest time to keep
+	uint64_t total = 0;
+	for (unsigned a = 0; a < thumbs.size(); a++)
+		total += thumbs[a].size;
+	uint64_t max_size = (uint64_t)thumb_cache_max_size * 1024 * 1024;
+	time_t min_time = 0;
+	if (thumb_cache_max_age > 0)
+		min_time = wxDateTime::Now().GetTicks() - (time_t)thumb_cache_max_age * 24 * 60 * 60;
+
+	// Remove thumbnails, oldest first
+	unsigned removed = 0;
+	for (unsigned a = 0; a < thumbs.size(); a++)
+	{
+		if (!thumb_cache_clear &&
+			thumbs[a].time >= min_time &&
+			(thumb_cache_max_size <= 0 || total <= max_size))
+			break;
+
+		if (wxRemoveFile(thumbs[a].path))
+		{
+			total -= thumbs[a].size;
+			removed++;
+		}
+	}
+
+	if (removed > 0)
+		LOG_MESSAGE(2, "Removed %d cached thumbnails", removed);
+
+	thumb_cache_clear = false;
+}
@@ -61,6 +61,9 @@ namespace Misc
 	void	setWindowInfo(string id, int width, int height, int left, int top);
 	void	readWindowInfo(Tokenizer* tz);
 	void	writeWindowInfo(wxFile& file);
+
+	// Thumbnail cache
+	void	pruneThumbCache();
 }
 
 #endif //__MISC_H__
@@ -467,6 +467,16 @@ void ResourceManager::getAllPatchEntries(vector<ArchiveEntry*>& list, Archive* p
 	}
 }
 
+/* ResourceManager::getAllPatchNames
+ * Adds all current patch names to [list]
+ *******************************************************************/
+void ResourceManager::getAllPatchNames(vector<string>& list)
+{
+	for (auto& i : patches)
+		if (i.second.length() > 0)	// Ignore if no entries
+			list.push_back(i.first);
+}
+
 /* ResourceManager::getAllTextures
  * Adds all current textures to [list]
  *******************************************************************/
@@ -105,6 +105,7 @@ public:
 
 	void	listAllPatches();
 	void	getAllPatchEntries(vector<ArchiveEntry*>& list, Archive* priority);
+	void	getAllPatchNames(vector<string>& list);
 
 	void	getAllTextures(vector<TextureResource::Texture*>& list, Archive* priority, Archive* ignore = NULL);
 	void	getAllTextureNames(vector<string>& list);
@@ -29,12 +29,15 @@
  *******************************************************************/
 #include "Main.h"
 #include "General/UndoRedo.h"
+#include "App.h"
+#include "Utility/Compression.h"
 
 
 /*******************************************************************
  * VARIABLES
  *******************************************************************/
 UndoManager*	current_undo_manager = NULL;
+CVAR(Int, undo_max_memory, 64, CVAR_SAVE)	// In MB, older undo levels are moved to a journal file beyond this (0 = no limit)
 
 
 /*******************************************************************
@@ -49,6 +52,9 @@ UndoLevel::UndoLevel(string name)
 	// Init variables
 	this->name = name;
 	this->timestamp = wxDateTime::Now();
+	this->unloaded = false;
+	this->journal_offset = 0;
+	this->journal_size = 0;
 }
 
 /* UndoLevel::~UndoLevel
@@ -107,19 +113,123 @@ bool UndoLevel::doRedo()
 }
 
 /* UndoLevel::readFile
- * Reads the undo level from a file
+ * Reads the undo level data back from the journal file [filename],
+ * after it was written there by writeFile and unloaded
  *******************************************************************/
 bool UndoLevel::readFile(string filename)
 {
+	// Read compressed data from the journal
+	wxFile file(filename, wxFile::read);
+	if (!file.IsOpened() || file.Seek(journal_offset) == wxInvalidOffset)
+		return false;
+	MemChunk compressed;
+	if (!compressed.importFileStream(file, journal_size) || compressed.getSize() != journal_size)
+		return false;
+
+	// Decompress
+	MemChunk mc;
+	if (!Compression::ZlibInflate(compressed, mc))
+		return false;
+	mc.seek(0, SEEK_SET);
+
+	// Read header
+	string level_name;
+	int64_t time;
+	uint32_t n_steps;
+	if (!mc.readString(level_name) || !mc.read(&time, 8) || !mc.read(&n_steps, 4) || n_steps != undo_steps.size())
+		return false;
+
+	// Read steps
+	for (unsigned a = 0; a < undo_steps.size(); a++)
+	{
+		uint32_t size;
+		if (!mc.read(&size, 4))
+			return false;
+
+		uint32_t start = mc.currentPos();
+		if (!undo_steps[a]->readFile(mc))
+			return false;
+		mc.seek(start + size, SEEK_SET);
+	}
+
+	unloaded = false;
+
 	return true;
 }
 
 /* UndoLevel::writeFile
- * Writes the undo level to a file
+ * Appends the undo level data (compressed) to the journal file
+ * [filename], so it can be unloaded from memory
  *******************************************************************/
 bool UndoLevel::writeFile(string filename)
 {
-	return true;
+	MemChunk mc;
+	size_t estimate = memoryUsage();
+	if (estimate > 0)
+		mc.reSize(estimate, false);
+
+	// Write header
+	int64_t time = timestamp.GetValue().GetValue();
+	uint32_t n_steps = undo_steps.size();
+	mc.writeString(name);
+	mc.write(&time, 8);
+	mc.write(&n_steps, 4);
+
+	// Write steps, each preceded by its size
+	for (unsigned a = 0; a < undo_steps.size(); a++)
+	{
+		uint32_t start = mc.currentPos();
+		uint32_t size = 0;
+		mc.write(&size, 4);
+		if (!undo_steps[a]->writeFile(mc))
+			return false;
+
+		size = mc.currentPos() - start - 4;
+		mc.write(&size, 4, start);
+		mc.seek(start + 4 + size, SEEK_SET);
+	}
+	mc.reSize(mc.currentPos(), true);
+
+	// Compress
+	MemChunk compressed;
+	if (!Compression::ZlibDeflate(mc, compressed))
+		return false;
+
+	// Append to journal
+	wxFile file(filename, wxFile::write_append);
+	if (!file.IsOpened())
+		return false;
+	journal_offset = file.Length();
+	journal_size = compressed.getSize();
+
+	return file.Write(compressed.getData(), journal_size) == journal_size;
+}
+
+/* UndoLevel::memoryUsage
+ * Returns (roughly) the memory used by the undo level data, in bytes
+ *******************************************************************/
+size_t UndoLevel::memoryUsage()
+{
+	if (unloaded)
+		return 0;
+
+	size_t size = 0;
+	for (unsigned a = 0; a < undo_steps.size(); a++)
+		size += undo_steps[a]->memoryUsage();
+
+	return size;
+}
+
+/* UndoLevel::unload
+ * Frees the undo level data from memory, it must have been written
+ * with writeFile first and read back with readFile before use
+ *******************************************************************/
+void UndoLevel::unload()
+{
+	for (unsigned a = 0; a < undo_steps.size(); a++)
+		undo_steps[a]->unload();
+
+	unloaded = true;
 }
 
 /* UndoLevel::createMerged
@@ -149,6 +259,7 @@ UndoManager::UndoManager(SLADEMap* map)
 	current_level = NULL;
 	current_level_index = -1;
 	undo_running = false;
+	last_failed = false;
 	this->map = map;
 }
 
@@ -159,6 +270,160 @@ UndoManager::~UndoManager()
 {
 	for (unsigned a = 0; a < undo_levels.size(); a++)
 		delete undo_levels[a];
+
+	// Remove journal
+	if (!journal_file.IsEmpty() && wxFileExists(journal_file))
+		wxRemoveFile(journal_file);
+}
+
+/* UndoManager::loadLevel
+ * Reads [level] back from the journal if it was unloaded. Returns
+ * false if it couldn't be read
+ *******************************************************************/
+bool UndoManager::loadLevel(UndoLevel* level)
+{
+	if (!level->isUnloaded())
+		return true;
+
+	if (!level->readFile(journal_file))
+	{
+		LOG_MESSAGE(1, "Unable to read undo level \"%s\" from the undo journal", level->getName());
+		return false;
+	}
+
+	return true;
+}
+
+/* UndoManager::checkMemoryUsage
+ * If the undo levels use more memory than allowed (undo_max_memory),
+ * moves the levels furthest from the current level out to the
+ * journal file until they don't
+ *******************************************************************/
+void UndoManager::checkMemoryUsage()
+{
+	if (undo_max_memory <= 0)
+		return;
+
+	// Get total memory used
+	size_t max = (size_t)undo_max_memory * 1024 * 1024;
+	size_t total = 0;
+	for (unsigned a = 0; a < undo_levels.size(); a++)
+		total += undo_levels[a]->memoryUsage();
+	if (total <= max)
+		return;
+
+	// Create journal file if needed
+	if (journal_file.IsEmpty())
+	{
+		journal_file = wxFileName::CreateTempFileName(App::path("undo", App::Dir::Temp));
+		if (journal_file.IsEmpty())
+		{
+			LOG_MESSAGE(1, "Unable to create undo journal file");
+			return;
+		}
+	}
+
+	// Unload levels, from whichever end of the list is furthest from
+	// the current level (always keep the next undo and redo levels)
+	int first = 0;
+	int last = (int)undo_levels.size() - 1;
+	while (total > max && first <= last)
+	{
+		int index;
+		if (current_level_index - first >= last - current_level_index)
+			index = first++;
+		else
+			index = last--;
+
+		if (index >= current_level_index && index <= current_level_index + 1)
+			break;
+
+		UndoLevel* level = undo_levels[index];
+		size_t size = level->memoryUsage();
+		if (size == 0)
+			continue;
+
+		if (!level->writeFile(journal_file))
+		{
+			LOG_MESSAGE(1, "Unable to write undo level \"%s\" to the undo journal", level->getName());
+			return;
+		}
+		level->unload();
+		total -= size;
+	}
+}
+
+/* UndoManager::compactJournal
+ * Removes data that is no longer needed (deleted levels or levels
+ * read back into memory) from the journal file. The journal is
+ * removed if no levels are unloaded, otherwise it is rewritten with
+ * only the unloaded levels once less than half of it is in use
+ *******************************************************************/
+void UndoManager::compactJournal()
+{
+	if (journal_file.IsEmpty())
+		return;
+
+	// Get journal data still in use
+	wxFileOffset used = 0;
+	for (unsigned a = 0; a < undo_levels.size(); a++)
+	{
+		if (undo_levels[a]->isUnloaded())
+			used += undo_levels[a]->journalSize();
+	}
+
+	// Remove the journal if nothing in it is used
+	if (used == 0)
+	{
+		if (wxFileExists(journal_file))
+			wxRemoveFile(journal_file);
+		journal_file = "";
+		return;
+	}
+
+	// Leave it alone if most of it is still in use
+	wxFile in(journal_file, wxFile::read);
+	if (!in.IsOpened() || in.Length() <= used * 2)
+		return;
+
+	// Copy unloaded levels to a new journal
+	string new_file = wxFileName::CreateTempFileName(App::path("undo", App::Dir::Temp));
+	if (new_file.IsEmpty())
+		return;
+	wxFile out(new_file, wxFile::write);
+	vector<wxFileOffset> offsets(undo_levels.size(), 0);
+	bool ok = out.IsOpened();
+	MemChunk mc;
+	for (unsigned a = 0; ok && a < undo_levels.size(); a++)
+	{
+		UndoLevel* level = undo_levels[a];
+		if (!level->isUnloaded())
+			continue;
+
+		offsets[a] = out.Tell();
+		ok = in.Seek(level->journalOffset()) != wxInvalidOffset &&
+			mc.importFileStream(in, level->journalSize()) &&
+			mc.getSize() == level->journalSize() &&
+			out.Write(mc.getData(), mc.getSize()) == mc.getSize();
+	}
+	in.Close();
+	out.Close();
+
+	if (!ok)
+	{
+		LOG_MESSAGE(1, "Unable to compact undo journal");
+		wxRemoveFile(new_file);
+		return;
+	}
+
+	// Switch to the new journal
+	for (unsigned a = 0; a < undo_levels.size(); a++)
+	{
+		if (undo_levels[a]->isUnloaded())
+			undo_levels[a]->setJournalOffset(offsets[a]);
+	}
+	wxRemoveFile(journal_file);
+	journal_file = new_file;
 }
 
 /* UndoManager::beginRecord
@@ -217,6 +482,9 @@ void UndoManager::endRecord(bool success)
 	// Clear current undo manager
 	current_undo_manager = NULL;
 
+	compactJournal();
+	checkMemoryUsage();
+
 	announce("level_recorded");
 }
 
@@ -250,10 +518,13 @@ bool UndoManager::recordUndoStep(UndoStep* step)
 }
 
 /* UndoManager::undo
- * Performs an undo operation
+ * Performs an undo operation. Returns the name of the undo level, or
+ * "" if there was nothing to undo or it failed (see lastFailed)
  *******************************************************************/
 string UndoManager::undo()
 {
+	last_failed = false;
+
 	// Can't while currently recording
 	if (current_level)
 		return "";
@@ -262,15 +533,26 @@ string UndoManager::undo()
 	if (current_level_index < 0)
 		return "";
 
+	// Make sure the level is in memory, stay at the current level if
+	// it can't be read back from the journal
+	UndoLevel* level = undo_levels[current_level_index];
+	if (!loadLevel(level))
+	{
+		LOG_MESSAGE(1, "Undo operation \"%s\" failed", level->getName());
+		last_failed = true;
+		return "";
+	}
+
 	// Perform undo level
 	undo_running = true;
 	current_undo_manager = this;
-	UndoLevel* level = undo_levels[current_level_index];
 	if (!level->doUndo())
 		LOG_MESSAGE(3, "Undo operation \"%s\" failed", level->getName());
 	undo_running = false;
 	current_undo_manager = NULL;
 	current_level_index--;
+	compactJournal();
+	checkMemoryUsage();
 
 	announce("undo");
 
@@ -278,10 +560,13 @@ string UndoManager::undo()
 }
 
 /* UndoManager::redo
- * Performs a redo operation
+ * Performs a redo operation. Returns the name of the undo level, or
+ * "" if there was nothing to redo or it failed (see lastFailed)
  *******************************************************************/
 string UndoManager::redo()
 {
+	last_failed = false;
+
 	// Can't while currently recording
 	if (current_level)
 		return "";
@@ -290,14 +575,25 @@ string UndoManager::redo()
 	if (current_level_index == undo_levels.size() - 1 || undo_levels.size() == 0)
 		return "";
 
+	// Make sure the level is in memory, stay at the current level if
+	// it can't be read back from the journal
+	UndoLevel* level = undo_levels[current_level_index + 1];
+	if (!loadLevel(level))
+	{
+		LOG_MESSAGE(1, "Redo operation \"%s\" failed", level->getName());
+		last_failed = true;
+		return "";
+	}
+
 	// Perform redo level
 	current_level_index++;
 	undo_running = true;
 	current_undo_manager = this;
-	UndoLevel* level = undo_levels[current_level_index];
 	level->doRedo();
 	undo_running = false;
 	current_undo_manager = NULL;
+	compactJournal();
+	checkMemoryUsage();
 
 	announce("redo");
 
@@ -327,6 +623,11 @@ void UndoManager::clear()
 	current_level = NULL;
 	current_level_index = -1;
 	undo_running = false;
+
+	// Remove journal
+	if (!journal_file.IsEmpty() && wxFileExists(journal_file))
+		wxRemoveFile(journal_file);
+	journal_file = "";
 }
 
 /* UndoManager::createMergedLevel
@@ -338,6 +639,10 @@ bool UndoManager::createMergedLevel(UndoManager* manager, string name)
 	if (manager->undo_levels.empty())
 		return false;
 
+	// Make sure all levels are in memory
+	for (unsigned a = 0; a < manager->undo_levels.size(); a++)
+		manager->loadLevel(manager->undo_levels[a]);
+
 	// Create merged undo level from manager
 	UndoLevel* merged = new UndoLevel(name);
 	merged->createMerged(manager->undo_levels);
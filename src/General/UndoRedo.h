@@ -18,6 +18,12 @@ public:
 	virtual bool	writeFile(MemChunk& mc) { return true; }
 	virtual bool	readFile(MemChunk& mc) { return true; }
 	virtual bool	isOk() { return true; }
+
+	// For moving undo data out of memory. Steps that implement
+	// writeFile/readFile should free anything written on unload, and
+	// return (roughly) the memory that would free from memoryUsage
+	virtual size_t	memoryUsage() { return 0; }
+	virtual void	unload() {}
 };
 
 class UndoLevel
@@ -27,6 +33,11 @@ private:
 	vector<UndoStep*>	undo_steps;
 	wxDateTime			timestamp;
 
+	// Journal file position, if unloaded
+	bool				unloaded;
+	wxFileOffset		journal_offset;
+	uint32_t			journal_size;
+
 public:
 	UndoLevel(string name);
 	~UndoLevel();
@@ -40,6 +51,14 @@ public:
 	bool	writeFile(string filename);
 	bool	readFile(string filename);
 	void	createMerged(vector<UndoLevel*>& levels);
+
+	size_t	memoryUsage();
+	bool	isUnloaded() { return unloaded; }
+	void	unload();
+
+	wxFileOffset	journalOffset() { return journal_offset; }
+	uint32_t		journalSize() { return journal_size; }
+	void			setJournalOffset(wxFileOffset offset) { journal_offset = offset; }
 };
 
 class SLADEMap;
@@ -50,7 +69,13 @@ private:
 	UndoLevel*			current_level;
 	int					current_level_index;
 	bool				undo_running;
+	bool				last_failed;	// Last undo/redo couldn't read its level from the journal
 	SLADEMap*			map;
+	string				journal_file;
+
+	bool	loadLevel(UndoLevel* level);
+	void	checkMemoryUsage();
+	void	compactJournal();
 
 public:
 	UndoManager(SLADEMap* map = NULL);
@@ -68,6 +93,7 @@ public:
 	bool	recordUndoStep(UndoStep* step);
 	string	undo();
 	string	redo();
+	bool	lastFailed() { return last_failed; }
 
 	void	clear();
 	bool	createMergedLevel(UndoManager* manager, string name);
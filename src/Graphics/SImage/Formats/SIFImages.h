@@ -411,6 +411,7 @@ public:
 	{
 		name = "PNG";
 		extension = "png";
+		addMagic("\x89PNG\r\n\x1A\n", 8);
 	}
 
 	bool isThisFormat(MemChunk& mc)
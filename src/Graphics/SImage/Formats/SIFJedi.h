@@ -207,6 +207,7 @@ public:
 		name = "Jedi BM";
 		extension = "dat";
 		reliability = 80;
+		addMagic("BM \x1E", 4);
 	}
 	~SIFJediBM() {}
 
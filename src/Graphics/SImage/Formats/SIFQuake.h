@@ -249,6 +249,7 @@ public:
 	{
 		name = "Quake Sprite";
 		extension = "dat";
+		addMagic("IDSP", 4);
 	}
 	~SIFQuakeSprite() {}
 
@@ -62,6 +62,7 @@ public:
 	{
 		name = "IMGZ";
 		extension = "imgz";
+		addMagic("IMGZ", 4);
 	}
 	~SIFImgz() {}
 
@@ -46,6 +46,12 @@ SIFormat*			sif_flat = NULL;
 SIFormat*			sif_general = NULL;
 SIFormat*			sif_unknown = NULL;
 
+// Format detection dispatch index: for each possible first byte of the
+// data, the (ordered) list of formats that could match it. Built once
+// by initFormats, and only read after that (detection can happen on
+// background threads)
+vector<SIFormat*>	sif_dispatch[256];
+
 
 /*******************************************************************
  * EXTERNAL VARIABLES
@@ -503,6 +509,24 @@ SIFormat::~SIFormat()
 {
 }
 
+/* SIFormat::matchesMagic
+ * Returns true if [data] begins with one of the format's magic
+ * signatures, or if the format has none
+ *******************************************************************/
+bool SIFormat::matchesMagic(const uint8_t* data, unsigned size)
+{
+	if (magic.empty())
+		return true;
+
+	for (unsigned a = 0; a < magic.size(); a++)
+	{
+		if (size >= magic[a].size() && memcmp(data, magic[a].data(), magic[a].size()) == 0)
+			return true;
+	}
+
+	return false;
+}
+
 
 /*******************************************************************
  * SIFORMAT CLASS STATIC FUNCTIONS
@@ -571,6 +595,26 @@ void SIFormat::initFormats()
 	new SIFHeretic2M32();
 	new SIFWolfPic();
 	new SIFWolfSprite();
+
+	// Build detection dispatch index
+	for (unsigned b = 0; b < 256; b++)
+		sif_dispatch[b].clear();
+
+	for (unsigned a = 0; a < simage_formats.size(); a++)
+	{
+		SIFormat* sif = simage_formats[a];
+		for (unsigned b = 0; b < 256; b++)
+		{
+			// Add the format under each byte its signatures can start with
+			// (or all bytes if it has no signatures)
+			bool match = sif->magic.empty();
+			for (unsigned m = 0; m < sif->magic.size() && !match; m++)
+				match = !sif->magic[m].empty() && (uint8_t)sif->magic[m][0] == b;
+
+			if (match)
+				sif_dispatch[b].push_back(sif);
+		}
+	}
 }
 
 /* SIFormat::getFormat
@@ -602,17 +646,20 @@ SIFormat* SIFormat::getFormat(string id)
  *******************************************************************/
 SIFormat* SIFormat::determineFormat(MemChunk& mc)
 {
-	// Go through all registered formats
+	// Get formats that could match the first byte of the data
+	vector<SIFormat*>& formats = mc.getSize() > 0 ? sif_dispatch[mc[0]] : simage_formats;
+
+	// Go through all possible formats
 	SIFormat* format = sif_unknown;
-	for (unsigned a = 0; a < simage_formats.size(); a++)
+	for (unsigned a = 0; a < formats.size(); a++)
 	{
 		// Don't bother checking if the format is less reliable
-		if (simage_formats[a]->reliability < format->reliability)
+		if (formats[a]->reliability < format->reliability)
 			continue;
 
 		// Check if data matches format
-		if (simage_formats[a]->isThisFormat(mc))
-			format = simage_formats[a];
+		if (formats[a]->matchesMagic(mc.getData(), mc.getSize()) && formats[a]->isThisFormat(mc))
+			format = formats[a];
 
 		// Stop if format detected is 100% reliable
 		if (format->reliability == 255)
@@ -12,6 +12,9 @@ protected:
 	string	name;
 	string	extension;
 	uint8_t	reliability;
+	vector<std::string>	magic;	// If any are given, the data must begin with one of these to match the format
+
+	void	addMagic(const char* bytes, unsigned length) { magic.push_back(std::string(bytes, length)); }
 
 	// Stuff to access protected image data
 	uint8_t*		imageData(SImage& image) { return image.data; }
@@ -58,6 +61,7 @@ public:
 	string	getExtension() { return extension; }
 
 	virtual bool	isThisFormat(MemChunk& mc) = 0;
+	bool			matchesMagic(const uint8_t* data, unsigned size);
 
 	// Reading
 	virtual SImage::info_t	getInfo(MemChunk& mc, int index = 0) = 0;
@@ -49,6 +49,138 @@ EXTERN_CVAR(Float, col_greyscale_r)
 EXTERN_CVAR(Float, col_greyscale_g)
 EXTERN_CVAR(Float, col_greyscale_b)
 
+
+/*******************************************************************
+ * PIXEL KERNELS
+ *******************************************************************
+ * Row-oriented loops used by the bulk image operations below. These
+ * avoid per-pixel index divisions and bounds checks so the compiler
+ * can keep the inner loops tight (and vectorise where it's able to)
+ */
+
+/* rotatePixels
+ * Copies the [w]x[h] image in [src] to [dst], rotated by [angle]
+ * (90, 180 or 270, with the same orientation as SImage::rotate's
+ * remapping). [bpp] is the number of bytes per pixel
+ *******************************************************************/
+template<unsigned bpp>
+static void rotatePixels(const uint8_t* src, uint8_t* dst, int w, int h, int angle)
+{
+	// 180 degrees is just the pixels in reverse order
+	if (angle == 180)
+	{
+		const uint8_t* s = src;
+		uint8_t* d = dst + (w * h - 1) * bpp;
+		for (int i = 0; i < w * h; i++, s += bpp, d -= bpp)
+			memcpy(d, s, bpp);
+		return;
+	}
+
+	// 90/270 degrees: each source row becomes a destination column.
+	// Process in square tiles so both sides stay in cache on big images
+	const int tile = 32;
+	int step = (angle == 90) ? -h : h;
+	for (int ty = 0; ty < h; ty += tile)
+	{
+		int ey = MIN(ty + tile, h);
+		for (int tx = 0; tx < w; tx += tile)
+		{
+			int ex = MIN(tx + tile, w);
+			for (int y = ty; y < ey; y++)
+			{
+				int j = (angle == 90) ? ((w - 1 - tx) * h + y) : (tx * h + (h - 1 - y));
+				const uint8_t* s = src + (y * w + tx) * bpp;
+				uint8_t* d = dst + j * bpp;
+				for (int x = tx; x < ex; x++, s += bpp, d += step * (int)bpp)
+					memcpy(d, s, bpp);
+			}
+		}
+	}
+}
+
+/* mirrorPixels
+ * Copies the [w]x[h] image in [src] to [dst], mirrored vertically or
+ * horizontally. [bpp] is the number of bytes per pixel
+ *******************************************************************/
+template<unsigned bpp>
+static void mirrorPixels(const uint8_t* src, uint8_t* dst, int w, int h, bool vertical)
+{
+	unsigned stride = w * bpp;
+
+	// Vertical: rows in reverse order
+	if (vertical)
+	{
+		for (int y = 0; y < h; y++)
+			memcpy(dst + (h - 1 - y) * stride, src + y * stride, stride);
+		return;
+	}
+
+	// Horizontal: each row reversed
+	for (int y = 0; y < h; y++)
+	{
+		const uint8_t* s = src + y * stride;
+		uint8_t* d = dst + y * stride + stride - bpp;
+		for (int x = 0; x < w; x++, s += bpp, d -= bpp)
+			memcpy(d, s, bpp);
+	}
+}
+
+/* blendColour
+ * Blends [colour] (with its final alpha already applied) on to
+ * [d_colour] using [blend] mode. Shared by SImage::drawPixel and
+ * SImage::drawImage so both give identical results
+ *******************************************************************/
+static inline void blendColour(rgba_t& d_colour, const rgba_t& colour, int blend)
+{
+	float alpha = (float)colour.a / 255.0f;
+
+	// Additive blending
+	if (blend == ADD)
+	{
+		d_colour.set(	MathStuff::clamp(d_colour.r+colour.r*alpha, 0, 255),
+		                MathStuff::clamp(d_colour.g+colour.g*alpha, 0, 255),
+		                MathStuff::clamp(d_colour.b+colour.b*alpha, 0, 255),
+		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+	}
+
+	// Subtractive blending
+	else if (blend == SUBTRACT)
+	{
+		d_colour.set(	MathStuff::clamp(d_colour.r-colour.r*alpha, 0, 255),
+		                MathStuff::clamp(d_colour.g-colour.g*alpha, 0, 255),
+		                MathStuff::clamp(d_colour.b-colour.b*alpha, 0, 255),
+		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+	}
+
+	// Reverse-Subtractive blending
+	else if (blend == REVERSE_SUBTRACT)
+	{
+		d_colour.set(	MathStuff::clamp((-d_colour.r)+colour.r*alpha, 0, 255),
+		                MathStuff::clamp((-d_colour.g)+colour.g*alpha, 0, 255),
+		                MathStuff::clamp((-d_colour.b)+colour.b*alpha, 0, 255),
+		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+	}
+
+	// 'Modulate' blending
+	else if (blend == MODULATE)
+	{
+		d_colour.set(	MathStuff::clamp(colour.r*d_colour.r / 255, 0, 255),
+		                MathStuff::clamp(colour.g*d_colour.g / 255, 0, 255),
+		                MathStuff::clamp(colour.b*d_colour.b / 255, 0, 255),
+		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+	}
+
+	// Normal blending (or unknown blend type)
+	else
+	{
+		float inv_alpha = 1.0f - alpha;
+		d_colour.set(	d_colour.r*inv_alpha + colour.r*alpha,
+		                d_colour.g*inv_alpha + colour.g*alpha,
+		                d_colour.b*inv_alpha + colour.b*alpha,
+		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+	}
+}
+
 /*******************************************************************
  * SIMAGE CLASS FUNCTIONS
  *******************************************************************/
@@ -1047,6 +1179,8 @@ bool SImage::rotate(int angle)
 	while (angle < 0) angle += 360;
 	angle %= 360;
 	angle = 360-angle;
+	if (angle != 90 && angle != 180 && angle != 270)
+		return false;
 
 	uint8_t* nd, * nm;
 	int nw, nh;
@@ -1061,33 +1195,16 @@ bool SImage::rotate(int angle)
 
 	// Create new data and mask
 	nd = new uint8_t[numpixels*numbpp];
-	if (mask) nm = new uint8_t[numpixels*numbpp];
+	if (mask) nm = new uint8_t[numpixels];
 	else nm = NULL;
 
-	// Remapping loop
-	int i, j, k;
-	for (i = 0; i < numpixels; ++i)
-	{
-		switch (angle)
-		{
-			// Urgh maths...
-		case 90:	j = (((nh - 1) - (i%width)) * nw) + (i/width);	break;
-		case 180:	j = (numpixels - 1) - i;						break;
-		case 270:	j = ((i%width) * nw) + ((nw - 1) - (i/width));	break;
-		default: delete[] nd; if (mask) delete[] nm; return false;
-		}
-		if (j >= numpixels)
-		{
-			LOG_MESSAGE(1, "Pixel %i remapped to %i, how did this even happen?", i, j);
-			delete [] nd; if (mask) delete[] nm;
-			return false;
-		}
-		for (k = 0; k < numbpp; ++k)
-		{
-			nd[(j*numbpp)+k] = data[(i*numbpp)+k];
-			if (mask) nm[(j*numbpp)+k] = mask[(i*numbpp)+k];
-		}
-	}
+	// Remap pixels
+	if (numbpp == 4)
+		rotatePixels<4>(data, nd, width, height, angle);
+	else
+		rotatePixels<1>(data, nd, width, height, angle);
+	if (mask)
+		rotatePixels<1>(mask, nm, width, height, angle);
 
 	// It worked, yay
 	clearData();
@@ -1113,29 +1230,16 @@ bool SImage::mirror(bool vertical)
 
 	// Create new data and mask
 	nd = new uint8_t[numpixels*numbpp];
-	if (mask) nm = new uint8_t[numpixels*numbpp];
+	if (mask) nm = new uint8_t[numpixels];
 	else nm = NULL;
 
-	// Remapping loop
-	int i, j, k;
-	for (i = 0; i < numpixels; ++i)
-	{
-		if (vertical)
-			j = (((height - 1) - (i/width)) * width) + (i%width);
-		else // horizontal
-			j = ((i/width) * width) + ((width - 1) - (i%width));
-		if (j >= numpixels)
-		{
-			LOG_MESSAGE(1, "Pixel %i remapped to %i, how did this even happen?", i, j);
-			delete [] nd; if (mask) delete[] nm;
-			return false;
-		}
-		for (k = 0; k < numbpp; ++k)
-		{
-			nd[(j*numbpp)+k] = data[(i*numbpp)+k];
-			if (mask) nm[(j*numbpp)+k] = mask[(i*numbpp)+k];
-		}
-	}
+	// Remap pixels
+	if (numbpp == 4)
+		mirrorPixels<4>(data, nd, width, height, vertical);
+	else
+		mirrorPixels<1>(data, nd, width, height, vertical);
+	if (mask)
+		mirrorPixels<1>(mask, nm, width, height, vertical);
 
 	// It worked, yay
 	clearData();
@@ -1428,55 +1532,11 @@ bool SImage::drawPixel(int x, int y, rgba_t colour, si_drawprops_t& properties,
 	rgba_t d_colour;
 	if (type == PALMASK)
 		d_colour = pal->colour(data[p]);
-	else
+	else if (type == RGBA)
 		d_colour.set(data[p], data[p+1], data[p+2], data[p+3]);
-	float alpha = (float)colour.a / 255.0f;
-
-	// Additive blending
-	if (properties.blend == ADD)
-	{
-		d_colour.set(	MathStuff::clamp(d_colour.r+colour.r*alpha, 0, 255),
-		                MathStuff::clamp(d_colour.g+colour.g*alpha, 0, 255),
-		                MathStuff::clamp(d_colour.b+colour.b*alpha, 0, 255),
-		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// Subtractive blending
-	else if (properties.blend == SUBTRACT)
-	{
-		d_colour.set(	MathStuff::clamp(d_colour.r-colour.r*alpha, 0, 255),
-		                MathStuff::clamp(d_colour.g-colour.g*alpha, 0, 255),
-		                MathStuff::clamp(d_colour.b-colour.b*alpha, 0, 255),
-		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// Reverse-Subtractive blending
-	else if (properties.blend == REVERSE_SUBTRACT)
-	{
-		d_colour.set(	MathStuff::clamp((-d_colour.r)+colour.r*alpha, 0, 255),
-		                MathStuff::clamp((-d_colour.g)+colour.g*alpha, 0, 255),
-		                MathStuff::clamp((-d_colour.b)+colour.b*alpha, 0, 255),
-		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// 'Modulate' blending
-	else if (properties.blend == MODULATE)
-	{
-		d_colour.set(	MathStuff::clamp(colour.r*d_colour.r / 255, 0, 255),
-		                MathStuff::clamp(colour.g*d_colour.g / 255, 0, 255),
-		                MathStuff::clamp(colour.b*d_colour.b / 255, 0, 255),
-		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// Normal blending (or unknown blend type)
 	else
-	{
-		float inv_alpha = 1.0f - alpha;
-		d_colour.set(	d_colour.r*inv_alpha + colour.r*alpha,
-		                d_colour.g*inv_alpha + colour.g*alpha,
-		                d_colour.b*inv_alpha + colour.b*alpha,
-		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
-	}
+		d_colour.set(data[p], data[p], data[p], data[p]);
+	blendColour(d_colour, colour, properties.blend);
 
 	// Apply new colour
 	if (type == PALMASK)
@@ -1510,51 +1570,113 @@ bool SImage::drawImage(SImage& img, int x_pos, int y_pos, si_drawprops_t& proper
 	if (has_palette || !pal_dest)
 		pal_dest = &palette;
 
+	// Clip the source area to this image
+	int sx1 = MAX(0, -x_pos);
+	int sy1 = MAX(0, -y_pos);
+	int sx2 = MIN(img.width, width - x_pos);
+	int sy2 = MIN(img.height, height - y_pos);
+	if (sx2 <= sx1 || sy2 <= sy1)
+		return true;
+
+	// When drawing paletted onto paletted, opaque pixels with normal
+	// blending only depend on the source palette index, so the nearest
+	// destination colour is only looked up once per index
+	short remap[256];
+	for (unsigned a = 0; a < 256; a++)
+		remap[a] = -1;
+
+	// Nearest destination colours for blended pixels, by rgb value
+	std::map<unsigned, uint8_t> nearest;
+
 	// Go through pixels
-	unsigned s_stride = img.getStride();
 	uint8_t s_bpp = img.getBpp();
-	unsigned sp = 0;
-	for (int y = y_pos; y < y_pos + img.height; y++)  		// Rows
+	uint8_t d_bpp = getBpp();
+	rgba_t col, d_colour;
+	for (int sy = sy1; sy < sy2; sy++)  		// Rows
 	{
-		// Skip out-of-bounds rows
-		if (y < 0 || y >= height)
-		{
-			sp += s_stride;
-			continue;
-		}
+		const uint8_t* sp = img.data + (sy * img.width + sx1) * s_bpp;
+		const uint8_t* sm = img.mask ? img.mask + (sy * img.width + sx1) : NULL;
+		unsigned dp = ((sy + y_pos) * width + sx1 + x_pos) * d_bpp;
+		unsigned dm = (sy + y_pos) * width + sx1 + x_pos;
 
-		for (int x = x_pos; x < x_pos + img.width; x++)  	// Columns
+		for (int sx = sx1; sx < sx2; sx++, sp += s_bpp, dp += d_bpp, dm++)  	// Columns
 		{
-			// Skip out-of-bounds columns
-			if (x < 0 || x >= width)
+			// Get source pixel colour, skip if fully transparent
+			if (img.type == PALMASK)
 			{
-				sp += s_bpp;
-				continue;
+				if (sm[sx - sx1] == 0)
+					continue;
+				col = pal_src->colour(*sp);
+				col.a = sm[sx - sx1];
 			}
+			else if (img.type == RGBA)
+			{
+				if (sp[3] == 0)
+					continue;
+				col.set(sp[0], sp[1], sp[2], sp[3]);
+			}
+			else
+			{
+				if (*sp == 0)
+					continue;
+				col.set(*sp, *sp, *sp, *sp);
+			}
+
+			// Setup alpha
+			if (properties.src_alpha)
+				col.a *= properties.alpha;
+			else
+				col.a = 255*properties.alpha;
 
-			// Skip if source pixel is fully transparent
-			if ((img.type == PALMASK && img.mask[sp] == 0) ||
-			        (img.type == ALPHAMAP && img.data[sp] == 0) ||
-			        (img.type == RGBA && img.data[sp+3] == 0))
+			// Do nothing if completely transparent
+			if (col.a == 0)
+				continue;
+
+			// Simple case (normal blending, no transparency involved)
+			if (col.a == 255 && properties.blend == NORMAL)
 			{
-				sp += s_bpp;
+				if (type == RGBA)
+					col.write(data+dp);
+				else
+				{
+					if (img.type == PALMASK)
+					{
+						short& index = remap[*sp];
+						if (index < 0)
+							index = pal_dest->nearestColour(col);
+						data[dp] = index;
+					}
+					else
+						data[dp] = pal_dest->nearestColour(col);
+					mask[dm] = col.a;
+				}
+
 				continue;
 			}
 
-			// Draw pixel
-			if (img.type == PALMASK)
+			// Not-so-simple case, do full processing
+			if (type == PALMASK)
+				d_colour = pal_dest->colour(data[dp]);
+			else if (type == RGBA)
+				d_colour.set(data[dp], data[dp+1], data[dp+2], data[dp+3]);
+			else
+				d_colour.set(data[dp], data[dp], data[dp], data[dp]);
+			blendColour(d_colour, col, properties.blend);
+
+			// Apply new colour
+			if (type == PALMASK)
 			{
-				rgba_t col = pal_src->colour(img.data[sp]);
-				col.a = img.mask[sp];
-				drawPixel(x, y, col, properties, pal_dest);
+				unsigned key = (d_colour.r << 16) | (d_colour.g << 8) | d_colour.b;
+				std::map<unsigned, uint8_t>::iterator i = nearest.find(key);
+				if (i == nearest.end())
+					i = nearest.insert(std::make_pair(key, (uint8_t)pal_dest->nearestColour(d_colour))).first;
+				data[dp] = i->second;
+				mask[dm] = d_colour.a;
 			}
-			else if (img.type == RGBA)
-				drawPixel(x, y, rgba_t(img.data[sp], img.data[sp+1], img.data[sp+2], img.data[sp+3]), properties, pal_dest);
-			else if (img.type == ALPHAMAP)
-				drawPixel(x, y, rgba_t(img.data[sp], img.data[sp], img.data[sp], img.data[sp]), properties, pal_dest);
-
-			// Go to next source pixel
-			sp += s_bpp;
+			else if (type == RGBA)
+				d_colour.write(data+dp);
+			else if (type == ALPHAMAP)
+				data[dp] = d_colour.a;
 		}
 	}
 
@@ -1575,36 +1697,54 @@ bool SImage::colourise(rgba_t colour, Palette8bit* pal, int start, int stop)
 	if (has_palette || !pal)
 		pal = &palette;
 
-	// Go through all pixels
-	uint8_t bpp = getBpp();
+	double grey_r = col_greyscale_r;
+	double grey_g = col_greyscale_g;
+	double grey_b = col_greyscale_b;
 	rgba_t col;
-	for (int a = 0; a < width*height*bpp; a+= bpp)
+
+	// Paletted: the result only depends on the palette index, so build
+	// a lookup table for the indices in range and apply that
+	if (type == PALMASK)
 	{
-		// Skip colors out of range if desired
-		if (type == PALMASK && start >= 0 && stop >= start && stop < 256) 
+		if (!(start >= 0 && stop >= start && stop < 256))
+		{
+			start = 0;
+			stop = 255;
+		}
+
+		uint8_t lut[256];
+		for (int a = 0; a < 256; a++)
 		{
-			if (data[a] < start || data[a] > stop)
+			lut[a] = a;
+			if (a < start || a > stop)
 				continue;
+
+			col.set(pal->colour(a));
+			float grey = (col.r*grey_r + col.g*grey_g + col.b*grey_b) / 255.0f;
+			if (grey > 1.0) grey = 1.0;
+			col.r = colour.r*grey;
+			col.g = colour.g*grey;
+			col.b = colour.b*grey;
+			lut[a] = pal->nearestColour(col);
 		}
 
-		// Get current pixel colour
-		if (type == RGBA)
-			col.set(data[a], data[a+1], data[a+2], data[a+3]);
-		else
-			col.set(pal->colour(data[a]));
+		for (int a = 0; a < width*height; a++)
+			data[a] = lut[data[a]];
+
+		return true;
+	}
 
+	// Go through all pixels
+	uint8_t* p = data;
+	uint8_t* end = data + width*height*4;
+	for (; p < end; p += 4)
+	{
 		// Colourise it
-		float grey = (col.r*col_greyscale_r + col.g*col_greyscale_g + col.b*col_greyscale_b) / 255.0f;
+		float grey = (p[0]*grey_r + p[1]*grey_g + p[2]*grey_b) / 255.0f;
 		if (grey > 1.0) grey = 1.0;
-		col.r = colour.r*grey;
-		col.g = colour.g*grey;
-		col.b = colour.b*grey;
-
-		// Set pixel colour
-		if (type == RGBA)
-			col.write(data+a);
-		else
-			data[a] = pal->nearestColour(col);
+		p[0] = (uint8_t)(colour.r*grey);
+		p[1] = (uint8_t)(colour.g*grey);
+		p[2] = (uint8_t)(colour.b*grey);
 	}
 
 	return true;
@@ -1624,35 +1764,51 @@ bool SImage::tint(rgba_t colour, float amount, Palette8bit* pal, int start, int
 	if (has_palette || !pal)
 		pal = &palette;
 
-	// Go through all pixels
-	uint8_t bpp = getBpp();
+	float inv_amt = 1.0f - amount;
 	rgba_t col;
-	for (int a = 0; a < width*height*bpp; a+= bpp)
+
+	// Paletted: the result only depends on the palette index, so build
+	// a lookup table for the indices in range and apply that
+	if (type == PALMASK)
 	{
-		// Skip colors out of range if desired
-		if (type == PALMASK && start >= 0 && stop >= start && stop < 256)
+		if (!(start >= 0 && stop >= start && stop < 256))
+		{
+			start = 0;
+			stop = 255;
+		}
+
+		uint8_t lut[256];
+		for (int a = 0; a < 256; a++)
 		{
-			if (data[a] < start || data[a] > stop)
+			lut[a] = a;
+			if (a < start || a > stop)
 				continue;
+
+			col.set(pal->colour(a));
+			col.set(col.r*inv_amt + colour.r*amount,
+			        col.g*inv_amt + colour.g*amount,
+			        col.b*inv_amt + colour.b*amount, col.a);
+			lut[a] = pal->nearestColour(col);
 		}
 
-		// Get current pixel colour
-		if (type == RGBA)
-			col.set(data[a], data[a+1], data[a+2], data[a+3]);
-		else
-			col.set(pal->colour(data[a]));
+		for (int a = 0; a < width*height; a++)
+			data[a] = lut[data[a]];
 
-		// Tint it
-		float inv_amt = 1.0f - amount;
-		col.set(col.r*inv_amt + colour.r*amount,
-		        col.g*inv_amt + colour.g*amount,
-		        col.b*inv_amt + colour.b*amount, col.a);
+		return true;
+	}
 
-		// Set pixel colour
-		if (type == RGBA)
-			col.write(data+a);
-		else
-			data[a] = pal->nearestColour(col);
+	// Go through all pixels
+	float tint_r = colour.r*amount;
+	float tint_g = colour.g*amount;
+	float tint_b = colour.b*amount;
+	uint8_t* p = data;
+	uint8_t* end = data + width*height*4;
+	for (; p < end; p += 4)
+	{
+		// Tint it
+		p[0] = (uint8_t)(p[0]*inv_amt + tint_r);
+		p[1] = (uint8_t)(p[1]*inv_amt + tint_g);
+		p[2] = (uint8_t)(p[2]*inv_amt + tint_b);
 	}
 
 	return true;
@@ -1791,4 +1947,171 @@ bool SImage::mirrorpad()
 		offset_x += extra;
 	}
 	return success;
-}
\ No newline at end of file
+}
+
+/*******************************************************************
+ * CONSOLE COMMANDS
+ *******************************************************************/
+#include "General/Console/Console.h"
+
+/* sameImage
+ * Returns true if images [a] and [b] have identical dimensions and
+ * pixels
+ *******************************************************************/
+static bool sameImage(SImage& a, SImage& b)
+{
+	if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight() || a.getType() != b.getType())
+		return false;
+
+	for (int y = 0; y < a.getHeight(); y++)
+	{
+		for (int x = 0; x < a.getWidth(); x++)
+		{
+			if (!a.getPixel(x, y).equals(b.getPixel(x, y), true))
+				return false;
+			if (a.getType() == PALMASK && a.getPixelIndex(x, y) != b.getPixelIndex(x, y))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/* randomImage
+ * Fills [image] with random pixels of [type], including fully and
+ * partially transparent ones
+ *******************************************************************/
+static void randomImage(SImage& image, int width, int height, SIType type)
+{
+	image.create(width, height, type);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			int r = rand() % 4;
+			uint8_t alpha = (r == 0) ? 0 : ((r == 1) ? rand() % 256 : 255);
+			if (type == PALMASK)
+				image.setPixel(x, y, rand() % 256, alpha);
+			else
+				image.setPixel(x, y, rgba_t(rand() % 256, rand() % 256, rand() % 256, alpha));
+		}
+	}
+}
+
+/* drawImageReference
+ * Draws [src] on to [dest] one pixel at a time with drawPixel, for
+ * checking SImage::drawImage against
+ *******************************************************************/
+static void drawImageReference(SImage& dest, SImage& src, int x_pos, int y_pos, si_drawprops_t& props)
+{
+	for (int y = 0; y < src.getHeight(); y++)
+	{
+		for (int x = 0; x < src.getWidth(); x++)
+		{
+			rgba_t col = src.getPixel(x, y);
+			if (col.a > 0)
+				dest.drawPixel(x + x_pos, y + y_pos, col, props, NULL);
+		}
+	}
+}
+
+CONSOLE_COMMAND(test_simage_ops, 0, false)
+{
+	int failed = 0;
+	SImage src[2], dest[2], orig, work;
+	randomImage(src[0], 61, 47, PALMASK);
+	randomImage(src[1], 61, 47, RGBA);
+	randomImage(dest[0], 100, 80, PALMASK);
+	randomImage(dest[1], 100, 80, RGBA);
+
+	// Check rotate and mirror round trips
+	for (unsigned t = 0; t < 2; t++)
+	{
+		orig.copyImage(&src[t]);
+		work.copyImage(&src[t]);
+		for (unsigned a = 0; a < 4; a++)
+			work.rotate(90);
+		if (!sameImage(work, orig))
+			failed++;
+
+		work.rotate(180);
+		work.mirror(true);
+		work.mirror(false);
+		if (!sameImage(work, orig))
+			failed++;
+
+		work.rotate(90);
+		work.rotate(-90);
+		if (!sameImage(work, orig))
+			failed++;
+	}
+
+	// Check drawImage against drawing each pixel, for all blend modes
+	SImage reference;
+	si_drawprops_t props;
+	int positions[3][2] = { { 10, 10 }, { -20, -15 }, { 70, 50 } };
+	for (unsigned s = 0; s < 2; s++)
+	{
+		for (unsigned d = 0; d < 2; d++)
+		{
+			for (int blend = NORMAL; blend <= MODULATE; blend++)
+			{
+				for (unsigned p = 0; p < 3; p++)
+				{
+					props.blend = (SIBlendType)blend;
+					props.alpha = (p == 1) ? 0.5f : 1.0f;
+					props.src_alpha = (p != 2);
+
+					work.copyImage(&dest[d]);
+					reference.copyImage(&dest[d]);
+					work.drawImage(src[s], positions[p][0], positions[p][1], props);
+					drawImageReference(reference, src[s], positions[p][0], positions[p][1], props);
+					if (!sameImage(work, reference))
+						failed++;
+				}
+			}
+		}
+	}
+
+	Log::console(S_FMT("Correctness checks: %d failed", failed));
+
+	// Time operations on a large image
+	const char* names[2] = { "paletted", "RGBA" };
+	for (unsigned t = 0; t < 2; t++)
+	{
+		SImage big, patch;
+		randomImage(big, 1024, 1024, t == 0 ? PALMASK : RGBA);
+		randomImage(patch, 128, 128, t == 0 ? PALMASK : RGBA);
+		props.blend = NORMAL;
+		props.alpha = 1.0f;
+		props.src_alpha = true;
+
+		wxStopWatch sw;
+		for (unsigned a = 0; a < 10; a++)
+			big.rotate(90);
+		long t_rotate = sw.Time();
+
+		sw.Start();
+		for (unsigned a = 0; a < 10; a++)
+			big.mirror(a % 2 == 0);
+		long t_mirror = sw.Time();
+
+		sw.Start();
+		for (unsigned a = 0; a < 10; a++)
+			big.tint(rgba_t(255, 0, 0), 0.1f);
+		long t_tint = sw.Time();
+
+		sw.Start();
+		for (unsigned a = 0; a < 10; a++)
+			big.colourise(rgba_t(0, 255, 0));
+		long t_colourise = sw.Time();
+
+		sw.Start();
+		for (unsigned a = 0; a < 64; a++)
+			big.drawImage(patch, (a % 8) * 128, (a / 8) * 128, props);
+		long t_draw = sw.Time();
+
+		Log::console(S_FMT("1024x1024 %s, 10x each: rotate %ldms, mirror %ldms, tint %ldms, colourise %ldms; drawImage 64x128x128: %ldms",
+			names[t], t_rotate, t_mirror, t_tint, t_colourise, t_draw));
+	}
+}
@@ -161,12 +161,7 @@ bool MapEntryPanel::createImage()
 		return false;
 
 	ArchiveEntry temp;
-	// Stupid OpenGL grumble grumble grumble
-	if (GLEW_ARB_framebuffer_object)
-		map_canvas->createImage(temp, map_image_width, map_image_height);
-	else
-		map_canvas->createImage(temp, min<int>(map_image_width, map_canvas->GetSize().x),
-		                        min<int>(map_image_height, map_canvas->GetSize().y));
+	map_canvas->createImage(temp, map_image_width, map_image_height);
 	string name = S_FMT("%s_%s", entry->getParent()->filename(false), entry->getName());
 	wxFileName fn(name);
 
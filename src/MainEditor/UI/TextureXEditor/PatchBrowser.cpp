@@ -106,6 +106,24 @@ bool PatchBrowserItem::loadImage()
 	return image->loadImage(&img, parent->getPalette());
 }
 
+/* PatchBrowserItem::thumbnailSource
+ * Gets the item's patch entry data for loading its thumbnail in the
+ * background. Textures are composited from their patches, so aren't
+ * loaded this way
+ *******************************************************************/
+bool PatchBrowserItem::thumbnailSource(MemChunk& data, string& format_hint, Palette8bit& palette)
+{
+	if (type != 0)
+		return false;
+
+	ArchiveEntry* entry = theResourceManager->getPatchEntry(name, nspace, archive);
+	if (!BrowserThumbnailLoader::entrySource(entry, data, format_hint))
+		return false;
+
+	palette.copyPalette(parent->getPalette());
+	return true;
+}
+
 /* PatchBrowserItem::itemInfo
  * Returns a string with extra information about the patch
  *******************************************************************/
@@ -114,8 +132,10 @@ string PatchBrowserItem::itemInfo()
 	string info;
 
 	// Add dimensions if known
-	if (image)
+	if (imageLoaded())
 		info += S_FMT("%dx%d", image->getWidth(), image->getHeight());
+	else if (thumb_state == THUMB_READY)
+		info += S_FMT("%dx%d", thumb_width, thumb_height);
 	else
 		info += "Unknown size";
 
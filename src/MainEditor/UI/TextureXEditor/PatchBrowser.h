@@ -19,6 +19,7 @@ public:
 
 	bool	loadImage();
 	string	itemInfo();
+	bool	thumbnailSource(MemChunk& data, string& format_hint, Palette8bit& palette);
 };
 
 class TextureXList;
@@ -37,6 +37,7 @@
 #include "MapEditor/Renderer/Overlays/MCOverlay.h"
 #include "MapEditor/UI/MapEditorWindow.h"
 #include "MapEditor/UI/ObjectEditPanel.h"
+#include "Utility/Profiler.h"
 
 using namespace MapEditor;
 
@@ -77,6 +78,9 @@ Input::Input(MapEditContext& context) : context_{ context }
  *******************************************************************/
 bool Input::mouseMove(int new_x, int new_y)
 {
+	PROFILE_SCOPE("Input");
+	PROFILE_SCOPE("Mouse Move");
+
 	// Check if a full screen overlay is active
 	if (context_.overlayActive())
 	{
@@ -192,6 +196,9 @@ bool Input::mouseMove(int new_x, int new_y)
  *******************************************************************/
 bool Input::mouseDown(MouseButton button, bool double_click)
 {
+	PROFILE_SCOPE("Input");
+	PROFILE_SCOPE("Mouse Down");
+
 	// Update hilight
 	if (mouse_state_ == MouseState::Normal)
 		context_.selection().updateHilight(mouse_pos_map_, context_.renderer().view().scale());
@@ -364,6 +371,9 @@ bool Input::mouseDown(MouseButton button, bool double_click)
  *******************************************************************/
 bool Input::mouseUp(MouseButton button)
 {
+	PROFILE_SCOPE("Input");
+	PROFILE_SCOPE("Mouse Up");
+
 	// Update mouse variables
 	mouse_button_down_[button] = false;
 
@@ -439,6 +449,9 @@ bool Input::mouseUp(MouseButton button)
  *******************************************************************/
 void Input::mouseWheel(bool up, double amount)
 {
+	PROFILE_SCOPE("Input");
+	PROFILE_SCOPE("Mouse Wheel");
+
 	mouse_wheel_speed_ = amount;
 
 	if (up)
@@ -516,6 +529,9 @@ bool Input::keyUp(const string& key) const
  *******************************************************************/
 void Input::onKeyBindPress(string name)
 {
+	PROFILE_SCOPE("Input");
+	PROFILE_SCOPE("Key Press");
+
 	// Check if an overlay is active
 	if (context_.overlayActive())
 	{
@@ -570,6 +586,9 @@ void Input::onKeyBindPress(string name)
  *******************************************************************/
 void Input::onKeyBindRelease(string name)
 {
+	PROFILE_SCOPE("Input");
+	PROFILE_SCOPE("Key Release");
+
 	if (name == "me2d_pan_view" && panning_)
 	{
 		panning_ = false;
@@ -1118,6 +1137,8 @@ void Input::handleKeyBind3d(const string& name) const
  *******************************************************************/
 bool Input::updateCamera3d(double mult) const
 {
+	PROFILE_SCOPE("Camera");
+
 	// --- Check for held-down keys ---
 	bool moving = false;
 	double speed = shift_down_ ? mult * 8 : mult * 4;
@@ -68,14 +68,16 @@ bool MoveObjects::begin(fpoint2_t mouse_pos)
 	items_ = context_.selection().selectionOrHilight();
 
 	// Get list of vertices being moved (if any)
-	vector<MapVertex*> move_verts;
+	vertices_.clear();
+	lines_.clear();
+	vector<MapLine*> item_lines;
 	if (context_.editMode() != Mode::Things)
 	{
 		// Vertices mode
 		if (context_.editMode() == Mode::Vertices)
 		{
 			for (auto& item : items_)
-				move_verts.push_back(context_.map().getVertex(item.index));
+				vertices_.push_back(context_.map().getVertex(item.index));
 		}
 
 		// Lines mode
@@ -83,9 +85,10 @@ bool MoveObjects::begin(fpoint2_t mouse_pos)
 		{
 			for (auto& item : items_)
 			{
-				// Duplicate vertices shouldn't matter here
-				move_verts.push_back(context_.map().getLine(item.index)->v1());
-				move_verts.push_back(context_.map().getLine(item.index)->v2());
+				auto line = context_.map().getLine(item.index);
+				vertices_.push_back(line->v1());
+				vertices_.push_back(line->v2());
+				item_lines.push_back(line);
 			}
 		}
 
@@ -93,9 +96,44 @@ bool MoveObjects::begin(fpoint2_t mouse_pos)
 		else if (context_.editMode() == Mode::Sectors)
 		{
 			for (auto& item : items_)
-				context_.map().getSector(item.index)->getVertices(move_verts);
+			{
+				auto sector = context_.map().getSector(item.index);
+				sector->getVertices(vertices_);
+				for (auto side : sector->connectedSides())
+					item_lines.push_back(side->getParentLine());
+			}
+		}
+
+		// Remove duplicate vertices and sort by index
+		std::sort(vertices_.begin(), vertices_.end());
+		vertices_.erase(std::unique(vertices_.begin(), vertices_.end()), vertices_.end());
+		std::sort(vertices_.begin(), vertices_.end(), [](MapVertex* l, MapVertex* r) { return l->getIndex() < r->getIndex(); });
+	}
+
+	// Get lines attached to the moving vertices, so only these need to be
+	// checked when drawing the move preview and when the move is finished
+	std::map<MapLine*, unsigned> line_index;
+	for (auto vertex : vertices_)
+	{
+		for (unsigned l = 0; l < vertex->nConnectedLines(); l++)
+		{
+			auto line = vertex->connectedLine(l);
+			auto ins = line_index.insert(std::make_pair(line, (unsigned)lines_.size()));
+			if (ins.second)
+				lines_.push_back({ line, false, false, false });
+
+			auto& ml = lines_[ins.first->second];
+			if (line->v1() == vertex) ml.move_v1 = true;
+			if (line->v2() == vertex) ml.move_v2 = true;
 		}
 	}
+	for (auto line : item_lines)
+	{
+		auto i = line_index.find(line);
+		if (i != line_index.end())
+			lines_[i->second].item = true;
+	}
+	std::sort(lines_.begin(), lines_.end(), [](const line_t& l, const line_t& r) { return l.line->getIndex() < r.line->getIndex(); });
 
 	// Filter out map objects being moved
 	if (context_.editMode() == Mode::Things)
@@ -107,11 +145,8 @@ bool MoveObjects::begin(fpoint2_t mouse_pos)
 	else
 	{
 		// Filter moving lines
-		for (auto vertex : move_verts)
-		{
-			for (unsigned l = 0; l < vertex->nConnectedLines(); l++)
-				vertex->connectedLine(l)->filter(true);
-		}
+		for (auto& ml : lines_)
+			ml.line->filter(true);
 	}
 
 	return true;
@@ -162,10 +197,13 @@ void MoveObjects::end(bool accept)
 	using MapEditor::Mode;
 
 	// Un-filter objects
-	for (unsigned a = 0; a < context_.map().nLines(); a++)
-		context_.map().getLine(a)->filter(false);
-	for (unsigned a = 0; a < context_.map().nThings(); a++)
-		context_.map().getThing(a)->filter(false);
+	if (context_.editMode() == Mode::Things)
+	{
+		for (auto& item : items_)
+			context_.map().getThing(item.index)->filter(false);
+	}
+	for (auto& ml : lines_)
+		ml.line->filter(false);
 
 	// Move depending on edit mode
 	if (context_.editMode() == Mode::Things && accept)
@@ -185,50 +223,15 @@ void MoveObjects::end(bool accept)
 		// Any other edit mode we're technically moving vertices
 		context_.beginUndoRecord(S_FMT("Move %s", context_.modeString()));
 
-		// Get list of vertices being moved
-		vector<uint8_t> move_verts(context_.map().nVertices());
-		memset(&move_verts[0], 0, context_.map().nVertices());
-
-		if (context_.editMode() == Mode::Vertices)
-		{
-			for (auto& item : items_)
-				move_verts[item.index] = 1;
-		}
-		else if (context_.editMode() == Mode::Lines)
-		{
-			for (auto& item : items_)
-			{
-				auto line = context_.map().getLine(item.index);
-				if (line->v1()) move_verts[line->v1()->getIndex()] = 1;
-				if (line->v2()) move_verts[line->v2()->getIndex()] = 1;
-			}
-		}
-		else if (context_.editMode() == Mode::Sectors)
-		{
-			vector<MapVertex*> sv;
-			for (auto& item : items_)
-				context_.map().getSector(item.index)->getVertices(sv);
-
-			for (auto vertex : sv)
-				move_verts[vertex->getIndex()] = 1;
-		}
-
-		// Move vertices
-		vector<MapVertex*> moved_verts;
-		for (unsigned a = 0; a < context_.map().nVertices(); a++)
-		{
-			if (!move_verts[a])
-				continue;
-
+		// Move vertices (this only resets geometry of attached lines and
+		// their sectors, so only those polygons are rebuilt afterwards)
+		for (auto vertex : vertices_)
 			context_.map().moveVertex(
-				a,
-				context_.map().getVertex(a)->xPos() + offset_.x,
-				context_.map().getVertex(a)->yPos() + offset_.y
+				vertex->getIndex(),
+				vertex->xPos() + offset_.x,
+				vertex->yPos() + offset_.y
 			);
 
-			moved_verts.push_back(context_.map().getVertex(a));
-		}
-
 		// Begin extra 'Merge' undo step if wanted
 		if (map_merge_undo_step)
 		{
@@ -237,7 +240,7 @@ void MoveObjects::end(bool accept)
 		}
 
 		// Do merge
-		bool merge = context_.map().mergeArch(moved_verts);
+		bool merge = context_.map().mergeArch(vertices_);
 
 		context_.endUndoRecord(merge || !map_merge_undo_step);
 	}
@@ -248,6 +251,8 @@ void MoveObjects::end(bool accept)
 
 	// Clear moving items
 	items_.clear();
+	vertices_.clear();
+	lines_.clear();
 
 	// Update map item indices
 	context_.map().refreshIndices();
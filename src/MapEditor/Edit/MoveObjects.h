@@ -3,14 +3,27 @@
 #include "MapEditor/MapEditor.h"
 
 class MapEditContext;
+class MapVertex;
+class MapLine;
 
 class MoveObjects
 {
 public:
+	// A line affected by the move operation
+	struct line_t
+	{
+		MapLine*	line;
+		bool		move_v1;	// First vertex is moving
+		bool		move_v2;	// Second vertex is moving
+		bool		item;		// Line is (part of) a moving item
+	};
+
 	MoveObjects(MapEditContext& context);
 
 	const vector<MapEditor::Item>&	items() const { return items_; }
-	fpoint2_t						offset() { return offset_; }
+	const vector<MapVertex*>&		vertices() const { return vertices_; }
+	const vector<line_t>&			lines() const { return lines_; }
+	fpoint2_t						offset() const { return offset_; }
 
 	bool	begin(fpoint2_t mouse_pos);
 	void	update(fpoint2_t mouse_pos);
@@ -22,4 +35,6 @@ private:
 	fpoint2_t				offset_;
 	vector<MapEditor::Item>	items_;
 	MapEditor::Item			item_closest_ = 0;
+	vector<MapVertex*>		vertices_;	// Vertices being moved, ordered by index
+	vector<line_t>			lines_;		// Lines attached to moving vertices, ordered by index
 };
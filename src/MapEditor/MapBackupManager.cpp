@@ -30,11 +30,13 @@
 #include "Main.h"
 #include "App.h"
 #include "MapBackupManager.h"
+#include "Archive/Formats/WadArchive.h"
 #include "Archive/Formats/ZipArchive.h"
 #include "General/Misc.h"
 #include "MapEditor.h"
 #include "UI/MapBackupPanel.h"
 #include "UI/SDialog.h"
+#include "Utility/Compression.h"
 
 
 /*******************************************************************
@@ -57,6 +59,217 @@ string mb_ignore_entries[] =
 	"GL_NODES"
 };
 
+namespace
+{
+	// Backup store files are a sequence of records, each one:
+	// "MBK1", uint32 header size, header (map name, timestamp, entry
+	// count, then name/size/crc/compressed size for each entry),
+	// followed by the zlib-compressed data of each entry
+	const char STORE_MAGIC[4] = { 'M', 'B', 'K', '1' };
+
+	struct record_entry_t
+	{
+		string		name;
+		uint32_t	size;
+		uint32_t	crc;
+		uint32_t	compressed_size;
+	};
+
+	struct record_t
+	{
+		string					map_name;
+		string					timestamp;
+		vector<record_entry_t>	entries;
+		wxFileOffset			offset;			// Start of the record
+		wxFileOffset			data_offset;	// Start of the entry data
+		wxFileOffset			end;
+	};
+}
+
+
+/*******************************************************************
+ * FUNCTIONS
+ *******************************************************************/
+
+/* readRecord
+ * Reads the backup record header at the current position in [file]
+ * into [record], and skips past its data. Returns false if there is
+ * no complete record there (end of file or a partially written one)
+ *******************************************************************/
+static bool readRecord(wxFile& file, record_t& record)
+{
+	record.offset = file.Tell();
+
+	char magic[4];
+	uint32_t header_size;
+	if (file.Read(magic, 4) != 4 || memcmp(magic, STORE_MAGIC, 4) != 0)
+		return false;
+	if (file.Read(&header_size, 4) != 4 || header_size == 0)
+		return false;
+
+	MemChunk header;
+	if (!header.importFileStream(file, header_size) || header.getSize() != header_size)
+		return false;
+
+	// Read header
+	header.seek(0, SEEK_SET);
+	uint32_t n_entries;
+	if (!header.readString(record.map_name) || !header.readString(record.timestamp) || !header.read(&n_entries, 4))
+		return false;
+
+	wxFileOffset data_size = 0;
+	record.entries.clear();
+	for (unsigned a = 0; a < n_entries; a++)
+	{
+		record_entry_t entry;
+		if (!header.readString(entry.name) ||
+			!header.read(&entry.size, 4) ||
+			!header.read(&entry.crc, 4) ||
+			!header.read(&entry.compressed_size, 4))
+			return false;
+
+		data_size += entry.compressed_size;
+		record.entries.push_back(entry);
+	}
+
+	// Skip data
+	record.data_offset = record.offset + 8 + header_size;
+	record.end = record.data_offset + data_size;
+	if (record.end > file.Length())
+		return false;
+	file.Seek(record.end);
+
+	return true;
+}
+
+/* readRecords
+ * Reads all complete backup record headers in [file] into [records].
+ * Returns the offset of the end of the last complete record
+ *******************************************************************/
+static wxFileOffset readRecords(wxFile& file, vector<record_t>& records)
+{
+	wxFileOffset end = 0;
+	wxFileOffset length = file.Length();
+
+	file.Seek(0);
+	while (end < length)
+	{
+		record_t record;
+		if (!readRecord(file, record))
+			break;
+
+		records.push_back(record);
+		end = record.end;
+	}
+
+	return end;
+}
+
+/* copyRecords
+ * Copies the raw data of all records in [records] that are flagged
+ * in [keep] from [in] to the end of [out]
+ *******************************************************************/
+static bool copyRecords(wxFile& in, wxFile& out, const vector<record_t>& records, const vector<bool>& keep)
+{
+	vector<char> buffer(65536);
+	for (unsigned a = 0; a < records.size(); a++)
+	{
+		if (!keep[a])
+			continue;
+
+		in.Seek(records[a].offset);
+		wxFileOffset left = records[a].end - records[a].offset;
+		while (left > 0)
+		{
+			size_t count = MIN((wxFileOffset)buffer.size(), left);
+			if (in.Read(buffer.data(), count) != (ssize_t)count || out.Write(buffer.data(), count) != count)
+				return false;
+
+			left -= count;
+		}
+	}
+
+	return true;
+}
+
+/* liveRecords
+ * Sets [live] to flag which of [records] are still in use, being the
+ * newest [max_map_backups] records for each map
+ *******************************************************************/
+static void liveRecords(const vector<record_t>& records, vector<bool>& live)
+{
+	std::map<string, int> counts;
+	live.assign(records.size(), false);
+	for (int a = (int)records.size() - 1; a >= 0; a--)
+	{
+		int& count = counts[records[a].map_name];
+		live[a] = count < max_map_backups;
+		count++;
+	}
+}
+
+/* compactStore
+ * Rewrites the store file [filename] (open as [file]) with only the
+ * [records] flagged in [keep]. [file] is closed afterwards
+ *******************************************************************/
+static bool compactStore(const string& filename, wxFile& file, const vector<record_t>& records, const vector<bool>& keep)
+{
+	string temp = filename + ".tmp";
+	wxFile out;
+	if (!out.Create(temp, true))
+	{
+		file.Close();
+		return false;
+	}
+
+	bool ok = copyRecords(file, out, records, keep);
+	out.Close();
+	file.Close();
+
+	if (!ok || !wxRenameFile(temp, filename, true))
+	{
+		wxRemoveFile(temp);
+		return false;
+	}
+
+	return true;
+}
+
+
+/*******************************************************************
+ * MAPBACKUPTHREAD CLASS
+ *******************************************************************
+ * Worker thread that writes queued backups to their store files,
+ * until the manager is stopped and there are no backups left to write
+ */
+class MapBackupThread : public wxThread
+{
+private:
+	MapBackupManager*	manager;
+
+public:
+	MapBackupThread(MapBackupManager* manager) : wxThread(wxTHREAD_JOINABLE), manager(manager) {}
+	~MapBackupThread() {}
+
+	ExitCode Entry()
+	{
+		while (true)
+		{
+			MapBackupManager::job_t* job = manager->nextJob();
+			if (!job)
+				break;
+
+			{
+				wxMutexLocker lock(manager->store_mutex);
+				MapBackupManager::processJob(job);
+			}
+			delete job;
+		}
+
+		return NULL;
+	}
+};
+
 
 /*******************************************************************
  * MAPBACKUPMANAGER CLASS FUNCTIONS
@@ -65,8 +278,10 @@ string mb_ignore_entries[] =
 /* MapBackupManager::MapBackupManager
  * MapBackupManager class constructor
  *******************************************************************/
-MapBackupManager::MapBackupManager()
+MapBackupManager::MapBackupManager() : jobs_cond(jobs_mutex)
 {
+	thread = NULL;
+	stopping = false;
 }
 
 /* MapBackupManager::~MapBackupManager
@@ -74,27 +289,97 @@ MapBackupManager::MapBackupManager()
  *******************************************************************/
 MapBackupManager::~MapBackupManager()
 {
+	finishWrites();
 }
 
-/* MapBackupManager::writeBackup
- * Writes a backup for [map_name] in [archive_name], with the map
- * data entries in [map_data]
+/* MapBackupManager::backupDir
+ * Returns the backups directory, creating it if needed
  *******************************************************************/
-bool MapBackupManager::writeBackup(vector<ArchiveEntry*>& map_data, string archive_name, string map_name)
+string MapBackupManager::backupDir()
 {
-	// Create backup directory if needed
 	string backup_dir = App::path("backups", App::Dir::User);
 	if (!wxDirExists(backup_dir)) wxMkdir(backup_dir);
 
-	// Open or create backup zip
-	ZipArchive backup;
+	return backup_dir;
+}
+
+/* MapBackupManager::storeFile
+ * Returns the path to the backup store file for [archive_name]
+ *******************************************************************/
+string MapBackupManager::storeFile(string archive_name)
+{
 	archive_name.Replace(".", "_");
-	string backup_file = backup_dir + "/" + archive_name + "_backup.zip";
-	if (!backup.open(backup_file))
-		backup.setFilename(backup_file);
+	return backupDir() + "/" + archive_name + "_backups.dat";
+}
+
+/* MapBackupManager::writeRecord
+ * Compresses [entries] and writes them as a backup record for
+ * [map_name] at the current position in [file]
+ *******************************************************************/
+bool MapBackupManager::writeRecord(wxFile& file, const string& map_name, const string& timestamp, vector<entry_t*>& entries)
+{
+	// Compress entry data
+	MemChunk header;
+	MemChunk data;
+	MemChunk compressed;
+	vector<record_entry_t> info(entries.size());
+	for (unsigned a = 0; a < entries.size(); a++)
+	{
+		MemChunk& entry_data = entries[a]->data;
+		info[a].name = entries[a]->name;
+		info[a].size = entry_data.getSize();
+		info[a].crc = entry_data.getSize() > 0 ? Misc::crc(entry_data.getData(), entry_data.getSize()) : 0;
+		info[a].compressed_size = 0;
+
+		if (entry_data.getSize() > 0)
+		{
+			compressed.clear();
+			if (!Compression::ZlibDeflate(entry_data, compressed))
+				return false;
+
+			info[a].compressed_size = compressed.getSize();
+			data.write(compressed.getData(), compressed.getSize());
+		}
+	}
+
+	// Write header
+	uint32_t n_entries = entries.size();
+	header.writeString(map_name);
+	header.writeString(timestamp);
+	header.write(&n_entries, 4);
+	for (unsigned a = 0; a < info.size(); a++)
+	{
+		header.writeString(info[a].name);
+		header.write(&info[a].size, 4);
+		header.write(&info[a].crc, 4);
+		header.write(&info[a].compressed_size, 4);
+	}
 
-	// Filter ignored entries
-	vector<ArchiveEntry*> backup_entries;
+	uint32_t header_size = header.getSize();
+	if (file.Write(STORE_MAGIC, 4) != 4 ||
+		file.Write(&header_size, 4) != 4 ||
+		file.Write(header.getData(), header_size) != header_size)
+		return false;
+	if (data.getSize() > 0 && file.Write(data.getData(), data.getSize()) != data.getSize())
+		return false;
+
+	return true;
+}
+
+/* MapBackupManager::writeBackup
+ * Writes a backup for [map_name] in [archive_name], with the map
+ * data entries in [map_data]. The data is copied and queued to be
+ * written on the backup thread, so this returns immediately
+ *******************************************************************/
+bool MapBackupManager::writeBackup(vector<ArchiveEntry*>& map_data, string archive_name, string map_name)
+{
+	job_t* job = new job_t();
+	job->store_file = storeFile(archive_name);
+	job->map_name = map_name;
+	job->timestamp = wxDateTime::Now().FormatISOCombined('_');
+	job->timestamp.Replace(":", "");
+
+	// Copy map data, filtering ignored entries
 	for (unsigned a = 0; a < map_data.size(); a++)
 	{
 		// Check for ignored entry
@@ -108,65 +393,308 @@ bool MapBackupManager::writeBackup(vector<ArchiveEntry*>& map_data, string archi
 			}
 		}
 
-		if (!ignored)
-			backup_entries.push_back(map_data[a]);
+		if (ignored)
+			continue;
+
+		entry_t* entry = new entry_t();
+		entry->name = map_data[a]->getName();
+		if (map_data[a]->getSize() > 0)
+			entry->data.importMem(map_data[a]->getData(), map_data[a]->getSize());
+		job->entries.push_back(entry);
 	}
 
-	// Compare with last backup (if any)
-	ArchiveTreeNode* map_dir = backup.getDir(map_name);
-	if (map_dir && map_dir->nChildren() > 0)
+	// Queue job, starting the backup thread if needed
+	wxMutexLocker lock(jobs_mutex);
+	if (!thread)
 	{
-		ArchiveTreeNode* last_backup = (ArchiveTreeNode*)map_dir->getChild(map_dir->nChildren() - 1);
-		bool same = true;
-		if (last_backup->numEntries() != backup_entries.size())
-			same = false;
-		else
+		stopping = false;
+		thread = new MapBackupThread(this);
+		if (thread->Run() != wxTHREAD_NO_ERROR)
 		{
-			for (unsigned a = 0; a < last_backup->numEntries(); a++)
-			{
-				ArchiveEntry* e1 = backup_entries[a];
-				ArchiveEntry* e2 = last_backup->entryAt(a);
-				if (e1->getSize() != e2->getSize())
-				{
-					same = false;
-					break;
-				}
-
-				uint32_t crc1 = Misc::crc(e1->getData(), e1->getSize());
-				uint32_t crc2 = Misc::crc(e2->getData(), e2->getSize());
-				if (crc1 != crc2)
-				{
-					same = false;
-					break;
-				}
-			}
+			delete thread;
+			thread = NULL;
+			delete job;
+			return false;
 		}
+	}
+	jobs.push_back(job);
+	jobs_cond.Broadcast();
 
-		if (same)
+	return true;
+}
+
+/* MapBackupManager::nextJob
+ * Waits for and returns the next backup to write, or NULL if the
+ * manager is stopping and all backups have been written. Called
+ * from the backup thread
+ *******************************************************************/
+MapBackupManager::job_t* MapBackupManager::nextJob()
+{
+	wxMutexLocker lock(jobs_mutex);
+	while (jobs.empty() && !stopping)
+		jobs_cond.Wait();
+
+	if (jobs.empty())
+		return NULL;
+
+	job_t* job = jobs.front();
+	jobs.pop_front();
+	return job;
+}
+
+/* MapBackupManager::processJob
+ * Appends the backup in [job] to its store file, unless it is the
+ * same as the previous backup of the map. Also compacts the store
+ * file if most of it is old backups or it has a partially written
+ * record at the end. Called from the backup thread (with the store
+ * mutex locked), so nothing here may touch the UI or log
+ *******************************************************************/
+bool MapBackupManager::processJob(job_t* job)
+{
+	// Open or create store file
+	wxFile file;
+	if (!wxFileExists(job->store_file))
+		wxFile().Create(job->store_file);
+	if (!file.Open(job->store_file, wxFile::read_write))
+		return false;
+
+	vector<record_t> records;
+	wxFileOffset end = readRecords(file, records);
+
+	// Compare with last backup of the map (if any)
+	for (int a = (int)records.size() - 1; a >= 0; a--)
+	{
+		if (records[a].map_name != job->map_name)
+			continue;
+
+		bool same = records[a].entries.size() == job->entries.size();
+		for (unsigned b = 0; same && b < job->entries.size(); b++)
 		{
-			LOG_MESSAGE(2, "Same data as previous backup - ignoring");
+			MemChunk& data = job->entries[b]->data;
+			const record_entry_t& entry = records[a].entries[b];
+			if (entry.name != job->entries[b]->name || entry.size != data.getSize())
+				same = false;
+			else if (data.getSize() > 0 && entry.crc != Misc::crc(data.getData(), data.getSize()))
+				same = false;
+		}
+
+		if (same)
 			return true;
+
+		break;
+	}
+
+	// Drop a partially written record (eg. from a crash) at the end
+	// of the file, by rewriting the complete ones
+	vector<bool> keep;
+	if (end < file.Length())
+	{
+		keep.assign(records.size(), true);
+		if (!compactStore(job->store_file, file, records, keep) ||
+			!file.Open(job->store_file, wxFile::read_write))
+			return false;
+	}
+
+	// Append backup
+	file.SeekEnd();
+	record_t record;
+	record.map_name = job->map_name;
+	record.offset = file.Tell();
+	if (!writeRecord(file, job->map_name, job->timestamp, job->entries))
+		return false;
+	record.end = file.Tell();
+	records.push_back(record);
+
+	// Compact the file once old backups take up more than half of it
+	liveRecords(records, keep);
+	wxFileOffset dead = 0;
+	for (unsigned a = 0; a < records.size(); a++)
+	{
+		if (!keep[a])
+			dead += records[a].end - records[a].offset;
+	}
+	if (dead > 0 && dead * 2 > record.end)
+		return compactStore(job->store_file, file, records, keep);
+
+	return true;
+}
+
+/* MapBackupManager::finishWrites
+ * Waits for all queued backups to be written and stops the backup
+ * thread (it is restarted by the next writeBackup call)
+ *******************************************************************/
+void MapBackupManager::finishWrites()
+{
+	{
+		wxMutexLocker lock(jobs_mutex);
+		if (!thread)
+			return;
+
+		stopping = true;
+		jobs_cond.Broadcast();
+	}
+
+	thread->Wait();
+	delete thread;
+	thread = NULL;
+}
+
+/* MapBackupManager::importLegacyBackups
+ * Moves any backups for [archive_name] from the old format (a zip
+ * with a directory per backup) into the backup store, before any
+ * backups already in the store. The zip is renamed afterwards rather
+ * than deleted. Must be called with the store mutex locked
+ *******************************************************************/
+void MapBackupManager::importLegacyBackups(string archive_name)
+{
+	archive_name.Replace(".", "_");
+	string zip_file = backupDir() + "/" + archive_name + "_backup.zip";
+	if (!wxFileExists(zip_file))
+		return;
+
+	ZipArchive zip;
+	if (!zip.open(zip_file))
+		return;
+
+	LOG_MESSAGE(1, "Importing map backups from %s", zip_file);
+
+	// Write legacy backups to a new store file
+	string store_file = storeFile(archive_name);
+	string temp = store_file + ".tmp";
+	wxFile out;
+	if (!out.Create(temp, true))
+		return;
+
+	bool ok = true;
+	ArchiveTreeNode* root = zip.rootDir();
+	for (unsigned a = 0; ok && a < root->nChildren(); a++)
+	{
+		ArchiveTreeNode* map_dir = (ArchiveTreeNode*)root->getChild(a);
+		for (unsigned b = 0; ok && b < map_dir->nChildren(); b++)
+		{
+			ArchiveTreeNode* dir = (ArchiveTreeNode*)map_dir->getChild(b);
+
+			job_t backup;
+			for (unsigned c = 0; c < dir->numEntries(); c++)
+			{
+				ArchiveEntry* entry = dir->entryAt(c);
+				entry_t* data = new entry_t();
+				data->name = entry->getName();
+				if (entry->getSize() > 0)
+					data->data.importMem(entry->getData(), entry->getSize());
+				backup.entries.push_back(data);
+			}
+
+			ok = writeRecord(out, map_dir->getName(), dir->getName(), backup.entries);
 		}
 	}
+	zip.close();
+
+	// Add existing backups after them
+	if (ok && wxFileExists(store_file))
+	{
+		wxFile in(store_file);
+		vector<record_t> records;
+		readRecords(in, records);
+		ok = copyRecords(in, out, records, vector<bool>(records.size(), true));
+	}
+	out.Close();
+
+	if (!ok || !wxRenameFile(temp, store_file, true))
+	{
+		LOG_MESSAGE(1, "Error: Unable to import map backups from %s", zip_file);
+		wxRemoveFile(temp);
+		return;
+	}
+
+	wxRenameFile(zip_file, backupDir() + "/" + archive_name + "_backup_old.zip", true);
+}
+
+/* MapBackupManager::getBackups
+ * Adds all backups of [map_name] in [archive_name] to [list], oldest
+ * first. Only backup headers are read, not the map data. Returns
+ * false if there are no backups
+ *******************************************************************/
+bool MapBackupManager::getBackups(string archive_name, string map_name, vector<backup_t>& list)
+{
+	wxMutexLocker lock(store_mutex);
+
+	importLegacyBackups(archive_name);
+
+	wxFile file;
+	string store_file = storeFile(archive_name);
+	if (!wxFileExists(store_file) || !file.Open(store_file))
+		return false;
+
+	vector<record_t> records;
+	vector<bool> live;
+	readRecords(file, records);
+	liveRecords(records, live);
+
+	for (unsigned a = 0; a < records.size(); a++)
+	{
+		if (!live[a] || records[a].map_name != map_name)
+			continue;
+
+		backup_t backup;
+		backup.map_name = records[a].map_name;
+		backup.timestamp = records[a].timestamp;
+		backup.offset = records[a].offset;
+		list.push_back(backup);
+	}
+
+	return !list.empty();
+}
 
-	// Add map data to backup
-	string timestamp = wxDateTime::Now().FormatISOCombined('_');
-	timestamp.Replace(":", "");
-	string dir = map_name + "/" + timestamp;
-	for (unsigned a = 0; a < backup_entries.size(); a++)
-		backup.addEntry(backup_entries[a], dir, true);
+/* MapBackupManager::readBackup
+ * Reads the map data of [backup] in [archive_name] into a new
+ * WadArchive. Returns NULL if the backup couldn't be read
+ *******************************************************************/
+Archive* MapBackupManager::readBackup(string archive_name, const backup_t& backup)
+{
+	wxMutexLocker lock(store_mutex);
+
+	wxFile file;
+	string store_file = storeFile(archive_name);
+	if (!wxFileExists(store_file) || !file.Open(store_file))
+		return NULL;
+
+	// Read record header
+	record_t record;
+	file.Seek(backup.offset);
+	if (!readRecord(file, record) || record.map_name != backup.map_name || record.timestamp != backup.timestamp)
+		return NULL;
+
+	// Read and decompress entries
+	WadArchive* archive = new WadArchive();
+	file.Seek(record.data_offset);
+	MemChunk compressed;
+	MemChunk data;
+	for (unsigned a = 0; a < record.entries.size(); a++)
+	{
+		const record_entry_t& info = record.entries[a];
+		ArchiveEntry* entry = new ArchiveEntry(info.name);
 
-	// Check for max backups & remove old ones if over
-	map_dir = backup.getDir(map_name);
-	while ((int)map_dir->nChildren() > max_map_backups)
-		backup.removeDir(map_dir->getChild(0)->getName(), map_dir);
+		if (info.compressed_size > 0)
+		{
+			compressed.clear();
+			data.clear();
+			if (!compressed.importFileStream(file, info.compressed_size) ||
+				!Compression::ZlibInflate(compressed, data, info.size) ||
+				data.getSize() != info.size)
+			{
+				delete entry;
+				delete archive;
+				return NULL;
+			}
 
-	// Save backup file
-	Archive::save_backup = false;
-	bool ok = backup.save();
-	Archive::save_backup = true;
+			entry->importMemChunk(data);
+		}
+
+		archive->addEntry(entry, "");
+	}
 
-	return ok;
+	return archive;
 }
 
 /* MapBackupManager::openBackp
@@ -2,18 +2,74 @@
 #ifndef __MAP_BACKUP_MANAGER_H__
 #define __MAP_BACKUP_MANAGER_H__
 
+#include "common.h"
+#include <deque>
+
 class ArchiveEntry;
 class Archive;
+
+// Keeps map backups in an append-only store file per archive. New
+// backups are compressed and appended on a background thread, so
+// saving a map never waits on rewriting the whole backup file. Old
+// backups beyond max_map_backups are hidden from listings straight
+// away, but only removed from the file once enough of it is unused
 class MapBackupManager
 {
-private:
-
+	friend class MapBackupThread;
 public:
+	// A backup in a store file, only the record header is read when
+	// listing backups, the map data is read on demand by readBackup
+	struct backup_t
+	{
+		string			map_name;
+		string			timestamp;
+		wxFileOffset	offset;		// Start of the backup record in the store file
+	};
+
 	MapBackupManager();
 	~MapBackupManager();
 
 	bool		writeBackup(vector<ArchiveEntry*>& map_data, string archive_name, string map_name);
 	Archive*	openBackup(string archive_name, string map_name);
+	bool		getBackups(string archive_name, string map_name, vector<backup_t>& list);
+	Archive*	readBackup(string archive_name, const backup_t& backup);
+	void		finishWrites();
+
+private:
+	struct entry_t
+	{
+		string		name;
+		MemChunk	data;
+	};
+
+	struct job_t
+	{
+		string				store_file;
+		string				map_name;
+		string				timestamp;
+		vector<entry_t*>	entries;
+
+		~job_t()
+		{
+			for (unsigned a = 0; a < entries.size(); a++)
+				delete entries[a];
+		}
+	};
+
+	wxThread*			thread;
+	wxMutex				jobs_mutex;
+	wxCondition			jobs_cond;
+	std::deque<job_t*>	jobs;
+	bool				stopping;
+	wxMutex				store_mutex;	// Held while reading/writing any store file
+
+	job_t*	nextJob();
+	void	importLegacyBackups(string archive_name);
+
+	static string	backupDir();
+	static string	storeFile(string archive_name);
+	static bool		writeRecord(wxFile& file, const string& map_name, const string& timestamp, vector<entry_t*>& entries);
+	static bool		processJob(job_t* job);
 };
 
 #endif//__MAP_BACKUP_MANAGER_H__
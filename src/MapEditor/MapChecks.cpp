@@ -42,6 +42,70 @@
 #include "Utility/MathStuff.h"
 
 
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+CVAR(Int, map_check_threads, 0, CVAR_SAVE)
+
+
+/*******************************************************************
+ * FUNCTIONS
+ *******************************************************************/
+
+/* overlappingBoxes
+ * Finds all pairs of boxes in [boxes] that overlap (including just
+ * touching), adding them to [pairs] as (lower index, higher index).
+ * The pairs are sorted, so they are in the same order as comparing
+ * every box against every later box would find them. This does a
+ * sort-and-sweep along the x axis, so only boxes that overlap on x
+ * are actually compared
+ *******************************************************************/
+static void overlappingBoxes(const vector<bbox_t>& boxes, vector<std::pair<unsigned, unsigned>>& pairs)
+{
+	// Sort boxes by left edge
+	vector<unsigned> order(boxes.size());
+	for (unsigned a = 0; a < boxes.size(); a++)
+		order[a] = a;
+	std::sort(order.begin(), order.end(), [&](unsigned left, unsigned right)
+	{
+		return boxes[left].min.x < boxes[right].min.x;
+	});
+
+	// Sweep
+	vector<unsigned> active;
+	for (unsigned a = 0; a < order.size(); a++)
+	{
+		const bbox_t& box = boxes[order[a]];
+
+		// Drop boxes that end before this one starts
+		unsigned n_active = 0;
+		for (unsigned b = 0; b < active.size(); b++)
+		{
+			if (boxes[active[b]].max.x >= box.min.x)
+				active[n_active++] = active[b];
+		}
+		active.resize(n_active);
+
+		// Remaining boxes overlap on x, check y
+		for (unsigned b = 0; b < active.size(); b++)
+		{
+			const bbox_t& other = boxes[active[b]];
+			if (other.max.y < box.min.y || other.min.y > box.max.y)
+				continue;
+
+			if (active[b] < order[a])
+				pairs.push_back(std::make_pair(active[b], order[a]));
+			else
+				pairs.push_back(std::make_pair(order[a], active[b]));
+		}
+
+		active.push_back(order[a]);
+	}
+
+	std::sort(pairs.begin(), pairs.end());
+}
+
+
 /*******************************************************************
  * MISSINGTEXTURECHECK CLASS
  *******************************************************************
@@ -123,8 +187,6 @@ public:
 				}
 			}
 		}
-
-		LOG_MESSAGE(3, "Missing Texture Check: %lu missing textures", parts.size());
 	}
 
 	unsigned nProblems() override
@@ -277,8 +339,8 @@ public:
 					continue;
 
 				// Get special and tag
-				int special = map->getThing(a)->intProperty("special");
-				int tag = map->getThing(a)->intProperty("arg0");
+				int special = map->getThing(a)->intProp(MobjKeys::special);
+				int tag = map->getThing(a)->intProp(MobjKeys::arg0);
 
 				// Get action special
 				auto tagged = Game::configuration().actionSpecial(special).needsTag();
@@ -518,20 +580,27 @@ public:
 		// Clear existing intersections
 		intersections.clear();
 
-		// Go through lines
+		// Get line bounding boxes
+		vector<bbox_t> boxes(lines.size());
 		for (unsigned a = 0; a < lines.size(); a++)
 		{
-			line1 = lines[a];
+			boxes[a].min.set(MIN(lines[a]->x1(), lines[a]->x2()), MIN(lines[a]->y1(), lines[a]->y2()));
+			boxes[a].max.set(MAX(lines[a]->x1(), lines[a]->x2()), MAX(lines[a]->y1(), lines[a]->y2()));
+		}
 
-			// Go through uncompared lines
-			for (unsigned b = a + 1; b < lines.size(); b++)
-			{
-				line2 = lines[b];
+		// Lines can only intersect if their bounding boxes overlap
+		vector<std::pair<unsigned, unsigned>> pairs;
+		overlappingBoxes(boxes, pairs);
 
-				// Check intersection
-				if (map->linesIntersect(line1, line2, x, y))
-					intersections.push_back(line_intersect_t(line1, line2, x, y));
-			}
+		// Go through possibly intersecting lines
+		for (unsigned a = 0; a < pairs.size(); a++)
+		{
+			line1 = lines[pairs[a].first];
+			line2 = lines[pairs[a].second];
+
+			// Check intersection
+			if (map->linesIntersect(line1, line2, x, y))
+				intersections.push_back(line_intersect_t(line1, line2, x, y));
 		}
 	}
 
@@ -659,22 +728,33 @@ public:
 
 	void doCheck() override
 	{
-		// Go through lines
+		// Group lines by the vertices they share (in either direction)
+		std::map<std::pair<MapVertex*, MapVertex*>, vector<unsigned>> groups;
 		for (unsigned a = 0; a < map->nLines(); a++)
 		{
-			MapLine* line1 = map->getLine(a);
+			MapLine* line = map->getLine(a);
+			if (line->v1() < line->v2())
+				groups[std::make_pair(line->v1(), line->v2())].push_back(a);
+			else
+				groups[std::make_pair(line->v2(), line->v1())].push_back(a);
+		}
 
-			// Go through uncompared lines
-			for (unsigned b = a + 1; b < map->nLines(); b++)
+		// Any lines in the same group overlap
+		vector<std::pair<unsigned, unsigned>> pairs;
+		for (auto i = groups.begin(); i != groups.end(); ++i)
+		{
+			vector<unsigned>& group = i->second;
+			for (unsigned a = 0; a < group.size(); a++)
 			{
-				MapLine* line2 = map->getLine(b);
-
-				// Check for overlap (both vertices shared)
-				if ((line1->v1() == line2->v1() && line1->v2() == line2->v2()) ||
-					(line1->v2() == line2->v1() && line1->v1() == line2->v2()))
-					overlaps.push_back(line_overlap_t(line1, line2));
+				for (unsigned b = a + 1; b < group.size(); b++)
+					pairs.push_back(std::make_pair(group[a], group[b]));
 			}
 		}
+
+		// Add in line order
+		std::sort(pairs.begin(), pairs.end());
+		for (unsigned a = 0; a < pairs.size(); a++)
+			overlaps.push_back(line_overlap_t(map->getLine(pairs[a].first), map->getLine(pairs[a].second)));
 	}
 
 	unsigned nProblems() override
@@ -774,139 +854,149 @@ public:
 	void doCheck() override
 	{
 		double r1, r2;
-
-		// Go through things
+		int map_format = map->currentFormat();
+		bool udmf_zdoom = (map_format == MAP_UDMF && S_CMPNOCASE(Game::configuration().udmfNamespace(), "zdoom"));
+		bool udmf_eternity = (map_format == MAP_UDMF && S_CMPNOCASE(Game::configuration().udmfNamespace(), "eternity"));
+		int min_skill = udmf_zdoom || udmf_eternity ? 1 : 2;
+		int max_skill = udmf_zdoom ? 17 : 5;
+		int max_class = udmf_zdoom ? 17 : 4;
+
+		// Get bounding boxes of solid things with a radius
+		vector<unsigned> solid_things;
+		vector<bbox_t> boxes;
 		for (unsigned a = 0; a < map->nThings(); a++)
 		{
-			MapThing* thing1 = map->getThing(a);
-			auto& tt1 = Game::configuration().thingType(thing1->getType());
-			r1 = tt1.radius() - 1;
+			MapThing* thing = map->getThing(a);
+			auto& tt = Game::configuration().thingType(thing->getType());
+			double r = tt.radius() - 1;
 
 			// Ignore if no radius
-			if (r1 < 0 || !tt1.solid())
+			if (r < 0 || !tt.solid())
 				continue;
 
-			// Go through uncompared things
-			int map_format = map->currentFormat();
-			bool udmf_zdoom = (map_format == MAP_UDMF && S_CMPNOCASE(Game::configuration().udmfNamespace(), "zdoom"));
-			bool udmf_eternity = (map_format == MAP_UDMF && S_CMPNOCASE(Game::configuration().udmfNamespace(), "eternity"));
-			int min_skill = udmf_zdoom || udmf_eternity ? 1 : 2;
-			int max_skill = udmf_zdoom ? 17 : 5;
-			int max_class = udmf_zdoom ? 17 : 4;
+			bbox_t box;
+			box.min.set(thing->xPos() - r, thing->yPos() - r);
+			box.max.set(thing->xPos() + r, thing->yPos() + r);
+			boxes.push_back(box);
+			solid_things.push_back(a);
+		}
 
-			for (unsigned b = a + 1; b < map->nThings(); b++)
-			{
-				MapThing* thing2 = map->getThing(b);
-				auto& tt2 = Game::configuration().thingType(thing2->getType());
-				r2 = tt2.radius() - 1;
+		// Get pairs of things with overlapping bounding boxes
+		vector<std::pair<unsigned, unsigned>> pairs;
+		overlappingBoxes(boxes, pairs);
 
-				// Ignore if no radius
-				if (r2 < 0 || !tt2.solid())
-					continue;
+		// Go through overlapping things
+		for (unsigned a = 0; a < pairs.size(); a++)
+		{
+			MapThing* thing1 = map->getThing(solid_things[pairs[a].first]);
+			MapThing* thing2 = map->getThing(solid_things[pairs[a].second]);
+			auto& tt1 = Game::configuration().thingType(thing1->getType());
+			auto& tt2 = Game::configuration().thingType(thing2->getType());
+			r1 = tt1.radius() - 1;
+			r2 = tt2.radius() - 1;
 
-				// Check flags
-				// Case #1: different skill levels
-				bool shareflag = false;
-				for (int s = min_skill; s < max_skill; ++s)
+			// Check flags
+			// Case #1: different skill levels
+			bool shareflag = false;
+			for (int s = min_skill; s < max_skill; ++s)
+			{
+				string skill = S_FMT("skill%d", s);
+				if (Game::configuration().thingBasicFlagSet(skill, thing1, map_format) && 
+					Game::configuration().thingBasicFlagSet(skill, thing2, map_format))
 				{
-					string skill = S_FMT("skill%d", s);
-					if (Game::configuration().thingBasicFlagSet(skill, thing1, map_format) && 
-						Game::configuration().thingBasicFlagSet(skill, thing2, map_format))
-					{
-						shareflag = true;
-						s = max_skill;
-					}
+					shareflag = true;
+					s = max_skill;
 				}
-				if (!shareflag)
-					continue;
+			}
+			if (!shareflag)
+				continue;
 
-				// Booleans for single, coop, deathmatch, and teamgame status for each thing
-				bool s1, s2, c1, c2, d1, d2, t1, t2;
-				s1 = Game::configuration().thingBasicFlagSet("single", thing1, map_format);
-				s2 = Game::configuration().thingBasicFlagSet("single", thing2, map_format);
-				c1 = Game::configuration().thingBasicFlagSet("coop", thing1, map_format);
-				c2 = Game::configuration().thingBasicFlagSet("coop", thing2, map_format);
-				d1 = Game::configuration().thingBasicFlagSet("dm", thing1, map_format);
-				d2 = Game::configuration().thingBasicFlagSet("dm", thing2, map_format);
-
-				// Player starts
-				// P1 are automatically S and C; P2+ are automatically C;
-				// Deathmatch starts are automatically D, and team start are T.
-				if (tt1.flags() & Game::ThingType::FLAG_COOPSTART)
-				{
-					c1 = true; d1 = t1 = false;
-					if (thing1->getType() == 1)
-						s1 = true;
-					else s1 = false;
-				}
-				else if (tt1.flags() & Game::ThingType::FLAG_DMSTART)
-				{
-					s1 = c1 = t1 = false; d1 = true;
-				}
-				else if (tt1.flags() & Game::ThingType::FLAG_TEAMSTART)
-				{
-					s1 = c1 = d1 = false; t1 = true;
-				}
-				if (tt2.flags() & Game::ThingType::FLAG_COOPSTART)
-				{
-					c2 = true; d2 = t2 = false;
-					if (thing2->getType() == 1)
-						s2 = true;
-					else s2 = false;
-				}
-				else if (tt2.flags() & Game::ThingType::FLAG_DMSTART)
-				{
-					s2 = c2 = t2 = false; d2 = true;
-				}
-				else if (tt2.flags() & Game::ThingType::FLAG_TEAMSTART)
-				{
-					s2 = c2 = d2 = false; t2 = true;
-				}
+			// Booleans for single, coop, deathmatch, and teamgame status for each thing
+			bool s1, s2, c1, c2, d1, d2, t1, t2;
+			s1 = Game::configuration().thingBasicFlagSet("single", thing1, map_format);
+			s2 = Game::configuration().thingBasicFlagSet("single", thing2, map_format);
+			c1 = Game::configuration().thingBasicFlagSet("coop", thing1, map_format);
+			c2 = Game::configuration().thingBasicFlagSet("coop", thing2, map_format);
+			d1 = Game::configuration().thingBasicFlagSet("dm", thing1, map_format);
+			d2 = Game::configuration().thingBasicFlagSet("dm", thing2, map_format);
+
+			// Player starts
+			// P1 are automatically S and C; P2+ are automatically C;
+			// Deathmatch starts are automatically D, and team start are T.
+			if (tt1.flags() & Game::ThingType::FLAG_COOPSTART)
+			{
+				c1 = true; d1 = t1 = false;
+				if (thing1->getType() == 1)
+					s1 = true;
+				else s1 = false;
+			}
+			else if (tt1.flags() & Game::ThingType::FLAG_DMSTART)
+			{
+				s1 = c1 = t1 = false; d1 = true;
+			}
+			else if (tt1.flags() & Game::ThingType::FLAG_TEAMSTART)
+			{
+				s1 = c1 = d1 = false; t1 = true;
+			}
+			if (tt2.flags() & Game::ThingType::FLAG_COOPSTART)
+			{
+				c2 = true; d2 = t2 = false;
+				if (thing2->getType() == 1)
+					s2 = true;
+				else s2 = false;
+			}
+			else if (tt2.flags() & Game::ThingType::FLAG_DMSTART)
+			{
+				s2 = c2 = t2 = false; d2 = true;
+			}
+			else if (tt2.flags() & Game::ThingType::FLAG_TEAMSTART)
+			{
+				s2 = c2 = d2 = false; t2 = true;
+			}
 
-				// Case #2: different game modes (single, coop, dm)
-				shareflag = false;
-				if ((c1 && c2)||(d1 && d2)||(t1 && t2))
-				{
-					shareflag = true;
-				}
-				if (!shareflag && s1 && s2)
+			// Case #2: different game modes (single, coop, dm)
+			shareflag = false;
+			if ((c1 && c2)||(d1 && d2)||(t1 && t2))
+			{
+				shareflag = true;
+			}
+			if (!shareflag && s1 && s2)
+			{
+				// Case #3: things flagged for single player with different class filters
+				for (int c = 1; c < max_class; ++c)
 				{
-					// Case #3: things flagged for single player with different class filters
-					for (int c = 1; c < max_class; ++c)
+					string pclass = S_FMT("class%d", c);
+					if (Game::configuration().thingBasicFlagSet(pclass, thing1, map_format) && 
+						Game::configuration().thingBasicFlagSet(pclass, thing2, map_format))
 					{
-						string pclass = S_FMT("class%d", c);
-						if (Game::configuration().thingBasicFlagSet(pclass, thing1, map_format) && 
-							Game::configuration().thingBasicFlagSet(pclass, thing2, map_format))
-						{
-							shareflag = true;
-							c = max_class;
-						}
+						shareflag = true;
+						c = max_class;
 					}
 				}
-				if (!shareflag)
-					continue;
+			}
+			if (!shareflag)
+				continue;
 
-				// Also check player start spots in Hexen-style hubs
-				shareflag = false;
-				if (tt1.flags() & Game::ThingType::FLAG_COOPSTART && tt2.flags() & Game::ThingType::FLAG_COOPSTART)
-				{
-					if (thing1->intProperty("arg0") == thing2->intProperty("arg0"))
-						shareflag = true;
-				}
-				if (!shareflag)
-					continue;
+			// Also check player start spots in Hexen-style hubs
+			shareflag = false;
+			if (tt1.flags() & Game::ThingType::FLAG_COOPSTART && tt2.flags() & Game::ThingType::FLAG_COOPSTART)
+			{
+				if (thing1->intProp(MobjKeys::arg0) == thing2->intProp(MobjKeys::arg0))
+					shareflag = true;
+			}
+			if (!shareflag)
+				continue;
 
-				// Check x non-overlap
-				if (thing2->xPos() + r2 < thing1->xPos() - r1 || thing2->xPos() - r2 > thing1->xPos() + r1)
-					continue;
+			// Check x non-overlap
+			if (thing2->xPos() + r2 < thing1->xPos() - r1 || thing2->xPos() - r2 > thing1->xPos() + r1)
+				continue;
 
-				// Check y non-overlap
-				if (thing2->yPos() + r2 < thing1->yPos() - r1 || thing2->yPos() - r2 > thing1->yPos() + r1)
-					continue;
+			// Check y non-overlap
+			if (thing2->yPos() + r2 < thing1->yPos() - r1 || thing2->yPos() - r2 > thing1->yPos() + r1)
+				continue;
 
-				// Overlap detected
-				overlaps.push_back(thing_overlap_t(thing1, thing2));
-			}
+			// Overlap detected
+			overlaps.push_back(thing_overlap_t(thing1, thing2));
 		}
 	}
 
@@ -1004,6 +1094,12 @@ public:
 		this->texman = texman;
 	}
 
+	bool canRunInThread() override
+	{
+		// The texture manager loads textures on demand
+		return false;
+	}
+
 	void doCheck() override
 	{
 		bool mixed = Game::configuration().featureSupported(Game::Feature::MixTexFlats);
@@ -1205,6 +1301,12 @@ public:
 		this->texman = texman;
 	}
 
+	bool canRunInThread() override
+	{
+		// The texture manager loads textures on demand
+		return false;
+	}
+
 	void doCheck() override
 	{
 		bool mixed = Game::configuration().featureSupported(Game::Feature::MixTexFlats);
@@ -1900,7 +2002,7 @@ public:
 					continue;
 
 				// Otherwise, check special
-				int special = map->getThing(a)->intProperty("special");
+				int special = map->getThing(a)->intProp(MobjKeys::special);
 				if (S_CMP(Game::configuration().actionSpecialName(special), "Unknown"))
 					objects.push_back(map->getThing(a));
 			}
@@ -2163,3 +2265,203 @@ MapCheck* MapCheck::obsoleteThingCheck(SLADEMap* map)
 {
 	return new ObsoleteThingCheck(map);
 }
+
+
+/*******************************************************************
+ * MAPCHECKTHREAD CLASS
+ *******************************************************************
+ * Worker thread that runs queued checks for a MapCheckRunner until
+ * there are none left
+ */
+class MapCheckThread : public wxThread
+{
+private:
+	MapCheckRunner*	runner;
+
+public:
+	MapCheckThread(MapCheckRunner* runner) : wxThread(wxTHREAD_JOINABLE), runner(runner) {}
+	~MapCheckThread() {}
+
+	ExitCode Entry()
+	{
+		int index;
+		while ((index = runner->takeQueued()) >= 0)
+			runner->runCheck(index);
+
+		return NULL;
+	}
+};
+
+
+/*******************************************************************
+ * MAPCHECKRUNNER CLASS FUNCTIONS
+ *******************************************************************/
+
+/* MapCheckRunner::MapCheckRunner
+ * MapCheckRunner class constructor
+ *******************************************************************/
+MapCheckRunner::MapCheckRunner(SLADEMap* map, const vector<MapCheck*>& checks) : done_cond(mutex)
+{
+	this->map = map;
+	this->checks = checks;
+	this->queue_next = 0;
+	this->next_result = 0;
+	times.resize(checks.size(), -1);
+
+	for (unsigned a = 0; a < checks.size(); a++)
+	{
+		if (checks[a]->canRunInThread())
+			queue.push_back(a);
+	}
+}
+
+/* MapCheckRunner::~MapCheckRunner
+ * MapCheckRunner class destructor
+ *******************************************************************/
+MapCheckRunner::~MapCheckRunner()
+{
+	// Don't start any more checks
+	{
+		wxMutexLocker lock(mutex);
+		queue_next = queue.size();
+	}
+
+	stopThreads();
+}
+
+/* MapCheckRunner::start
+ * Starts running the checks. Any lazily cached map geometry is
+ * calculated first so that the checks never modify the map while
+ * reading it
+ *******************************************************************/
+void MapCheckRunner::start()
+{
+	timer.Start();
+	map->precacheGeometry();
+
+	// Start worker threads (0 = one per cpu)
+	int count = map_check_threads;
+	if (count <= 0)
+		count = wxThread::GetCPUCount();
+	if (count > (int)queue.size())
+		count = queue.size();
+	for (int a = 0; a < count; a++)
+	{
+		wxThread* thread = new MapCheckThread(this);
+		if (thread->Run() != wxTHREAD_NO_ERROR)
+		{
+			delete thread;
+			continue;
+		}
+		threads.push_back(thread);
+	}
+}
+
+/* MapCheckRunner::waitNext
+ * Waits for the next check (in the original order) to complete and
+ * returns its index, or -1 if all checks are complete. Checks that
+ * can't run in a worker thread are run here, and queued checks are
+ * also picked up while waiting if no worker has started them yet.
+ * Must be called from the main thread
+ *******************************************************************/
+int MapCheckRunner::waitNext()
+{
+	if (next_result >= checks.size())
+	{
+		stopThreads();
+		return -1;
+	}
+
+	unsigned index = next_result++;
+	while (true)
+	{
+		// Check if it's done
+		{
+			wxMutexLocker lock(mutex);
+			if (times[index] >= 0)
+				return index;
+		}
+
+		// Run the next main thread check, if any (times for these are
+		// only ever written by this thread, so no need to lock)
+		int main_check = -1;
+		for (unsigned a = index; a < checks.size(); a++)
+		{
+			if (!checks[a]->canRunInThread() && times[a] < 0)
+			{
+				main_check = a;
+				break;
+			}
+		}
+		if (main_check >= 0)
+		{
+			runCheck(main_check);
+			continue;
+		}
+
+		// Help out with any queued checks
+		int queued = takeQueued();
+		if (queued >= 0)
+		{
+			runCheck(queued);
+			continue;
+		}
+
+		// Otherwise wait for a worker to finish it
+		wxMutexLocker lock(mutex);
+		while (times[index] < 0)
+			done_cond.Wait();
+
+		return index;
+	}
+}
+
+/* MapCheckRunner::checkTime
+ * Returns the time (in ms) check [index] took to run, or -1 if it
+ * hasn't been run yet
+ *******************************************************************/
+long MapCheckRunner::checkTime(unsigned index)
+{
+	wxMutexLocker lock(mutex);
+	return index < times.size() ? times[index] : -1;
+}
+
+/* MapCheckRunner::takeQueued
+ * Returns the index of the next queued check that hasn't been
+ * started yet (and marks it as started), or -1 if there are none
+ *******************************************************************/
+int MapCheckRunner::takeQueued()
+{
+	wxMutexLocker lock(mutex);
+	if (queue_next >= queue.size())
+		return -1;
+
+	return queue[queue_next++];
+}
+
+/* MapCheckRunner::runCheck
+ * Runs check [index] and records how long it took
+ *******************************************************************/
+void MapCheckRunner::runCheck(unsigned index)
+{
+	wxStopWatch sw;
+	checks[index]->doCheck();
+	long time = sw.Time();
+
+	wxMutexLocker lock(mutex);
+	times[index] = time;
+	done_cond.Broadcast();
+}
+
+/* MapCheckRunner::stopThreads
+ * Waits for all worker threads to finish and cleans them up
+ *******************************************************************/
+void MapCheckRunner::stopThreads()
+{
+	for (unsigned a = 0; a < threads.size(); a++)
+	{
+		threads[a]->Wait();
+		delete threads[a];
+	}
+	threads.clear();
+}
@@ -24,6 +24,10 @@ public:
 	virtual string		progressText() { return "Checking..."; }
 	virtual string		fixText(unsigned fix_type, unsigned index) { return ""; }
 
+	// Returns false if the check needs something other than the map
+	// (eg. textures) that can only be accessed from the main thread
+	virtual bool		canRunInThread() { return true; }
+
 	static MapCheck*	missingTextureCheck(SLADEMap* map);
 	static MapCheck*	specialTagCheck(SLADEMap* map);
 	static MapCheck*	intersectingLineCheck(SLADEMap* map);
@@ -41,4 +45,36 @@ public:
 	static MapCheck*	obsoleteThingCheck(SLADEMap* map);
 };
 
+// Runs a list of map checks, with any checks that only read the map
+// spread over worker threads. Results are collected in check order via
+// waitNext, and the map must not be modified until all are complete
+class MapCheckRunner
+{
+	friend class MapCheckThread;
+public:
+	MapCheckRunner(SLADEMap* map, const vector<MapCheck*>& checks);
+	~MapCheckRunner();
+
+	void	start();
+	int		waitNext();
+	long	checkTime(unsigned index);
+	long	totalTime() { return timer.Time(); }
+
+private:
+	SLADEMap*			map;
+	vector<MapCheck*>	checks;
+	vector<long>		times;		// Time taken for each check, -1 if not done yet
+	vector<unsigned>	queue;		// Checks that can run in a worker thread
+	unsigned			queue_next;
+	unsigned			next_result;
+	vector<wxThread*>	threads;
+	wxMutex				mutex;
+	wxCondition			done_cond;
+	wxStopWatch			timer;
+
+	int		takeQueued();
+	void	runCheck(unsigned index);
+	void	stopThreads();
+};
+
 #endif//__MAP_CHECKS_H__
@@ -49,6 +49,8 @@
 #include "UI/MapCanvas.h"
 #include "UI/MapEditorWindow.h"
 #include "UndoSteps.h"
+#include "Utility/PolygonTriangulator.h"
+#include "Utility/Profiler.h"
 
 using MapEditor::Mode;
 using MapEditor::SectorMode;
@@ -87,8 +89,10 @@ namespace
 	};
 }
 CVAR(Bool, info_overlay_3d, true, CVAR_SAVE)
+CVAR(Bool, info_overlay_3d_cull_stats, false, CVAR_SAVE)
 CVAR(Int, map_bg_ms, 15, CVAR_SAVE)
 CVAR(Bool, hilight_smooth, true, CVAR_SAVE)
+CVAR(Bool, map_profile_record, false, 0)
 
 
 // ----------------------------------------------------------------------------
@@ -290,6 +294,8 @@ bool MapEditContext::update(long frametime)
 	if (frametime < next_frame_length_)
 		return false;
 
+	PROFILE_SCOPE("Update");
+
 	// Set initial time (ms) until next update
 	// This will be set lower if animations are active
 	next_frame_length_ = overlayActive() ? 2 : map_bg_ms;
@@ -312,6 +318,7 @@ bool MapEditContext::update(long frametime)
 		MapEditor::Item hl{ -1, MapEditor::ItemType::Any };
 		if (!selection_.hilightLocked())
 		{
+			PROFILE_SCOPE("Hilight");
 			auto old_hl = selection_.hilight();
 			hl = renderer_.renderer3D().determineHilight();
 			if (selection_.setHilight(hl))
@@ -338,6 +345,7 @@ bool MapEditContext::update(long frametime)
 		auto prev_hl = selection_.hilight();
 		if (input_.mouseState() == MapEditor::Input::MouseState::Normal/* && !mouse_movebegin*/)
 		{
+			PROFILE_SCOPE("Hilight");
 			auto old_hl = selection_.hilightedObject();
 			if (selection_.updateHilight(input_.mousePosMap(), renderer_.view().scale()) && hilight_smooth)
 				renderer_.animateHilightChange({}, old_hl);
@@ -345,7 +353,10 @@ bool MapEditContext::update(long frametime)
 
 		// Do item moving if needed
 		if (input_.mouseState() == MapEditor::Input::MouseState::Move)
+		{
+			PROFILE_SCOPE("Move Objects");
 			move_objects_.update(input_.mousePosMap());
+		}
 
 		// Check if we have to update the info overlay
 		if (selection_.hilight() != prev_hl)
@@ -1399,6 +1410,8 @@ void MapEditContext::doUndo()
 		map_.updateGeometryInfo(time);
 		last_undo_level_ = "";
 	}
+	else if (manager->lastFailed())
+		addEditorMessage("Undo failed: unable to read undo data from the undo journal");
 	updateThingLists();
 	map_.recomputeSpecials();
 }
@@ -1431,6 +1444,8 @@ void MapEditContext::doRedo()
 		map_.updateGeometryInfo(time);
 		last_undo_level_ = "";
 	}
+	else if (manager->lastFailed())
+		addEditorMessage("Redo failed: unable to read undo data from the undo journal");
 	updateThingLists();
 	map_.recomputeSpecials();
 }
@@ -1616,8 +1631,27 @@ void MapEditContext::drawInfoOverlay(const point2_t& size, float alpha)
 	case Mode::Things:
 		info_thing_.draw(size.y, size.x, alpha); return;
 	case Mode::Visual:
+	{
+		// Visibility culling stats
+		string stats;
+		if (info_overlay_3d_cull_stats)
+		{
+			auto& cull = renderer_.renderer3D().cullStats();
+			stats = S_FMT(
+				"%s: %d/%d sectors, %d/%d lines, %d portals",
+				cull.portal ? "Portal cull" : "Distance cull",
+				cull.sectors,
+				map_.nSectors(),
+				cull.lines,
+				map_.nLines(),
+				cull.portals
+			);
+		}
+		info_3d_.setCullStats(stats);
+
 		info_3d_.draw(size.y, size.x, size.x * 0.5, alpha); return;
 	}
+	}
 }
 
 // ----------------------------------------------------------------------------
@@ -2060,11 +2094,12 @@ CONSOLE_COMMAND(m_check, 0, true)
 	}
 
 	// Run checks
-	for (unsigned a = 0; a < checks.size(); a++)
+	MapCheckRunner runner(map, checks);
+	runner.start();
+	int a;
+	while ((a = runner.waitNext()) >= 0)
 	{
-		// Run
-		Log::console(checks[a]->progressText());
-		checks[a]->doCheck();
+		Log::console(S_FMT("%s (%ldms)", checks[a]->progressText(), runner.checkTime(a)));
 
 		// Check if no problems found
 		if (checks[a]->nProblems() == 0)
@@ -2073,10 +2108,52 @@ CONSOLE_COMMAND(m_check, 0, true)
 		// List problem details
 		for (unsigned b = 0; b < checks[a]->nProblems(); b++)
 			Log::console(checks[a]->problemDesc(b));
+	}
+	Log::console(S_FMT("All checks completed in %ldms", runner.totalTime()));
 
-		// Clean up
+	// Clean up
+	for (unsigned a = 0; a < checks.size(); a++)
 		delete checks[a];
+}
+
+CONSOLE_COMMAND(m_profile, 0, true)
+{
+	if (args.empty())
+	{
+		Log::console("Usage: m_profile <start|stop|reset|dump> [file]");
+		Log::console("start: Start timing map editor passes (also done while map_show_profiler is on)");
+		Log::console("stop: Stop timing, keeping statistics so far");
+		Log::console("reset: Clear all statistics");
+		Log::console("dump: Output statistics as CSV (to [file] if given)");
+		return;
+	}
+
+	string cmd = args[0].Lower();
+	if (cmd == "start")
+		map_profile_record = true;
+	else if (cmd == "stop")
+		map_profile_record = false;
+	else if (cmd == "reset")
+		Profiler::reset();
+	else if (cmd == "dump")
+	{
+		string csv = Profiler::statsCSV();
+		if (args.size() > 1)
+		{
+			wxFile file(args[1], wxFile::write);
+			if (!file.IsOpened())
+			{
+				Log::console(S_FMT("Unable to open \"%s\" for writing", args[1]));
+				return;
+			}
+			file.Write(csv);
+			Log::console(S_FMT("Wrote profiler statistics to \"%s\"", args[1]));
+		}
+		else
+			Log::console(csv);
 	}
+	else
+		Log::console(S_FMT("Unknown command \"%s\"", cmd));
 }
 
 
@@ -2155,6 +2232,54 @@ CONSOLE_COMMAND(m_n_polys, 0, false)
 	Log::console(S_FMT("%d polygons total", npoly));
 }
 
+CONSOLE_COMMAND(m_test_triangulation, 0, false)
+{
+	// Times building polygons for every sector in the map with both the
+	// triangulator and the (old) polygon splitter
+	SLADEMap& map = MapEditor::editContext().map();
+	Polygon2D poly;
+	sf::Clock clock;
+	sf::Int64 time_tri = 0, time_split = 0, slowest_tri = 0, slowest_split = 0;
+	int n_tri = 0, n_split = 0, n_failed = 0;
+	for (unsigned a = 0; a < map.nSectors(); a++)
+	{
+		MapSector* sector = map.getSector(a);
+
+		// Triangulator
+		poly.clear();
+		clock.restart();
+		PolygonTriangulator triangulator;
+		triangulator.openSector(sector);
+		bool ok = triangulator.triangulate(&poly);
+		sf::Int64 time = clock.getElapsedTime().asMicroseconds();
+		time_tri += time;
+		slowest_tri = MAX(slowest_tri, time);
+		n_tri += poly.nSubPolys();
+		if (!ok)
+		{
+			Log::console(S_FMT("Triangulation failed for sector %d", a));
+			n_failed++;
+		}
+
+		// Splitter
+		poly.clear();
+		clock.restart();
+		PolygonSplitter splitter;
+		splitter.openSector(sector);
+		splitter.doSplitting(&poly);
+		time = clock.getElapsedTime().asMicroseconds();
+		time_split += time;
+		slowest_split = MAX(slowest_split, time);
+		n_split += poly.nSubPolys();
+	}
+
+	Log::console(S_FMT("%d sectors", map.nSectors()));
+	Log::console(S_FMT("Triangulator: %1.2fms total, %1.2fms slowest sector, %d polygons, %d failed",
+		time_tri * 0.001, slowest_tri * 0.001, n_tri, n_failed));
+	Log::console(S_FMT("Splitter: %1.2fms total, %1.2fms slowest sector, %d polygons",
+		time_split * 0.001, slowest_split * 0.001, n_split));
+}
+
 CONSOLE_COMMAND(mobj_info, 1, false)
 {
 	long id;
@@ -48,6 +48,7 @@
  * VARIABLES
  *******************************************************************/
 CVAR(Int, map_tex_filter, 0, CVAR_SAVE)
+CVAR(Bool, map_tex_atlas, false, CVAR_SAVE)
 
 
 /*******************************************************************
@@ -62,6 +63,7 @@ MapTextureManager::MapTextureManager(Archive* archive)
 	// Init variables
 	this->archive = archive;
 	editor_images_loaded = false;
+	sprite_index_built = false;
 	palette = new Palette8bit();
 }
 
@@ -104,6 +106,22 @@ Palette8bit* MapTextureManager::getResourcePalette()
 		return theMainWindow->getPaletteChooser()->getSelectedPalette();
 }
 
+/* MapTextureManager::getImageEntry
+ * Returns the stand-alone image entry that would be used for the
+ * texture (or flat if [flat] is true) [name], or NULL if there is
+ * none (eg. composite textures)
+ *******************************************************************/
+ArchiveEntry* MapTextureManager::getImageEntry(string name, bool flat)
+{
+	ArchiveEntry* entry = theResourceManager->getTextureEntry(name, "hires", archive);
+	if (!entry)
+		entry = theResourceManager->getTextureEntry(name, flat ? "flats" : "textures", archive);
+	if (!entry && flat)
+		entry = theResourceManager->getFlatEntry(name, archive);
+
+	return entry;
+}
+
 /* MapTextureManager::getTexture
  * Returns the texture matching [name]. Loads it from resources if
  * necessary. If [mixed] is true, flats are also searched if no
@@ -300,6 +318,16 @@ GLTexture* MapTextureManager::getSprite(string name, string translation, string
 		hashname += translation.Lower();
 	if (!palette.IsEmpty())
 		hashname += palette.Upper();
+
+	// Check if the sprite is already known to be missing
+	if (sprites_missing.find(hashname) != sprites_missing.end())
+		return NULL;
+
+	// Check if the name is a wildcard that has already been resolved
+	auto wildcard = sprite_wildcards.find(hashname);
+	if (wildcard != sprite_wildcards.end())
+		return getSprite(wildcard->second, translation, palette);
+
 	map_tex_t& mtex = sprites[hashname];
 
 	// Get desired filter type
@@ -313,11 +341,14 @@ GLTexture* MapTextureManager::getSprite(string name, string translation, string
 	else if (map_tex_filter == 3)
 		filter = GLTexture::NEAREST_MIPMAP;
 
+	// Atlas pages can be refiltered in place
+	sprite_atlas.setFilter(filter);
+
 	// If the texture is loaded
 	if (mtex.texture)
 	{
 		// If the texture filter matches the desired one, return it
-		if (mtex.texture->getFilter() == filter)
+		if (mtex.texture->getFilter() == filter || mtex.texture->isAtlased())
 			return mtex.texture;
 		else
 		{
@@ -327,6 +358,46 @@ GLTexture* MapTextureManager::getSprite(string name, string translation, string
 		}
 	}
 
+	// Resolve wildcard names to the first available frame/rotation
+	if (name.EndsWith("?"))
+	{
+		name.RemoveLast(1);
+		vector<string> candidates;
+		candidates.push_back(name + '0');
+		candidates.push_back(name + '1');
+		if (name.length() == 5)
+		{
+			for (char chr = 'A'; chr <= ']'; ++chr)
+			{
+				candidates.push_back(name + '0' + chr + '0');
+				candidates.push_back(name + '1' + chr + '1');
+			}
+		}
+
+		for (unsigned a = 0; a < candidates.size(); a++)
+		{
+			if (!spriteIndexed(candidates[a]))
+				continue;
+
+			GLTexture* sprite = getSprite(candidates[a], translation, palette);
+			if (sprite)
+			{
+				sprite_wildcards[hashname] = candidates[a];
+				return sprite;
+			}
+		}
+
+		sprites_missing.insert(hashname);
+		return NULL;
+	}
+
+	// Don't bother searching resources if the sprite doesn't exist
+	if (!spriteIndexed(name))
+	{
+		sprites_missing.insert(hashname);
+		return NULL;
+	}
+
 	// Sprite not found, look for it
 	bool found = false;
 	bool mirror = false;
@@ -377,36 +448,72 @@ GLTexture* MapTextureManager::getSprite(string name, string translation, string
 		}
 		// Apply mirroring
 		if (mirror) image.mirror(false);
-		// Turn into GL texture
-		mtex.texture = new GLTexture(false);
-		mtex.texture->setFilter(filter);
-		mtex.texture->setTiling(false);
-		mtex.texture->loadImage(&image, pal);
-		return mtex.texture;
-	}
-	else if (name.EndsWith("?"))
-	{
-		name.RemoveLast(1);
-		GLTexture* sprite = getSprite(name + '0', translation, palette);
-		if (!sprite)
-			sprite = getSprite(name + '1', translation, palette);
-		if (sprite)
-			return sprite;
-		if (!sprite && name.length() == 5)
+		// Turn into GL texture (packed into the sprite atlas if enabled)
+		if (map_tex_atlas)
+			mtex.texture = sprite_atlas.addImage(&image, pal);
+		if (!mtex.texture)
 		{
-			for (char chr = 'A'; chr <= ']'; ++chr)
-			{
-				sprite = getSprite(name + '0' + chr + '0', translation, palette);
-				if (sprite) return sprite;
-				sprite = getSprite(name + '1' + chr + '1', translation, palette);
-				if (sprite) return sprite;
-			}
+			mtex.texture = new GLTexture(false);
+			mtex.texture->setFilter(filter);
+			mtex.texture->setTiling(false);
+			mtex.texture->loadImage(&image, pal);
 		}
+		return mtex.texture;
 	}
 
+	sprites_missing.insert(hashname);
 	return NULL;
 }
 
+/* MapTextureManager::buildSpriteIndex
+ * (Re)builds the index of all resource names a sprite can be loaded
+ * from (patches and composite textures), grouped by their first 4
+ * characters (the sprite prefix). Used to avoid full resource
+ * searches for sprites that don't exist
+ *******************************************************************/
+void MapTextureManager::buildSpriteIndex()
+{
+	sprite_index.clear();
+
+	vector<string> names;
+	theResourceManager->getAllPatchNames(names);
+	theResourceManager->getAllTextureNames(names);
+	for (unsigned a = 0; a < names.size(); a++)
+		sprite_index[names[a].Left(4)].push_back(names[a]);
+
+	sprite_index_built = true;
+}
+
+/* MapTextureManager::spriteIndexed
+ * Returns true if a sprite named [name] (or its mirrored frame, for
+ * 8-character names) exists in the sprite index
+ *******************************************************************/
+bool MapTextureManager::spriteIndexed(string name)
+{
+	if (!sprite_index_built)
+		buildSpriteIndex();
+
+	name.MakeUpper();
+	auto prefix = sprite_index.find(name.Left(4));
+	if (prefix == sprite_index.end())
+		return false;
+
+	const vector<string>& frames = prefix->second;
+	if (VECTOR_EXISTS(frames, name))
+		return true;
+
+	// Check mirrored frame
+	if (name.length() == 8)
+	{
+		string mirrored = name;
+		mirrored[4] = name[6]; mirrored[5] = name[7]; mirrored[6] = name[4]; mirrored[7] = name[5];
+		if (VECTOR_EXISTS(frames, mirrored))
+			return true;
+	}
+
+	return false;
+}
+
 /* MapTextureManager::getVerticalOffset
  * Detects offset hacks such as that used by the wall torch thing in
  * Heretic (type 50). If the Y offset is noticeably larger than the
@@ -503,6 +610,10 @@ void MapTextureManager::refreshResources()
 	textures.clear();
 	flats.clear();
 	sprites.clear();
+	sprites_missing.clear();
+	sprite_wildcards.clear();
+	sprite_index_built = false;
+	sprite_atlas.clear();
 	theMainWindow->getPaletteChooser()->setGlobalFromArchive(archive);
 	MapEditor::forceRefresh(true);
 	palette = getResourcePalette();
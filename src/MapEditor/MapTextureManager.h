@@ -4,6 +4,7 @@
 
 #include "common.h"
 #include "OpenGL/GLTexture.h"
+#include "OpenGL/GLTextureAtlas.h"
 #include "General/ListenerAnnouncer.h"
 
 struct map_tex_t
@@ -14,6 +15,7 @@ struct map_tex_t
 };
 
 class Archive;
+class ArchiveEntry;
 struct map_texinfo_t
 {
 	string			name;
@@ -42,12 +44,20 @@ private:
 	MapTexHashMap			textures;
 	MapTexHashMap			flats;
 	MapTexHashMap			sprites;
+	GLTextureAtlas			sprite_atlas;
+	std::set<string>		sprites_missing;
+	std::map<string, string>	sprite_wildcards;
+	std::map<string, vector<string>>	sprite_index;
+	bool					sprite_index_built;
 	MapTexHashMap			editor_images;
 	bool					editor_images_loaded;
 	Palette8bit*			palette;
 	vector<map_texinfo_t>	tex_info;
 	vector<map_texinfo_t>	flat_info;
 
+	void	buildSpriteIndex();
+	bool	spriteIndexed(string name);
+
 public:
 	enum
 	{
@@ -68,6 +78,8 @@ public:
 	void	buildTexInfoList();
 
 	Palette8bit*	getResourcePalette();
+	Palette8bit*	getPalette() { return palette; }
+	ArchiveEntry*	getImageEntry(string name, bool flat);
 	GLTexture*		getTexture(string name, bool mixed);
 	GLTexture*		getFlat(string name, bool mixed);
 	GLTexture*		getSprite(string name, string translation = "", string palette = "");
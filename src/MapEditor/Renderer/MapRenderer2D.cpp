@@ -41,7 +41,9 @@
 #include "OpenGL/Drawing.h"
 #include "OpenGL/GLTexture.h"
 #include "OpenGL/OpenGL.h"
+#include "Utility/MathStuff.h"
 #include "Utility/Polygon2D.h"
+#include "Utility/Profiler.h"
 
 
 /*******************************************************************
@@ -88,6 +90,60 @@ CVAR(Bool, test_ssplit, false, CVAR_SAVE)
 EXTERN_CVAR(Bool, use_zeth_icons)
 
 
+/*******************************************************************
+ * VBORANGEUPLOADER CLASS
+ *******************************************************************
+ * Uploads changed items from a copy of a VBO's contents to the VBO
+ * currently bound to GL_ARRAY_BUFFER. Changed items close together
+ * are uploaded in one go, to keep the number of glBufferSubData
+ * calls down when a lot of things change at once
+ */
+class VBORangeUploader
+{
+private:
+	const char*	data;
+	unsigned	item_size;
+	int			first;
+	int			last;
+
+	static const int MAX_GAP = 32;
+
+public:
+	VBORangeUploader(const void* data, unsigned item_size)
+	{
+		this->data = (const char*)data;
+		this->item_size = item_size;
+		first = last = -1;
+	}
+	~VBORangeUploader() { flush(); }
+
+	// Adds item [index] to be uploaded, indices must be increasing
+	void add(int index)
+	{
+		if (first >= 0 && index - last > MAX_GAP)
+			flush();
+		if (first < 0)
+			first = index;
+		last = index;
+	}
+
+	// Uploads the current range of items
+	void flush()
+	{
+		if (first < 0)
+			return;
+
+		glBufferSubData(
+			GL_ARRAY_BUFFER,
+			first * item_size,
+			(last - first + 1) * item_size,
+			data + first * item_size
+		);
+		first = last = -1;
+	}
+};
+
+
 /*******************************************************************
  * MAPRENDERER2D CLASS FUNCTIONS
  *******************************************************************/
@@ -108,6 +164,16 @@ MapRenderer2D::MapRenderer2D(SLADEMap* map)
 	this->n_vertices = 0;
 	this->n_lines = 0;
 	this->n_things = 0;
+	this->vertices_updated = 0;
+	this->lines_updated = 0;
+	this->flats_updated = 0;
+	this->vbo_flats_size = 0;
+	this->vbo_flats_used = 0;
+	this->lines_alpha = 1.0f;
+	this->thing_sprites_updated = 0;
+	this->things_batch_ok = false;
+	this->things_batch_updated = 0;
+	this->things_batch_sprites = 0;
 }
 
 /* MapRenderer2D::~MapRenderer2D
@@ -177,6 +243,8 @@ bool MapRenderer2D::setupVertexRendering(float size_scale, bool overlay)
  *******************************************************************/
 void MapRenderer2D::renderVertices(float alpha)
 {
+	PROFILE_SCOPE("Vertices");
+
 	// Check there are any vertices to render
 	if (map->nVertices() == 0)
 		return;
@@ -241,7 +309,7 @@ void MapRenderer2D::renderVerticesVBO()
 		return;
 
 	// Update vertices VBO if required
-	if (vbo_vertices == 0 || map->nVertices() != n_vertices || map->geometryUpdated() > vertices_updated)
+	if (vbo_vertices == 0 || map->nVertices() != n_vertices || map->geometryUpdated() >= vertices_updated)
 		updateVerticesVBO();
 
 	// Set VBO arrays to use
@@ -364,6 +432,8 @@ rgba_t MapRenderer2D::lineColour(MapLine* line, bool ignore_filter)
  *******************************************************************/
 void MapRenderer2D::renderLines(bool show_direction, float alpha)
 {
+	PROFILE_SCOPE("Lines");
+
 	// Check there are any lines to render
 	if (map->nLines() == 0)
 		return;
@@ -464,8 +534,8 @@ void MapRenderer2D::renderLinesVBO(bool show_direction, float alpha)
 	if (vbo_lines == 0 ||
 		show_direction != lines_dirs ||
 		map->nLines() != n_lines ||
-		map->geometryUpdated() > lines_updated ||
-		map->modifiedSince(lines_updated, MOBJ_LINE))
+		map->geometryUpdated() >= lines_updated ||
+		map->modifiedSince(lines_updated - 1, MOBJ_LINE))
 		updateLinesVBO(show_direction, alpha);
 
 	// Disable any blending
@@ -766,17 +836,14 @@ void MapRenderer2D::renderThingOverlay(double x, double y, double radius, bool p
 }
 
 /* MapRenderer2D::renderRoundThing
- * Renders a round thing icon at [x,y]
+ * Adds a round thing icon at [x,y] to [batch]
  *******************************************************************/
-void MapRenderer2D::renderRoundThing(double x, double y, double angle, const Game::ThingType& tt, float alpha, double radius_mult)
+void MapRenderer2D::renderRoundThing(GLQuadBatch& batch, double x, double y, double angle, const Game::ThingType& tt, float alpha, double radius_mult)
 {
 	// --- Determine texture to use ---
 	GLTexture* tex = nullptr;
 	bool rotate = false;
 
-	// Set colour
-	glColor4f(tt.colour().fr(), tt.colour().fg(), tt.colour().fb(), alpha);
-
 	// Check for custom thing icon
 	if (!tt.icon().IsEmpty() && !thing_force_dir && !things_angles)
 	{
@@ -803,46 +870,22 @@ void MapRenderer2D::renderRoundThing(double x, double y, double angle, const Gam
 	// If for whatever reason the thing texture doesn't exist, just draw a basic, square thing
 	if (!tex)
 	{
-		renderSimpleSquareThing(x, y, angle, tt, alpha);
+		renderSimpleSquareThing(batch, x, y, angle, tt, alpha);
 		return;
 	}
 
-	// Bind texture
-	if (tex_last != tex)
-	{
-		tex->bind();
-		tex_last = tex;
-	}
-
-	// Rotate if needed
-	if (rotate)
-	{
-		glPushMatrix();
-		glTranslated(x, y, 0);
-		glRotated(angle, 0, 0, 1);
-		x = y = 0;
-	}
-
-	// Draw thing
+	// Draw thing (rotated if needed)
 	double radius = tt.radius() * radius_mult;
 	if (tt.shrinkOnZoom()) radius = scaledRadius(radius);
-	glBegin(GL_QUADS);
-	glTexCoord2f(0.0f, 1.0f);	glVertex2d(x-radius, y-radius);
-	glTexCoord2f(0.0f, 0.0f);	glVertex2d(x-radius, y+radius);
-	glTexCoord2f(1.0f, 0.0f);	glVertex2d(x+radius, y+radius);
-	glTexCoord2f(1.0f, 1.0f);	glVertex2d(x+radius, y-radius);
-	glEnd();
-
-	// Restore previous matrix if rotated
-	if (rotate)
-		glPopMatrix();
+	batch.setColour(tt.colour().fr(), tt.colour().fg(), tt.colour().fb(), alpha);
+	batch.addRect(tex, x, y, radius, radius, frect_t(0, 0, 1, 1), rotate ? angle : 0);
 }
 
 /* MapRenderer2D::renderSpriteThing
- * Renders a sprite thing icon at [x,y]. If [fitradius] is true, the
- * sprite is drawn to fit within the thing's radius
+ * Adds a sprite thing icon at [x,y] to [batch]. If [fitradius] is
+ * true, the sprite is drawn to fit within the thing's radius
  *******************************************************************/
-bool MapRenderer2D::renderSpriteThing(double x, double y, double angle, const Game::ThingType& tt, unsigned index, float alpha, bool fitradius)
+bool MapRenderer2D::renderSpriteThing(GLQuadBatch& batch, double x, double y, double angle, const Game::ThingType& tt, unsigned index, float alpha, bool fitradius)
 {
 	// Refresh sprites list if needed
 	if (thing_sprites.size() != map->nThings())
@@ -872,9 +915,9 @@ bool MapRenderer2D::renderSpriteThing(double x, double y, double angle, const Ga
 	if (!tex)
 	{
 		if (thing_drawtype == TDT_FRAMEDSPRITE)
-			renderRoundThing(x, y, angle, tt, alpha, 0.7);
+			renderRoundThing(batch, x, y, angle, tt, alpha, 0.7);
 		else
-			renderRoundThing(x, y, angle, tt, alpha);
+			renderRoundThing(batch, x, y, angle, tt, alpha);
 		return false;
 	}
 
@@ -882,21 +925,8 @@ bool MapRenderer2D::renderSpriteThing(double x, double y, double angle, const Ga
 	if (tt.angled() || thing_force_dir || things_angles)
 		show_angle = true;
 
-	//// If for whatever reason the thing texture doesn't exist, just draw a basic, square thing
-	//if (!tex)
-	//{
-	//	renderSquareThing(x, y, angle, tt, alpha);
-	//	return false;
-	//}
-
-	// Bind texture
-	if (tex_last != tex)
-	{
-		tex->bind();
-		tex_last = tex;
-	}
-
 	// Draw thing
+	frect_t tc = tex->texCoords();
 	double hw = tex->getWidth()*0.5;
 	double hh = tex->getHeight()*0.5;
 
@@ -908,49 +938,31 @@ bool MapRenderer2D::renderSpriteThing(double x, double y, double angle, const Ga
 		hh *= scale;
 	}
 
-	// Shadow if needed
+	// Shadow if needed (sprites packed into the same atlas page share a group)
 	if (thing_shadow > 0.01f && alpha >= 0.9 && !fitradius)
 	{
 		double sz = (min(hw, hh))*0.1;
 		if (sz < 1) sz = 1;
-		glColor4f(0.0f, 0.0f, 0.0f, alpha*(thing_shadow*0.7));
-		glBegin(GL_QUADS);
-		glTexCoord2f(0.0f, 1.0f);	glVertex2d(x-hw-sz, y-hh-sz);
-		glTexCoord2f(0.0f, 0.0f);	glVertex2d(x-hw-sz, y+hh+sz);
-		glTexCoord2f(1.0f, 0.0f);	glVertex2d(x+hw+sz, y+hh+sz);
-		glTexCoord2f(1.0f, 1.0f);	glVertex2d(x+hw+sz, y-hh-sz);
-		glEnd();
-		glBegin(GL_QUADS);
-		glTexCoord2f(0.0f, 1.0f);	glVertex2d(x-hw-sz, y-hh-sz-sz);
-		glTexCoord2f(0.0f, 0.0f);	glVertex2d(x-hw-sz, y+hh+sz);
-		glTexCoord2f(1.0f, 0.0f);	glVertex2d(x+hw+sz+sz, y+hh+sz);
-		glTexCoord2f(1.0f, 1.0f);	glVertex2d(x+hw+sz+sz, y-hh-sz-sz);
-		glEnd();
+		batch.setColour(0.0f, 0.0f, 0.0f, alpha*(thing_shadow*0.7));
+		batch.addRect(tex, x, y, hw + sz, hh + sz, tc);
+		batch.addRect(tex, x + sz*0.5, y - sz*0.5, hw + sz*1.5, hh + sz*1.5, tc);
 	}
-	// Draw thing
-	glColor4f(1.0f, 1.0f, 1.0f, alpha);
-	glBegin(GL_QUADS);
-	glTexCoord2f(0.0f, 1.0f);	glVertex2d(x-hw, y-hh);
-	glTexCoord2f(0.0f, 0.0f);	glVertex2d(x-hw, y+hh);
-	glTexCoord2f(1.0f, 0.0f);	glVertex2d(x+hw, y+hh);
-	glTexCoord2f(1.0f, 1.0f);	glVertex2d(x+hw, y-hh);
-	glEnd();
 
+	// Draw thing
+	batch.setColour(1.0f, 1.0f, 1.0f, alpha);
+	batch.addRect(tex, x, y, hw, hh, tc);
 
 	return show_angle;
 }
 
 /* MapRenderer2D::renderSquareThing
- * Renders a square thing icon at [x,y]
+ * Adds a square thing icon at [x,y] to [batch]
  *******************************************************************/
-bool MapRenderer2D::renderSquareThing(double x, double y, double angle, const Game::ThingType& tt, float alpha, bool showicon, bool framed)
+bool MapRenderer2D::renderSquareThing(GLQuadBatch& batch, double x, double y, double angle, const Game::ThingType& tt, float alpha, bool showicon, bool framed)
 {
 	// --- Determine texture to use ---
 	GLTexture* tex = nullptr;
 
-	// Set colour
-	glColor4f(tt.colour().fr(), tt.colour().fg(), tt.colour().fb(), alpha);
-
 	// Show icon anyway if no sprite set
 	if (tt.sprite().IsEmpty())
 		showicon = true;
@@ -1015,115 +1027,136 @@ bool MapRenderer2D::renderSquareThing(double x, double y, double angle, const Ga
 	// If for whatever reason the thing texture doesn't exist, just draw a basic, square thing
 	if (!tex)
 	{
-		renderSimpleSquareThing(x, y, angle, tt, alpha);
+		renderSimpleSquareThing(batch, x, y, angle, tt, alpha);
 		return false;
 	}
 
-	// Bind texture
-	if (tex && tex_last != tex)
-	{
-		tex->bind();
-		tex_last = tex;
-	}
-
 	// Draw thing
 	double radius = tt.radius();
 	if (tt.shrinkOnZoom()) radius = scaledRadius(radius);
-	glBegin(GL_QUADS);
+	batch.setColour(tt.colour().fr(), tt.colour().fg(), tt.colour().fb(), alpha);
+	GLQuadBatch::vertex_t* quad = batch.addQuad(tex);
+	double cx[4] = { -radius, -radius, radius, radius };
+	double cy[4] = { -radius, radius, radius, -radius };
 	int tc = tc_start;
-	glTexCoord2f(sq_thing_tc[tc], sq_thing_tc[tc+1]);
-	tc += 2;
-	if (tc == 8) tc = 0;
-	glVertex2d(x-radius, y-radius);
-	glTexCoord2f(sq_thing_tc[tc], sq_thing_tc[tc+1]);
-	tc += 2;
-	if (tc == 8) tc = 0;
-	glVertex2d(x-radius, y+radius);
-	glTexCoord2f(sq_thing_tc[tc], sq_thing_tc[tc+1]);
-	tc += 2;
-	if (tc == 8) tc = 0;
-	glVertex2d(x+radius, y+radius);
-	glTexCoord2f(sq_thing_tc[tc], sq_thing_tc[tc+1]);
-	glVertex2d(x+radius, y-radius);
-	glEnd();
+	for (unsigned a = 0; a < 4; a++)
+	{
+		quad[a].set(x + cx[a], y + cy[a], 0, sq_thing_tc[tc], sq_thing_tc[tc+1]);
+		tc += 2;
+		if (tc == 8) tc = 0;
+	}
 
 	return ((tt.angled() || thing_force_dir || things_angles) && !showicon);
 }
 
 /* MapRenderer2D::renderSimpleSquareThing
- * Renders a simple square thing icon at [x,y]
+ * Adds a simple (untextured) square thing icon at [x,y] to [batch]
  *******************************************************************/
-void MapRenderer2D::renderSimpleSquareThing(double x, double y, double angle, const Game::ThingType& tt, float alpha)
+void MapRenderer2D::renderSimpleSquareThing(GLQuadBatch& batch, double x, double y, double angle, const Game::ThingType& tt, float alpha)
 {
 	// Get thing info
 	double radius = tt.radius();
 	if (tt.shrinkOnZoom()) radius = scaledRadius(radius);
 	double radius2 = radius * 0.1;
-
-	// Move to thing position
-	glPushMatrix();
-	glTranslated(x, y, 0);
+	frect_t tc(0, 0, 1, 1);
 
 	// Draw background
-	glColor4f(0.0f, 0.0f, 0.0f, alpha);
-	glBegin(GL_QUADS);
-	glVertex2d(-radius, -radius);
-	glVertex2d(-radius, radius);
-	glVertex2d(radius, radius);
-	glVertex2d(radius, -radius);
-	glEnd();
+	batch.setColour(0.0f, 0.0f, 0.0f, alpha);
+	batch.addRect(nullptr, x, y, radius, radius, tc);
 
 	// Draw base
-	//tt.getColour().set_gl(false);
-	glColor4f(tt.colour().fr(), tt.colour().fg(), tt.colour().fb(), alpha);
-	glBegin(GL_QUADS);
-	glVertex2d(-radius+radius2, -radius+radius2);
-	glVertex2d(-radius+radius2, radius-radius2);
-	glVertex2d(radius-radius2, radius-radius2);
-	glVertex2d(radius-radius2, -radius+radius2);
-	glEnd();
+	batch.setColour(tt.colour().fr(), tt.colour().fg(), tt.colour().fb(), alpha);
+	batch.addRect(nullptr, x, y, radius - radius2, radius - radius2, tc);
 
-	// Draw angle indicator (if needed)
+	// Draw angle indicator (if needed), as a 1 pixel wide line from the centre
 	if (tt.angled() || thing_force_dir)
 	{
-		glColor4f(0.0f, 0.0f, 0.0f, 1.0f);
-		glRotated(angle, 0, 0, 1);
-		glBegin(GL_LINES);
-		glVertex2d(0, 0);
-		glVertex2d(radius, 0);
-		glEnd();
+		double rad = angle * (PI / 180.0);
+		batch.setColour(0.0f, 0.0f, 0.0f, 1.0f);
+		batch.addRect(
+			nullptr,
+			x + cos(rad) * radius * 0.5,
+			y + sin(rad) * radius * 0.5,
+			radius * 0.5,
+			view_scale_inv * 0.5,
+			tc,
+			angle
+		);
 	}
-
-	// Restore previous matrix
-	glPopMatrix();
 }
 
 /* MapRenderer2D::renderThings
- * Renders map things
+ * Renders map things. The things are drawn from a batch of quads
+ * grouped by texture, which is only rebuilt when the view, the
+ * things or the thing display settings change
  *******************************************************************/
 void MapRenderer2D::renderThings(float alpha, bool force_dir)
 {
+	PROFILE_SCOPE("Things");
+
 	// Don't bother if (practically) invisible
 	if (alpha <= 0.01f)
 		return;
 
+	// Check if the things batch needs rebuilding
+	string settings = S_FMT(
+		"%1.3f %d %d %d %d %d %1.3f %1.3f",
+		alpha,
+		force_dir ? 1 : 0,
+		(int)thing_drawtype,
+		thing_force_dir ? 1 : 0,
+		arrow_colour ? 1 : 0,
+		use_zeth_icons ? 1 : 0,
+		(float)thing_shadow,
+		(float)arrow_alpha
+	);
+	bool rebuild =
+		!things_batch_ok ||
+		settings != things_batch_settings ||
+		map->nThings() != things_batch_filtered.size() ||
+		thing_sprites_updated != things_batch_sprites;
+
+	// Check for modified (or filtered/unfiltered) things
+	for (unsigned a = 0; a < map->nThings() && !rebuild; a++)
+	{
+		MapThing* thing = map->getThing(a);
+		if (thing->modifiedTime() >= things_batch_updated || thing->isFiltered() != (things_batch_filtered[a] > 0))
+			rebuild = true;
+	}
+
 	things_angles = force_dir;
-	renderThingsImmediate(alpha);
+	if (rebuild)
+	{
+		updateThingsBatch(alpha);
+		things_batch_settings = settings;
+	}
+
+	// Draw
+	glEnable(GL_TEXTURE_2D);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	things_batch.draw();
+	glDisable(GL_TEXTURE_2D);
 }
 
-/* MapRenderer2D::renderThingsImmediate
- * Renders map things in immediate mode
+/* MapRenderer2D::updateThingsBatch
+ * Rebuilds the batch of quads used to render all visible map things
  *******************************************************************/
-void MapRenderer2D::renderThingsImmediate(float alpha)
+void MapRenderer2D::updateThingsBatch(float alpha)
 {
-	// Display lists aren't really good for this, better to check for
-	// visibility and just render things in immediate mode
+	PROFILE_SCOPE("Batch Update");
 
-	// Enable textures
-	glEnable(GL_TEXTURE_2D);
-	glColor4f(1.0f, 1.0f, 1.0f, alpha);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	tex_last = nullptr;
+	// Batch layers, drawn in this order
+	enum
+	{
+		LAYER_SHADOWS,
+		LAYER_THINGS,
+		LAYER_SPRITES,
+		LAYER_ARROWS,
+	};
+
+	things_batch.clear();
+	things_batch_updated = App::runTimer();
+	things_batch_filtered.resize(map->nThings());
 
 	// Go through things
 	MapThing* thing = nullptr;
@@ -1131,27 +1164,16 @@ void MapRenderer2D::renderThingsImmediate(float alpha)
 	vector<int> things_arrows;
 	long last_update = thing_sprites_updated;
 
-	// Draw thing shadows if needed
+	// Add thing shadows if needed
 	if (thing_shadow > 0.01f && thing_drawtype != TDT_SPRITE)
 	{
-		glEnable(GL_TEXTURE_2D);
 		GLTexture* tex_shadow = MapEditor::textureManager().getEditorImage("thing/shadow");
 		if (thing_drawtype == TDT_SQUARE || thing_drawtype == TDT_SQUARESPRITE || thing_drawtype == TDT_FRAMEDSPRITE)
 			tex_shadow = MapEditor::textureManager().getEditorImage("thing/square/shadow");
 		if (tex_shadow)
 		{
-			tex_shadow->bind();
-			glColor4f(0.0f, 0.0f, 0.0f, alpha*thing_shadow);
-
-			// Setup point sprites if supported
-			bool point = false;
-			if (OpenGL::pointSpriteSupport())
-			{
-				glEnable(GL_POINT_SPRITE);
-				glTexEnvi(GL_POINT_SPRITE, GL_COORD_REPLACE, GL_TRUE);
-				point = true;
-			}
-
+			things_batch.setKey(LAYER_SHADOWS);
+			things_batch.setColour(0.0f, 0.0f, 0.0f, alpha*thing_shadow);
 			for (unsigned a = 0; a < map->nThings(); a++)
 			{
 				if (vis_t[a] > 0)
@@ -1167,46 +1189,23 @@ void MapRenderer2D::renderThingsImmediate(float alpha)
 				double radius = (tt.radius()+1);
 				if (tt.shrinkOnZoom()) radius = scaledRadius(radius);
 				radius *= 1.3;
-				x = thing->xPos();
-				y = thing->yPos();
 
-				// Draw shadow
-				if (point && radius*2*view_scale <= OpenGL::maxPointSize())
-				{
-					// Point sprite
-					glPointSize(radius*2*view_scale);
-					glBegin(GL_POINTS);
-					glVertex2d(x, y);
-					glEnd();
-				}
-				else
-				{
-					// Textured quad
-					if (point) glDisable(GL_POINT_SPRITE);
-					glBegin(GL_QUADS);
-					glTexCoord2f(0.0f, 1.0f);	glVertex2d(x-radius, y-radius);
-					glTexCoord2f(0.0f, 0.0f);	glVertex2d(x-radius, y+radius);
-					glTexCoord2f(1.0f, 0.0f);	glVertex2d(x+radius, y+radius);
-					glTexCoord2f(1.0f, 1.0f);	glVertex2d(x+radius, y-radius);
-					glEnd();
-					if (point) glEnable(GL_POINT_SPRITE);
-				}
+				things_batch.addRect(tex_shadow, thing->xPos(), thing->yPos(), radius, radius, frect_t(0, 0, 1, 1));
 			}
-
-			if (point)
-				glDisable(GL_POINT_SPRITE);
 		}
 	}
 
-	// Draw things
+	// Add things
 	double talpha;
+	things_batch.setKey(LAYER_THINGS);
 	for (unsigned a = 0; a < map->nThings(); a++)
 	{
+		thing = map->getThing(a);
+		things_batch_filtered[a] = thing->isFiltered() ? 1 : 0;
 		if (vis_t[a] > 0)
 			continue;
 
 		// Get thing info
-		thing = map->getThing(a);
 		x = thing->xPos();
 		y = thing->yPos();
 		angle = thing->getAngle();
@@ -1228,23 +1227,22 @@ void MapRenderer2D::renderThingsImmediate(float alpha)
 		if (thing_drawtype == TDT_SPRITE)  		// Drawtype 2: Sprites
 		{
 			// Check if we need to draw the direction arrow for this thing
-			if (renderSpriteThing(x, y, angle, tt, a, talpha))
+			if (renderSpriteThing(things_batch, x, y, angle, tt, a, talpha))
 				things_arrows.push_back(a);
 		}
 		else if (thing_drawtype == TDT_ROUND)	// Drawtype 1: Round
-			renderRoundThing(x, y, angle, tt, talpha);
+			renderRoundThing(things_batch, x, y, angle, tt, talpha);
 		else  							// Drawtype 0 (or other): Square
 		{
-			if (renderSquareThing(x, y, angle, tt, talpha, (thing_drawtype < TDT_SQUARESPRITE), (thing_drawtype == TDT_FRAMEDSPRITE)))
+			if (renderSquareThing(things_batch, x, y, angle, tt, talpha, (thing_drawtype < TDT_SQUARESPRITE), (thing_drawtype == TDT_FRAMEDSPRITE)))
 				things_arrows.push_back(a);
 		}
 	}
 
-	// Draw thing sprites within squares if that drawtype is set
+	// Add thing sprites within squares if that drawtype is set
 	if (thing_drawtype > TDT_SPRITE)
 	{
-		glEnable(GL_TEXTURE_2D);
-
+		things_batch.setKey(LAYER_SPRITES);
 		for (unsigned a = 0; a < map->nThings(); a++)
 		{
 			if (vis_t[a] > 0)
@@ -1265,58 +1263,32 @@ void MapRenderer2D::renderThingsImmediate(float alpha)
 			else
 				talpha = alpha;
 
-			renderSpriteThing(x, y, thing->getAngle(), tt, a, talpha, true);
+			renderSpriteThing(things_batch, x, y, thing->getAngle(), tt, a, talpha, true);
 		}
 	}
 
-	// Draw any thing direction arrows needed
-	if (things_arrows.size() > 0)
+	// Add any thing direction arrows needed
+	GLTexture* tex_arrow = MapEditor::textureManager().getEditorImage("arrow");
+	if (things_arrows.size() > 0 && tex_arrow)
 	{
-		rgba_t acol = COL_WHITE;
-		acol.a = 255*alpha*arrow_alpha;
-		OpenGL::setColour(acol);
-		//glColor4f(1.0f, 1.0f, 1.0f, alpha * arrow_alpha);
-		GLTexture* tex_arrow = MapEditor::textureManager().getEditorImage("arrow");
-		if (tex_arrow)
+		things_batch.setKey(LAYER_ARROWS);
+		things_batch.setColour(1.0f, 1.0f, 1.0f, alpha*arrow_alpha);
+		for (unsigned a = 0; a < things_arrows.size(); a++)
 		{
-			glEnable(GL_TEXTURE_2D);
-			tex_arrow->bind();
-
-			for (unsigned a = 0; a < things_arrows.size(); a++)
+			thing = map->getThing(things_arrows[a]);
+			if (arrow_colour)
 			{
-				thing = map->getThing(things_arrows[a]);
-				if (arrow_colour)
-				{
-					auto& tt = Game::configuration().thingType(thing->getType());
-					if (tt.defined())
-					{
-						acol.set(tt.colour());
-						acol.a = 255*alpha*arrow_alpha;
-						OpenGL::setColour(acol, false);
-						//glColor4f(tt->getColour().fr(), tt->getColour().fg(), tt->getColour().fb(), alpha * arrow_alpha);
-					}
-				}
-				x = thing->xPos();
-				y = thing->yPos();
-
-				glPushMatrix();
-				glTranslated(x, y, 0);
-				glRotated(thing->getAngle(), 0, 0, 1);
-
-				glBegin(GL_QUADS);
-				glTexCoord2f(0.0f, 1.0f);	glVertex2d(-32, -32);
-				glTexCoord2f(0.0f, 0.0f);	glVertex2d(-32, 32);
-				glTexCoord2f(1.0f, 0.0f);	glVertex2d(32, 32);
-				glTexCoord2f(1.0f, 1.0f);	glVertex2d(32, -32);
-				glEnd();
-
-				glPopMatrix();
+				auto& tt = Game::configuration().thingType(thing->getType());
+				if (tt.defined())
+					things_batch.setColour(tt.colour().fr(), tt.colour().fg(), tt.colour().fb(), alpha*arrow_alpha);
 			}
+
+			things_batch.addRect(tex_arrow, thing->xPos(), thing->yPos(), 32, 32, frect_t(0, 0, 1, 1), thing->getAngle());
 		}
 	}
 
-	// Disable textures
-	glDisable(GL_TEXTURE_2D);
+	things_batch_sprites = thing_sprites_updated;
+	things_batch_ok = true;
 }
 
 /* MapRenderer2D::renderThingHilight
@@ -1604,7 +1576,7 @@ void MapRenderer2D::renderPathedThings(vector<MapThing*>& things)
 			// Dragon Path
 			if (tt.flags() & Game::ThingType::FLAG_DRAGON)
 			{
-				MapThing* first = map->getFirstThingWithId(thing->intProperty("id"));
+				MapThing* first = map->getFirstThingWithId(thing->intProp(MobjKeys::id));
 				if (first)
 				{
 					path.from_index = thing->getIndex();
@@ -1617,21 +1589,21 @@ void MapRenderer2D::renderPathedThings(vector<MapThing*>& things)
 					map->getDragonTargets(first, dragon_things);
 					for (unsigned d = 0; d < dragon_things.size(); ++d)
 					{
-						int id1 = dragon_things[d]->intProperty("id");
-						int a11 = dragon_things[d]->intProperty("arg0");
-						int a12 = dragon_things[d]->intProperty("arg1");
-						int a13 = dragon_things[d]->intProperty("arg2");
-						int a14 = dragon_things[d]->intProperty("arg3");
-						int a15 = dragon_things[d]->intProperty("arg4");
+						int id1 = dragon_things[d]->intProp(MobjKeys::id);
+						int a11 = dragon_things[d]->intProp(MobjKeys::arg0);
+						int a12 = dragon_things[d]->intProp(MobjKeys::arg1);
+						int a13 = dragon_things[d]->intProp(MobjKeys::arg2);
+						int a14 = dragon_things[d]->intProp(MobjKeys::arg3);
+						int a15 = dragon_things[d]->intProp(MobjKeys::arg4);
 						auto& tt1 = Game::configuration().thingType(dragon_things[d]->getType());
 						for (unsigned e = d + 1; e < dragon_things.size(); ++e)
 						{
-							int id2 = dragon_things[e]->intProperty("id");
-							int a21 = dragon_things[e]->intProperty("arg0");
-							int a22 = dragon_things[e]->intProperty("arg1");
-							int a23 = dragon_things[e]->intProperty("arg2");
-							int a24 = dragon_things[e]->intProperty("arg3");
-							int a25 = dragon_things[e]->intProperty("arg4");
+							int id2 = dragon_things[e]->intProp(MobjKeys::id);
+							int a21 = dragon_things[e]->intProp(MobjKeys::arg0);
+							int a22 = dragon_things[e]->intProp(MobjKeys::arg1);
+							int a23 = dragon_things[e]->intProp(MobjKeys::arg2);
+							int a24 = dragon_things[e]->intProp(MobjKeys::arg3);
+							int a25 = dragon_things[e]->intProp(MobjKeys::arg4);
 							auto& tt2 = Game::configuration().thingType(dragon_things[e]->getType());
 							bool l1to2 = ((a11 == id2) || (a12 == id2) || (a13 == id2) || (a14 == id2) || (a15 == id2));
 							bool l2to1 = ((a21 == id1) || (a22 == id1) || (a23 == id1) || (a24 == id1) || (a25 == id1));
@@ -1697,13 +1669,13 @@ void MapRenderer2D::renderPathedThings(vector<MapThing*>& things)
 						na[3] = ('0' + pos - 1);
 						tid2 += (256 * thing2->intProperty(na));
 					}
-					if (thing2->intProperty("id") == tid)
+					if (thing2->intProp(MobjKeys::id) == tid)
 					{
 						path.from_index = thing->getIndex();
 						path.to_index = thing2->getIndex();
-						path.type = (tid2 == thing->intProperty("id")) ? PATH_NORMAL_BOTH : PATH_NORMAL;
+						path.type = (tid2 == thing->intProp(MobjKeys::id)) ? PATH_NORMAL_BOTH : PATH_NORMAL;
 					}
-					else if (thing->intProperty("id") == tid2)
+					else if (thing->intProp(MobjKeys::id) == tid2)
 					{
 						path.from_index = thing2->getIndex();
 						path.to_index = thing->getIndex();
@@ -1727,7 +1699,7 @@ void MapRenderer2D::renderPathedThings(vector<MapThing*>& things)
 
 		MapThing *from = map->getThing(thing_paths[a].from_index);
 
-		if (from && ((from->intProperty("arg3") | (from->intProperty("arg4") << 8)) > 0))
+		if (from && ((from->intProp(MobjKeys::arg3) | (from->intProp(MobjKeys::arg4) << 8)) > 0))
 		{
 			MapThing *to = map->getThing(thing_paths[a].to_index);
 			if (!to)
@@ -1747,6 +1719,8 @@ void MapRenderer2D::renderPathedThings(vector<MapThing*>& things)
  *******************************************************************/
 void MapRenderer2D::renderFlats(int type, bool texture, float alpha)
 {
+	PROFILE_SCOPE("Flats");
+
 	// Don't bother if (practically) invisible
 	if (alpha <= 0.01f)
 		return;
@@ -1866,32 +1840,32 @@ void MapRenderer2D::renderFlatsImmediate(int type, bool texture, float alpha)
 				{
 					if (Game::configuration().featureSupported(UDMFFeature::FlatPanning))
 					{
-						ox = sector->floatProperty("xpanningfloor");
-						oy = sector->floatProperty("ypanningfloor");
+						ox = sector->floatProp(MobjKeys::xpanningfloor);
+						oy = sector->floatProp(MobjKeys::ypanningfloor);
 					}
 					if (Game::configuration().featureSupported(UDMFFeature::FlatScaling))
 					{
-						sx *= (1.0 / sector->floatProperty("xscalefloor"));
-						sy *= (1.0 / sector->floatProperty("yscalefloor"));
+						sx *= (1.0 / sector->floatProp(MobjKeys::xscalefloor));
+						sy *= (1.0 / sector->floatProp(MobjKeys::yscalefloor));
 					}
 					if (Game::configuration().featureSupported(UDMFFeature::FlatRotation))
-						rot = sector->floatProperty("rotationfloor");
+						rot = sector->floatProp(MobjKeys::rotationfloor);
 				}
 				// Ceiling
 				else
 				{
 					if (Game::configuration().featureSupported(UDMFFeature::FlatPanning))
 					{
-						ox = sector->floatProperty("xpanningceiling");
-						oy = sector->floatProperty("ypanningceiling");
+						ox = sector->floatProp(MobjKeys::xpanningceiling);
+						oy = sector->floatProp(MobjKeys::ypanningceiling);
 					}
 					if (Game::configuration().featureSupported(UDMFFeature::FlatScaling))
 					{
-						sx *= (1.0 / sector->floatProperty("xscaleceiling"));
-						sy *= (1.0 / sector->floatProperty("yscaleceiling"));
+						sx *= (1.0 / sector->floatProp(MobjKeys::xscaleceiling));
+						sy *= (1.0 / sector->floatProp(MobjKeys::yscaleceiling));
 					}
 					if (Game::configuration().featureSupported(UDMFFeature::FlatRotation))
-						rot = sector->floatProperty("rotationceiling");
+						rot = sector->floatProp(MobjKeys::rotationceiling);
 				}
 			}
 
@@ -1942,23 +1916,34 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 		last_flat_type = type;
 	}
 
-	// First, check if any polygon vertex data has changed (in this case we need to refresh the entire vbo)
-	for (unsigned a = 0; a < map->nSectors(); a++)
+	// Create VBO if necessary
+	if (vbo_flats == 0 || vbo_flats_slots.size() != map->nSectors())
 	{
-		Polygon2D* poly = map->getSector(a)->getPolygon();
-		if (poly && poly->vboUpdate() > 1)
+		updateFlatsVBO();
+		vbo_updated = true;
+	}
+
+	// Otherwise, rewrite any polygons whose vertex data has changed
+	// (or the entire vbo if one no longer fits)
+	else if (flats_use_vbo)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, vbo_flats);
+		for (unsigned a = 0; a < map->nSectors(); a++)
 		{
-			//LOG_MESSAGE(1, "Updating sector %d polygon vbo data", a);
-			updateFlatsVBO();
+			MapSector* sector = map->getSector(a);
+			if (sector->getPolygon()->vboUpdate() <= 1 && vbo_flats_slots[a].id == sector->getId())
+				continue;
+
 			vbo_updated = true;
+			if (!updateFlatVBO(a, sector))
+			{
+				updateFlatsVBO();
+				break;
+			}
 		}
-	}
 
-	// Create VBO if necessary
-	if (!vbo_updated && vbo_flats == 0)
-	{
-		updateFlatsVBO();
-		vbo_updated = true;
+		if (vbo_updated)
+			flats_updated = App::runTimer();
 	}
 
 	//if (vbo_updated)
@@ -2021,32 +2006,32 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 				{
 					if (Game::configuration().featureSupported(UDMFFeature::FlatPanning))
 					{
-						ox = sector->floatProperty("xpanningfloor");
-						oy = sector->floatProperty("ypanningfloor");
+						ox = sector->floatProp(MobjKeys::xpanningfloor);
+						oy = sector->floatProp(MobjKeys::ypanningfloor);
 					}
 					if (Game::configuration().featureSupported(UDMFFeature::FlatScaling))
 					{
-						sx *= (1.0 / sector->floatProperty("xscalefloor"));
-						sy *= (1.0 / sector->floatProperty("yscalefloor"));
+						sx *= (1.0 / sector->floatProp(MobjKeys::xscalefloor));
+						sy *= (1.0 / sector->floatProp(MobjKeys::yscalefloor));
 					}
 					if (Game::configuration().featureSupported(UDMFFeature::FlatRotation))
-						rot = sector->floatProperty("rotationfloor");
+						rot = sector->floatProp(MobjKeys::rotationfloor);
 				}
 				// Ceiling
 				else
 				{
 					if (Game::configuration().featureSupported(UDMFFeature::FlatPanning))
 					{
-						ox = sector->floatProperty("xpanningceiling");
-						oy = sector->floatProperty("ypanningceiling");
+						ox = sector->floatProp(MobjKeys::xpanningceiling);
+						oy = sector->floatProp(MobjKeys::ypanningceiling);
 					}
 					if (Game::configuration().featureSupported(UDMFFeature::FlatScaling))
 					{
-						sx *= (1.0 / sector->floatProperty("xscaleceiling"));
-						sy *= (1.0 / sector->floatProperty("yscaleceiling"));
+						sx *= (1.0 / sector->floatProp(MobjKeys::xscaleceiling));
+						sy *= (1.0 / sector->floatProp(MobjKeys::yscaleceiling));
 					}
 					if (Game::configuration().featureSupported(UDMFFeature::FlatRotation))
-						rot = sector->floatProperty("rotationceiling");
+						rot = sector->floatProp(MobjKeys::rotationceiling);
 				}
 			}
 			// Scaling applies to offsets as well.
@@ -2289,57 +2274,50 @@ void MapRenderer2D::renderTaggedFlats(vector<MapSector*>& sectors, float fade)
 	}
 }
 
-/* MapRenderer2D::renderMovingVertices
- * Renders the moving overlay for vertex indices in [vertices], to
- * show movement by [move_vec]
+/* MapRenderer2D::renderMovingLinesPreview
+ * Renders lines affected by the move operation [move], with their
+ * moving vertices offset by the current move vector
  *******************************************************************/
-void MapRenderer2D::renderMovingVertices(const vector<MapEditor::Item>& vertices, fpoint2_t move_vec)
+void MapRenderer2D::renderMovingLinesPreview(const MoveObjects& move)
 {
-	uint8_t* lines_drawn = new uint8_t[map->nLines()];
-	memset(lines_drawn, 0, map->nLines());
-
-	// Determine what lines need drawing (and which of their vertices are being moved)
-	for (unsigned a = 0; a < vertices.size(); a++)
-	{
-		MapVertex* v = map->getVertex(vertices[a].index);
-		for (unsigned l = 0; l < v->nConnectedLines(); l++)
-		{
-			MapLine* line = v->connectedLine(l);
-
-			if (line->v1() == v) lines_drawn[line->getIndex()] |= 1;
-			if (line->v2() == v) lines_drawn[line->getIndex()] |= 2;
-		}
-	}
+	fpoint2_t move_vec = move.offset();
 
 	// Draw any lines attached to the moving vertices
 	glLineWidth(line_width);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glBegin(GL_LINES);
-	for (unsigned a = 0; a < map->nLines(); a++)
+	for (auto& ml : move.lines())
 	{
-		MapLine* line = map->getLine(a);
-		uint8_t drawn = lines_drawn[line->getIndex()];
-
-		// Skip if not attached to any moving vertices
-		if (drawn == 0)
-			continue;
+		MapLine* line = ml.line;
 
 		// Set line colour
 		OpenGL::setColour(lineColour(line, true), false);
 
 		// First vertex
-		if (drawn & 1)
+		if (ml.move_v1)
 			glVertex2d(line->x1() + move_vec.x, line->y1() + move_vec.y);
 		else
 			glVertex2d(line->x1(), line->y1());
 
 		// Second vertex
-		if (drawn & 2)
+		if (ml.move_v2)
 			glVertex2d(line->x2() + move_vec.x, line->y2() + move_vec.y);
 		else
 			glVertex2d(line->x2(), line->y2());
 	}
 	glEnd();
+}
+
+/* MapRenderer2D::renderMovingVertices
+ * Renders the moving overlay for vertices in the move operation
+ * [move], to show movement by its current move vector
+ *******************************************************************/
+void MapRenderer2D::renderMovingVertices(const MoveObjects& move)
+{
+	fpoint2_t move_vec = move.offset();
+
+	// Draw any lines attached to the moving vertices
+	renderMovingLinesPreview(move);
 
 	// Set 'moving' colour
 	OpenGL::setColour(ColourConfiguration::getColour("map_moving"));
@@ -2347,15 +2325,11 @@ void MapRenderer2D::renderMovingVertices(const vector<MapEditor::Item>& vertices
 	// Draw moving vertex overlays
 	bool point = setupVertexRendering(1.5f);
 	glBegin(GL_POINTS);
-	for (unsigned a = 0; a < vertices.size(); a++)
-	{
-		glVertex2d(map->getVertex(vertices[a].index)->xPos() + move_vec.x,
-				   map->getVertex(vertices[a].index)->yPos() + move_vec.y);
-	}
+	for (auto vertex : move.vertices())
+		glVertex2d(vertex->xPos() + move_vec.x, vertex->yPos() + move_vec.y);
 	glEnd();
 
 	// Clean up
-	delete[] lines_drawn;
 	if (point)
 	{
 		glDisable(GL_POINT_SPRITE);
@@ -2364,67 +2338,16 @@ void MapRenderer2D::renderMovingVertices(const vector<MapEditor::Item>& vertices
 }
 
 /* MapRenderer2D::renderMovingLines
- * Renders the moving overlay for line indices in [lines], to show
- * movement by [move_vec]
+ * Renders the moving overlay for lines in the move operation [move]
+ * (lines mode, or the lines of moving sectors in sectors mode), to
+ * show movement by its current move vector
  *******************************************************************/
-void MapRenderer2D::renderMovingLines(const vector<MapEditor::Item>& lines, fpoint2_t move_vec)
+void MapRenderer2D::renderMovingLines(const MoveObjects& move)
 {
-	uint8_t* lines_drawn = new uint8_t[map->nLines()];
-	memset(lines_drawn, 0, map->nLines());
-
-	// Determine what lines need drawing (and which of their vertices are being moved)
-	for (unsigned a = 0; a < lines.size(); a++)
-	{
-		// Check first vertex
-		MapVertex* v = map->getLine(lines[a].index)->v1();
-		for (unsigned l = 0; l < v->nConnectedLines(); l++)
-		{
-			MapLine* line = v->connectedLine(l);
-
-			if (line->v1() == v) lines_drawn[line->getIndex()] |= 1;
-			if (line->v2() == v) lines_drawn[line->getIndex()] |= 2;
-		}
-
-		// Check second vertex
-		v = map->getLine(lines[a].index)->v2();
-		for (unsigned l = 0; l < v->nConnectedLines(); l++)
-		{
-			MapLine* line = v->connectedLine(l);
-
-			if (line->v1() == v) lines_drawn[line->getIndex()] |= 1;
-			if (line->v2() == v) lines_drawn[line->getIndex()] |= 2;
-		}
-	}
+	fpoint2_t move_vec = move.offset();
 
 	// Draw any lines attached to the moving vertices
-	glLineWidth(line_width);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glBegin(GL_LINES);
-	for (unsigned a = 0; a < map->nLines(); a++)
-	{
-		MapLine* line = map->getLine(a);
-		uint8_t drawn = lines_drawn[line->getIndex()];
-
-		// Skip if not attached to any moving vertices
-		if (drawn == 0)
-			continue;
-
-		// Set line colour
-		OpenGL::setColour(lineColour(line, true), false);
-
-		// First vertex
-		if (drawn & 1)
-			glVertex2d(line->x1() + move_vec.x, line->y1() + move_vec.y);
-		else
-			glVertex2d(line->x1(), line->y1());
-
-		// Second vertex
-		if (drawn & 2)
-			glVertex2d(line->x2() + move_vec.x, line->y2() + move_vec.y);
-		else
-			glVertex2d(line->x2(), line->y2());
-	}
-	glEnd();
+	renderMovingLinesPreview(move);
 
 	// Set 'moving' colour
 	OpenGL::setColour(ColourConfiguration::getColour("map_moving"));
@@ -2432,48 +2355,15 @@ void MapRenderer2D::renderMovingLines(const vector<MapEditor::Item>& lines, fpoi
 	// Draw moving line overlays
 	glLineWidth(line_width*3);
 	glBegin(GL_LINES);
-	for (unsigned a = 0; a < lines.size(); a++)
-	{
-		MapLine* line = map->getLine(lines[a].index);
-		glVertex2d(line->x1() + move_vec.x, line->y1() + move_vec.y);
-		glVertex2d(line->x2() + move_vec.x, line->y2() + move_vec.y);
-	}
-	glEnd();
-
-	// Clean up
-	delete[] lines_drawn;
-}
-
-/* MapRenderer2D::renderMovingSectors
- * Renders the moving overlay for sector indices in [sectors], to
- * show movement by [move_vec]
- *******************************************************************/
-void MapRenderer2D::renderMovingSectors(const vector<MapEditor::Item>& sectors, fpoint2_t move_vec)
-{
-	// Determine what lines are being moved
-	uint8_t* lines_moved = new uint8_t[map->nLines()];
-	memset(lines_moved, 0, map->nLines());
-	for (unsigned a = 0; a < sectors.size(); a++)
+	for (auto& ml : move.lines())
 	{
-		// Go through connected sides
-		vector<MapSide*>& sides = map->getSector(sectors[a].index)->connectedSides();
-		for (unsigned s = 0; s < sides.size(); s++)
-			lines_moved[sides[s]->getParentLine()->getIndex()] = 1;	// Mark parent line as moved
-	}
+		if (!ml.item)
+			continue;
 
-	// Build list of moving lines
-	vector<MapEditor::Item> lines;
-	for (unsigned a = 0; a < map->nLines(); a++)
-	{
-		if (lines_moved[a] > 0)
-			lines.push_back({ (int)a, MapEditor::ItemType::Line });
+		glVertex2d(ml.line->x1() + move_vec.x, ml.line->y1() + move_vec.y);
+		glVertex2d(ml.line->x2() + move_vec.x, ml.line->y2() + move_vec.y);
 	}
-
-	// Draw moving lines
-	renderMovingLines(lines, move_vec);
-
-	// Clean up
-	delete[] lines_moved;
+	glEnd();
 }
 
 /* MapRenderer2D::renderMovingThings
@@ -2486,7 +2376,7 @@ void MapRenderer2D::renderMovingThings(const vector<MapEditor::Item>& things, fp
 	glEnable(GL_TEXTURE_2D);
 	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	tex_last = nullptr;
+	GLQuadBatch batch;
 
 	// Draw things
 	MapThing* thing = nullptr;
@@ -2504,18 +2394,17 @@ void MapRenderer2D::renderMovingThings(const vector<MapEditor::Item>& things, fp
 
 		// Draw thing depending on 'things_drawtype' cvar
 		if (thing_drawtype == TDT_SPRITE)		// Drawtype 2: Sprites
-			renderSpriteThing(x, y, angle, tt, a, 1.0f);
+			renderSpriteThing(batch, x, y, angle, tt, a, 1.0f);
 		else if (thing_drawtype == TDT_ROUND)	// Drawtype 1: Round
-			renderRoundThing(x, y, angle, tt, 1.0f);
+			renderRoundThing(batch, x, y, angle, tt, 1.0f);
 		else							// Drawtype 0 (or other): Square
-			renderSquareThing(x, y, angle, tt, 1.0f, thing_drawtype < TDT_SQUARESPRITE, thing_drawtype == TDT_FRAMEDSPRITE);
+			renderSquareThing(batch, x, y, angle, tt, 1.0f, thing_drawtype < TDT_SQUARESPRITE, thing_drawtype == TDT_FRAMEDSPRITE);
 	}
 
 	// Draw thing sprites within squares if that drawtype is set
 	if (thing_drawtype > TDT_SPRITE)
 	{
-		glEnable(GL_TEXTURE_2D);
-
+		batch.setKey(1);
 		for (unsigned a = 0; a < things.size(); a++)
 		{
 			// Get thing info
@@ -2525,9 +2414,10 @@ void MapRenderer2D::renderMovingThings(const vector<MapEditor::Item>& things, fp
 			y = thing->yPos() + move_vec.y;
 			angle = thing->getAngle();
 
-			renderSpriteThing(x, y, angle, tt, things[a].index, 1.0f, true);
+			renderSpriteThing(batch, x, y, angle, tt, things[a].index, 1.0f, true);
 		}
 	}
+	batch.draw();
 
 	// Set 'moving' colour
 	OpenGL::setColour(ColourConfiguration::getColour("map_moving"));
@@ -2565,7 +2455,7 @@ void MapRenderer2D::renderPasteThings(vector<MapThing*>& things, fpoint2_t pos)
 	glEnable(GL_TEXTURE_2D);
 	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	tex_last = nullptr;
+	GLQuadBatch batch;
 
 	// Draw things
 	MapThing* thing = nullptr;
@@ -2583,18 +2473,17 @@ void MapRenderer2D::renderPasteThings(vector<MapThing*>& things, fpoint2_t pos)
 
 		// Draw thing depending on 'things_drawtype' cvar
 		if (thing_drawtype == TDT_SPRITE)		// Drawtype 2: Sprites
-			renderSpriteThing(x, y, angle, tt, wxUINT32_MAX, 1.0f);
+			renderSpriteThing(batch, x, y, angle, tt, wxUINT32_MAX, 1.0f);
 		else if (thing_drawtype == TDT_ROUND)	// Drawtype 1: Round
-			renderRoundThing(x, y, angle, tt, 1.0f);
+			renderRoundThing(batch, x, y, angle, tt, 1.0f);
 		else							// Drawtype 0 (or other): Square
-			renderSquareThing(x, y, angle, tt, 1.0f, thing_drawtype < TDT_SQUARESPRITE, thing_drawtype == TDT_FRAMEDSPRITE);
+			renderSquareThing(batch, x, y, angle, tt, 1.0f, thing_drawtype < TDT_SQUARESPRITE, thing_drawtype == TDT_FRAMEDSPRITE);
 	}
 
 	// Draw thing sprites within squares if that drawtype is set
 	if (thing_drawtype > TDT_SPRITE)
 	{
-		glEnable(GL_TEXTURE_2D);
-
+		batch.setKey(1);
 		for (unsigned a = 0; a < things.size(); a++)
 		{
 			// Get thing info
@@ -2604,9 +2493,10 @@ void MapRenderer2D::renderPasteThings(vector<MapThing*>& things, fpoint2_t pos)
 			y = thing->yPos() + pos.y;
 			angle = thing->getAngle();
 
-			renderSpriteThing(x, y, angle, tt, wxUINT32_MAX, 1.0f, true);
+			renderSpriteThing(batch, x, y, angle, tt, wxUINT32_MAX, 1.0f, true);
 		}
 	}
+	batch.draw();
 
 	// Set 'drawing' colour
 	OpenGL::setColour(ColourConfiguration::getColour("map_linedraw"));
@@ -2708,7 +2598,7 @@ void MapRenderer2D::renderObjectEditGroup(ObjectEditGroup* group)
 		glEnable(GL_TEXTURE_2D);
 		glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		tex_last = nullptr;
+		GLQuadBatch batch;
 
 		// Draw things
 		MapThing* thing = nullptr;
@@ -2726,18 +2616,17 @@ void MapRenderer2D::renderObjectEditGroup(ObjectEditGroup* group)
 
 			// Draw thing depending on 'things_drawtype' cvar
 			if (thing_drawtype == TDT_SPRITE)		// Drawtype 2: Sprites
-				renderSpriteThing(x, y, angle, tt, thing->getIndex(), 1.0f);
+				renderSpriteThing(batch, x, y, angle, tt, thing->getIndex(), 1.0f);
 			else if (thing_drawtype == TDT_ROUND)	// Drawtype 1: Round
-				renderRoundThing(x, y, angle, tt, 1.0f);
+				renderRoundThing(batch, x, y, angle, tt, 1.0f);
 			else							// Drawtype 0 (or other): Square
-				renderSquareThing(x, y, angle, tt, 1.0f, thing_drawtype < TDT_SQUARESPRITE, thing_drawtype == TDT_FRAMEDSPRITE);
+				renderSquareThing(batch, x, y, angle, tt, 1.0f, thing_drawtype < TDT_SQUARESPRITE, thing_drawtype == TDT_FRAMEDSPRITE);
 		}
 
 		// Draw thing sprites within squares if that drawtype is set
 		if (thing_drawtype > TDT_SPRITE)
 		{
-			glEnable(GL_TEXTURE_2D);
-
+			batch.setKey(1);
 			for (unsigned a = 0; a < things.size(); a++)
 			{
 				// Get thing info
@@ -2747,9 +2636,10 @@ void MapRenderer2D::renderObjectEditGroup(ObjectEditGroup* group)
 				y = things[a].position.y;
 				angle = thing->getAngle();
 
-				renderSpriteThing(x, y, angle, tt, thing->getIndex(), 1.0f, true);
+				renderSpriteThing(batch, x, y, angle, tt, thing->getIndex(), 1.0f, true);
 			}
 		}
+		batch.draw();
 
 		// Set 'moving' colour
 		OpenGL::setColour(ColourConfiguration::getColour("map_object_edit"));
@@ -2780,104 +2670,147 @@ void MapRenderer2D::renderObjectEditGroup(ObjectEditGroup* group)
 }
 
 /* MapRenderer2D::updateVerticesVBO
- * (Re)builds the map vertices VBO
+ * Updates the map vertices VBO, only vertices that have changed
+ * since the last update are uploaded
  *******************************************************************/
 void MapRenderer2D::updateVerticesVBO()
 {
+	PROFILE_SCOPE("VBO Update");
+
 	// Create VBO if needed
 	if (vbo_vertices == 0)
 		glGenBuffers(1, &vbo_vertices);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_vertices);
 
-	// Fill vertices VBO
-	int nfloats = map->nVertices()*2;
-	GLfloat* verts = new GLfloat[nfloats];
-	unsigned i = 0;
-	for (unsigned a = 0; a < map->nVertices(); a++)
+	// (Re)allocate the VBO with some room to grow if there are more
+	// vertices than will fit, all slots need writing in that case
+	unsigned count = map->nVertices();
+	if (count > vbo_vertices_ids.size())
 	{
-		verts[i++] = map->getVertex(a)->xPos();
-		verts[i++] = map->getVertex(a)->yPos();
+		unsigned size = count + count / 2 + 64;
+		vbo_vertices_data.resize(size * 2);
+		vbo_vertices_ids.assign(size, NO_ID);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * size * 2, nullptr, GL_DYNAMIC_DRAW);
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_vertices);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat)*nfloats, verts, GL_STATIC_DRAW);
+
+	// Write vertices that have changed, or are new to their slot
+	long updated = App::runTimer();
+	VBORangeUploader upload(vbo_vertices_data.data(), sizeof(GLfloat) * 2);
+	for (unsigned a = 0; a < count; a++)
+	{
+		MapVertex* vertex = map->getVertex(a);
+		if (vbo_vertices_ids[a] == vertex->getId() && vertex->modifiedTime() < vertices_updated)
+			continue;
+
+		vbo_vertices_data[a * 2] = vertex->xPos();
+		vbo_vertices_data[a * 2 + 1] = vertex->yPos();
+		vbo_vertices_ids[a] = vertex->getId();
+		upload.add(a);
+	}
+	upload.flush();
 
 	// Clean up
-	delete[] verts;
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-	n_vertices = map->nVertices();
-	vertices_updated = App::runTimer();
+	n_vertices = count;
+	vertices_updated = updated;
 }
 
 /* MapRenderer2D::updateLinesVBO
- * (Re)builds the map lines VBO
+ * Updates the map lines VBO, only lines that have changed (or moved)
+ * since the last update are uploaded
  *******************************************************************/
 void MapRenderer2D::updateLinesVBO(bool show_direction, float base_alpha)
 {
+	PROFILE_SCOPE("VBO Update");
+
 	LOG_MESSAGE(3, "Updating lines VBO");
 
 	// Create VBO if needed
 	if (vbo_lines == 0)
 		glGenBuffers(1, &vbo_lines);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_lines);
 
 	// Determine the number of vertices per line
 	int vpl = 2;
 	if (show_direction) vpl = 4;
 
-	// Fill lines VBO
-	int nverts = map->nLines()*vpl;
-	glvert_t* lines = new glvert_t[nverts];
-	unsigned v = 0;
+	// (Re)allocate the VBO with some room to grow if there are more
+	// lines than will fit, or the vertex layout or alpha changed (all
+	// slots need writing in that case)
+	unsigned count = map->nLines();
+	if (count > vbo_lines_slots.size() || show_direction != lines_dirs || base_alpha != lines_alpha)
+	{
+		unsigned size = MAX(count + count / 2 + 64, (unsigned)vbo_lines_slots.size());
+		line_slot_t empty = { NO_ID, false };
+		vbo_lines_data.resize(size * vpl);
+		vbo_lines_slots.assign(size, empty);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(glvert_t) * size * vpl, nullptr, GL_DYNAMIC_DRAW);
+		lines_alpha = base_alpha;
+	}
+
+	// Write lines that have changed, or are new to their slot
+	long updated = App::runTimer();
+	VBORangeUploader upload(vbo_lines_data.data(), sizeof(glvert_t) * vpl);
 	rgba_t col;
 	float alpha;
-	for (unsigned a = 0; a < map->nLines(); a++)
+	for (unsigned a = 0; a < count; a++)
 	{
 		MapLine* line = map->getLine(a);
+		line_slot_t& slot = vbo_lines_slots[a];
+		if (slot.id == line->getId() &&
+			slot.filtered == line->isFiltered() &&
+			line->modifiedTime() < lines_updated &&
+			line->v1()->modifiedTime() < lines_updated &&
+			line->v2()->modifiedTime() < lines_updated)
+			continue;
 
 		// Get line colour
 		col = lineColour(line);
 		alpha = base_alpha*col.fa();
 
 		// Set line vertices
-		lines[v].x = line->v1()->xPos();
-		lines[v].y = line->v1()->yPos();
-		lines[v+1].x = line->v2()->xPos();
-		lines[v+1].y = line->v2()->yPos();
+		glvert_t* lines = &vbo_lines_data[a * vpl];
+		lines[0].x = line->v1()->xPos();
+		lines[0].y = line->v1()->yPos();
+		lines[1].x = line->v2()->xPos();
+		lines[1].y = line->v2()->yPos();
 
 		// Set line colour(s)
-		lines[v].r = lines[v+1].r = col.fr();
-		lines[v].g = lines[v+1].g = col.fg();
-		lines[v].b = lines[v+1].b = col.fb();
-		lines[v].a = lines[v+1].a = alpha;
+		lines[0].r = lines[1].r = col.fr();
+		lines[0].g = lines[1].g = col.fg();
+		lines[0].b = lines[1].b = col.fb();
+		lines[0].a = lines[1].a = alpha;
 
 		// Direction tab if needed
 		if (show_direction)
 		{
 			fpoint2_t mid = line->getPoint(MOBJ_POINT_MID);
 			fpoint2_t tab = line->dirTabPoint();
-			lines[v+2].x = mid.x;
-			lines[v+2].y = mid.y;
-			lines[v+3].x = tab.x;
-			lines[v+3].y = tab.y;
+			lines[2].x = mid.x;
+			lines[2].y = mid.y;
+			lines[3].x = tab.x;
+			lines[3].y = tab.y;
 
 			// Colours
-			lines[v+2].r = lines[v+3].r = col.fr();
-			lines[v+2].g = lines[v+3].g = col.fg();
-			lines[v+2].b = lines[v+3].b = col.fb();
-			lines[v+2].a = lines[v+3].a = alpha*0.6f;
+			lines[2].r = lines[3].r = col.fr();
+			lines[2].g = lines[3].g = col.fg();
+			lines[2].b = lines[3].b = col.fb();
+			lines[2].a = lines[3].a = alpha*0.6f;
 		}
 
-		// Next line
-		v += vpl;
+		slot.id = line->getId();
+		slot.filtered = line->isFiltered();
+		upload.add(a);
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_lines);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glvert_t)*nverts, lines, GL_STATIC_DRAW);
+	upload.flush();
 
 	// Clean up
-	delete[] lines;
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-	n_lines = map->nLines();
-	lines_updated = App::runTimer();
+	n_lines = count;
+	lines_dirs = show_direction;
+	lines_updated = updated;
 }
 
 /* MapRenderer2D::updateFlatsVBO
@@ -2885,6 +2818,8 @@ void MapRenderer2D::updateLinesVBO(bool show_direction, float base_alpha)
  *******************************************************************/
 void MapRenderer2D::updateFlatsVBO()
 {
+	PROFILE_SCOPE("VBO Update");
+
 	if (!flats_use_vbo)
 		return;
 
@@ -2892,6 +2827,9 @@ void MapRenderer2D::updateFlatsVBO()
 	if (vbo_flats == 0)
 		glGenBuffers(1, &vbo_flats);
 
+	// Build any out of date sector polygons first (in parallel)
+	map->updateSectorPolygons();
+
 	// Get total size needed
 	unsigned totalsize = 0;
 	for (unsigned a = 0; a < map->nSectors(); a++)
@@ -2900,19 +2838,25 @@ void MapRenderer2D::updateFlatsVBO()
 		totalsize += poly->vboDataSize();
 	}
 
-	// Allocate buffer data
+	// Allocate buffer data, with some room for polygons to grow
+	vbo_flats_size = totalsize + totalsize / 4 + 20 * 1024;
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_flats);
-	glBufferData(GL_ARRAY_BUFFER, totalsize, nullptr, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vbo_flats_size, nullptr, GL_DYNAMIC_DRAW);
 
 	// Write polygon data to VBO
 	unsigned offset = 0;
 	unsigned index = 0;
+	vbo_flats_slots.resize(map->nSectors());
 	for (unsigned a = 0; a < map->nSectors(); a++)
 	{
 		Polygon2D* poly = map->getSector(a)->getPolygon();
+		vbo_flats_slots[a].id = map->getSector(a)->getId();
+		vbo_flats_slots[a].offset = offset;
+		vbo_flats_slots[a].size = poly->vboDataSize();
 		offset = poly->writeToVBO(offset, index);
 		index += poly->totalVertices();
 	}
+	vbo_flats_used = offset;
 
 	// Clean up
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -2920,11 +2864,41 @@ void MapRenderer2D::updateFlatsVBO()
 	flats_updated = App::runTimer();
 }
 
+/* MapRenderer2D::updateFlatVBO
+ * Rewrites the flats VBO data for [sector] (at [index]), in its
+ * existing space if it still fits, otherwise in unused space at the
+ * end of the VBO. The flats VBO must be bound. Returns false if
+ * there isn't enough room for it (and the VBO needs rebuilding)
+ *******************************************************************/
+bool MapRenderer2D::updateFlatVBO(unsigned index, MapSector* sector)
+{
+	Polygon2D* poly = sector->getPolygon();
+	flat_slot_t& slot = vbo_flats_slots[index];
+	unsigned size = poly->vboDataSize();
+	if (size > slot.size)
+	{
+		if (vbo_flats_used + size > vbo_flats_size)
+			return false;
+
+		slot.offset = vbo_flats_used;
+		slot.size = size;
+		vbo_flats_used += size;
+	}
+
+	// Vertex data is 20 bytes per vertex (see Polygon2D::writeToVBO)
+	poly->writeToVBO(slot.offset, slot.offset / 20);
+	slot.id = sector->getId();
+
+	return true;
+}
+
 /* MapRenderer2D::updateVisibility
  * Updates map object visibility info depending on the current view
  *******************************************************************/
 void MapRenderer2D::updateVisibility(fpoint2_t view_tl, fpoint2_t view_br)
 {
+	PROFILE_SCOPE("Visibility");
+
 	// Sector visibility
 	if (map->nSectors() != vis_s.size())
 	{
@@ -2977,6 +2951,9 @@ void MapRenderer2D::updateVisibility(fpoint2_t view_tl, fpoint2_t view_br)
 		else if (radius*view_scale < 2)
 			vis_t[a] = VIS_SMALL;
 	}
+
+	// Things batch needs rebuilding for the new view
+	things_batch_ok = false;
 }
 
 /* MapRenderer2D::forceUpdate
@@ -2989,9 +2966,14 @@ void MapRenderer2D::forceUpdate(float line_alpha)
 	tex_flats.clear();
 	thing_sprites.clear();
 	thing_paths.clear();
+	things_batch_ok = false;
 
 	if (OpenGL::vboSupport())
 	{
+		// Clear VBO slots so everything is rewritten
+		vbo_vertices_ids.assign(vbo_vertices_ids.size(), NO_ID);
+		for (unsigned a = 0; a < vbo_lines_slots.size(); a++)
+			vbo_lines_slots[a].id = NO_ID;
 		updateVerticesVBO();
 		updateLinesVBO(lines_dirs, line_alpha);
 	}
@@ -3,6 +3,7 @@
 #define __MAP_RENDERER_2D__
 
 #include "MapEditor/MapEditor.h"
+#include "OpenGL/GLQuadBatch.h"
 
 // Forward declarations
 class GLTexture;
@@ -10,6 +11,7 @@ class ItemSelection;
 class MapLine;
 class MapSector;
 class MapThing;
+class MoveObjects;
 class ObjectEditGroup;
 class SLADEMap;
 namespace Game { class ThingType; }
@@ -18,7 +20,6 @@ class MapRenderer2D
 {
 private:
 	SLADEMap*	map;
-	GLTexture*	tex_last;
 	long		vertices_updated;
 	long		lines_updated;
 	long		flats_updated;
@@ -72,6 +73,14 @@ private:
 	vector<GLTexture*>	thing_sprites;
 	long				thing_sprites_updated;
 
+	// Batched things (rebuilt only when the view or things change)
+	GLQuadBatch		things_batch;
+	bool			things_batch_ok;
+	long			things_batch_updated;
+	long			things_batch_sprites;
+	string			things_batch_settings;
+	vector<uint8_t>	things_batch_filtered;
+
 	// Thing paths
 	enum
 	{
@@ -89,6 +98,29 @@ private:
 	vector<tpath_t>		thing_paths;
 	long				thing_paths_updated;
 
+	// Persistent VBO contents. Each vertex/line has a fixed slot (by
+	// index), and only slots whose object has changed are uploaded
+	static const unsigned NO_ID = 0xFFFFFFFF;
+	struct line_slot_t
+	{
+		unsigned	id;
+		bool		filtered;
+	};
+	struct flat_slot_t
+	{
+		unsigned	id;
+		unsigned	offset;
+		unsigned	size;
+	};
+	vector<float>		vbo_vertices_data;
+	vector<unsigned>	vbo_vertices_ids;
+	vector<glvert_t>	vbo_lines_data;
+	vector<line_slot_t>	vbo_lines_slots;
+	vector<flat_slot_t>	vbo_flats_slots;
+	unsigned			vbo_flats_size;
+	unsigned			vbo_flats_used;
+	float				lines_alpha;
+
 public:
 	MapRenderer2D(SLADEMap* map);
 	~MapRenderer2D();
@@ -117,6 +149,7 @@ public:
 	bool	setupThingOverlay();
 	void	renderThingOverlay(double x, double y, double radius, bool point);
 	void	renderRoundThing(
+				GLQuadBatch& batch,
 				double x,
 				double y,
 				double angle,
@@ -125,6 +158,7 @@ public:
 				double radius_mult = 1.0
 			);
 	bool	renderSpriteThing(
+				GLQuadBatch& batch,
 				double x,
 				double y,
 				double angle,
@@ -134,6 +168,7 @@ public:
 				bool fitradius = false
 			);
 	void	renderSimpleSquareThing(
+				GLQuadBatch& batch,
 				double x,
 				double y,
 				double angle,
@@ -141,6 +176,7 @@ public:
 				float alpha = 1.0f
 			);
 	bool	renderSquareThing(
+				GLQuadBatch& batch,
 				double x,
 				double y,
 				double angle,
@@ -150,7 +186,7 @@ public:
 				bool framed = false
 			);
 	void	renderThings(float alpha = 1.0f, bool force_dir = false);
-	void	renderThingsImmediate(float alpha);
+	void	updateThingsBatch(float alpha);
 	void	renderThingHilight(int index, float fade);
 	void	renderThingSelection(const ItemSelection& selection, float fade = 1.0f);
 	void	renderTaggedThings(vector<MapThing*>& things, float fade);
@@ -166,9 +202,9 @@ public:
 	void	renderTaggedFlats(vector<MapSector*>& sectors, float fade);
 
 	// Moving
-	void	renderMovingVertices(const vector<MapEditor::Item>& vertices, fpoint2_t move_vec);
-	void	renderMovingLines(const vector<MapEditor::Item>& lines, fpoint2_t move_vec);
-	void	renderMovingSectors(const vector<MapEditor::Item>& sectors, fpoint2_t move_vec);
+	void	renderMovingLinesPreview(const MoveObjects& move);
+	void	renderMovingVertices(const MoveObjects& move);
+	void	renderMovingLines(const MoveObjects& move);
 	void	renderMovingThings(const vector<MapEditor::Item>& things, fpoint2_t move_vec);
 
 	// Paste
@@ -182,6 +218,7 @@ public:
 	void	updateVerticesVBO();
 	void	updateLinesVBO(bool show_direction, float alpha);
 	void	updateFlatsVBO();
+	bool	updateFlatVBO(unsigned index, MapSector* sector);
 
 	// Misc
 	void	setScale(double scale) { view_scale = scale; view_scale_inv = 1.0 / scale; }
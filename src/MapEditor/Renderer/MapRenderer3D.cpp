@@ -42,6 +42,7 @@
 #include "OpenGL/OpenGL.h"
 #include "UI/PaletteChooser.h"
 #include "Utility/MathStuff.h"
+#include "Utility/Profiler.h"
 
 
 /*******************************************************************
@@ -54,6 +55,7 @@ CVAR(Bool, render_fog_quality, true, CVAR_SAVE)
 CVAR(Bool, render_max_dist_adaptive, false, CVAR_SAVE)
 CVAR(Int, render_adaptive_ms, 15, CVAR_SAVE)
 CVAR(Bool, render_3d_sky, true, CVAR_SAVE)
+CVAR(Bool, render_3d_portal_cull, true, CVAR_SAVE)
 CVAR(Int, render_3d_things, 1, CVAR_SAVE)
 CVAR(Int, render_3d_things_style, 1, CVAR_SAVE)
 CVAR(Int, render_3d_hilight, 1, CVAR_SAVE)
@@ -73,6 +75,177 @@ EXTERN_CVAR(Bool, flats_use_vbo)
 EXTERN_CVAR(Bool, use_zeth_icons)
 
 
+/*******************************************************************
+ * FUNCTIONS
+ *******************************************************************/
+
+/* textureKey
+ * Returns the key to sort [texture] by when bucketing by texture
+ * (its GL texture id, or 0 for no texture)
+ *******************************************************************/
+static inline unsigned textureKey(GLTexture* texture)
+{
+	return texture ? texture->glId() : 0;
+}
+
+/* sortByTexture
+ * Counting sorts the first [count] items in [items] by texture into
+ * [sorted], so items with the same texture are next to each other.
+ * GL texture ids are small and allocated sequentially, so [counts]
+ * (indexed by texture id) stays small, and along with [sorted] it
+ * is kept between frames so nothing is reallocated once it has grown
+ * to fit
+ *******************************************************************/
+template<class T> static void sortByTexture(T** items, unsigned count, vector<T*>& sorted, vector<unsigned>& counts)
+{
+	// Count items per texture
+	std::fill(counts.begin(), counts.end(), 0);
+	for (unsigned a = 0; a < count; a++)
+	{
+		unsigned key = textureKey(items[a]->texture);
+		if (key >= counts.size())
+			counts.resize(key + 1, 0);
+		counts[key]++;
+	}
+
+	// Get start position of each texture's bucket
+	unsigned total = 0;
+	for (unsigned a = 0; a < counts.size(); a++)
+	{
+		unsigned n = counts[a];
+		counts[a] = total;
+		total += n;
+	}
+
+	// Put items in buckets
+	sorted.resize(count);
+	for (unsigned a = 0; a < count; a++)
+		sorted[counts[textureKey(items[a]->texture)]++] = items[a];
+}
+
+/* bboxDistance
+ * Returns the distance from [point] to the nearest side of [bbox]
+ *******************************************************************/
+static double bboxDistance(fpoint2_t point, bbox_t& bbox)
+{
+	double min_dist = 9999999;
+	double dist = MathStuff::distanceToLine(point, bbox.left_side());
+	if (dist < min_dist) min_dist = dist;
+	dist = MathStuff::distanceToLine(point, bbox.top_side());
+	if (dist < min_dist) min_dist = dist;
+	dist = MathStuff::distanceToLine(point, bbox.right_side());
+	if (dist < min_dist) min_dist = dist;
+	dist = MathStuff::distanceToLine(point, bbox.bottom_side());
+	if (dist < min_dist) min_dist = dist;
+
+	return min_dist;
+}
+
+/* viewAngle
+ * Returns the angle of [point] as seen from [cam], relative to
+ * [view_angle] (from -PI to PI)
+ *******************************************************************/
+static double viewAngle(fpoint2_t cam, fpoint2_t point, double view_angle)
+{
+	double angle = atan2(point.y - cam.y, point.x - cam.x) - view_angle;
+	while (angle > PI) angle -= 2 * PI;
+	while (angle <= -PI) angle += 2 * PI;
+
+	return angle;
+}
+
+/* clipViewWindow
+ * Clips the view window [lo]-[hi] (angles relative to [view_angle])
+ * to the part of it that [line] covers as seen from [cam]. Returns
+ * false if [line] is entirely outside the window
+ *******************************************************************/
+static bool clipViewWindow(fpoint2_t cam, MapLine* line, double view_angle, double& lo, double& hi)
+{
+	// If the camera is (almost) on the line it could cover any angle,
+	// so keep the whole window
+	if (MathStuff::distanceToLine(cam, line->seg()) < 1.0)
+		return true;
+
+	// Get angle range of the line
+	double a1 = viewAngle(cam, line->point1(), view_angle);
+	double span = viewAngle(cam, line->point2(), view_angle) - a1;
+	if (span > PI) span -= 2 * PI;
+	if (span <= -PI) span += 2 * PI;
+	double l_lo = MIN(a1, a1 + span);
+	double l_hi = MAX(a1, a1 + span);
+
+	// The range can extend past +/-PI (behind the camera), so check it
+	// wrapped either way too. If more than one part is in the window,
+	// keep everything between them
+	double c_lo = 2 * PI;
+	double c_hi = -2 * PI;
+	for (int a = -1; a <= 1; a++)
+	{
+		double p_lo = MAX(lo, l_lo + a * 2 * PI);
+		double p_hi = MIN(hi, l_hi + a * 2 * PI);
+		if (p_lo <= p_hi)
+		{
+			c_lo = MIN(c_lo, p_lo);
+			c_hi = MAX(c_hi, p_hi);
+		}
+	}
+
+	if (c_lo > c_hi)
+		return false;
+
+	lo = c_lo;
+	hi = c_hi;
+	return true;
+}
+
+/* portalOpen
+ * Returns true if there is any gap between the floors and ceilings
+ * either side of (two-sided) [line] that can be seen through
+ *******************************************************************/
+static bool portalOpen(MapLine* line)
+{
+	plane_t f1 = line->frontSector()->getFloorPlane();
+	plane_t c1 = line->frontSector()->getCeilingPlane();
+	plane_t f2 = line->backSector()->getFloorPlane();
+	plane_t c2 = line->backSector()->getCeilingPlane();
+
+	// Heights at either end of the line
+	fpoint2_t p1 = line->point1();
+	fpoint2_t p2 = line->point2();
+	double hf1[2] = { f1.height_at(p1), f1.height_at(p2) };
+	double hc1[2] = { c1.height_at(p1), c1.height_at(p2) };
+	double hf2[2] = { f2.height_at(p1), f2.height_at(p2) };
+	double hc2[2] = { c2.height_at(p1), c2.height_at(p2) };
+
+	// The gap along the line is the lower ceiling minus the higher
+	// floor. Since the planes are flat, it is largest either at one of
+	// the line's ends or where the two floors or two ceilings cross
+	double samples[4] = { 0, 1, -1, -1 };
+	double df0 = hf1[0] - hf2[0];
+	double df1 = hf1[1] - hf2[1];
+	if ((df0 < 0 && df1 > 0) || (df0 > 0 && df1 < 0))
+		samples[2] = df0 / (df0 - df1);
+	double dc0 = hc1[0] - hc2[0];
+	double dc1 = hc1[1] - hc2[1];
+	if ((dc0 < 0 && dc1 > 0) || (dc0 > 0 && dc1 < 0))
+		samples[3] = dc0 / (dc0 - dc1);
+
+	for (unsigned a = 0; a < 4; a++)
+	{
+		double t = samples[a];
+		if (t < 0)
+			continue;
+
+		double top = MIN(hc1[0] + (hc1[1] - hc1[0]) * t, hc2[0] + (hc2[1] - hc2[0]) * t);
+		double bottom = MAX(hf1[0] + (hf1[1] - hf1[0]) * t, hf2[0] + (hf2[1] - hf2[0]) * t);
+		if (top > bottom)
+			return true;
+	}
+
+	return false;
+}
+
+
 /*******************************************************************
  * MAPRENDERER3D CLASS FUNCTIONS
  *******************************************************************/
@@ -99,6 +272,8 @@ MapRenderer3D::MapRenderer3D(SLADEMap* map)
 	this->flat_last = 0;
 	this->render_hilight = true;
 	this->render_selection = true;
+	this->view_aspect = 1.6f;
+	this->cull_stats = { false, 0, 0, 0 };
 
 	// Build skybox circle
 	buildSkyCircle();
@@ -443,6 +618,7 @@ void MapRenderer3D::setupView(int width, int height)
 {
 	// Calculate aspect ratio
 	float aspect = (1.6f / 1.333333f) * ((float)width / (float)height);
+	view_aspect = aspect;
 	float fovy = 2 * MathStuff::radToDeg(atan(tan(MathStuff::degToRad(90) / 2) / aspect));
 
 	// Setup projection
@@ -465,11 +641,11 @@ void MapRenderer3D::setupView(int width, int height)
 	          up.x, up.y, up.z);
 }
 
-/* MapRenderer3D::setLight
- * Sets the OpenGL colour for rendering an object using [colour]
- * and [light] level
+/* MapRenderer3D::lightColour
+ * Calculates the OpenGL colour for rendering an object using
+ * [colour] and [light] level, and writes it to [out] (rgba)
  *******************************************************************/
-void MapRenderer3D::setLight(rgba_t& colour, uint8_t light, float alpha)
+void MapRenderer3D::lightColour(rgba_t& colour, uint8_t light, float alpha, float* out)
 {
 	// Force 255 light in fullbright mode
 	if (fullbright)
@@ -483,7 +659,21 @@ void MapRenderer3D::setLight(rgba_t& colour, uint8_t light, float alpha)
 	// closer resemble the software renderer light level
 	float mult = (float)light / 255.0f;
 	mult *= (mult * 1.3f);
-	glColor4f(colour.fr()*mult, colour.fg()*mult, colour.fb()*mult, colour.fa()*alpha);
+	out[0] = colour.fr()*mult;
+	out[1] = colour.fg()*mult;
+	out[2] = colour.fb()*mult;
+	out[3] = colour.fa()*alpha;
+}
+
+/* MapRenderer3D::setLight
+ * Sets the OpenGL colour for rendering an object using [colour]
+ * and [light] level
+ *******************************************************************/
+void MapRenderer3D::setLight(rgba_t& colour, uint8_t light, float alpha)
+{
+	float col[4];
+	lightColour(colour, light, alpha, col);
+	glColor4fv(col);
 }
 
 /* MapRenderer3D::setFog
@@ -541,6 +731,9 @@ void MapRenderer3D::renderMap()
 	// Init VBO stuff
 	if (OpenGL::vboSupport())
 	{
+		// Build any out of date sector polygons first (in parallel)
+		map->updateSectorPolygons();
+
 		// Check if any polygon vertex data has changed (in this case we need to refresh the entire vbo)
 		bool vbo_updated = false;
 		for (unsigned a = 0; a < map->nSectors(); a++)
@@ -689,6 +882,8 @@ void MapRenderer3D::renderSkySlice(float top, float bottom, float atop, float ab
  *******************************************************************/
 void MapRenderer3D::renderSky()
 {
+	PROFILE_SCOPE("Sky");
+
 	OpenGL::setColour(COL_WHITE);
 	glDisable(GL_CULL_FACE);
 	glDisable(GL_FOG);
@@ -823,31 +1018,31 @@ void MapRenderer3D::updateFlatTexCoords(unsigned index, bool floor)
 		{
 			if (Game::configuration().featureSupported(UDMFFeature::FlatPanning))
 			{
-				ox = sector->floatProperty("xpanningfloor");
-				oy = sector->floatProperty("ypanningfloor");
+				ox = sector->floatProp(MobjKeys::xpanningfloor);
+				oy = sector->floatProp(MobjKeys::ypanningfloor);
 			}
 			if (Game::configuration().featureSupported(UDMFFeature::FlatScaling))
 			{
-				sx *= (1.0 / sector->floatProperty("xscalefloor"));
-				sy *= (1.0 / sector->floatProperty("yscalefloor"));
+				sx *= (1.0 / sector->floatProp(MobjKeys::xscalefloor));
+				sy *= (1.0 / sector->floatProp(MobjKeys::yscalefloor));
 			}
 			if (Game::configuration().featureSupported(UDMFFeature::FlatRotation))
-				rot = sector->floatProperty("rotationfloor");
+				rot = sector->floatProp(MobjKeys::rotationfloor);
 		}
 		else
 		{
 			if (Game::configuration().featureSupported(UDMFFeature::FlatPanning))
 			{
-				ox = sector->floatProperty("xpanningceiling");
-				oy = sector->floatProperty("ypanningceiling");
+				ox = sector->floatProp(MobjKeys::xpanningceiling);
+				oy = sector->floatProp(MobjKeys::ypanningceiling);
 			}
 			if (Game::configuration().featureSupported(UDMFFeature::FlatScaling))
 			{
-				sx *= (1.0 / sector->floatProperty("xscaleceiling"));
-				sy *= (1.0 / sector->floatProperty("yscaleceiling"));
+				sx *= (1.0 / sector->floatProp(MobjKeys::xscaleceiling));
+				sy *= (1.0 / sector->floatProp(MobjKeys::yscaleceiling));
 			}
 			if (Game::configuration().featureSupported(UDMFFeature::FlatRotation))
-				rot = sector->floatProperty("rotationceiling");
+				rot = sector->floatProp(MobjKeys::rotationceiling);
 		}
 	}
 
@@ -1015,6 +1210,8 @@ void MapRenderer3D::renderFlat(flat_3d_t* flat)
  *******************************************************************/
 void MapRenderer3D::renderFlats()
 {
+	PROFILE_SCOPE("Flats");
+
 	// Check for map
 	if (!map)
 		return;
@@ -1023,32 +1220,21 @@ void MapRenderer3D::renderFlats()
 	glEnable(GL_TEXTURE_2D);
 
 	// Render all visible flats, ordered by texture
-	unsigned a = 0;
+	sortByTexture(flats, n_flats, flats_sorted, tex_buckets);
 	flat_last = 0;
-	while (n_flats > 0)
+	tex_last = nullptr;
+	for (unsigned a = 0; a < flats_sorted.size(); a++)
 	{
-		tex_last = nullptr;
-		a = 0;
-		while (a < n_flats)
-		{
-			// Check texture
-			if (!tex_last && flats[a]->texture)
-			{
-				tex_last = flats[a]->texture;
-				flats[a]->texture->bind();
-			}
-			if (flats[a]->texture != tex_last)
-			{
-				a++;
-				continue;
-			}
+		// Bind texture once per bucket
+		flat_3d_t* flat = flats_sorted[a];
+		if (flat->texture && (a == 0 || flat->texture != tex_last))
+			flat->texture->bind();
+		tex_last = flat->texture;
 
-			// Render flat
-			renderFlat(flats[a]);
-			flats[a] = flats[n_flats-1];
-			n_flats--;
-		}
+		// Render flat
+		renderFlat(flat);
 	}
+	n_flats = 0;
 
 	// Reset gl stuff
 	glDisable(GL_TEXTURE_2D);
@@ -1233,7 +1419,7 @@ void MapRenderer3D::updateLine(unsigned index)
 	lines[index].line = line;
 	double alpha = 1.0;
 	if (line->hasProp("alpha"))
-		alpha = line->floatProperty("alpha");
+		alpha = line->floatProp(MobjKeys::alpha);
 
 	// Get first side info
 	int floor1 = line->frontSector()->getFloorHeight();
@@ -1279,9 +1465,9 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map->currentFormat() == MAP_UDMF && Game::configuration().featureSupported(UDMFFeature::TextureOffsets))
 		{
 			if (line->s1()->hasProp("offsetx_mid"))
-				xoff += line->s1()->floatProperty("offsetx_mid");
+				xoff += line->s1()->floatProp(MobjKeys::offsetx_mid);
 			if (line->s1()->hasProp("offsety_mid"))
-				yoff += line->s1()->floatProperty("offsety_mid");
+				yoff += line->s1()->floatProp(MobjKeys::offsety_mid);
 		}
 
 		// Texture scale
@@ -1289,9 +1475,9 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (Game::configuration().featureSupported(UDMFFeature::TextureScaling))
 		{
 			if (line->s1()->hasProp("scalex_mid"))
-				sx = 1.0 / line->s1()->floatProperty("scalex_mid");
+				sx = 1.0 / line->s1()->floatProp(MobjKeys::scalex_mid);
 			if (line->s1()->hasProp("scaley_mid"))
-				sy = 1.0 / line->s1()->floatProperty("scaley_mid");
+				sy = 1.0 / line->s1()->floatProp(MobjKeys::scaley_mid);
 		}
 		xoff *= sx;
 		yoff *= sy;
@@ -1326,7 +1512,7 @@ void MapRenderer3D::updateLine(unsigned index)
 	int highfloor = max(floor1, floor2);
 	string sky_flat = Game::configuration().skyFlat();
 	string hidden_tex = map->currentFormat() == MAP_DOOM64 ? "?" : "-";
-	bool show_midtex = (map->currentFormat() != MAP_DOOM64) || (line->intProperty("flags") & 512);
+	bool show_midtex = (map->currentFormat() != MAP_DOOM64) || (line->intProp(MobjKeys::flags) & 512);
 	// Heights at both endpoints, for both planes, on both sides
 	double f1h1 = fp1.height_at(line->x1(), line->y1());
 	double f1h2 = fp1.height_at(line->x2(), line->y2());
@@ -1370,9 +1556,9 @@ void MapRenderer3D::updateLine(unsigned index)
 		{
 			// UDMF extra offsets
 			if (line->s1()->hasProp("offsetx_bottom"))
-				xoff += line->s1()->floatProperty("offsetx_bottom");
+				xoff += line->s1()->floatProp(MobjKeys::offsetx_bottom);
 			if (line->s1()->hasProp("offsety_bottom"))
-				yoff += line->s1()->floatProperty("offsety_bottom");
+				yoff += line->s1()->floatProp(MobjKeys::offsety_bottom);
 		}
 
 		// Texture scale
@@ -1380,9 +1566,9 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map->currentFormat() == MAP_UDMF && Game::configuration().featureSupported(UDMFFeature::TextureScaling))
 		{
 			if (line->s1()->hasProp("scalex_bottom"))
-				sx = 1.0 / line->s1()->floatProperty("scalex_bottom");
+				sx = 1.0 / line->s1()->floatProp(MobjKeys::scalex_bottom);
 			if (line->s1()->hasProp("scaley_bottom"))
-				sy = 1.0 / line->s1()->floatProperty("scaley_bottom");
+				sy = 1.0 / line->s1()->floatProp(MobjKeys::scaley_bottom);
 		}
 		xoff *= sx;
 		yoff *= sy;
@@ -1421,9 +1607,9 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map->currentFormat() == MAP_UDMF && Game::configuration().featureSupported(UDMFFeature::TextureOffsets))
 		{
 			if (line->s1()->hasProp("offsetx_mid"))
-				xoff += line->s1()->floatProperty("offsetx_mid");
+				xoff += line->s1()->floatProp(MobjKeys::offsetx_mid);
 			if (line->s1()->hasProp("offsety_mid"))
-				yoff += line->s1()->floatProperty("offsety_mid");
+				yoff += line->s1()->floatProp(MobjKeys::offsety_mid);
 		}
 
 		// Texture scale
@@ -1431,9 +1617,9 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map->currentFormat() == MAP_UDMF && Game::configuration().featureSupported(UDMFFeature::TextureScaling))
 		{
 			if (line->s1()->hasProp("scalex_mid"))
-				sx = 1.0 / line->s1()->floatProperty("scalex_mid");
+				sx = 1.0 / line->s1()->floatProp(MobjKeys::scalex_mid);
 			if (line->s1()->hasProp("scaley_mid"))
-				sy = 1.0 / line->s1()->floatProperty("scaley_mid");
+				sy = 1.0 / line->s1()->floatProp(MobjKeys::scaley_mid);
 		}
 		xoff *= sx;
 		yoff *= sy;
@@ -1442,7 +1628,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		double top, bottom;
 		if ((map->currentFormat() == MAP_DOOM64) || ((map->currentFormat() == MAP_UDMF &&
 			Game::configuration().featureSupported(UDMFFeature::SideMidtexWrapping) &&
-			line->boolProperty("wrapmidtex"))))
+			line->boolProp(MobjKeys::wrapmidtex))))
 		{
 			top = lowceil;
 			bottom = highfloor;
@@ -1478,7 +1664,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		quad.light = light1;
 		setupQuadTexCoords(&quad, length, xoff, ytex, top, bottom, false, sx, sy);
 		quad.flags |= MIDTEX;
-		if (line->hasProp("renderstyle") && !wxStrcmp(line->stringProperty("renderstyle"), "add"))
+		if (line->hasProp("renderstyle") && !wxStrcmp(line->stringProp(MobjKeys::renderstyle), "add"))
 			quad.flags |= TRANSADD;
 
 		// Add quad
@@ -1497,9 +1683,9 @@ void MapRenderer3D::updateLine(unsigned index)
 		{
 			// UDMF extra offsets
 			if (line->s1()->hasProp("offsetx_top"))
-				xoff += line->s1()->floatProperty("offsetx_top");
+				xoff += line->s1()->floatProp(MobjKeys::offsetx_top);
 			if (line->s1()->hasProp("offsety_top"))
-				yoff += line->s1()->floatProperty("offsety_top");
+				yoff += line->s1()->floatProp(MobjKeys::offsety_top);
 		}
 
 		// Texture scale
@@ -1507,9 +1693,9 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map->currentFormat() == MAP_UDMF && Game::configuration().featureSupported(UDMFFeature::TextureScaling))
 		{
 			if (line->s1()->hasProp("scalex_top"))
-				sx = 1.0 / line->s1()->floatProperty("scalex_top");
+				sx = 1.0 / line->s1()->floatProp(MobjKeys::scalex_top);
 			if (line->s1()->hasProp("scaley_top"))
-				sy = 1.0 / line->s1()->floatProperty("scaley_top");
+				sy = 1.0 / line->s1()->floatProp(MobjKeys::scaley_top);
 		}
 		xoff *= sx;
 		yoff *= sy;
@@ -1541,9 +1727,9 @@ void MapRenderer3D::updateLine(unsigned index)
 		{
 			// UDMF extra offsets
 			if (line->s2()->hasProp("offsetx_bottom"))
-				xoff += line->s2()->floatProperty("offsetx_bottom");
+				xoff += line->s2()->floatProp(MobjKeys::offsetx_bottom);
 			if (line->s2()->hasProp("offsety_bottom"))
-				yoff += line->s2()->floatProperty("offsety_bottom");
+				yoff += line->s2()->floatProp(MobjKeys::offsety_bottom);
 		}
 
 		// Texture scale
@@ -1551,9 +1737,9 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map->currentFormat() == MAP_UDMF && Game::configuration().featureSupported(UDMFFeature::TextureScaling))
 		{
 			if (line->s2()->hasProp("scalex_bottom"))
-				sx = 1.0 / line->s2()->floatProperty("scalex_bottom");
+				sx = 1.0 / line->s2()->floatProp(MobjKeys::scalex_bottom);
 			if (line->s2()->hasProp("scaley_bottom"))
-				sy = 1.0 / line->s2()->floatProperty("scaley_bottom");
+				sy = 1.0 / line->s2()->floatProp(MobjKeys::scaley_bottom);
 		}
 		xoff *= sx;
 		yoff *= sy;
@@ -1592,9 +1778,9 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map->currentFormat() == MAP_UDMF && Game::configuration().featureSupported(UDMFFeature::TextureOffsets))
 		{
 			if (line->s2()->hasProp("offsetx_mid"))
-				xoff += line->s2()->floatProperty("offsetx_mid");
+				xoff += line->s2()->floatProp(MobjKeys::offsetx_mid);
 			if (line->s2()->hasProp("offsety_mid"))
-				yoff += line->s2()->floatProperty("offsety_mid");
+				yoff += line->s2()->floatProp(MobjKeys::offsety_mid);
 		}
 
 		// Texture scale
@@ -1602,9 +1788,9 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map->currentFormat() == MAP_UDMF && Game::configuration().featureSupported(UDMFFeature::TextureScaling))
 		{
 			if (line->s2()->hasProp("scalex_mid"))
-				sx = 1.0 / line->s2()->floatProperty("scalex_mid");
+				sx = 1.0 / line->s2()->floatProp(MobjKeys::scalex_mid);
 			if (line->s2()->hasProp("scaley_mid"))
-				sy = 1.0 / line->s2()->floatProperty("scaley_mid");
+				sy = 1.0 / line->s2()->floatProp(MobjKeys::scaley_mid);
 		}
 		xoff *= sx;
 		yoff *= sy;
@@ -1612,7 +1798,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		// Setup quad coordinates
 		double top, bottom;
 		if ((map->currentFormat() == MAP_DOOM64) || (map->currentFormat() == MAP_UDMF &&
-			Game::configuration().featureSupported(UDMFFeature::SideMidtexWrapping) && line->boolProperty("wrapmidtex")))
+			Game::configuration().featureSupported(UDMFFeature::SideMidtexWrapping) && line->boolProp(MobjKeys::wrapmidtex)))
 		{
 			top = lowceil;
 			bottom = highfloor;
@@ -1649,7 +1835,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		setupQuadTexCoords(&quad, length, xoff, ytex, top, bottom, false, sx, sy);
 		quad.flags |= BACK;
 		quad.flags |= MIDTEX;
-		if (line->hasProp("renderstyle") && !wxStrcmp(line->stringProperty("renderstyle"), "add"))
+		if (line->hasProp("renderstyle") && !wxStrcmp(line->stringProp(MobjKeys::renderstyle), "add"))
 			quad.flags |= TRANSADD;
 
 		// Add quad
@@ -1668,9 +1854,9 @@ void MapRenderer3D::updateLine(unsigned index)
 		{
 			// UDMF extra offsets
 			if (line->s2()->hasProp("offsetx_top"))
-				xoff += line->s2()->floatProperty("offsetx_top");
+				xoff += line->s2()->floatProp(MobjKeys::offsetx_top);
 			if (line->s2()->hasProp("offsety_top"))
-				yoff += line->s2()->floatProperty("offsety_top");
+				yoff += line->s2()->floatProp(MobjKeys::offsety_top);
 		}
 
 		// Texture scale
@@ -1678,9 +1864,9 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map->currentFormat() == MAP_UDMF && Game::configuration().featureSupported(UDMFFeature::TextureScaling))
 		{
 			if (line->s2()->hasProp("scalex_top"))
-				sx = 1.0 / line->s2()->floatProperty("scalex_top");
+				sx = 1.0 / line->s2()->floatProp(MobjKeys::scalex_top);
 			if (line->s2()->hasProp("scaley_top"))
-				sy = 1.0 / line->s2()->floatProperty("scaley_top");
+				sy = 1.0 / line->s2()->floatProp(MobjKeys::scaley_top);
 		}
 		xoff *= sx;
 		yoff *= sy;
@@ -1757,46 +1943,38 @@ void MapRenderer3D::renderQuad(MapRenderer3D::quad_3d_t* quad, float alpha)
  *******************************************************************/
 void MapRenderer3D::renderWalls()
 {
+	PROFILE_SCOPE("Walls");
+
 	// Init
 	quads_transparent.clear();
 	glEnable(GL_TEXTURE_2D);
 	glCullFace(GL_BACK);
 
-	// Render all visible quads, ordered by texture
-	unsigned a = 0;
-	while (n_quads > 0)
+	// Move transparent quads to be rendered later
+	unsigned n_opaque = 0;
+	for (unsigned a = 0; a < n_quads; a++)
 	{
-		tex_last = nullptr;
-		a = 0;
-		while (a < n_quads)
-		{
-			// Check alpha
-			if (quads[a]->colour.a < 255)
-			{
-				quads_transparent.push_back(quads[a]);
-				quads[a] = quads[n_quads-1];
-				n_quads--;
-				continue;
-			}
+		if (quads[a]->colour.a < 255)
+			quads_transparent.push_back(quads[a]);
+		else
+			quads[n_opaque++] = quads[a];
+	}
 
-			// Check texture
-			if (!tex_last && quads[a]->texture)
-			{
-				tex_last = quads[a]->texture;
-				quads[a]->texture->bind();
-			}
-			if (quads[a]->texture != tex_last)
-			{
-				a++;
-				continue;
-			}
+	// Render all visible quads, ordered by texture
+	sortByTexture(quads, n_opaque, quads_sorted, tex_buckets);
+	tex_last = nullptr;
+	for (unsigned a = 0; a < quads_sorted.size(); a++)
+	{
+		// Bind texture once per bucket
+		quad_3d_t* quad = quads_sorted[a];
+		if (quad->texture && (a == 0 || quad->texture != tex_last))
+			quad->texture->bind();
+		tex_last = quad->texture;
 
-			// Render quad
-			renderQuad(quads[a], quads[a]->alpha);
-			quads[a] = quads[n_quads-1];
-			n_quads--;
-		}
+		// Render quad
+		renderQuad(quad, quad->alpha);
 	}
+	n_quads = 0;
 
 	glDisable(GL_TEXTURE_2D);
 }
@@ -1806,6 +1984,8 @@ void MapRenderer3D::renderWalls()
  *******************************************************************/
 void MapRenderer3D::renderTransparentWalls()
 {
+	PROFILE_SCOPE("Transparent Walls");
+
 	// Init
 	glEnable(GL_TEXTURE_2D);
 	glDepthMask(GL_FALSE);
@@ -1970,7 +2150,7 @@ void MapRenderer3D::updateThing(unsigned index, MapThing* thing)
 	{
 		// Get sector floor (or ceiling) height
 		int sheight;
-		float zheight = thing->floatProperty("height");
+		float zheight = thing->floatProp(MobjKeys::height);
 		if (things[index].type->hanging())
 		{
 			sheight = things[index].sector->getCeilingPlane().height_at(thing->xPos(), thing->yPos());
@@ -2002,10 +2182,13 @@ void MapRenderer3D::updateThing(unsigned index, MapThing* thing)
  *******************************************************************/
 void MapRenderer3D::renderThings()
 {
+	PROFILE_SCOPE("Things");
+
 	// Init
 	glEnable(GL_TEXTURE_2D);
 	glCullFace(GL_BACK);
 	GLTexture* tex = nullptr;
+	things_batch.clear();
 
 	// Go through things
 	double dist, halfwidth, theight;
@@ -2014,6 +2197,7 @@ void MapRenderer3D::renderThings()
 	rgba_t col;
 	uint8_t light;
 	float x1, y1, x2, y2;
+	float colour[4];
 	unsigned update = 0;
 	fseg2_t strafe(cam_position.get2d(), (cam_position + cam_strafe).get2d());
 	for (unsigned a = 0; a < map->nThings(); a++)
@@ -2052,13 +2236,6 @@ void MapRenderer3D::renderThings()
 		// Get thing sprite
 		tex = things[a].sprite;
 
-		// Bind texture if needed
-		if (tex != tex_last)
-		{
-			tex->bind();
-			tex_last = tex;
-		}
-
 		// Determine coordinates
 		halfwidth = things[a].type->scaleX() * tex->getWidth() * 0.5;
 		theight = things[a].type->scaleY() * tex->getHeight();
@@ -2098,24 +2275,41 @@ void MapRenderer3D::renderThings()
 			else if (things[a].sector)
 				col.set(things[a].sector->getColour(0, true));
 		}
-		setLight(col, light, calcDistFade(dist, mdist));
-		rgba_t fogcol = rgba_t(0, 0, 0, 0);
-		if (things[a].sector)
-			fogcol = things[a].sector->getFogColour();
+		lightColour(col, light, calcDistFade(dist, mdist), colour);
+		things_batch.setColour(colour[0], colour[1], colour[2], colour[3]);
 
-		setFog(fogcol, light);
+		// Things are grouped by sprite texture and fog (colour + light
+		// level, packed into the batch key), no fog means one group per
+		// texture
+		if (fog)
+		{
+			rgba_t fogcol = rgba_t(0, 0, 0, 0);
+			if (things[a].sector)
+				fogcol = things[a].sector->getFogColour();
+			things_batch.setKey(((unsigned)fogcol.r << 24) | (fogcol.g << 16) | (fogcol.b << 8) | light);
+		}
 
-		// Draw thing
-		glBegin(GL_QUADS);
-		glTexCoord2f(0.0f, 0.0f);	glVertex3f(x1, y1, things[a].z + theight);
-		glTexCoord2f(0.0f, 1.0f);	glVertex3f(x1, y1, things[a].z);
-		glTexCoord2f(1.0f, 1.0f);	glVertex3f(x2, y2, things[a].z);
-		glTexCoord2f(1.0f, 0.0f);	glVertex3f(x2, y2, things[a].z + theight);
-		glEnd();
+		// Add thing
+		frect_t tc = tex->texCoords();
+		GLQuadBatch::vertex_t* quad = things_batch.addQuad(tex);
+		quad[0].set(x1, y1, things[a].z + theight, tc.x1(), tc.y1());
+		quad[1].set(x1, y1, things[a].z, tc.x1(), tc.y2());
+		quad[2].set(x2, y2, things[a].z, tc.x2(), tc.y2());
+		quad[3].set(x2, y2, things[a].z + theight, tc.x2(), tc.y1());
 
 		things[a].flags |= DRAWN;
 	}
 
+	// Draw things, one group at a time
+	for (unsigned a = 0; a < things_batch.nGroups(); a++)
+	{
+		unsigned key = things_batch.groupKey(a);
+		rgba_t fogcol(key >> 24, (key >> 16) & 0xFF, (key >> 8) & 0xFF, 0);
+		setFog(fogcol, key & 0xFF);
+		things_batch.drawGroup(a);
+	}
+	tex_last = nullptr;
+
 	// Draw thing borders if needed
 	if (render_3d_things_style >= 1)
 	{
@@ -2322,6 +2516,8 @@ void MapRenderer3D::renderThingSelection(const ItemSelection& selection, float a
  *******************************************************************/
 void MapRenderer3D::updateFlatsVBO()
 {
+	PROFILE_SCOPE("VBO Update");
+
 	if (!flats_use_vbo)
 		return;
 
@@ -2401,18 +2597,25 @@ void MapRenderer3D::updateWallsVBO()
 }
 
 /* MapRenderer3D::quickVisDiscard
- * Runs a quick check of all sector bounding boxes against the
- * current view to hide any that are outside it
+ * Hides any sectors and lines that can't be seen from the current
+ * view, using portal culling if possible. Otherwise runs a quick
+ * check of all sector bounding boxes against the current view
  *******************************************************************/
 void MapRenderer3D::quickVisDiscard()
 {
+	PROFILE_SCOPE("Vis Culling");
+
 	// Create sector distance array if needed
 	if (dist_sectors.size() != map->nSectors())
 		dist_sectors.resize(map->nSectors());
 
+	// Use portal culling if possible
+	if (render_3d_portal_cull && portalVisCheck())
+		return;
+
 	// Go through all sectors
 	fpoint2_t cam = cam_position.get2d();
-	double min_dist, dist;
+	double dist;
 	fseg2_t strafe(cam, cam + cam_strafe.get2d());
 	for (unsigned a = 0; a < map->nSectors(); a++)
 	{
@@ -2442,30 +2645,154 @@ void MapRenderer3D::quickVisDiscard()
 
 		// Check distance to bbox
 		if (render_max_dist > 0)
-		{
-			min_dist = 9999999;
-			dist = MathStuff::distanceToLine(cam, bbox.left_side());
-			if (dist < min_dist) min_dist = dist;
-			dist = MathStuff::distanceToLine(cam, bbox.top_side());
-			if (dist < min_dist) min_dist = dist;
-			dist = MathStuff::distanceToLine(cam, bbox.right_side());
-			if (dist < min_dist) min_dist = dist;
-			dist = MathStuff::distanceToLine(cam, bbox.bottom_side());
-			if (dist < min_dist) min_dist = dist;
-
-			dist_sectors[a] = dist;
-		}
+			dist_sectors[a] = bboxDistance(cam, bbox);
 	}
 
 	// Set all lines that are part of invisible sectors to invisible
+	for (unsigned a = 0; a < lines.size(); a++)
+		lines[a].visible = false;
 	for (unsigned a = 0; a < map->nSides(); a++)
 	{
 		dist = dist_sectors[map->getSide(a)->getSector()->getIndex()];
-		if (dist < 0 || (render_max_dist > 0 && dist > render_max_dist))
-			lines[map->getSide(a)->getParentLine()->getIndex()].visible = false;
-		else
+		if (dist >= 0 && (render_max_dist <= 0 || dist <= render_max_dist))
 			lines[map->getSide(a)->getParentLine()->getIndex()].visible = true;
 	}
+
+	// Build visible lists
+	vis_sectors.clear();
+	vis_lines.clear();
+	for (unsigned a = 0; a < map->nSectors(); a++)
+	{
+		if (dist_sectors[a] >= 0)
+			vis_sectors.push_back(a);
+	}
+	for (unsigned a = 0; a < lines.size(); a++)
+	{
+		if (lines[a].visible)
+			vis_lines.push_back(a);
+	}
+
+	cull_stats.portal = false;
+	cull_stats.sectors = vis_sectors.size();
+	cull_stats.lines = vis_lines.size();
+	cull_stats.portals = 0;
+}
+
+/* MapRenderer3D::portalVisCheck
+ * Finds visible sectors and lines by walking through two-sided lines
+ * from the sector the camera is in, narrowing the horizontal view
+ * window to each portal's opening along the way. Returns false if
+ * the camera isn't within a sector
+ *******************************************************************/
+bool MapRenderer3D::portalVisCheck()
+{
+	// Get sector the camera is in
+	fpoint2_t cam = cam_position.get2d();
+	int cam_sector = map->sectorAt(cam);
+	if (cam_sector < 0)
+		return false;
+
+	// Get horizontal view window (angles either side of the view
+	// direction). The view is 90 degrees wide, but looking up or down
+	// widens its area on the map, up to everything around the camera
+	double tan_v = 1.0 / view_aspect;
+	double pitch = fabs(cam_pitch);
+	double width = cos(pitch) - sin(pitch) * tan_v;
+	double window = PI;
+	if (width > 0.01)
+		window = MIN(PI, atan(1.0 / width) + 0.05);
+	double view_angle = atan2(cam_direction.y, cam_direction.x);
+
+	// Init
+	unsigned n_sectors = map->nSectors();
+	vis_window_lo.assign(n_sectors, 1.0);
+	vis_window_hi.assign(n_sectors, -1.0);
+	for (unsigned a = 0; a < n_sectors; a++)
+		dist_sectors[a] = -1.0f;
+	for (unsigned a = 0; a < lines.size(); a++)
+		lines[a].visible = false;
+	vis_sectors.clear();
+	vis_lines.clear();
+	cull_stats.portals = 0;
+
+	// Walk through portals from the camera sector
+	struct portal_t
+	{
+		unsigned	sector;
+		double		lo;
+		double		hi;
+	};
+	vector<portal_t> portals;
+	portals.push_back({ (unsigned)cam_sector, -window, window });
+	while (!portals.empty())
+	{
+		portal_t current = portals.back();
+		portals.pop_back();
+
+		// Check if the sector was already reached with a wider window
+		double& w_lo = vis_window_lo[current.sector];
+		double& w_hi = vis_window_hi[current.sector];
+		MapSector* sector = map->getSector(current.sector);
+		if (w_lo <= w_hi)
+		{
+			if (current.lo >= w_lo && current.hi <= w_hi)
+				continue;
+
+			w_lo = MIN(w_lo, current.lo);
+			w_hi = MAX(w_hi, current.hi);
+		}
+		else
+		{
+			// First time reached, sector is visible
+			w_lo = current.lo;
+			w_hi = current.hi;
+			vis_sectors.push_back(current.sector);
+
+			bbox_t bbox = sector->boundingBox();
+			if (render_max_dist > 0 && !bbox.contains(cam))
+				dist_sectors[current.sector] = bboxDistance(cam, bbox);
+			else
+				dist_sectors[current.sector] = 0.0f;
+		}
+
+		// Check sector lines
+		vector<MapSide*>& sides = sector->connectedSides();
+		for (unsigned a = 0; a < sides.size(); a++)
+		{
+			MapLine* line = sides[a]->getParentLine();
+
+			// Check line is within the view window and distance
+			double lo = current.lo;
+			double hi = current.hi;
+			if (!clipViewWindow(cam, line, view_angle, lo, hi))
+				continue;
+			if (render_max_dist > 0 && MathStuff::distanceToLine(cam, line->seg()) > render_max_dist)
+				continue;
+
+			// Line is visible
+			unsigned index = line->getIndex();
+			if (index < lines.size() && !lines[index].visible)
+			{
+				lines[index].visible = true;
+				vis_lines.push_back(index);
+			}
+
+			// Continue through the line if there is an opening to the
+			// sector on the other side
+			MapSector* other = (sides[a] == line->s1()) ? line->backSector() : line->frontSector();
+			if (!other || other == sector || !portalOpen(line))
+				continue;
+
+			portals.push_back({ (unsigned)other->getIndex(), lo, hi });
+			cull_stats.portals++;
+		}
+	}
+
+	cull_stats.portal = true;
+	cull_stats.sectors = vis_sectors.size();
+	cull_stats.lines = vis_lines.size();
+
+	return true;
 }
 
 /* MapRenderer3D::calcDistFade
@@ -2489,6 +2816,8 @@ float MapRenderer3D::calcDistFade(double distance, double max)
  *******************************************************************/
 void MapRenderer3D::checkVisibleQuads()
 {
+	PROFILE_SCOPE("Visible Walls");
+
 	// Create quads array if empty
 	if (!quads)
 		quads = (quad_3d_t**)malloc(sizeof(quad_3d_t*) * map->nLines() * 4);
@@ -2500,14 +2829,11 @@ void MapRenderer3D::checkVisibleQuads()
 	unsigned updates = 0;
 	bool update = false;
 	fseg2_t strafe(cam_position.get2d(), (cam_position + cam_strafe).get2d());
-	for (unsigned a = 0; a < lines.size(); a++)
+	for (unsigned v = 0; v < vis_lines.size(); v++)
 	{
+		unsigned a = vis_lines[v];
 		line = map->getLine(a);
 
-		// Skip if not visible
-		if (!lines[a].visible)
-			continue;
-
 		// Check side of camera
 		if (cam_pitch > -0.9 && cam_pitch < 0.9)
 		{
@@ -2573,6 +2899,8 @@ void MapRenderer3D::checkVisibleQuads()
  *******************************************************************/
 void MapRenderer3D::checkVisibleFlats()
 {
+	PROFILE_SCOPE("Visible Flats");
+
 	// Create flats array if empty
 	if (!flats)
 		flats = (flat_3d_t**)malloc(sizeof(flat_3d_t*) * map->nSectors() * 2);
@@ -2582,14 +2910,11 @@ void MapRenderer3D::checkVisibleFlats()
 	n_flats = 0;
 	float alpha;
 	fpoint2_t cam = cam_position.get2d();
-	for (unsigned a = 0; a < map->nSectors(); a++)
+	for (unsigned v = 0; v < vis_sectors.size(); v++)
 	{
+		unsigned a = vis_sectors[v];
 		sector = map->getSector(a);
 
-		// Skip if invisible
-		if (dist_sectors[a] < 0)
-			continue;
-
 		// Check distance if needed
 		if (render_max_dist > 0)
 		{
@@ -2620,9 +2945,10 @@ void MapRenderer3D::checkVisibleFlats()
 		// Add floor flat
 		flats[n_flats++] = &(floors[a]);
 	}
-	for (unsigned a = 0; a < map->nSectors(); a++)
+	for (unsigned v = 0; v < vis_sectors.size(); v++)
 	{
 		// Skip if invisible
+		unsigned a = vis_sectors[v];
 		if (dist_sectors[a] < 0)
 			continue;
 
@@ -5,6 +5,7 @@
 #include "MapEditor/SLADEMap/SLADEMap.h"
 #include "General/ListenerAnnouncer.h"
 #include "MapEditor/Edit/Edit3D.h"
+#include "OpenGL/GLQuadBatch.h"
 
 class ItemSelection;
 class GLTexture;
@@ -112,6 +113,15 @@ public:
 		}
 	};
 
+	// Visibility culling statistics for the last frame
+	struct cull_stats_t
+	{
+		bool		portal;		// Portal culling was used
+		unsigned	sectors;	// Visible sectors
+		unsigned	lines;		// Visible lines
+		unsigned	portals;	// Portals traversed
+	};
+
 	MapRenderer3D(SLADEMap* map = NULL);
 	~MapRenderer3D();
 
@@ -123,6 +133,8 @@ public:
 	void	enableHilight(bool render) { render_hilight = render; }
 	void	enableSelection(bool render) { render_selection = render; }
 
+	const cull_stats_t&	cullStats() { return cull_stats; }
+
 	bool	init();
 	void	refresh();
 	void	clearData();
@@ -149,6 +161,7 @@ public:
 
 	// -- Rendering --
 	void	setupView(int width, int height);
+	void	lightColour(rgba_t& colour, uint8_t light, float alpha, float* out);
 	void	setLight(rgba_t& colour, uint8_t light, float alpha = 1.0f);
 	void	setFog(rgba_t &fogcol, uint8_t light);
 	void	renderMap();
@@ -183,6 +196,7 @@ public:
 
 	// Visibility checking
 	void	quickVisDiscard();
+	bool	portalVisCheck();
 	float	calcDistFade(double distance, double max = -1);
 	void	checkVisibleQuads();
 	void	checkVisibleFlats();
@@ -208,7 +222,13 @@ private:
 	float		fog_depth_last;
 
 	// Visibility
-	vector<float>	dist_sectors;
+	vector<float>		dist_sectors;
+	vector<unsigned>	vis_sectors;	// Sectors not culled in the current frame
+	vector<unsigned>	vis_lines;		// Lines not culled in the current frame
+	vector<double>		vis_window_lo;	// View angle range each sector is visible within
+	vector<double>		vis_window_hi;
+	cull_stats_t		cull_stats;
+	float				view_aspect;
 
 	// Camera
 	fpoint3_t	cam_position;
@@ -229,6 +249,14 @@ private:
 	vector<flat_3d_t>	ceilings;
 	flat_3d_t**			flats;
 
+	// Visible quads/flats bucketed by texture (kept between frames)
+	vector<quad_3d_t*>	quads_sorted;
+	vector<flat_3d_t*>	flats_sorted;
+	vector<unsigned>	tex_buckets;
+
+	// Visible thing sprites, batched by sprite texture and fog
+	GLQuadBatch			things_batch;
+
 	// VBOs
 	unsigned	vbo_floors;
 	unsigned	vbo_ceilings;
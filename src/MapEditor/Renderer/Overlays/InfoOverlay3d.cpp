@@ -556,6 +556,10 @@ void InfoOverlay3D::draw(int bottom, int right, int middle, float alpha)
 		y -= line_height;
 	}
 
+	// Draw visibility culling stats (if any)
+	if (!cull_stats.IsEmpty())
+		Drawing::drawText(cull_stats, right - 4, bottom - height, col_fg, Drawing::FONT_CONDENSED, Drawing::ALIGN_RIGHT);
+
 	// Draw texture if any
 	drawTexture(alpha, middle - (40 * scale), bottom);
 
@@ -17,6 +17,7 @@ public:
 	void	draw(int bottom, int right, int middle, float alpha = 1.0f);
 	void	drawTexture(float alpha, int x, int y);
 	void	clearTexture() { texture = nullptr; }
+	void	setCullStats(const string& stats) { cull_stats = stats; }
 
 private:
 	vector<string>		info;
@@ -27,6 +28,7 @@ private:
 	bool				thing_icon;
 	MapObject*			object;
 	long				last_update;
+	string				cull_stats;
 };
 
 #endif//__INFO_OVERLAY_3D_H__
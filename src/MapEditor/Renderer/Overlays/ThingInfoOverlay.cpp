@@ -237,12 +237,13 @@ void ThingInfoOverlay::draw(int bottom, int right, float alpha)
 			width = 64;
 			height = 64;
 		}
+		frect_t tc = tex->texCoords();
 		tex->bind();
 		glBegin(GL_QUADS);
-		glTexCoord2f(0.0f, 0.0f);	glVertex2d(right - 8 - width, bottom - 8 - height);
-		glTexCoord2f(0.0f, 1.0f);	glVertex2d(right - 8 - width, bottom - 8);
-		glTexCoord2f(1.0f, 1.0f);	glVertex2d(right - 8, bottom - 8);
-		glTexCoord2f(1.0f, 0.0f);	glVertex2d(right - 8, bottom - 8 - height);
+		glTexCoord2d(tc.x1(), tc.y1());	glVertex2d(right - 8 - width, bottom - 8 - height);
+		glTexCoord2d(tc.x1(), tc.y2());	glVertex2d(right - 8 - width, bottom - 8);
+		glTexCoord2d(tc.x2(), tc.y2());	glVertex2d(right - 8, bottom - 8);
+		glTexCoord2d(tc.x2(), tc.y1());	glVertex2d(right - 8, bottom - 8 - height);
 		glEnd();
 	}
 	glDisable(GL_TEXTURE_2D);
@@ -40,6 +40,7 @@
 #include "Overlays/MCOverlay.h"
 #include "Renderer.h"
 #include "Utility/MathStuff.h"
+#include "Utility/Profiler.h"
 
 using namespace MapEditor;
 
@@ -64,6 +65,7 @@ CVAR(Int, map_crosshair, 0, CVAR_SAVE)
 CVAR(Bool, map_show_selection_numbers, true, CVAR_SAVE)
 CVAR(Int, map_max_selection_numbers, 1000, CVAR_SAVE)
 CVAR(Int, flat_drawtype, 2, CVAR_SAVE)
+CVAR(Bool, map_show_profiler, false, CVAR_SAVE)
 
 
 /*******************************************************************
@@ -71,6 +73,7 @@ CVAR(Int, flat_drawtype, 2, CVAR_SAVE)
  *******************************************************************/
 EXTERN_CVAR(Bool, vertex_round)
 EXTERN_CVAR(Int, vertex_size)
+EXTERN_CVAR(Int, gl_font_size)
 
 
 /*******************************************************************
@@ -321,6 +324,8 @@ fpoint2_t Renderer::cameraDir2D()
  *******************************************************************/
 void Renderer::drawGrid() const
 {
+	PROFILE_SCOPE("Grid");
+
 	// Get grid size
 	int gridsize = context_.gridSize();
 
@@ -590,6 +595,70 @@ void Renderer::drawFeatureHelpText() const
 	Drawing::enableTextStateReset(true);
 }
 
+/* Renderer::drawProfiler
+ * Draws the rolling per-pass frame timings from the profiler
+ *******************************************************************/
+void Renderer::drawProfiler() const
+{
+	vector<Profiler::stats_t> stats;
+	Profiler::getStats(stats);
+
+	// Determine size
+	double scale = gl_font_size / 12.0;
+	int line_height = 16 * scale;
+	int char_width = Drawing::textExtents("0", Drawing::FONT_MONOSPACE).x;
+	int left = 8;
+	int top = 64;
+	int right = left + char_width * 52 + 8;
+	int bottom = top + line_height * (stats.size() + 1) + 8;
+
+	// Draw background
+	rgba_t col_bg = ColourConfiguration::getColour("map_overlay_background");
+	rgba_t col_fg = ColourConfiguration::getColour("map_overlay_foreground");
+	glDisable(GL_TEXTURE_2D);
+	glLineWidth(1.0f);
+	Drawing::drawBorderedRect(left, top, right, bottom, col_bg, rgba_t(0, 0, 0, 140));
+
+	Drawing::setTextState(true);
+	Drawing::enableTextStateReset(false);
+
+	// Draw frame time
+	double frame_ms = Profiler::frameTime();
+	int y = top + 4;
+	Drawing::drawText(
+		S_FMT("Frame: %1.2fms (%d fps)", frame_ms, frame_ms > 0 ? MathStuff::round(1000.0 / frame_ms) : 0),
+		left + 4,
+		y,
+		col_fg,
+		Drawing::FONT_MONOSPACE
+	);
+	Drawing::drawText("avg ms   max ms", right - 4, y, col_fg, Drawing::FONT_MONOSPACE, Drawing::ALIGN_RIGHT);
+
+	// Draw passes (indented by depth)
+	for (unsigned a = 0; a < stats.size(); a++)
+	{
+		y += line_height;
+		Drawing::drawText(
+			stats[a].name,
+			left + 4 + char_width * 2 * (stats[a].depth + 1),
+			y,
+			col_fg,
+			Drawing::FONT_MONOSPACE
+		);
+		Drawing::drawText(
+			S_FMT("%6.2f   %6.2f", stats[a].avg_ms, stats[a].max_ms),
+			right - 4,
+			y,
+			col_fg,
+			Drawing::FONT_MONOSPACE,
+			Drawing::ALIGN_RIGHT
+		);
+	}
+
+	Drawing::setTextState(false);
+	Drawing::enableTextStateReset(true);
+}
+
 /* Renderer::drawSelectionNumbers
  * Draws numbers for selected map objects
  *******************************************************************/
@@ -614,6 +683,7 @@ void Renderer::drawSelectionNumbers() const
 	if (context_.selection().size() <= map_max_selection_numbers * 0.5)
 		Drawing::setTextOutline(1.0f, COL_BLACK);
 #endif
+	Drawing::beginTextBatch();
 	for (unsigned a = 0; a < selection.size(); a++)
 	{
 		if ((int)a > map_max_selection_numbers)
@@ -635,8 +705,9 @@ void Renderer::drawSelectionNumbers() const
 		}
 
 		// Draw text
-		Drawing::drawText(S_FMT("%d", a + 1), tp.x, tp.y, col, Drawing::FONT_BOLD);
+		Drawing::drawText(text, tp.x, tp.y, col, Drawing::FONT_BOLD);
 	}
+	Drawing::endTextBatch();
 	Drawing::setTextOutline(0);
 	Drawing::enableTextStateReset();
 	Drawing::setTextState(false);
@@ -751,6 +822,7 @@ void Renderer::drawLineDrawLines(bool snap_nearest_vertex) const
 
 	// Draw line lengths
 	view_.setOverlayCoords(true);
+	Drawing::beginTextBatch();
 	if (npoints > 1)
 	{
 		for (int a = 0; a < npoints - 1; a++)
@@ -758,6 +830,7 @@ void Renderer::drawLineDrawLines(bool snap_nearest_vertex) const
 	}
 	if (npoints > 0 && context_.lineDraw().state() == LineDraw::State::Line)
 		drawLineLength(line_draw.point(npoints - 1), end, col);
+	Drawing::endTextBatch();
 	view_.setOverlayCoords(false);
 
 	// Draw points
@@ -959,6 +1032,8 @@ void Renderer::drawAnimations() const
  *******************************************************************/
 void Renderer::drawMap2d()
 {
+	PROFILE_SCOPE("2D Map");
+
 	// Apply the current 2d view
 	view_.apply();
 
@@ -1171,18 +1246,16 @@ void Renderer::drawMap2d()
 	// Draw moving stuff if needed
 	if (mouse_state == Input::MouseState::Move)
 	{
-		auto& items = context_.moveObjects().items();
-		auto offset = context_.moveObjects().offset();
+		auto& move = context_.moveObjects();
 		switch (context_.editMode())
 		{
 		case Mode::Vertices:
-			renderer_2d_.renderMovingVertices(items, offset); break;
+			renderer_2d_.renderMovingVertices(move); break;
 		case Mode::Lines:
-			renderer_2d_.renderMovingLines(items, offset); break;
 		case Mode::Sectors:
-			renderer_2d_.renderMovingSectors(items, offset); break;
+			renderer_2d_.renderMovingLines(move); break;
 		case Mode::Things:
-			renderer_2d_.renderMovingThings(items, offset); break;
+			renderer_2d_.renderMovingThings(move.items(), move.offset()); break;
 		default: break;
 		};
 	}
@@ -1193,6 +1266,8 @@ void Renderer::drawMap2d()
  *******************************************************************/
 void Renderer::drawMap3d()
 {
+	PROFILE_SCOPE("3D Map");
+
 	// Setup 3d renderer view
 	renderer_3d_.setupView(view_.size().x, view_.size().y);
 
@@ -1218,6 +1293,8 @@ void Renderer::drawMap3d()
  *******************************************************************/
 void Renderer::draw()
 {
+	PROFILE_SCOPE("Render");
+
 	// Setup the viewport
 	glViewport(0, 0, view_.size().x, view_.size().y);
 
@@ -1252,11 +1329,21 @@ void Renderer::draw()
 
 	// Draw current info overlay
 	glDisable(GL_TEXTURE_2D);
-	context_.drawInfoOverlay(view_.size(), anim_info_fade_);
+	{
+		PROFILE_SCOPE("Info Overlay");
+		Drawing::beginTextBatch();
+		context_.drawInfoOverlay(view_.size(), anim_info_fade_);
+		Drawing::endTextBatch();
+	}
 
 	// Draw current fullscreen overlay
 	if (context_.currentOverlay())
+	{
+		PROFILE_SCOPE("Fullscreen Overlay");
+		Drawing::beginTextBatch();
 		context_.currentOverlay()->draw(view_.size().x, view_.size().y, anim_overlay_fade_);
+		Drawing::endTextBatch();
+	}
 
 	// Draw crosshair if 3d mode
 	if (context_.editMode() == Mode::Visual)
@@ -1334,11 +1421,23 @@ void Renderer::draw()
 	// test
 	//Drawing::drawText(S_FMT("Render distance: %1.2f", (double)render_max_dist), 0, 100);
 
-	// Editor messages
-	drawEditorMessages();
+	// Editor messages and help text
+	{
+		PROFILE_SCOPE("Messages");
+		Drawing::beginTextBatch();
+		drawEditorMessages();
+		drawFeatureHelpText();
+		Drawing::endTextBatch();
+	}
 
-	// Help text
-	drawFeatureHelpText();
+	// Profiler timings
+	if (map_show_profiler)
+	{
+		PROFILE_SCOPE("Profiler");
+		Drawing::beginTextBatch();
+		drawProfiler();
+		Drawing::endTextBatch();
+	}
 }
 
 namespace
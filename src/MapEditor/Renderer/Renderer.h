@@ -75,6 +75,7 @@ namespace MapEditor
 		void	drawGrid() const;
 		void	drawEditorMessages() const;
 		void	drawFeatureHelpText() const;
+		void	drawProfiler() const;
 		void	drawSelectionNumbers() const;
 		void	drawThingQuickAngleLines() const;
 		void	drawLineLength(fpoint2_t p1, fpoint2_t p2, rgba_t col) const;
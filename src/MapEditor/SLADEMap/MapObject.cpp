@@ -119,6 +119,10 @@ void MapObject::setModified()
 	}
 
 	modified_time = App::runTimer();
+
+	// Let the map know (to update its spatial index)
+	if (parent_map)
+		parent_map->objectModified(this);
 }
 
 /* MapObject::copy
@@ -151,8 +155,9 @@ void MapObject::copy(MapObject* c)
 bool MapObject::boolProperty(string key)
 {
 	// If the property exists already, return it
-	if (properties[key].hasValue())
-		return properties[key].getBoolValue();
+	const Property* value = properties.getIfExists(key);
+	if (value && value->hasValue())
+		return value->getBoolValue();
 
 	// Otherwise check the game configuration for a default value
 	else
@@ -171,8 +176,9 @@ bool MapObject::boolProperty(string key)
 int MapObject::intProperty(string key)
 {
 	// If the property exists already, return it
-	if (properties[key].hasValue())
-		return properties[key].getIntValue();
+	const Property* value = properties.getIfExists(key);
+	if (value && value->hasValue())
+		return value->getIntValue();
 
 	// Otherwise check the game configuration for a default value
 	else
@@ -191,8 +197,9 @@ int MapObject::intProperty(string key)
 double MapObject::floatProperty(string key)
 {
 	// If the property exists already, return it
-	if (properties[key].hasValue())
-		return properties[key].getFloatValue();
+	const Property* value = properties.getIfExists(key);
+	if (value && value->hasValue())
+		return value->getFloatValue();
 
 	// Otherwise check the game configuration for a default value
 	else
@@ -211,8 +218,9 @@ double MapObject::floatProperty(string key)
 string MapObject::stringProperty(string key)
 {
 	// If the property exists already, return it
-	if (properties[key].hasValue())
-		return properties[key].getStringValue();
+	const Property* value = properties.getIfExists(key);
+	if (value && value->hasValue())
+		return value->getStringValue();
 
 	// Otherwise check the game configuration for a default value
 	else
@@ -225,6 +233,82 @@ string MapObject::stringProperty(string key)
 	}
 }
 
+/* MapObject::boolProp
+ * Returns the value of the boolean property with key id [key]. Only
+ * for properties kept in the property list (see MapObject.h)
+ *******************************************************************/
+bool MapObject::boolProp(unsigned key)
+{
+	// If the property exists already, return it
+	const Property* value = properties.getIfExists(key);
+	if (value && value->hasValue())
+		return value->getBoolValue();
+
+	// Otherwise check the game configuration for a default value
+	UDMFProperty* prop = Game::configuration().getUDMFProperty(MobjPropertyList::keyName(key), type);
+	if (prop)
+		return prop->defaultValue().getBoolValue();
+	else
+		return false;
+}
+
+/* MapObject::intProp
+ * Returns the value of the integer property with key id [key]. Only
+ * for properties kept in the property list (see MapObject.h)
+ *******************************************************************/
+int MapObject::intProp(unsigned key)
+{
+	// If the property exists already, return it
+	const Property* value = properties.getIfExists(key);
+	if (value && value->hasValue())
+		return value->getIntValue();
+
+	// Otherwise check the game configuration for a default value
+	UDMFProperty* prop = Game::configuration().getUDMFProperty(MobjPropertyList::keyName(key), type);
+	if (prop)
+		return prop->defaultValue().getIntValue();
+	else
+		return 0;
+}
+
+/* MapObject::floatProp
+ * Returns the value of the float property with key id [key]. Only
+ * for properties kept in the property list (see MapObject.h)
+ *******************************************************************/
+double MapObject::floatProp(unsigned key)
+{
+	// If the property exists already, return it
+	const Property* value = properties.getIfExists(key);
+	if (value && value->hasValue())
+		return value->getFloatValue();
+
+	// Otherwise check the game configuration for a default value
+	UDMFProperty* prop = Game::configuration().getUDMFProperty(MobjPropertyList::keyName(key), type);
+	if (prop)
+		return prop->defaultValue().getFloatValue();
+	else
+		return 0;
+}
+
+/* MapObject::stringProp
+ * Returns the value of the string property with key id [key]. Only
+ * for properties kept in the property list (see MapObject.h)
+ *******************************************************************/
+string MapObject::stringProp(unsigned key)
+{
+	// If the property exists already, return it
+	const Property* value = properties.getIfExists(key);
+	if (value && value->hasValue())
+		return value->getStringValue();
+
+	// Otherwise check the game configuration for a default value
+	UDMFProperty* prop = Game::configuration().getUDMFProperty(MobjPropertyList::keyName(key), type);
+	if (prop)
+		return prop->defaultValue().getStringValue();
+	else
+		return "";
+}
+
 /* MapObject::setBoolProperty
  * Sets the boolean value of the property [key] to [value]
  *******************************************************************/
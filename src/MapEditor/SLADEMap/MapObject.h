@@ -65,7 +65,7 @@ public:
 	void		setModified();
 
 	MobjPropertyList&	props()				{ return properties; }
-	bool				hasProp(string key)	{ return properties[key].hasValue(); }
+	bool				hasProp(string key)	{ const Property* prop = properties.getIfExists(key); return prop && prop->hasValue(); }
 
 	// Generic property modification
 	virtual bool	boolProperty(string key);
@@ -77,6 +77,15 @@ public:
 	virtual void	setFloatProperty(string key, double value);
 	virtual void	setStringProperty(string key, string value);
 
+	// Property access by key id (see MobjKeys). These skip the key lookup
+	// but also the virtual functions above, so can only be used for
+	// properties that are always kept in the property list (eg. not
+	// "x", "texturetop" or a line's "special")
+	bool	boolProp(unsigned key);
+	int		intProp(unsigned key);
+	double	floatProp(unsigned key);
+	string	stringProp(unsigned key);
+
 	virtual fpoint2_t	getPoint(uint8_t point) { return fpoint2_t(0,0); }
 
 	void	filter(bool f = true) { filtered = f; }
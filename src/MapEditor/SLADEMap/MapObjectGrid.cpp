@@ -0,0 +1,181 @@
+/*******************************************************************
+ * SLADE - It's a Doom Editor
+ * Copyright (C) 2008-2014 Simon Judd
+ *
+ * Email:       sirjuddington@gmail.com
+ * Web:         http://slade.mancubus.net
+ * Filename:    MapObjectGrid.cpp
+ * Description: MapObjectGrid class, a uniform grid of map objects
+ *              (by bounding box) used by SLADEMap to speed up point
+ *              queries such as nearestVertex and sectorAt
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *******************************************************************/
+
+
+/*******************************************************************
+ * INCLUDES
+ *******************************************************************/
+#include "Main.h"
+#include "MapObjectGrid.h"
+
+
+/*******************************************************************
+ * MAPOBJECTGRID CLASS FUNCTIONS
+ *******************************************************************/
+
+/* MapObjectGrid::MapObjectGrid
+ * MapObjectGrid class constructor
+ *******************************************************************/
+MapObjectGrid::MapObjectGrid(double cell_size)
+{
+	this->cell_size = cell_size;
+}
+
+/* MapObjectGrid::cellCoord
+ * Returns the grid cell coordinate containing map coordinate [coord]
+ *******************************************************************/
+int MapObjectGrid::cellCoord(double coord) const
+{
+	double cell = floor(coord / cell_size);
+
+	// Keep within int range for silly coordinates
+	if (cell < -1000000000.0) return -1000000000;
+	if (cell > 1000000000.0) return 1000000000;
+
+	return (int)cell;
+}
+
+/* MapObjectGrid::clear
+ * Removes all objects from the grid
+ *******************************************************************/
+void MapObjectGrid::clear()
+{
+	cells.clear();
+	ranges.clear();
+}
+
+/* MapObjectGrid::add
+ * Adds [object] to all cells overlapping the box [x1,y1]-[x2,y2].
+ * If [object] is already in the grid it is moved to the new box
+ *******************************************************************/
+void MapObjectGrid::add(MapObject* object, double x1, double y1, double x2, double y2)
+{
+	// Get cell range
+	cell_range_t range;
+	range.x1 = cellCoord(MIN(x1, x2));
+	range.y1 = cellCoord(MIN(y1, y2));
+	range.x2 = cellCoord(MAX(x1, x2));
+	range.y2 = cellCoord(MAX(y1, y2));
+
+	// Check if the object is already there
+	std::map<MapObject*, cell_range_t>::iterator existing = ranges.find(object);
+	if (existing != ranges.end())
+	{
+		cell_range_t& old = existing->second;
+		if (old.x1 == range.x1 && old.y1 == range.y1 && old.x2 == range.x2 && old.y2 == range.y2)
+			return;
+
+		remove(object);
+	}
+
+	// Add to cells
+	ranges[object] = range;
+	for (int x = range.x1; x <= range.x2; x++)
+	{
+		for (int y = range.y1; y <= range.y2; y++)
+			cells[cellKey(x, y)].push_back(object);
+	}
+}
+
+/* MapObjectGrid::remove
+ * Removes [object] from the grid
+ *******************************************************************/
+void MapObjectGrid::remove(MapObject* object)
+{
+	std::map<MapObject*, cell_range_t>::iterator i = ranges.find(object);
+	if (i == ranges.end())
+		return;
+
+	cell_range_t range = i->second;
+	ranges.erase(i);
+	for (int x = range.x1; x <= range.x2; x++)
+	{
+		for (int y = range.y1; y <= range.y2; y++)
+		{
+			std::map<int64_t, vector<MapObject*>>::iterator cell = cells.find(cellKey(x, y));
+			if (cell == cells.end())
+				continue;
+
+			vector<MapObject*>& objects = cell->second;
+			for (unsigned a = 0; a < objects.size(); a++)
+			{
+				if (objects[a] == object)
+				{
+					objects[a] = objects.back();
+					objects.pop_back();
+					break;
+				}
+			}
+
+			if (objects.empty())
+				cells.erase(cell);
+		}
+	}
+}
+
+/* MapObjectGrid::getObjects
+ * Adds all objects in cells overlapping the box [x1,y1]-[x2,y2] to
+ * [list]. Each object is only added once, though the list may include
+ * objects that aren't actually within the box
+ *******************************************************************/
+void MapObjectGrid::getObjects(double x1, double y1, double x2, double y2, vector<MapObject*>& list) const
+{
+	int cx1 = cellCoord(MIN(x1, x2));
+	int cy1 = cellCoord(MIN(y1, y2));
+	int cx2 = cellCoord(MAX(x1, x2));
+	int cy2 = cellCoord(MAX(y1, y2));
+	size_t start = list.size();
+
+	// If the box covers more cells than there are in the grid,
+	// go through the occupied cells instead
+	double n_cells = ((double)cx2 - cx1 + 1) * ((double)cy2 - cy1 + 1);
+	if (n_cells > cells.size())
+	{
+		for (std::map<int64_t, vector<MapObject*>>::const_iterator i = cells.begin(); i != cells.end(); ++i)
+		{
+			int x = (int)(int32_t)(i->first >> 32);
+			int y = (int)(int32_t)(i->first & 0xFFFFFFFF);
+			if (x >= cx1 && x <= cx2 && y >= cy1 && y <= cy2)
+				list.insert(list.end(), i->second.begin(), i->second.end());
+		}
+	}
+	else
+	{
+		for (int x = cx1; x <= cx2; x++)
+		{
+			for (int y = cy1; y <= cy2; y++)
+			{
+				std::map<int64_t, vector<MapObject*>>::const_iterator cell = cells.find(cellKey(x, y));
+				if (cell != cells.end())
+					list.insert(list.end(), cell->second.begin(), cell->second.end());
+			}
+		}
+	}
+
+	// Remove duplicates (objects spanning multiple cells)
+	std::sort(list.begin() + start, list.end());
+	list.erase(std::unique(list.begin() + start, list.end()), list.end());
+}
@@ -0,0 +1,38 @@
+
+#ifndef __MAP_OBJECT_GRID_H__
+#define __MAP_OBJECT_GRID_H__
+
+class MapObject;
+
+// A uniform grid of map objects by bounding box, used to quickly find
+// objects near a point without going through every object in the map
+class MapObjectGrid
+{
+private:
+	struct cell_range_t
+	{
+		int	x1, y1, x2, y2;
+	};
+
+	double									cell_size;
+	std::map<int64_t, vector<MapObject*>>	cells;
+	std::map<MapObject*, cell_range_t>		ranges;
+
+	int				cellCoord(double coord) const;
+	static int64_t	cellKey(int x, int y) { return (int64_t)(((uint64_t)(uint32_t)x << 32) | (uint32_t)y); }
+
+public:
+	MapObjectGrid(double cell_size = 256);
+	~MapObjectGrid() {}
+
+	double	cellSize() const { return cell_size; }
+	size_t	nObjects() const { return ranges.size(); }
+
+	void	clear();
+	void	add(MapObject* object, double x1, double y1, double x2, double y2);
+	void	add(MapObject* object, double x, double y) { add(object, x, y, x, y); }
+	void	remove(MapObject* object);
+	void	getObjects(double x1, double y1, double x2, double y2, vector<MapObject*>& list) const;
+};
+
+#endif//__MAP_OBJECT_GRID_H__
@@ -0,0 +1,95 @@
+
+#ifndef __MAP_OBJECT_POOL_H__
+#define __MAP_OBJECT_POOL_H__
+
+// Allocates map objects of type [T] contiguously in large blocks, so
+// objects of the same type are close together in memory. Map objects
+// are never freed individually (deleted objects are kept for undo), so
+// this is just a bump allocator: objects are constructed in place with
+// placement new and all destroyed at once by clear(). Objects never
+// move, so pointers to them remain valid until then
+template<class T> class MapObjectPool
+{
+private:
+	struct block_t
+	{
+		char*		data;
+		unsigned	capacity;
+		unsigned	used;
+	};
+
+	vector<block_t>	blocks;
+	unsigned		min_block_size;
+	unsigned		n_objects;
+
+	// Adds a new block with room for at least [count] objects
+	void addBlock(unsigned count)
+	{
+		// Grow block sizes as the pool grows, to keep the number of
+		// blocks (and allocations) low for large maps
+		unsigned capacity = MAX(count, MAX(min_block_size, n_objects / 2));
+
+		block_t block;
+		block.data = (char*)::operator new(capacity * sizeof(T));
+		block.capacity = capacity;
+		block.used = 0;
+		blocks.push_back(block);
+	}
+
+public:
+	MapObjectPool(unsigned min_block_size = 256)
+	{
+		this->min_block_size = min_block_size;
+		this->n_objects = 0;
+	}
+
+	~MapObjectPool() { clear(); }
+
+	unsigned	nObjects() const { return n_objects; }
+
+	// Returns the memory used by the pool, in bytes
+	size_t memoryUsage() const
+	{
+		size_t size = 0;
+		for (unsigned a = 0; a < blocks.size(); a++)
+			size += blocks[a].capacity * sizeof(T);
+
+		return size;
+	}
+
+	// Makes sure there is contiguous room for at least [count] more
+	// objects, use before creating many objects at once
+	void reserve(unsigned count)
+	{
+		if (blocks.empty() || blocks.back().capacity - blocks.back().used < count)
+			addBlock(count);
+	}
+
+	// Returns uninitialised memory for one object, to be constructed
+	// with placement new
+	void* allocate()
+	{
+		reserve(1);
+		block_t& block = blocks.back();
+		n_objects++;
+		return block.data + (block.used++ * sizeof(T));
+	}
+
+	// Destroys all objects in the pool and frees all memory
+	void clear()
+	{
+		for (unsigned a = 0; a < blocks.size(); a++)
+		{
+			T* objects = (T*)blocks[a].data;
+			for (unsigned b = 0; b < blocks[a].used; b++)
+				objects[b].~T();
+
+			::operator delete(blocks[a].data);
+		}
+
+		blocks.clear();
+		n_objects = 0;
+	}
+};
+
+#endif//__MAP_OBJECT_POOL_H__
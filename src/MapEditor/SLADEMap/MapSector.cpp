@@ -299,6 +299,16 @@ bbox_t MapSector::boundingBox()
 	return bbox;
 }
 
+/* MapSector::resetPolygon
+ * Marks the sector polygon to be rebuilt when next needed
+ *******************************************************************/
+void MapSector::resetPolygon()
+{
+	poly_needsupdate = true;
+	if (parent_map)
+		parent_map->setSectorPolygonsDirty();
+}
+
 /* MapSector::getPolygon
  * Returns the sector polygon, updating it if necessary
  *******************************************************************/
@@ -477,8 +487,8 @@ uint8_t MapSector::getLight(int where)
 		if (where == 1)
 		{
 			// Floor
-			int fl = intProperty("lightfloor");
-			if (boolProperty("lightfloorabsolute"))
+			int fl = intProp(MobjKeys::lightfloor);
+			if (boolProp(MobjKeys::lightfloorabsolute))
 				l = fl;
 			else
 				l += fl;
@@ -486,8 +496,8 @@ uint8_t MapSector::getLight(int where)
 		else if (where == 2)
 		{
 			// Ceiling
-			int cl = intProperty("lightceiling");
-			if (boolProperty("lightceilingabsolute"))
+			int cl = intProp(MobjKeys::lightceiling);
+			if (boolProp(MobjKeys::lightceilingabsolute))
 				l = cl;
 			else
 				l += cl;
@@ -535,12 +545,12 @@ void MapSector::changeLight(int amount, int where)
 	// Change light level by amount
 	if (where == 1 && separate)
 	{
-		int cur = intProperty("lightfloor");
+		int cur = intProp(MobjKeys::lightfloor);
 		setIntProperty("lightfloor", cur + amount);
 	}
 	else if (where == 2 && separate)
 	{
-		int cur = intProperty("lightceiling");
+		int cur = intProp(MobjKeys::lightceiling);
 		setIntProperty("lightceiling", cur + amount);
 	}
 	else
@@ -592,7 +602,7 @@ rgba_t MapSector::getColour(int where, bool fullbright)
 		wxColour wxcol;
 		if(Game::configuration().featureSupported(UDMFFeature::SectorColor))
 		{
-			int intcol = MapObject::intProperty("lightcolor");
+			int intcol = intProp(MobjKeys::lightcolor);
 			wxcol = wxColour(intcol);
 		}
 		else
@@ -612,8 +622,8 @@ rgba_t MapSector::getColour(int where, bool fullbright)
 			if(where == 1)
 			{
 				// Floor
-				int fl = MapObject::intProperty("lightfloor");
-				if(boolProperty("lightfloorabsolute"))
+				int fl = intProp(MobjKeys::lightfloor);
+				if(boolProp(MobjKeys::lightfloorabsolute))
 					ll = fl;
 				else
 					ll += fl;
@@ -621,8 +631,8 @@ rgba_t MapSector::getColour(int where, bool fullbright)
 			else if(where == 2)
 			{
 				// Ceiling
-				int cl = MapObject::intProperty("lightceiling");
-				if(boolProperty("lightceilingabsolute"))
+				int cl = intProp(MobjKeys::lightceiling);
+				if(boolProp(MobjKeys::lightceilingabsolute))
 					ll = cl;
 				else
 					ll += cl;
@@ -675,7 +685,7 @@ rgba_t MapSector::getFogColour()
 	if (parent_map->currentFormat() == MAP_UDMF &&
 		Game::configuration().featureSupported(Game::UDMFFeature::SectorFog))
 	{
-		int intcol = MapObject::intProperty("fadecolor");
+		int intcol = intProp(MobjKeys::fadecolor);
 
 		wxColour wxcol(intcol);
 		color = rgba_t(wxcol.Blue(), wxcol.Green(), wxcol.Red(), 0);
@@ -691,7 +701,7 @@ void MapSector::connectSide(MapSide* side)
 {
 	setModified();
 	connected_sides.push_back(side);
-	poly_needsupdate = true;
+	resetPolygon();
 	bbox.reset();
 	setGeometryUpdated();
 }
@@ -711,7 +721,7 @@ void MapSector::disconnectSide(MapSide* side)
 		}
 	}
 
-	poly_needsupdate = true;
+	resetPolygon();
 	bbox.reset();
 	setGeometryUpdated();
 }
@@ -754,7 +764,7 @@ void MapSector::readBackup(mobj_backup_t* backup)
 	parent_map->updateFlatUsage(c_tex, 1);
 
 	// Update geometry info
-	poly_needsupdate = true;
+	resetPolygon();
 	bbox.reset();
 	setGeometryUpdated();
 }
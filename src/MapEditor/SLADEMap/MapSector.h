@@ -110,7 +110,7 @@ public:
 	void				resetBBox() { bbox.reset(); }
 	bbox_t				boundingBox();
 	vector<MapSide*>&	connectedSides() { return connected_sides; }
-	void				resetPolygon() { poly_needsupdate = true; }
+	void				resetPolygon();
 	Polygon2D*			getPolygon();
 	bool				isWithin(fpoint2_t point);
 	double				distanceTo(fpoint2_t point, double maxdist = -1);
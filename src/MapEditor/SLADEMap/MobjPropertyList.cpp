@@ -6,7 +6,11 @@
  * Web:         http://slade.mancubus.net
  * Filename:    MobjPropertyList.cpp
  * Description: A special version of the PropertyList class that
- *              uses a vector rather than a map to store properties
+ *              uses a vector rather than a map to store properties.
+ *              Property names are interned into a global key table,
+ *              so each list only needs to store key ids along with
+ *              the values (in the order added, plus an index sorted
+ *              by key id for binary search)
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU General Public License
@@ -29,6 +33,65 @@
  *******************************************************************/
 #include "Main.h"
 #include "MobjPropertyList.h"
+#include "Utility/MemChunk.h"
+#include <deque>
+
+
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+namespace
+{
+	// The key table. Keys are only ever added (from the main thread),
+	// a deque is used so references to key names remain valid
+	std::map<string, unsigned>	key_ids;
+	std::deque<string>			key_names;
+}
+
+// Common key ids (after the key table, so it is initialised first)
+namespace MobjKeys
+{
+	const unsigned	id = MobjPropertyList::keyId("id");
+	const unsigned	special = MobjPropertyList::keyId("special");
+	const unsigned	flags = MobjPropertyList::keyId("flags");
+	const unsigned	arg0 = MobjPropertyList::keyId("arg0");
+	const unsigned	arg1 = MobjPropertyList::keyId("arg1");
+	const unsigned	arg2 = MobjPropertyList::keyId("arg2");
+	const unsigned	arg3 = MobjPropertyList::keyId("arg3");
+	const unsigned	arg4 = MobjPropertyList::keyId("arg4");
+	const unsigned	height = MobjPropertyList::keyId("height");
+	const unsigned	alpha = MobjPropertyList::keyId("alpha");
+	const unsigned	renderstyle = MobjPropertyList::keyId("renderstyle");
+	const unsigned	wrapmidtex = MobjPropertyList::keyId("wrapmidtex");
+	const unsigned	xpanningfloor = MobjPropertyList::keyId("xpanningfloor");
+	const unsigned	ypanningfloor = MobjPropertyList::keyId("ypanningfloor");
+	const unsigned	xscalefloor = MobjPropertyList::keyId("xscalefloor");
+	const unsigned	yscalefloor = MobjPropertyList::keyId("yscalefloor");
+	const unsigned	rotationfloor = MobjPropertyList::keyId("rotationfloor");
+	const unsigned	xpanningceiling = MobjPropertyList::keyId("xpanningceiling");
+	const unsigned	ypanningceiling = MobjPropertyList::keyId("ypanningceiling");
+	const unsigned	xscaleceiling = MobjPropertyList::keyId("xscaleceiling");
+	const unsigned	yscaleceiling = MobjPropertyList::keyId("yscaleceiling");
+	const unsigned	rotationceiling = MobjPropertyList::keyId("rotationceiling");
+	const unsigned	lightcolor = MobjPropertyList::keyId("lightcolor");
+	const unsigned	fadecolor = MobjPropertyList::keyId("fadecolor");
+	const unsigned	lightfloor = MobjPropertyList::keyId("lightfloor");
+	const unsigned	lightceiling = MobjPropertyList::keyId("lightceiling");
+	const unsigned	lightfloorabsolute = MobjPropertyList::keyId("lightfloorabsolute");
+	const unsigned	lightceilingabsolute = MobjPropertyList::keyId("lightceilingabsolute");
+	const unsigned	offsetx_top = MobjPropertyList::keyId("offsetx_top");
+	const unsigned	offsety_top = MobjPropertyList::keyId("offsety_top");
+	const unsigned	scalex_top = MobjPropertyList::keyId("scalex_top");
+	const unsigned	scaley_top = MobjPropertyList::keyId("scaley_top");
+	const unsigned	offsetx_mid = MobjPropertyList::keyId("offsetx_mid");
+	const unsigned	offsety_mid = MobjPropertyList::keyId("offsety_mid");
+	const unsigned	scalex_mid = MobjPropertyList::keyId("scalex_mid");
+	const unsigned	scaley_mid = MobjPropertyList::keyId("scaley_mid");
+	const unsigned	offsetx_bottom = MobjPropertyList::keyId("offsetx_bottom");
+	const unsigned	offsety_bottom = MobjPropertyList::keyId("offsety_bottom");
+	const unsigned	scalex_bottom = MobjPropertyList::keyId("scalex_bottom");
+	const unsigned	scaley_bottom = MobjPropertyList::keyId("scaley_bottom");
+}
 
 
 /*******************************************************************
@@ -49,36 +112,70 @@ MobjPropertyList::~MobjPropertyList()
 {
 }
 
-/* MobjPropertyList::propertyExists
- * Returns true if a property with the given name exists, false
- * otherwise
+/* MobjPropertyList::keyId
+ * Returns the key id for property name [key], adding it to the key
+ * table if it isn't there already
  *******************************************************************/
-bool MobjPropertyList::propertyExists(string key)
+unsigned MobjPropertyList::keyId(const string& key)
 {
-	for (unsigned a = 0; a < properties.size(); ++a)
-	{
-		if (properties[a].name == key)
-			return true;
-	}
+	std::map<string, unsigned>::iterator i = key_ids.find(key);
+	if (i != key_ids.end())
+		return i->second;
 
-	return false;
+	unsigned id = key_names.size();
+	key_names.push_back(key);
+	key_ids[key] = id;
+
+	return id;
+}
+
+/* MobjPropertyList::findKeyId
+ * Returns the key id for property name [key], or NO_KEY if no
+ * property with that name has ever been set. Unlike keyId this never
+ * modifies the key table, so it is safe to use from other threads
+ * while the map isn't being edited
+ *******************************************************************/
+unsigned MobjPropertyList::findKeyId(const string& key)
+{
+	std::map<string, unsigned>::const_iterator i = key_ids.find(key);
+	if (i != key_ids.end())
+		return i->second;
+
+	return NO_KEY;
+}
+
+/* MobjPropertyList::keyName
+ * Returns the property name for [key]
+ *******************************************************************/
+const string& MobjPropertyList::keyName(unsigned key)
+{
+	static string invalid;
+	if (key >= key_names.size())
+		return invalid;
+
+	return key_names[key];
 }
 
 /* MobjPropertyList::removeProperty
  * Removes a property value, returns true if [key] was removed
  * or false if key didn't exist
  *******************************************************************/
-bool MobjPropertyList::removeProperty(string key)
+bool MobjPropertyList::removeProperty(const string& key)
 {
-	//return properties.erase(key) > 0;
-	for (unsigned a = 0; a < properties.size(); ++a)
+	unsigned id = findKeyId(key);
+	unsigned pos = lowerBound(id);
+	if (pos < sorted.size() && properties[sorted[pos]].key == id)
 	{
-		if (properties[a].name == key)
+		// Remove it (keeping the order of the rest) and update the index
+		unsigned index = sorted[pos];
+		properties.erase(properties.begin() + index);
+		sorted.erase(sorted.begin() + pos);
+		for (unsigned a = 0; a < sorted.size(); a++)
 		{
-			properties[a] = properties.back();
-			properties.pop_back();
-			return true;
+			if (sorted[a] > index)
+				sorted[a]--;
 		}
+		return true;
 	}
 
 	return false;
@@ -87,28 +184,24 @@ bool MobjPropertyList::removeProperty(string key)
 /* MobjPropertyList::copyTo
  * Copies all properties to [list]
  *******************************************************************/
-void MobjPropertyList::copyTo(MobjPropertyList& list)
+void MobjPropertyList::copyTo(MobjPropertyList& list) const
 {
-	// Clear given list
-	list.clear();
-
-	for (unsigned a = 0; a < properties.size(); ++a)
-		list.properties.push_back(prop_t(properties[a].name, properties[a].value));
+	list.properties = properties;
+	list.sorted = sorted;
 }
 
 /* MobjPropertyList::addFlag
  * Adds a 'flag' property [key]
  *******************************************************************/
-void MobjPropertyList::addFlag(string key)
+void MobjPropertyList::addFlag(const string& key)
 {
-	Property flag;
-	properties.push_back(prop_t(key, flag));
+	(*this)[keyId(key)] = Property();
 }
 
 /* MobjPropertyList::toString
  * Returns a string representation of the property list
  *******************************************************************/
-string MobjPropertyList::toString(bool condensed)
+string MobjPropertyList::toString(bool condensed) const
 {
 	// Init return string
 	string ret = wxEmptyString;
@@ -120,7 +213,7 @@ string MobjPropertyList::toString(bool condensed)
 			continue;
 
 		// Add "key = value;\n" to the return string
-		string key = properties[a].name;
+		string key = properties[a].name();
 		string val = properties[a].value.getStringValue();
 
 		if (properties[a].value.getType() == PROP_STRING)
@@ -134,3 +227,139 @@ string MobjPropertyList::toString(bool condensed)
 
 	return ret;
 }
+
+/* MobjPropertyList::memoryUsage
+ * Returns (roughly) the memory used by the property list, in bytes
+ *******************************************************************/
+size_t MobjPropertyList::memoryUsage() const
+{
+	size_t size = sizeof(MobjPropertyList) + properties.capacity() * sizeof(prop_t) + sorted.capacity() * sizeof(unsigned);
+	for (unsigned a = 0; a < properties.size(); ++a)
+	{
+		if (properties[a].value.getType() == PROP_STRING)
+			size += properties[a].value.getStringValue().length() * sizeof(wxChar);
+	}
+
+	return size;
+}
+
+/* MobjPropertyList::write
+ * Writes the property list to [mc] in binary form. Property names
+ * are written in full, key ids are only valid for this session
+ *******************************************************************/
+void MobjPropertyList::write(MemChunk& mc) const
+{
+	uint32_t count = properties.size();
+	mc.write(&count, 4);
+
+	for (unsigned a = 0; a < properties.size(); ++a)
+	{
+		const Property& value = properties[a].value;
+		uint8_t type = value.getType();
+		uint8_t has_value = value.hasValue() ? 1 : 0;
+
+		mc.writeString(properties[a].name());
+		mc.write(&type, 1);
+		mc.write(&has_value, 1);
+
+		switch (type)
+		{
+		case PROP_BOOL:
+		{
+			uint8_t b = value.getBoolValue() ? 1 : 0;
+			mc.write(&b, 1);
+			break;
+		}
+		case PROP_INT:
+		{
+			int32_t i = value.getIntValue();
+			mc.write(&i, 4);
+			break;
+		}
+		case PROP_UINT:
+		{
+			uint32_t u = value.getUnsignedValue();
+			mc.write(&u, 4);
+			break;
+		}
+		case PROP_FLOAT:
+		{
+			double f = value.getFloatValue();
+			mc.write(&f, 8);
+			break;
+		}
+		case PROP_STRING:
+			mc.writeString(value.getStringValue()); break;
+		default:
+			break;
+		}
+	}
+}
+
+/* MobjPropertyList::read
+ * Reads a property list written by write from [mc], replacing any
+ * existing properties. Returns false if the data is invalid
+ *******************************************************************/
+bool MobjPropertyList::read(MemChunk& mc)
+{
+	clear();
+
+	uint32_t count;
+	if (!mc.read(&count, 4))
+		return false;
+
+	for (unsigned a = 0; a < count; a++)
+	{
+		string name;
+		uint8_t type, has_value;
+		if (!mc.readString(name) || !mc.read(&type, 1) || !mc.read(&has_value, 1))
+			return false;
+
+		Property value(type);
+		switch (type)
+		{
+		case PROP_BOOL:
+		{
+			uint8_t b;
+			if (!mc.read(&b, 1)) return false;
+			value.setValue(b != 0);
+			break;
+		}
+		case PROP_INT:
+		{
+			int32_t i;
+			if (!mc.read(&i, 4)) return false;
+			value.setValue((int)i);
+			break;
+		}
+		case PROP_UINT:
+		{
+			uint32_t u;
+			if (!mc.read(&u, 4)) return false;
+			value.setValue((unsigned)u);
+			break;
+		}
+		case PROP_FLOAT:
+		{
+			double f;
+			if (!mc.read(&f, 8)) return false;
+			value.setValue(f);
+			break;
+		}
+		case PROP_STRING:
+		{
+			string str;
+			if (!mc.readString(str)) return false;
+			value.setValue(str);
+			break;
+		}
+		default:
+			break;
+		}
+
+		value.setHasValue(has_value != 0);
+		(*this)[keyId(name)] = value;
+	}
+
+	return true;
+}
@@ -1,54 +1,153 @@
-
 #ifndef __MOBJ_PROPERTY_LIST_H__
 #define __MOBJ_PROPERTY_LIST_H__
 
 #include "Utility/PropertyList/Property.h"
 
+class MemChunk;
+
+// A list of map object properties. Property names are interned into a
+// global key table, each list only stores (key id, value) pairs. These
+// are kept in the order they were added (so output order doesn't depend
+// on key ids, which vary between sessions), along with an index sorted
+// by key id so lookups are a binary search on integers rather than a
+// linear search comparing strings
 class MobjPropertyList
 {
 public:
+	static const unsigned NO_KEY = (unsigned)-1;
+
 	struct prop_t
 	{
-		string		name;
+		unsigned	key;
 		Property	value;
 
-		prop_t(string name) { this->name = name; }
-		prop_t(string name, Property value)
+		prop_t(unsigned key) { this->key = key; }
+		prop_t(unsigned key, Property value)
 		{
-			this->name = name;
+			this->key = key;
 			this->value = value;
 		}
+
+		const string&	name() const { return keyName(key); }
 	};
 
 	MobjPropertyList();
 	~MobjPropertyList();
 
-	// Operator for direct access to hash map
-	Property& operator[](string key)
+	// Key table
+	static unsigned			keyId(const string& key);
+	static unsigned			findKeyId(const string& key);
+	static const string&	keyName(unsigned key);
+
+	// Operators for direct access, add the property if it doesn't exist
+	Property& operator[](const string& key) { return (*this)[keyId(key)]; }
+	Property& operator[](unsigned key)
 	{
-		for (unsigned a = 0; a < properties.size(); ++a)
-		{
-			if (properties[a].name == key)
-				return properties[a].value;
-		}
+		unsigned pos = lowerBound(key);
+		if (pos < sorted.size() && properties[sorted[pos]].key == key)
+			return properties[sorted[pos]].value;
 
+		sorted.insert(sorted.begin() + pos, properties.size());
 		properties.push_back(prop_t(key));
 		return properties.back().value;
 	}
 
-	vector<prop_t>&	allProperties() { return properties; }
+	// Returns the property matching [key], or nullptr if it doesn't exist.
+	// Unlike operator[] this never adds a property to the list
+	const Property* getIfExists(const string& key) const { return getIfExists(findKeyId(key)); }
+	const Property* getIfExists(unsigned key) const
+	{
+		unsigned pos = lowerBound(key);
+		if (pos < sorted.size() && properties[sorted[pos]].key == key)
+			return &properties[sorted[pos]].value;
+
+		return nullptr;
+	}
 
-	void	clear() { properties.clear(); }
-	bool	propertyExists(string key);
-	bool	removeProperty(string key);
-	void	copyTo(MobjPropertyList& list);
-	void	addFlag(string key);
-	bool	isEmpty() { return properties.empty(); }
+	const vector<prop_t>&	allProperties() const { return properties; }
 
-	string	toString(bool condensed = false);
+	void	clear() { properties.clear(); sorted.clear(); }
+	bool	propertyExists(const string& key) const { return getIfExists(key) != nullptr; }
+	bool	removeProperty(const string& key);
+	void	copyTo(MobjPropertyList& list) const;
+	void	addFlag(const string& key);
+	bool	isEmpty() const { return properties.empty(); }
+
+	string	toString(bool condensed = false) const;
+	size_t	memoryUsage() const;
+	void	write(MemChunk& mc) const;
+	bool	read(MemChunk& mc);
 
 private:
-	vector<prop_t>	properties;
+	vector<prop_t>		properties;	// In the order they were added
+	vector<unsigned>	sorted;		// Indices into [properties], sorted by key
+
+	// Returns the position in [sorted] of the first property with a key
+	// not less than [key]
+	unsigned lowerBound(unsigned key) const
+	{
+		unsigned first = 0;
+		unsigned count = sorted.size();
+		while (count > 0)
+		{
+			unsigned half = count / 2;
+			if (properties[sorted[first + half]].key < key)
+			{
+				first += half + 1;
+				count -= half + 1;
+			}
+			else
+				count = half;
+		}
+
+		return first;
+	}
 };
 
+// Key ids of commonly used properties, interned at startup so hot
+// paths (rendering, map checks) can skip the key table lookup
+namespace MobjKeys
+{
+	extern const unsigned	id;
+	extern const unsigned	special;
+	extern const unsigned	flags;
+	extern const unsigned	arg0;
+	extern const unsigned	arg1;
+	extern const unsigned	arg2;
+	extern const unsigned	arg3;
+	extern const unsigned	arg4;
+	extern const unsigned	height;
+	extern const unsigned	alpha;
+	extern const unsigned	renderstyle;
+	extern const unsigned	wrapmidtex;
+	extern const unsigned	xpanningfloor;
+	extern const unsigned	ypanningfloor;
+	extern const unsigned	xscalefloor;
+	extern const unsigned	yscalefloor;
+	extern const unsigned	rotationfloor;
+	extern const unsigned	xpanningceiling;
+	extern const unsigned	ypanningceiling;
+	extern const unsigned	xscaleceiling;
+	extern const unsigned	yscaleceiling;
+	extern const unsigned	rotationceiling;
+	extern const unsigned	lightcolor;
+	extern const unsigned	fadecolor;
+	extern const unsigned	lightfloor;
+	extern const unsigned	lightceiling;
+	extern const unsigned	lightfloorabsolute;
+	extern const unsigned	lightceilingabsolute;
+	extern const unsigned	offsetx_top;
+	extern const unsigned	offsety_top;
+	extern const unsigned	scalex_top;
+	extern const unsigned	scaley_top;
+	extern const unsigned	offsetx_mid;
+	extern const unsigned	offsety_mid;
+	extern const unsigned	scalex_mid;
+	extern const unsigned	scaley_mid;
+	extern const unsigned	offsetx_bottom;
+	extern const unsigned	offsety_bottom;
+	extern const unsigned	scalex_bottom;
+	extern const unsigned	scaley_bottom;
+}
+
 #endif//__MOBJ_PROPERTY_LIST_H__
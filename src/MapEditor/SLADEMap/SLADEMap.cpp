@@ -36,8 +36,9 @@
 #include "General/UI.h"
 #include "MapEditor/SectorBuilder.h"
 #include "SLADEMap.h"
+#include "UDMFWriter.h"
 #include "Utility/MathStuff.h"
-#include "Utility/Parser.h"
+#include "Utility/Profiler.h"
 
 #define IDEQ(x) (((x) != 0) && ((x) == id))
 
@@ -46,6 +47,143 @@
  * VARIABLES
  *******************************************************************/
 CVAR(Bool, map_split_auto_offset, true, CVAR_SAVE)
+CVAR(Int, map_polygon_threads, 0, CVAR_SAVE)
+
+// Number of sectors a polygon building thread takes at a time
+#define SECTOR_POLY_BATCH 64
+
+
+/*******************************************************************
+ * FUNCTIONS
+ *******************************************************************/
+
+/* removeFromList
+ * Removes the object at [index] in [list], replacing it with the last
+ * object in the list (the same way SLADEMap removes objects)
+ *******************************************************************/
+template<class T> static void removeFromList(vector<T*>& list, unsigned index)
+{
+	list[index] = list.back();
+	list[index]->index = index;
+	list.pop_back();
+}
+
+/* replayListChange
+ * Redoes (or undoes if [undo] is true) the creation or deletion [cd]
+ * of [object] in the object [list] it belongs to
+ *******************************************************************/
+template<class T> static void replayListChange(vector<T*>& list, T* object, const mobj_cd_t& cd, bool undo)
+{
+	// Add object
+	if (cd.created != undo)
+	{
+		// Created objects go at the end
+		if (cd.created || cd.index >= list.size())
+		{
+			object->index = list.size();
+			list.push_back(object);
+		}
+
+		// Deleted objects go back where they were, moving the object
+		// that replaced them back to the end
+		else
+		{
+			list.push_back(list[cd.index]);
+			list.back()->index = list.size() - 1;
+			list[cd.index] = object;
+			object->index = cd.index;
+		}
+	}
+
+	// Remove object
+	else
+	{
+		// Should be at the end if it was created, or at the same index
+		// if it was deleted, but check anyway
+		unsigned index = cd.created ? list.size() - 1 : cd.index;
+		if (index >= list.size() || list[index] != object)
+		{
+			index = std::find(list.begin(), list.end(), object) - list.begin();
+			if (index >= list.size())
+				return;
+		}
+
+		removeFromList(list, index);
+	}
+}
+
+
+/*******************************************************************
+ * SECTORPOLYGONBUILDER CLASS
+ *******************************************************************
+ * Builds polygons for a list of sectors, in batches taken by any
+ * number of threads at once. Each sector's polygon only depends on
+ * its own sides, lines and vertices, so sectors can be built in any
+ * order as long as nothing modifies the map meanwhile
+ */
+class SectorPolygonBuilder
+{
+private:
+	vector<MapSector*>&	sectors;
+	unsigned			next;
+	unsigned			done;
+	wxMutex				mutex;
+
+public:
+	SectorPolygonBuilder(vector<MapSector*>& sectors) : sectors(sectors), next(0), done(0) {}
+	~SectorPolygonBuilder() {}
+
+	// Builds polygons for the next batch of sectors, returns false if
+	// there were none left
+	bool buildNext()
+	{
+		unsigned start, end;
+		{
+			wxMutexLocker lock(mutex);
+			start = next;
+			end = next = MIN(next + SECTOR_POLY_BATCH, sectors.size());
+		}
+		if (start >= end)
+			return false;
+
+		for (unsigned a = start; a < end; a++)
+			sectors[a]->getPolygon();
+
+		wxMutexLocker lock(mutex);
+		done += end - start;
+		return true;
+	}
+
+	// Returns the fraction of sectors built so far
+	float progress()
+	{
+		wxMutexLocker lock(mutex);
+		return (float)done / (float)sectors.size();
+	}
+};
+
+/*******************************************************************
+ * SECTORPOLYGONTHREAD CLASS
+ *******************************************************************
+ * Worker thread that builds sector polygons for a
+ * SectorPolygonBuilder until there are none left
+ */
+class SectorPolygonThread : public wxThread
+{
+private:
+	SectorPolygonBuilder*	builder;
+
+public:
+	SectorPolygonThread(SectorPolygonBuilder* builder) : wxThread(wxTHREAD_JOINABLE), builder(builder) {}
+	~SectorPolygonThread() {}
+
+	ExitCode Entry()
+	{
+		while (builder->buildNext()) {}
+
+		return NULL;
+	}
+};
 
 
 /*******************************************************************
@@ -60,6 +198,9 @@ SLADEMap::SLADEMap()
 	// Init variables
 	this->geometry_updated = 0;
 	this->position_frac = false;
+	this->grid_valid = false;
+	this->geometry_dirty_all = false;
+	this->sector_polys_dirty = false;
 
 	// Object id 0 is always null
 	all_objects.push_back(mobj_holder_t(nullptr, false));
@@ -202,7 +343,8 @@ void SLADEMap::addMapObject(MapObject* object)
 {
 	all_objects.push_back(mobj_holder_t(object, true));
 	object->id = all_objects.size() - 1;
-	created_deleted_objects.push_back(mobj_cd_t(object->id, true));
+	created_deleted_objects.push_back(mobj_cd_t(object->id, true, 0));
+	objectModified(object);
 }
 
 /* SLADEMap::removeMapObject
@@ -212,121 +354,204 @@ void SLADEMap::addMapObject(MapObject* object)
 void SLADEMap::removeMapObject(MapObject* object)
 {
 	all_objects[object->id].in_map = false;
-	created_deleted_objects.push_back(mobj_cd_t(object->id, false));
+	created_deleted_objects.push_back(mobj_cd_t(object->id, false, object->index));
+	objectModified(object);
 }
 
-/* SLADEMap::getObjectIdList
- * Adds all object ids of [type] currently in the map to [list]
+/* SLADEMap::objectMemoryUsage
+ * Returns the memory allocated for map objects, in bytes (not
+ * including properties or any other data they point to)
  *******************************************************************/
-void SLADEMap::getObjectIdList(uint8_t type, vector<unsigned>& list)
+size_t SLADEMap::objectMemoryUsage() const
 {
-	if (type == MOBJ_VERTEX)
-	{
-		for (unsigned a = 0; a < vertices.size(); a++)
-			list.push_back(vertices[a]->id);
-	}
-	else if (type == MOBJ_LINE)
-	{
-		for (unsigned a = 0; a < lines.size(); a++)
-			list.push_back(lines[a]->id);
-	}
-	else if (type == MOBJ_SIDE)
-	{
-		for (unsigned a = 0; a < sides.size(); a++)
-			list.push_back(sides[a]->id);
-	}
-	else if (type == MOBJ_SECTOR)
-	{
-		for (unsigned a = 0; a < sectors.size(); a++)
-			list.push_back(sectors[a]->id);
-	}
-	else if (type == MOBJ_THING)
+	return
+		pool_vertices.memoryUsage() +
+		pool_sides.memoryUsage() +
+		pool_lines.memoryUsage() +
+		pool_sectors.memoryUsage() +
+		pool_things.memoryUsage();
+}
+
+/* SLADEMap::replayCreateDelete
+ * Redoes the creation or deletion [cd], or undoes it if [undo] is
+ * true. Changes must be undone in the reverse order they were made
+ * (and redone in the same order) for list order to be restored
+ *******************************************************************/
+void SLADEMap::replayCreateDelete(const mobj_cd_t& cd, bool undo)
+{
+	if (cd.id == 0 || cd.id >= all_objects.size())
+		return;
+
+	MapObject* object = all_objects[cd.id].mobj;
+	switch (object->getObjType())
 	{
-		for (unsigned a = 0; a < things.size(); a++)
-			list.push_back(things[a]->id);
+	case MOBJ_VERTEX:	replayListChange(vertices, (MapVertex*)object, cd, undo); break;
+	case MOBJ_LINE:		replayListChange(lines, (MapLine*)object, cd, undo); break;
+	case MOBJ_SIDE:		replayListChange(sides, (MapSide*)object, cd, undo); break;
+	case MOBJ_SECTOR:	replayListChange(sectors, (MapSector*)object, cd, undo); break;
+	case MOBJ_THING:	replayListChange(things, (MapThing*)object, cd, undo); break;
+	default: break;
 	}
+
+	all_objects[cd.id].in_map = (cd.created != undo);
+	objectModified(object);
 }
 
-/* SLADEMap::restoreObjectIdList
- * Add all object ids in [list] to the map as [type], clearing any
- * objects of [type] currently in the map
+/* SLADEMap::objectModified
+ * Called when [object] is modified, created or removed, so that its
+ * entry in the spatial index can be updated before the next query
  *******************************************************************/
-void SLADEMap::restoreObjectIdList(uint8_t type, vector<unsigned>& list)
+void SLADEMap::objectModified(MapObject* object)
 {
-	if (type == MOBJ_VERTEX)
-	{
-		// Clear
-		for (unsigned a = 0; a < vertices.size(); a++)
-			all_objects[vertices[a]->id].in_map = false;
-		vertices.clear();
+	// Ignore objects that aren't part of this map (eg. clipboard copies)
+	if (object->id == 0 || object->id >= all_objects.size() || all_objects[object->id].mobj != object)
+		return;
 
-		// Restore
-		for (unsigned a = 0; a < list.size(); a++)
+	// Added/removed sectors change the list updateSectorPolygons checks
+	if (object->getObjType() == MOBJ_SECTOR)
+		sector_polys_dirty = true;
+
+	// Keep track of modified vertices for updateGeometryInfo
+	if (object->getObjType() == MOBJ_VERTEX && !geometry_dirty_all)
+	{
+		geometry_dirty.push_back((MapVertex*)object);
+		if (geometry_dirty.size() > vertices.size())
 		{
-			all_objects[list[a]].in_map = true;
-			vertices.push_back((MapVertex*)all_objects[list[a]].mobj);
-			vertices.back()->index = vertices.size() - 1;
+			geometry_dirty.clear();
+			geometry_dirty_all = true;
 		}
 	}
-	else if (type == MOBJ_LINE)
+
+	// Nothing else to do if the index will be rebuilt anyway
+	if (!grid_valid)
+		return;
+
+	grid_dirty.push_back(object);
+
+	// Just rebuild the whole index if a lot has changed
+	if (grid_dirty.size() > all_objects.size())
+		invalidateSpatialIndex();
+}
+
+/* SLADEMap::invalidateSpatialIndex
+ * Marks the spatial index to be fully rebuilt before the next query
+ *******************************************************************/
+void SLADEMap::invalidateSpatialIndex()
+{
+	grid_valid = false;
+	grid_dirty.clear();
+}
+
+/* SLADEMap::updateSpatialIndex
+ * Brings the spatial index up to date, either by rebuilding it
+ * completely or by updating any objects modified since the last
+ * update
+ *******************************************************************/
+void SLADEMap::updateSpatialIndex()
+{
+	// Rebuild if needed
+	if (!grid_valid)
 	{
-		// Clear
-		for (unsigned a = 0; a < lines.size(); a++)
-			all_objects[lines[a]->id].in_map = false;
-		lines.clear();
+		grid_vertices.clear();
+		grid_lines.clear();
+		grid_sectors.clear();
+		grid_things.clear();
 
-		// Restore
-		for (unsigned a = 0; a < list.size(); a++)
+		for (unsigned a = 0; a < vertices.size(); a++)
+			grid_vertices.add(vertices[a], vertices[a]->x, vertices[a]->y);
+		for (unsigned a = 0; a < lines.size(); a++)
+			grid_lines.add(lines[a], lines[a]->x1(), lines[a]->y1(), lines[a]->x2(), lines[a]->y2());
+		for (unsigned a = 0; a < sectors.size(); a++)
 		{
-			all_objects[list[a]].in_map = true;
-			lines.push_back((MapLine*)all_objects[list[a]].mobj);
-			lines.back()->index = lines.size() - 1;
+			bbox_t bbox = sectors[a]->boundingBox();
+			grid_sectors.add(sectors[a], bbox.min.x, bbox.min.y, bbox.max.x, bbox.max.y);
 		}
+		for (unsigned a = 0; a < things.size(); a++)
+			grid_things.add(things[a], things[a]->x, things[a]->y);
+
+		grid_dirty.clear();
+		grid_valid = true;
+		return;
 	}
-	else if (type == MOBJ_SIDE)
+
+	if (grid_dirty.empty())
+		return;
+
+	// Get modified objects (each only once)
+	vector<MapObject*> dirty;
+	dirty.swap(grid_dirty);
+	std::sort(dirty.begin(), dirty.end());
+	dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+
+	// Update vertices and things, and determine which lines and sectors
+	// need updating. Moving a vertex moves its lines, and changing a line
+	// or side can change a sector's bounding box
+	std::set<MapLine*> dirty_lines;
+	std::set<MapSector*> dirty_sectors;
+	for (unsigned a = 0; a < dirty.size(); a++)
 	{
-		// Clear
-		for (unsigned a = 0; a < sides.size(); a++)
-			all_objects[sides[a]->id].in_map = false;
-		sides.clear();
+		MapObject* object = dirty[a];
+		uint8_t type = object->getObjType();
 
-		// Restore
-		for (unsigned a = 0; a < list.size(); a++)
+		if (type == MOBJ_VERTEX)
+		{
+			MapVertex* vertex = (MapVertex*)object;
+			if (vertex->index < vertices.size() && vertices[vertex->index] == vertex)
+			{
+				grid_vertices.add(vertex, vertex->x, vertex->y);
+				for (unsigned l = 0; l < vertex->connected_lines.size(); l++)
+					dirty_lines.insert(vertex->connected_lines[l]);
+			}
+			else
+				grid_vertices.remove(vertex);
+		}
+		else if (type == MOBJ_LINE)
+			dirty_lines.insert((MapLine*)object);
+		else if (type == MOBJ_SIDE)
 		{
-			all_objects[list[a]].in_map = true;
-			sides.push_back((MapSide*)all_objects[list[a]].mobj);
-			sides.back()->index = sides.size() - 1;
+			MapSide* side = (MapSide*)object;
+			if (side->sector)
+				dirty_sectors.insert(side->sector);
+		}
+		else if (type == MOBJ_SECTOR)
+			dirty_sectors.insert((MapSector*)object);
+		else if (type == MOBJ_THING)
+		{
+			MapThing* thing = (MapThing*)object;
+			if (thing->index < things.size() && things[thing->index] == thing)
+				grid_things.add(thing, thing->x, thing->y);
+			else
+				grid_things.remove(thing);
 		}
 	}
-	else if (type == MOBJ_SECTOR)
-	{
-		// Clear
-		for (unsigned a = 0; a < sectors.size(); a++)
-			all_objects[sectors[a]->id].in_map = false;
-		sectors.clear();
 
-		// Restore
-		for (unsigned a = 0; a < list.size(); a++)
+	// Update lines
+	for (std::set<MapLine*>::iterator i = dirty_lines.begin(); i != dirty_lines.end(); ++i)
+	{
+		MapLine* line = *i;
+		if (line->index < lines.size() && lines[line->index] == line)
 		{
-			all_objects[list[a]].in_map = true;
-			sectors.push_back((MapSector*)all_objects[list[a]].mobj);
-			sectors.back()->index = sectors.size() - 1;
+			grid_lines.add(line, line->x1(), line->y1(), line->x2(), line->y2());
+			if (line->frontSector())
+				dirty_sectors.insert(line->frontSector());
+			if (line->backSector())
+				dirty_sectors.insert(line->backSector());
 		}
+		else
+			grid_lines.remove(line);
 	}
-	else if (type == MOBJ_THING)
-	{
-		// Clear
-		for (unsigned a = 0; a < things.size(); a++)
-			all_objects[things[a]->id].in_map = false;
-		things.clear();
 
-		// Restore
-		for (unsigned a = 0; a < list.size(); a++)
+	// Update sectors
+	for (std::set<MapSector*>::iterator i = dirty_sectors.begin(); i != dirty_sectors.end(); ++i)
+	{
+		MapSector* sector = *i;
+		if (sector->index < sectors.size() && sectors[sector->index] == sector)
 		{
-			all_objects[list[a]].in_map = true;
-			things.push_back((MapThing*)all_objects[list[a]].mobj);
-			things.back()->index = things.size() - 1;
+			bbox_t bbox = sector->boundingBox();
+			grid_sectors.add(sector, bbox.min.x, bbox.min.y, bbox.max.x, bbox.max.y);
 		}
+		else
+			grid_sectors.remove(sector);
 	}
 }
 
@@ -336,6 +561,8 @@ void SLADEMap::restoreObjectIdList(uint8_t type, vector<unsigned>& list)
 bool SLADEMap::readMap(Archive::MapDesc map)
 {
 	Archive::MapDesc omap = map;
+	invalidateSpatialIndex();
+	wxStopWatch sw;
 
 	// Check for map archive
 	Archive* tempwad = nullptr;
@@ -386,6 +613,11 @@ bool SLADEMap::readMap(Archive::MapDesc map)
 	initSectorPolygons();
 	recomputeSpecials();
 
+	// Objects created while reading the map can't be undone
+	created_deleted_objects.clear();
+
+	LOG_MESSAGE(2, "Map read in %ldms, map objects use %dKB", sw.Time(), (int)(objectMemoryUsage() / 1024));
+
 	opened_time = App::runTimer() + 10;
 
 	return ok;
@@ -396,7 +628,7 @@ bool SLADEMap::readMap(Archive::MapDesc map)
  *******************************************************************/
 bool SLADEMap::addVertex(doomvertex_t& v)
 {
-	MapVertex* nv = new MapVertex(v.x, v.y, this);
+	MapVertex* nv = new (pool_vertices.allocate()) MapVertex(v.x, v.y, this);
 	vertices.push_back(nv);
 	return true;
 }
@@ -406,7 +638,7 @@ bool SLADEMap::addVertex(doomvertex_t& v)
  *******************************************************************/
 bool SLADEMap::addVertex(doom64vertex_t& v)
 {
-	MapVertex* nv = new MapVertex((double)v.x/65536, (double)v.y/65536, this);
+	MapVertex* nv = new (pool_vertices.allocate()) MapVertex((double)v.x/65536, (double)v.y/65536, this);
 	vertices.push_back(nv);
 	return true;
 }
@@ -417,7 +649,7 @@ bool SLADEMap::addVertex(doom64vertex_t& v)
 bool SLADEMap::addSide(doomside_t& s)
 {
 	// Create side
-	MapSide* ns = new MapSide(getSector(s.sector), this);
+	MapSide* ns = new (pool_sides.allocate()) MapSide(getSector(s.sector), this);
 
 	// Setup side properties
 	ns->tex_upper = wxString::FromAscii(s.tex_upper, 8);
@@ -442,7 +674,7 @@ bool SLADEMap::addSide(doomside_t& s)
 bool SLADEMap::addSide(doom64side_t& s)
 {
 	// Create side
-	MapSide* ns = new MapSide(getSector(s.sector), this);
+	MapSide* ns = new (pool_sides.allocate()) MapSide(getSector(s.sector), this);
 
 	// Setup side properties
 	ns->tex_upper = theResourceManager->getTextureName(s.tex_upper);
@@ -493,7 +725,7 @@ bool SLADEMap::addLine(doomline_t& l)
 	if (s1 && s1->parent)
 	{
 		// Duplicate side
-		MapSide* ns = new MapSide(s1->sector, this);
+		MapSide* ns = new (pool_sides.allocate()) MapSide(s1->sector, this);
 		ns->copy(s1);
 		s1 = ns;
 		sides.push_back(s1);
@@ -503,14 +735,14 @@ bool SLADEMap::addLine(doomline_t& l)
 	if (s2 && s2->parent)
 	{
 		// Duplicate side
-		MapSide* ns = new MapSide(s2->sector, this);
+		MapSide* ns = new (pool_sides.allocate()) MapSide(s2->sector, this);
 		ns->copy(s2);
 		s2 = ns;
 		sides.push_back(s2);
 	}
 
 	// Create line
-	MapLine* nl = new MapLine(v1, v2, s1, s2, this);
+	MapLine* nl = new (pool_lines.allocate()) MapLine(v1, v2, s1, s2, this);
 
 	// Setup line properties
 	nl->properties["arg0"] = l.sector_tag;
@@ -555,7 +787,7 @@ bool SLADEMap::addLine(doom64line_t& l)
 	if (s1 && s1->parent)
 	{
 		// Duplicate side
-		MapSide* ns = new MapSide(s1->sector, this);
+		MapSide* ns = new (pool_sides.allocate()) MapSide(s1->sector, this);
 		ns->copy(s1);
 		s1 = ns;
 		sides.push_back(s1);
@@ -565,14 +797,14 @@ bool SLADEMap::addLine(doom64line_t& l)
 	if (s2 && s2->parent)
 	{
 		// Duplicate side
-		MapSide* ns = new MapSide(s2->sector, this);
+		MapSide* ns = new (pool_sides.allocate()) MapSide(s2->sector, this);
 		ns->copy(s2);
 		s2 = ns;
 		sides.push_back(s2);
 	}
 
 	// Create line
-	MapLine* nl = new MapLine(v1, v2, s1, s2, this);
+	MapLine* nl = new (pool_lines.allocate()) MapLine(v1, v2, s1, s2, this);
 
 	// Setup line properties
 	nl->properties["arg0"] = l.sector_tag;
@@ -594,7 +826,7 @@ bool SLADEMap::addLine(doom64line_t& l)
 bool SLADEMap::addSector(doomsector_t& s)
 {
 	// Create sector
-	MapSector* ns = new MapSector(wxString::FromAscii(s.f_tex, 8), wxString::FromAscii(s.c_tex, 8), this);
+	MapSector* ns = new (pool_sectors.allocate()) MapSector(wxString::FromAscii(s.f_tex, 8), wxString::FromAscii(s.c_tex, 8), this);
 
 	// Setup sector properties
 	ns->setFloorHeight(s.f_height);
@@ -619,7 +851,7 @@ bool SLADEMap::addSector(doom64sector_t& s)
 {
 	// Create sector
 	// We need to retrieve the texture name from the hash value
-	MapSector* ns = new MapSector(theResourceManager->getTextureName(s.f_tex),
+	MapSector* ns = new (pool_sectors.allocate()) MapSector(theResourceManager->getTextureName(s.f_tex),
 								  theResourceManager->getTextureName(s.c_tex), this);
 
 	// Setup sector properties
@@ -650,7 +882,7 @@ bool SLADEMap::addSector(doom64sector_t& s)
 bool SLADEMap::addThing(doomthing_t& t)
 {
 	// Create thing
-	MapThing* nt = new MapThing(t.x, t.y, t.type, this);
+	MapThing* nt = new (pool_things.allocate()) MapThing(t.x, t.y, t.type, this);
 
 	// Setup thing properties
 	nt->angle = t.angle;
@@ -667,7 +899,7 @@ bool SLADEMap::addThing(doomthing_t& t)
 bool SLADEMap::addThing(doom64thing_t& t)
 {
 	// Create thing
-	MapThing* nt = new MapThing(t.x, t.y, t.type, this);
+	MapThing* nt = new (pool_things.allocate()) MapThing(t.x, t.y, t.type, this);
 
 	// Setup thing properties
 	nt->angle = t.angle;
@@ -701,6 +933,8 @@ bool SLADEMap::readDoomVertexes(ArchiveEntry* entry)
 
 	doomvertex_t* vert_data = (doomvertex_t*)entry->getData(true);
 	unsigned nv = entry->getSize() / sizeof(doomvertex_t);
+	pool_vertices.reserve(nv);
+	vertices.reserve(vertices.size() + nv);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < nv; a++)
 	{
@@ -734,6 +968,8 @@ bool SLADEMap::readDoomSidedefs(ArchiveEntry* entry)
 
 	doomside_t* side_data = (doomside_t*)entry->getData(true);
 	unsigned ns = entry->getSize() / sizeof(doomside_t);
+	pool_sides.reserve(ns);
+	sides.reserve(sides.size() + ns);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < ns; a++)
 	{
@@ -767,6 +1003,8 @@ bool SLADEMap::readDoomLinedefs(ArchiveEntry* entry)
 
 	doomline_t* line_data = (doomline_t*)entry->getData(true);
 	unsigned nl = entry->getSize() / sizeof(doomline_t);
+	pool_lines.reserve(nl);
+	lines.reserve(lines.size() + nl);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < nl; a++)
 	{
@@ -801,6 +1039,8 @@ bool SLADEMap::readDoomSectors(ArchiveEntry* entry)
 
 	doomsector_t* sect_data = (doomsector_t*)entry->getData(true);
 	unsigned ns = entry->getSize() / sizeof(doomsector_t);
+	pool_sectors.reserve(ns);
+	sectors.reserve(sectors.size() + ns);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < ns; a++)
 	{
@@ -834,6 +1074,8 @@ bool SLADEMap::readDoomThings(ArchiveEntry* entry)
 
 	doomthing_t* thng_data = (doomthing_t*)entry->getData(true);
 	unsigned nt = entry->getSize() / sizeof(doomthing_t);
+	pool_things.reserve(nt);
+	things.reserve(things.size() + nt);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < nt; a++)
 	{
@@ -958,7 +1200,7 @@ bool SLADEMap::addLine(hexenline_t& l)
 	if (s1 && s1->parent)
 	{
 		// Duplicate side
-		MapSide* ns = new MapSide(s1->sector, this);
+		MapSide* ns = new (pool_sides.allocate()) MapSide(s1->sector, this);
 		ns->copy(s1);
 		s1 = ns;
 		sides.push_back(s1);
@@ -968,14 +1210,14 @@ bool SLADEMap::addLine(hexenline_t& l)
 	if (s2 && s2->parent)
 	{
 		// Duplicate side
-		MapSide* ns = new MapSide(s2->sector, this);
+		MapSide* ns = new (pool_sides.allocate()) MapSide(s2->sector, this);
 		ns->copy(s2);
 		s2 = ns;
 		sides.push_back(s2);
 	}
 
 	// Create line
-	MapLine* nl = new MapLine(v1, v2, s1, s2, this);
+	MapLine* nl = new (pool_lines.allocate()) MapLine(v1, v2, s1, s2, this);
 
 	// Setup line properties
 	nl->properties["arg0"] = l.args[0];
@@ -1012,7 +1254,7 @@ bool SLADEMap::addLine(hexenline_t& l)
 bool SLADEMap::addThing(hexenthing_t& t)
 {
 	// Create thing
-	MapThing* nt = new MapThing(t.x, t.y, t.type, this);
+	MapThing* nt = new (pool_things.allocate()) MapThing(t.x, t.y, t.type, this);
 
 	// Setup thing properties
 	nt->angle = t.angle;
@@ -1051,6 +1293,8 @@ bool SLADEMap::readHexenLinedefs(ArchiveEntry* entry)
 
 	hexenline_t* line_data = (hexenline_t*)entry->getData(true);
 	unsigned nl = entry->getSize() / sizeof(hexenline_t);
+	pool_lines.reserve(nl);
+	lines.reserve(lines.size() + nl);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < nl; a++)
 	{
@@ -1083,6 +1327,8 @@ bool SLADEMap::readHexenThings(ArchiveEntry* entry)
 
 	hexenthing_t* thng_data = (hexenthing_t*)entry->getData(true);
 	unsigned nt = entry->getSize() / sizeof(hexenthing_t);
+	pool_things.reserve(nt);
+	things.reserve(things.size() + nt);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < nt; a++)
 	{
@@ -1192,6 +1438,8 @@ bool SLADEMap::readDoom64Vertexes(ArchiveEntry* entry)
 
 	doom64vertex_t* vert_data = (doom64vertex_t*)entry->getData(true);
 	unsigned n = entry->getSize() / sizeof(doom64vertex_t);
+	pool_vertices.reserve(n);
+	vertices.reserve(vertices.size() + n);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < n; a++)
 	{
@@ -1224,6 +1472,8 @@ bool SLADEMap::readDoom64Sidedefs(ArchiveEntry* entry)
 
 	doom64side_t* side_data = (doom64side_t*)entry->getData(true);
 	unsigned n = entry->getSize() / sizeof(doom64side_t);
+	pool_sides.reserve(n);
+	sides.reserve(sides.size() + n);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < n; a++)
 	{
@@ -1256,6 +1506,8 @@ bool SLADEMap::readDoom64Linedefs(ArchiveEntry* entry)
 
 	doom64line_t* line_data = (doom64line_t*)entry->getData(true);
 	unsigned n = entry->getSize() / sizeof(doom64line_t);
+	pool_lines.reserve(n);
+	lines.reserve(lines.size() + n);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < n; a++)
 	{
@@ -1288,6 +1540,8 @@ bool SLADEMap::readDoom64Sectors(ArchiveEntry* entry)
 
 	doom64sector_t* sect_data = (doom64sector_t*)entry->getData(true);
 	unsigned n = entry->getSize() / sizeof(doom64sector_t);
+	pool_sectors.reserve(n);
+	sectors.reserve(sectors.size() + n);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < n; a++)
 	{
@@ -1320,6 +1574,8 @@ bool SLADEMap::readDoom64Things(ArchiveEntry* entry)
 
 	doom64thing_t* thng_data = (doom64thing_t*)entry->getData(true);
 	unsigned n = entry->getSize() / sizeof(doom64thing_t);
+	pool_things.reserve(n);
+	things.reserve(things.size() + n);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < n; a++)
 	{
@@ -1409,31 +1665,47 @@ bool SLADEMap::readDoom64Map(Archive::MapDesc map)
 	return true;
 }
 
+/* findUDMFField
+ * Returns the index of the first field in [fields] named [name]
+ * (ignoring case), or -1 if there is none
+ *******************************************************************/
+static int findUDMFField(const UDMFReader::field_t* fields, unsigned n_fields, const char* name)
+{
+	for (unsigned a = 0; a < n_fields; a++)
+	{
+		if (UDMFReader::nameIs(fields[a], name))
+			return a;
+	}
+
+	return -1;
+}
+
 /* SLADEMap::addVertex
- * Adds a vertex to the map from parsed UDMF vertex definition [def]
+ * Adds a vertex to the map from UDMF vertex definition [fields]
  *******************************************************************/
-bool SLADEMap::addVertex(ParseTreeNode* def)
+bool SLADEMap::addVertex(const UDMFReader::field_t* fields, unsigned n_fields)
 {
 	// Check for required properties
-	auto prop_x = def->getChildPTN("x");
-	auto prop_y = def->getChildPTN("y");
-	if (!prop_x || !prop_y)
+	int prop_x = findUDMFField(fields, n_fields, "x");
+	int prop_y = findUDMFField(fields, n_fields, "y");
+	if (prop_x < 0 || prop_y < 0)
 		return false;
 
 	// Create new vertex
-	MapVertex* nv = new MapVertex(prop_x->floatValue(), prop_y->floatValue(), this);
+	MapVertex* nv = new (pool_vertices.allocate()) MapVertex(
+		UDMFReader::value(fields[prop_x]).getFloatValue(),
+		UDMFReader::value(fields[prop_y]).getFloatValue(),
+		this
+	);
 
 	// Add extra vertex info
-	ParseTreeNode* prop = nullptr;
-	for (unsigned a = 0; a < def->nChildren(); a++)
+	for (int a = 0; a < (int)n_fields; a++)
 	{
-		prop = def->getChildPTN(a);
-
 		// Skip required properties
-		if (prop == prop_x || prop == prop_y)
+		if (a == prop_x || a == prop_y)
 			continue;
 
-		nv->properties[prop->getName()] = prop->value();
+		nv->properties[UDMFReader::name(fields[a])] = UDMFReader::value(fields[a]);
 	}
 
 	// Add vertex to map
@@ -1443,22 +1715,22 @@ bool SLADEMap::addVertex(ParseTreeNode* def)
 }
 
 /* SLADEMap::addSide
- * Adds a side to the map from parsed UDMF side definition [def]
+ * Adds a side to the map from UDMF side definition [fields]
  *******************************************************************/
-bool SLADEMap::addSide(ParseTreeNode* def)
+bool SLADEMap::addSide(const UDMFReader::field_t* fields, unsigned n_fields)
 {
 	// Check for required properties
-	auto prop_sector = def->getChildPTN("sector");
-	if (!prop_sector)
+	int prop_sector = findUDMFField(fields, n_fields, "sector");
+	if (prop_sector < 0)
 		return false;
 
 	// Check sector index
-	int sector = prop_sector->intValue();
+	int sector = UDMFReader::value(fields[prop_sector]).getIntValue();
 	if (sector < 0 || sector >= (int)sectors.size())
 		return false;
 
 	// Create new side
-	MapSide* ns = new MapSide(sectors[sector], this);
+	MapSide* ns = new (pool_sides.allocate()) MapSide(sectors[sector], this);
 
 	// Set defaults
 	ns->offset_x = 0;
@@ -1468,28 +1740,25 @@ bool SLADEMap::addSide(ParseTreeNode* def)
 	ns->tex_lower = "-";
 
 	// Add extra side info
-	ParseTreeNode* prop = nullptr;
-	for (unsigned a = 0; a < def->nChildren(); a++)
+	for (int a = 0; a < (int)n_fields; a++)
 	{
-		prop = def->getChildPTN(a);
-
 		// Skip required properties
-		if (prop == prop_sector)
+		if (a == prop_sector)
 			continue;
 
-		if (S_CMPNOCASE(prop->getName(), "texturetop"))
-			ns->tex_upper = prop->stringValue();
-		else if (S_CMPNOCASE(prop->getName(), "texturemiddle"))
-			ns->tex_middle = prop->stringValue();
-		else if (S_CMPNOCASE(prop->getName(), "texturebottom"))
-			ns->tex_lower = prop->stringValue();
-		else if (S_CMPNOCASE(prop->getName(), "offsetx"))
-			ns->offset_x = prop->intValue();
-		else if (S_CMPNOCASE(prop->getName(), "offsety"))
-			ns->offset_y = prop->intValue();
+		const UDMFReader::field_t& field = fields[a];
+		if (UDMFReader::nameIs(field, "texturetop"))
+			ns->tex_upper = UDMFReader::value(field).getStringValue();
+		else if (UDMFReader::nameIs(field, "texturemiddle"))
+			ns->tex_middle = UDMFReader::value(field).getStringValue();
+		else if (UDMFReader::nameIs(field, "texturebottom"))
+			ns->tex_lower = UDMFReader::value(field).getStringValue();
+		else if (UDMFReader::nameIs(field, "offsetx"))
+			ns->offset_x = UDMFReader::value(field).getIntValue();
+		else if (UDMFReader::nameIs(field, "offsety"))
+			ns->offset_y = UDMFReader::value(field).getIntValue();
 		else
-			ns->properties[prop->getName()] = prop->value();
-		//LOG_MESSAGE(1, "Property %s type %s (%s)", prop->getName(), prop->getValue().typeString(), prop->getValue().getStringValue());
+			ns->properties[UDMFReader::name(field)] = UDMFReader::value(field);
 	}
 
 	// Update texture counts
@@ -1504,21 +1773,21 @@ bool SLADEMap::addSide(ParseTreeNode* def)
 }
 
 /* SLADEMap::addLine
- * Adds a line to the map from parsed UDMF line definition [def]
+ * Adds a line to the map from UDMF line definition [fields]
  *******************************************************************/
-bool SLADEMap::addLine(ParseTreeNode* def)
+bool SLADEMap::addLine(const UDMFReader::field_t* fields, unsigned n_fields)
 {
 	// Check for required properties
-	auto prop_v1 = def->getChildPTN("v1");
-	auto prop_v2 = def->getChildPTN("v2");
-	auto prop_s1 = def->getChildPTN("sidefront");
-	if (!prop_v1 || !prop_v2 || !prop_s1)
+	int prop_v1 = findUDMFField(fields, n_fields, "v1");
+	int prop_v2 = findUDMFField(fields, n_fields, "v2");
+	int prop_s1 = findUDMFField(fields, n_fields, "sidefront");
+	if (prop_v1 < 0 || prop_v2 < 0 || prop_s1 < 0)
 		return false;
 
 	// Check indices
-	int v1 = prop_v1->intValue();
-	int v2 = prop_v2->intValue();
-	int s1 = prop_s1->intValue();
+	int v1 = UDMFReader::value(fields[prop_v1]).getIntValue();
+	int v2 = UDMFReader::value(fields[prop_v2]).getIntValue();
+	int s1 = UDMFReader::value(fields[prop_s1]).getIntValue();
 	if (v1 < 0 || v1 >= (int)vertices.size())
 		return false;
 	if (v2 < 0 || v2 >= (int)vertices.size())
@@ -1528,29 +1797,26 @@ bool SLADEMap::addLine(ParseTreeNode* def)
 
 	// Get second side if any
 	MapSide* side2 = nullptr;
-	auto prop_s2 = def->getChildPTN("sideback");
-	if (prop_s2) side2 = getSide(prop_s2->intValue());
+	int prop_s2 = findUDMFField(fields, n_fields, "sideback");
+	if (prop_s2 >= 0) side2 = getSide(UDMFReader::value(fields[prop_s2]).getIntValue());
 
 	// Create new line
-	MapLine* nl = new MapLine(vertices[v1], vertices[v2], sides[s1], side2, this);
+	MapLine* nl = new (pool_lines.allocate()) MapLine(vertices[v1], vertices[v2], sides[s1], side2, this);
 
 	// Set defaults
 	nl->special = 0;
 
 	// Add extra line info
-	ParseTreeNode* prop = nullptr;
-	for (unsigned a = 0; a < def->nChildren(); a++)
+	for (int a = 0; a < (int)n_fields; a++)
 	{
-		prop = def->getChildPTN(a);
-
 		// Skip required properties
-		if (prop == prop_v1 || prop == prop_v2 || prop == prop_s1 || prop == prop_s2)
+		if (a == prop_v1 || a == prop_v2 || a == prop_s1 || a == prop_s2)
 			continue;
 
-		if (prop->getName() == "special")
-			nl->special = prop->intValue();
+		if (UDMFReader::nameIs(fields[a], "special"))
+			nl->special = UDMFReader::value(fields[a]).getIntValue();
 		else
-			nl->properties[prop->getName()] = prop->value();
+			nl->properties[UDMFReader::name(fields[a])] = UDMFReader::value(fields[a]);
 	}
 
 	// Add line to map
@@ -1560,18 +1826,22 @@ bool SLADEMap::addLine(ParseTreeNode* def)
 }
 
 /* SLADEMap::addSector
- * Adds a sector to the map from parsed UDMF sector definition [def]
+ * Adds a sector to the map from UDMF sector definition [fields]
  *******************************************************************/
-bool SLADEMap::addSector(ParseTreeNode* def)
+bool SLADEMap::addSector(const UDMFReader::field_t* fields, unsigned n_fields)
 {
 	// Check for required properties
-	auto prop_ftex = def->getChildPTN("texturefloor");
-	auto prop_ctex = def->getChildPTN("textureceiling");
-	if (!prop_ftex || !prop_ctex)
+	int prop_ftex = findUDMFField(fields, n_fields, "texturefloor");
+	int prop_ctex = findUDMFField(fields, n_fields, "textureceiling");
+	if (prop_ftex < 0 || prop_ctex < 0)
 		return false;
 
 	// Create new sector
-	MapSector* ns = new MapSector(prop_ftex->stringValue(), prop_ctex->stringValue(), this);
+	MapSector* ns = new (pool_sectors.allocate()) MapSector(
+		UDMFReader::value(fields[prop_ftex]).getStringValue(),
+		UDMFReader::value(fields[prop_ctex]).getStringValue(),
+		this
+	);
 	usage_flat[ns->f_tex.Upper()] += 1;
 	usage_flat[ns->c_tex.Upper()] += 1;
 
@@ -1583,27 +1853,25 @@ bool SLADEMap::addSector(ParseTreeNode* def)
 	ns->tag = 0;
 
 	// Add extra sector info
-	ParseTreeNode* prop = nullptr;
-	for (unsigned a = 0; a < def->nChildren(); a++)
+	for (int a = 0; a < (int)n_fields; a++)
 	{
-		prop = def->getChildPTN(a);
-
 		// Skip required properties
-		if (prop == prop_ftex || prop == prop_ctex)
+		if (a == prop_ftex || a == prop_ctex)
 			continue;
 
-		if (S_CMPNOCASE(prop->getName(), "heightfloor"))
-			ns->setFloorHeight(prop->intValue());
-		else if (S_CMPNOCASE(prop->getName(), "heightceiling"))
-			ns->setCeilingHeight(prop->intValue());
-		else if (S_CMPNOCASE(prop->getName(), "lightlevel"))
-			ns->light = prop->intValue();
-		else if (S_CMPNOCASE(prop->getName(), "special"))
-			ns->special = prop->intValue();
-		else if (S_CMPNOCASE(prop->getName(), "id"))
-			ns->tag = prop->intValue();
+		const UDMFReader::field_t& field = fields[a];
+		if (UDMFReader::nameIs(field, "heightfloor"))
+			ns->setFloorHeight(UDMFReader::value(field).getIntValue());
+		else if (UDMFReader::nameIs(field, "heightceiling"))
+			ns->setCeilingHeight(UDMFReader::value(field).getIntValue());
+		else if (UDMFReader::nameIs(field, "lightlevel"))
+			ns->light = UDMFReader::value(field).getIntValue();
+		else if (UDMFReader::nameIs(field, "special"))
+			ns->special = UDMFReader::value(field).getIntValue();
+		else if (UDMFReader::nameIs(field, "id"))
+			ns->tag = UDMFReader::value(field).getIntValue();
 		else
-			ns->properties[prop->getName()] = prop->value();
+			ns->properties[UDMFReader::name(field)] = UDMFReader::value(field);
 	}
 
 	// Add sector to map
@@ -1613,35 +1881,37 @@ bool SLADEMap::addSector(ParseTreeNode* def)
 }
 
 /* SLADEMap::addThing
- * Adds a thing to the map from parsed UDMF thing definition [def]
+ * Adds a thing to the map from UDMF thing definition [fields]
  *******************************************************************/
-bool SLADEMap::addThing(ParseTreeNode* def)
+bool SLADEMap::addThing(const UDMFReader::field_t* fields, unsigned n_fields)
 {
 	// Check for required properties
-	auto prop_x = def->getChildPTN("x");
-	auto prop_y = def->getChildPTN("y");
-	auto prop_type = def->getChildPTN("type");
-	if (!prop_x || !prop_y || !prop_type)
+	int prop_x = findUDMFField(fields, n_fields, "x");
+	int prop_y = findUDMFField(fields, n_fields, "y");
+	int prop_type = findUDMFField(fields, n_fields, "type");
+	if (prop_x < 0 || prop_y < 0 || prop_type < 0)
 		return false;
 
 	// Create new thing
-	MapThing* nt = new MapThing(prop_x->floatValue(), prop_y->floatValue(), prop_type->intValue(), this);
+	MapThing* nt = new (pool_things.allocate()) MapThing(
+		UDMFReader::value(fields[prop_x]).getFloatValue(),
+		UDMFReader::value(fields[prop_y]).getFloatValue(),
+		UDMFReader::value(fields[prop_type]).getIntValue(),
+		this
+	);
 
 	// Add extra thing info
-	ParseTreeNode* prop = nullptr;
-	for (unsigned a = 0; a < def->nChildren(); a++)
+	for (int a = 0; a < (int)n_fields; a++)
 	{
-		prop = def->getChildPTN(a);
-
 		// Skip required properties
-		if (prop == prop_x || prop == prop_y || prop == prop_type)
+		if (a == prop_x || a == prop_y || a == prop_type)
 			continue;
 
 		// Builtin properties
-		if (S_CMPNOCASE(prop->getName(), "angle"))
-			nt->angle = prop->intValue();
+		if (UDMFReader::nameIs(fields[a], "angle"))
+			nt->angle = UDMFReader::value(fields[a]).getIntValue();
 		else
-			nt->properties[prop->getName()] = prop->value();
+			nt->properties[UDMFReader::name(fields[a])] = UDMFReader::value(fields[a]);
 	}
 
 	// Add thing to map
@@ -1650,7 +1920,7 @@ bool SLADEMap::addThing(ParseTreeNode* def)
 	return true;
 }
 
-/* SLADEMap::readDoomMap
+/* SLADEMap::readUDMFMap
  * Reads a UDMF format map using info in [map]
  *******************************************************************/
 bool SLADEMap::readUDMFMap(Archive::MapDesc map)
@@ -1658,102 +1928,96 @@ bool SLADEMap::readUDMFMap(Archive::MapDesc map)
 	// Get TEXTMAP entry (will always be after the 'head' entry)
 	ArchiveEntry* textmap = map.head->nextEntry();
 
-	// --- Parse UDMF text ---
-	UI::setSplashProgressMessage("Parsing TEXTMAP");
-	UI::setSplashProgress(-100.0f);
-	Parser parser;
-	if (!parser.parseText(textmap->getMCData()))
-		return false;
-
-	// --- Process parsed data ---
+	// --- Read UDMF text ---
 
-	// First we have to sort the definition blocks by type so they can
-	// be created in the correct order (verts->sides->lines->sectors->things),
-	// even if they aren't defined in that order.
-	// Unknown definitions are also kept, just in case
-	UI::setSplashProgressMessage("Sorting definitions");
-	ParseTreeNode* root = parser.parseTreeRoot();
-	vector<ParseTreeNode*> defs_vertices;
-	vector<ParseTreeNode*> defs_lines;
-	vector<ParseTreeNode*> defs_sides;
-	vector<ParseTreeNode*> defs_sectors;
-	vector<ParseTreeNode*> defs_things;
-	vector<ParseTreeNode*> defs_other;
-	for (unsigned a = 0; a < root->nChildren(); a++)
+	// The text is read in a single pass, creating map objects directly
+	// from each definition. Vertices, sectors and things are created
+	// straight away, but sides and lines refer to other objects by
+	// index and could come before them, so they are kept until the end
+	// (as lists of fields pointing into the text, not full objects).
+	// Unknown definitions are kept as-is and written back on save
+	UI::setSplashProgressMessage("Reading TEXTMAP");
+	UI::setSplashProgress(0.0f);
+	UDMFReader reader(textmap->getMCData(), textmap->getName());
+	UDMFReader::def_t def;
+	vector<UDMFReader::field_t> fields_sides;
+	vector<UDMFReader::field_t> fields_lines;
+	vector<unsigned> defs_sides;	// Start of each definition in fields_sides
+	vector<unsigned> defs_lines;	// Start of each definition in fields_lines
+	unsigned n_defs = 0;
+	while (reader.next(def))
 	{
-		UI::setSplashProgress((float)a / root->nChildren());
+		if (++n_defs % 1000 == 0)
+			UI::setSplashProgress(reader.progress() * 0.8f);
 
-		auto node = root->getChildPTN(a);
+		const UDMFReader::field_t* fields = def.fields.empty() ? nullptr : &def.fields[0];
 
 		// Vertex definition
-		if (S_CMPNOCASE(node->getName(), "vertex"))
-			defs_vertices.push_back(node);
-
-		// Line definition
-		else if (S_CMPNOCASE(node->getName(), "linedef"))
-			defs_lines.push_back(node);
-
-		// Side definition
-		else if (S_CMPNOCASE(node->getName(), "sidedef"))
-			defs_sides.push_back(node);
+		if (def.block && UDMFReader::typeIs(def, "vertex"))
+			addVertex(fields, def.fields.size());
 
 		// Sector definition
-		else if (S_CMPNOCASE(node->getName(), "sector"))
-			defs_sectors.push_back(node);
+		else if (def.block && UDMFReader::typeIs(def, "sector"))
+			addSector(fields, def.fields.size());
 
 		// Thing definition
-		else if (S_CMPNOCASE(node->getName(), "thing"))
-			defs_things.push_back(node);
+		else if (def.block && UDMFReader::typeIs(def, "thing"))
+			addThing(fields, def.fields.size());
+
+		// Side definition
+		else if (def.block && UDMFReader::typeIs(def, "sidedef"))
+		{
+			defs_sides.push_back(fields_sides.size());
+			fields_sides.insert(fields_sides.end(), def.fields.begin(), def.fields.end());
+		}
+
+		// Line definition
+		else if (def.block && UDMFReader::typeIs(def, "linedef"))
+		{
+			defs_lines.push_back(fields_lines.size());
+			fields_lines.insert(fields_lines.end(), def.fields.begin(), def.fields.end());
+		}
 
 		// Namespace
-		else if (S_CMPNOCASE(node->getName(), "namespace"))
-			udmf_namespace = node->stringValue();
+		else if (!def.block && UDMFReader::typeIs(def, "namespace"))
+			udmf_namespace = UDMFReader::value(def.fields[0]).getStringValue();
 
 		// Unknown
 		else
-			defs_other.push_back(node);
+			udmf_extra_defs.push_back(string(def.text, def.text_len));
 	}
 
-	// Now create map structures from parsed data, in the right order
-
-	// Create vertices from parsed data
-	UI::setSplashProgressMessage("Reading Vertices");
-	for (unsigned a = 0; a < defs_vertices.size(); a++)
-	{
-		UI::setSplashProgress(((float)a / defs_vertices.size()) * 0.2f);
-		addVertex(defs_vertices[a]);
-	}
-
-	// Create sectors from parsed data
-	UI::setSplashProgressMessage("Reading Sectors");
-	for (unsigned a = 0; a < defs_sectors.size(); a++)
+	if (reader.hasError())
 	{
-		UI::setSplashProgress(0.2f + ((float)a / defs_sectors.size()) * 0.2f);
-		addSector(defs_sectors[a]);
+		LOG_MESSAGE(1, "Error reading UDMF map: %s", reader.errorMessage());
+		Global::error = reader.errorMessage();
+		return false;
 	}
 
-	// Create sides from parsed data
+	// Create sides
 	UI::setSplashProgressMessage("Reading Sides");
-	for (unsigned a = 0; a < defs_sides.size(); a++)
+	pool_sides.reserve(defs_sides.size());
+	sides.reserve(sides.size() + defs_sides.size());
+	defs_sides.push_back(fields_sides.size());
+	for (unsigned a = 0; a + 1 < defs_sides.size(); a++)
 	{
-		UI::setSplashProgress(0.4f + ((float)a / defs_sides.size()) * 0.2f);
-		addSide(defs_sides[a]);
+		if (a % 1000 == 0)
+			UI::setSplashProgress(0.8f + ((float)a / defs_sides.size()) * 0.1f);
+		unsigned n_fields = defs_sides[a + 1] - defs_sides[a];
+		addSide(n_fields > 0 ? &fields_sides[defs_sides[a]] : nullptr, n_fields);
 	}
 
-	// Create lines from parsed data
+	// Create lines
 	UI::setSplashProgressMessage("Reading Lines");
-	for (unsigned a = 0; a < defs_lines.size(); a++)
-	{
-		UI::setSplashProgress(0.6f + ((float)a / defs_lines.size()) * 0.2f);
-		addLine(defs_lines[a]);
-	}
-
-	// Create things from parsed data
-	UI::setSplashProgressMessage("Reading Things");
-	for (unsigned a = 0; a < defs_things.size(); a++)
+	pool_lines.reserve(defs_lines.size());
+	lines.reserve(lines.size() + defs_lines.size());
+	defs_lines.push_back(fields_lines.size());
+	for (unsigned a = 0; a + 1 < defs_lines.size(); a++)
 	{
-		UI::setSplashProgress(0.8f + ((float)a / defs_things.size()) * 0.2f);
-		addThing(defs_things[a]);
+		if (a % 1000 == 0)
+			UI::setSplashProgress(0.9f + ((float)a / defs_lines.size()) * 0.1f);
+		unsigned n_fields = defs_lines[a + 1] - defs_lines[a];
+		addLine(n_fields > 0 ? &fields_lines[defs_lines[a]] : nullptr, n_fields);
 	}
 
 	UI::setSplashProgressMessage("Init map data");
@@ -2343,154 +2607,152 @@ bool SLADEMap::writeUDMFMap(ArchiveEntry* textmap)
 	if (!textmap)
 		return false;
 
-	// Open temp text file
-	wxFile tempfile(App::path("sladetemp.txt", App::Dir::Temp), wxFile::write);
+	// Estimate output size, to avoid reallocating the buffer as it grows
+	size_t reserve = 64 + things.size() * 96 + lines.size() * 96 + sides.size() * 96 + vertices.size() * 48 + sectors.size() * 160;
+	for (unsigned a = 0; a < udmf_extra_defs.size(); a++)
+		reserve += udmf_extra_defs[a].length() + 2;
+	UDMFWriter writer(reserve);
 
 	// Write map namespace
-	tempfile.Write("// Written by SLADE3\n");
-	tempfile.Write(S_FMT("namespace=\"%s\";\n", udmf_namespace));
-
-	//sf::Clock clock;
-
-	// Locale for float number format
-	setlocale(LC_NUMERIC, "C");
+	writer.writeRaw("// Written by SLADE3\n");
+	writer.writeString("namespace", udmf_namespace);
 
 	// Write things
-	string object_def;
 	for (unsigned a = 0; a < things.size(); a++)
 	{
-		object_def = S_FMT("thing//#%u\n{\n", a);
+		MapThing* thing = things[a];
+		writer.beginBlock("thing", a);
 
 		// Basic properties
-		object_def += S_FMT("x=%1.3f;\ny=%1.3f;\ntype=%d;\n", things[a]->x, things[a]->y, things[a]->type);
-		if (things[a]->angle != 0) object_def += S_FMT("angle=%d;\n", things[a]->angle);
+		writer.writeFloat("x", thing->x);
+		writer.writeFloat("y", thing->y);
+		writer.writeInt("type", thing->type);
+		if (thing->angle != 0) writer.writeInt("angle", thing->angle);
 
 		// Remove internal 'flags' property if it exists
-		things[a]->props().removeProperty("flags");
+		thing->properties.removeProperty("flags");
 
 		// Other properties
-		if (!things[a]->properties.isEmpty())
+		if (!thing->properties.isEmpty())
 		{
-			Game::configuration().cleanObjectUDMFProps(things[a]);
-			object_def += things[a]->properties.toString(true);
+			Game::configuration().cleanObjectUDMFProps(thing);
+			writer.writeProperties(thing->properties);
 		}
 
-		object_def += "}\n\n";
-		tempfile.Write(object_def);
+		writer.endBlock();
 	}
-	//LOG_MESSAGE(1, "Writing things took %dms", clock.getElapsedTime().asMilliseconds());
 
 	// Write lines
-	//clock.restart();
 	for (unsigned a = 0; a < lines.size(); a++)
 	{
-		object_def = S_FMT("linedef//#%u\n{\n", a);
+		MapLine* line = lines[a];
+		writer.beginBlock("linedef", a);
 
 		// Basic properties
-		object_def += S_FMT("v1=%d;\nv2=%d;\nsidefront=%d;\n", lines[a]->v1Index(), lines[a]->v2Index(), lines[a]->s1Index());
-		if (lines[a]->s2())
-			object_def += S_FMT("sideback=%d;\n", lines[a]->s2Index());
-		if (lines[a]->special != 0)
-			object_def += S_FMT("special=%d;\n", lines[a]->special);
+		writer.writeInt("v1", line->v1Index());
+		writer.writeInt("v2", line->v2Index());
+		writer.writeInt("sidefront", line->s1Index());
+		if (line->s2())
+			writer.writeInt("sideback", line->s2Index());
+		if (line->special != 0)
+			writer.writeInt("special", line->special);
 
 		// Remove internal 'flags' property if it exists
-		lines[a]->props().removeProperty("flags");
+		line->properties.removeProperty("flags");
 
 		// Other properties
-		if (!lines[a]->properties.isEmpty())
+		if (!line->properties.isEmpty())
 		{
-			Game::configuration().cleanObjectUDMFProps(lines[a]);
-			object_def += lines[a]->properties.toString(true);
+			Game::configuration().cleanObjectUDMFProps(line);
+			writer.writeProperties(line->properties);
 		}
 
-		object_def += "}\n\n";
-		tempfile.Write(object_def);
+		writer.endBlock();
 	}
-	//LOG_MESSAGE(1, "Writing lines took %dms", clock.getElapsedTime().asMilliseconds());
 
 	// Write sides
-	//clock.restart();
 	for (unsigned a = 0; a < sides.size(); a++)
 	{
-		object_def = S_FMT("sidedef//#%u\n{\n", a);
+		MapSide* side = sides[a];
+		writer.beginBlock("sidedef", a);
 
 		// Basic properties
-		object_def += S_FMT("sector=%u;\n", sides[a]->sector->getIndex());
-		if (sides[a]->tex_upper != "-")
-			object_def += S_FMT("texturetop=\"%s\";\n", sides[a]->tex_upper);
-		if (sides[a]->tex_middle != "-")
-			object_def += S_FMT("texturemiddle=\"%s\";\n", sides[a]->tex_middle);
-		if (sides[a]->tex_lower != "-")
-			object_def += S_FMT("texturebottom=\"%s\";\n", sides[a]->tex_lower);
-		if (sides[a]->offset_x != 0)
-			object_def += S_FMT("offsetx=%d;\n", sides[a]->offset_x);
-		if (sides[a]->offset_y != 0)
-			object_def += S_FMT("offsety=%d;\n", sides[a]->offset_y);
+		writer.writeInt("sector", side->sector->getIndex());
+		if (side->tex_upper != "-")
+			writer.writeString("texturetop", side->tex_upper);
+		if (side->tex_middle != "-")
+			writer.writeString("texturemiddle", side->tex_middle);
+		if (side->tex_lower != "-")
+			writer.writeString("texturebottom", side->tex_lower);
+		if (side->offset_x != 0)
+			writer.writeInt("offsetx", side->offset_x);
+		if (side->offset_y != 0)
+			writer.writeInt("offsety", side->offset_y);
 
 		// Other properties
-		if (!sides[a]->properties.isEmpty())
+		if (!side->properties.isEmpty())
 		{
-			Game::configuration().cleanObjectUDMFProps(sides[a]);
-			object_def += sides[a]->properties.toString(true);
+			Game::configuration().cleanObjectUDMFProps(side);
+			writer.writeProperties(side->properties);
 		}
 
-		object_def += "}\n\n";
-		tempfile.Write(object_def);
+		writer.endBlock();
 	}
-	//LOG_MESSAGE(1, "Writing sides took %dms", clock.getElapsedTime().asMilliseconds());
 
 	// Write vertices
-	//clock.restart();
 	for (unsigned a = 0; a < vertices.size(); a++)
 	{
-		object_def = S_FMT("vertex//#%u\n{\n", a);
+		MapVertex* vertex = vertices[a];
+		writer.beginBlock("vertex", a);
 
 		// Basic properties
-		object_def += S_FMT("x=%1.3f;\ny=%1.3f;\n", vertices[a]->x, vertices[a]->y);
+		writer.writeFloat("x", vertex->x);
+		writer.writeFloat("y", vertex->y);
 
 		// Other properties
-		if (!vertices[a]->properties.isEmpty())
+		if (!vertex->properties.isEmpty())
 		{
-			Game::configuration().cleanObjectUDMFProps(vertices[a]);
-			object_def += vertices[a]->properties.toString(true);
+			Game::configuration().cleanObjectUDMFProps(vertex);
+			writer.writeProperties(vertex->properties);
 		}
 
-		object_def += "}\n\n";
-		tempfile.Write(object_def);
+		writer.endBlock();
 	}
-	//LOG_MESSAGE(1, "Writing vertices took %dms", clock.getElapsedTime().asMilliseconds());
 
 	// Write sectors
-	//clock.restart();
 	for (unsigned a = 0; a < sectors.size(); a++)
 	{
-		object_def = S_FMT("sector//#%u\n{\n", a);
+		MapSector* sector = sectors[a];
+		writer.beginBlock("sector", a);
 
 		// Basic properties
-		object_def += S_FMT("texturefloor=\"%s\";\ntextureceiling=\"%s\";\n", sectors[a]->f_tex, sectors[a]->c_tex);
-		if (sectors[a]->f_height != 0) object_def += S_FMT("heightfloor=%d;\n", sectors[a]->f_height);
-		if (sectors[a]->c_height != 0) object_def += S_FMT("heightceiling=%d;\n", sectors[a]->c_height);
-		if (sectors[a]->light != 160) object_def += S_FMT("lightlevel=%d;\n", sectors[a]->light);
-		if (sectors[a]->special != 0) object_def += S_FMT("special=%d;\n", sectors[a]->special);
-		if (sectors[a]->tag != 0) object_def += S_FMT("id=%d;\n", sectors[a]->tag);
+		writer.writeString("texturefloor", sector->f_tex);
+		writer.writeString("textureceiling", sector->c_tex);
+		if (sector->f_height != 0) writer.writeInt("heightfloor", sector->f_height);
+		if (sector->c_height != 0) writer.writeInt("heightceiling", sector->c_height);
+		if (sector->light != 160) writer.writeInt("lightlevel", sector->light);
+		if (sector->special != 0) writer.writeInt("special", sector->special);
+		if (sector->tag != 0) writer.writeInt("id", sector->tag);
 
 		// Other properties
-		if (!sectors[a]->properties.isEmpty())
+		if (!sector->properties.isEmpty())
 		{
-			Game::configuration().cleanObjectUDMFProps(sectors[a]);
-			object_def += sectors[a]->properties.toString(true);
+			Game::configuration().cleanObjectUDMFProps(sector);
+			writer.writeProperties(sector->properties);
 		}
 
-		object_def += "}\n\n";
-		tempfile.Write(object_def);
+		writer.endBlock();
 	}
-	//LOG_MESSAGE(1, "Writing sectors took %dms", clock.getElapsedTime().asMilliseconds());
 
-	// Close file
-	tempfile.Close();
+	// Write unknown definitions from the original TEXTMAP
+	for (unsigned a = 0; a < udmf_extra_defs.size(); a++)
+	{
+		writer.writeRaw(udmf_extra_defs[a]);
+		writer.writeRaw("\n\n");
+	}
 
-	// Load file to entry
-	textmap->importFile(App::path("sladetemp.txt", App::Dir::Temp));
+	// Load text to entry
+	textmap->importMem(writer.data(), writer.size());
 
 	return true;
 }
@@ -2501,6 +2763,7 @@ bool SLADEMap::writeUDMFMap(ArchiveEntry* textmap)
 void SLADEMap::clearMap()
 {
 	map_specials.reset();
+	invalidateSpatialIndex();
 
 	// Clear vectors
 	sides.clear();
@@ -2509,13 +2772,18 @@ void SLADEMap::clearMap()
 	sectors.clear();
 	things.clear();
 
-	// Clear map objects
-	for (unsigned a = 0; a < all_objects.size(); a++)
-	{
-		if (all_objects[a].mobj)
-			delete all_objects[a].mobj;
-	}
+	// Clear map objects (all objects are allocated from the pools,
+	// so they are all freed at once here)
 	all_objects.clear();
+	created_deleted_objects.clear();
+	geometry_dirty.clear();
+	geometry_dirty_all = false;
+	sector_polys_dirty = false;
+	pool_vertices.clear();
+	pool_sides.clear();
+	pool_lines.clear();
+	pool_sectors.clear();
+	pool_things.clear();
 
 	// Object id 0 is always null
 	all_objects.push_back(mobj_holder_t(nullptr, false));
@@ -2529,6 +2797,7 @@ void SLADEMap::clearMap()
 	for (unsigned a = 0; a < udmf_extra_entries.size(); a++)
 		delete udmf_extra_entries[a];
 	udmf_extra_entries.clear();
+	udmf_extra_defs.clear();
 }
 
 /* SLADEMap::removeVertex
@@ -2804,42 +3073,107 @@ bool SLADEMap::removeThing(unsigned index)
 	return true;
 }
 
-/* SLADEMap::nearestVertex
- * Returns the index of the vertex closest to the point, or -1 if none
- * found. Igonres any vertices further away than [min]
+/* nearestObjects
+ * Finds the objects in [grid] nearest (by taxicab distance) to
+ * [point], adding their indices in [objects] to [nearest] in
+ * ascending order. Objects further away than [range] may be missed,
+ * in which case the nearest ones found within the searched area are
+ * returned
  *******************************************************************/
-int SLADEMap::nearestVertex(fpoint2_t point, double min)
+template<class T>
+static void nearestObjects(const MapObjectGrid& grid, const vector<T*>& objects, fpoint2_t point, double range, vector<int>& nearest)
 {
-	// Go through vertices
-	double min_dist = 999999999;
-	MapVertex* v = nullptr;
-	double dist = 0;
-	int index = -1;
-	for (unsigned a = 0; a < vertices.size(); a++)
+	// Search a box around the point, widening it until the nearest object
+	// is known. Every object within a taxicab distance of [r] from the
+	// point is within the box, so once the nearest object found is that
+	// close, there can't be a nearer one outside it
+	vector<MapObject*> list;
+	double r = grid.cellSize();
+	while (true)
 	{
-		v = vertices[a];
+		if (r > range)
+			r = range;
 
-		// Get 'quick' distance (no need to get real distance)
-		dist = point.taxicab_distance_to(v->point());
+		list.clear();
+		grid.getObjects(point.x - r, point.y - r, point.x + r, point.y + r, list);
 
-		// Check if it's nearer than the previous nearest
-		if (dist < min_dist)
+		nearest.clear();
+		double min_dist = 999999999;
+		for (unsigned a = 0; a < list.size(); a++)
 		{
-			index = a;
-			min_dist = dist;
+			T* object = (T*)list[a];
+			unsigned index = object->getIndex();
+			if (index >= objects.size() || objects[index] != object)
+				continue;
+
+			// Get 'quick' distance (no need to get real distance)
+			double dist = point.taxicab_distance_to(object->point());
+
+			// Check if it's nearer than the previous nearest
+			if (dist < min_dist)
+			{
+				nearest.clear();
+				nearest.push_back(index);
+				min_dist = dist;
+			}
+			else if (dist == min_dist)
+				nearest.push_back(index);
 		}
+
+		if ((!nearest.empty() && min_dist <= r) || r >= range || list.size() >= grid.nObjects())
+			break;
+
+		r *= 4;
 	}
 
-	// Now determine the real distance to the closest vertex,
-	// to check for minimum hilight distance
-	if (index >= 0)
+	std::sort(nearest.begin(), nearest.end());
+}
+
+/* objectsInBox
+ * Adds the objects in [grid] within the box [x1,y1]-[x2,y2] that
+ * are still in [objects] to [list], sorted by index (ie. in the
+ * same order a loop through [objects] would find them)
+ *******************************************************************/
+template<class T>
+static void objectsInBox(const MapObjectGrid& grid, const vector<T*>& objects, double x1, double y1, double x2, double y2, vector<T*>& list)
+{
+	vector<MapObject*> found;
+	grid.getObjects(x1, y1, x2, y2, found);
+
+	list.clear();
+	for (unsigned a = 0; a < found.size(); a++)
 	{
-		v = vertices[index];
-		double rdist = MathStuff::distance(v->point(), point);
-		if (rdist > min)
-			return -1;
+		T* object = (T*)found[a];
+		unsigned index = object->getIndex();
+		if (index < objects.size() && objects[index] == object)
+			list.push_back(object);
 	}
 
+	std::sort(list.begin(), list.end(), [](T* left, T* right) { return left->getIndex() < right->getIndex(); });
+}
+
+/* SLADEMap::nearestVertex
+ * Returns the index of the vertex closest to the point, or -1 if none
+ * found. Igonres any vertices further away than [min]
+ *******************************************************************/
+int SLADEMap::nearestVertex(fpoint2_t point, double min)
+{
+	updateSpatialIndex();
+
+	// Find the vertex with the smallest 'quick' distance. Nothing with a
+	// taxicab distance over [min]*sqrt(2) can be within [min]
+	vector<int> nearest;
+	nearestObjects(grid_vertices, vertices, point, min * 1.5, nearest);
+	if (nearest.empty())
+		return -1;
+
+	// Now determine the real distance to the closest vertex,
+	// to check for minimum hilight distance
+	int index = nearest[0];
+	double rdist = MathStuff::distance(vertices[index]->point(), point);
+	if (rdist > min)
+		return -1;
+
 	return index;
 }
 
@@ -2849,14 +3183,22 @@ int SLADEMap::nearestVertex(fpoint2_t point, double min)
  *******************************************************************/
 int SLADEMap::nearestLine(fpoint2_t point, double mindist)
 {
+	updateSpatialIndex();
+
+	// Get lines near the point
+	vector<MapObject*> list;
+	grid_lines.getObjects(point.x - mindist, point.y - mindist, point.x + mindist, point.y + mindist, list);
+
 	// Go through lines
 	double min_dist = mindist;
 	double dist = 0;
 	int index = -1;
 	MapLine* l;
-	for (unsigned a = 0; a < lines.size(); a++)
+	for (unsigned a = 0; a < list.size(); a++)
 	{
-		l = lines[a];
+		l = (MapLine*)list[a];
+		if (l->index >= lines.size() || lines[l->index] != l)
+			continue;
 
 		// Check with line bounding box first (since we have a minimum distance)
 		fseg2_t bbox = l->seg();
@@ -2868,9 +3210,10 @@ int SLADEMap::nearestLine(fpoint2_t point, double mindist)
 		dist = l->distanceTo(point);
 
 		// Check if it's nearer than the previous nearest
-		if (dist < min_dist && dist < mindist)
+		// (or the same distance with a lower index)
+		if ((dist < min_dist && dist < mindist) || (index >= 0 && dist == min_dist && (int)l->index < index))
 		{
-			index = a;
+			index = l->index;
 			min_dist = dist;
 		}
 	}
@@ -2884,35 +3227,21 @@ int SLADEMap::nearestLine(fpoint2_t point, double mindist)
  *******************************************************************/
 int SLADEMap::nearestThing(fpoint2_t point, double min)
 {
-	// Go through things
-	double min_dist = 999999999;
-	MapThing* t = nullptr;
-	double dist = 0;
-	int index = -1;
-	for (unsigned a = 0; a < things.size(); a++)
-	{
-		t = things[a];
+	updateSpatialIndex();
 
-		// Get 'quick' distance (no need to get real distance)
-		dist = point.taxicab_distance_to(t->point());
-
-		// Check if it's nearer than the previous nearest
-		if (dist < min_dist)
-		{
-			index = a;
-			min_dist = dist;
-		}
-	}
+	// Find the thing with the smallest 'quick' distance. Nothing with a
+	// taxicab distance over [min]*sqrt(2) can be within [min]
+	vector<int> nearest;
+	nearestObjects(grid_things, things, point, min * 1.5, nearest);
+	if (nearest.empty())
+		return -1;
 
 	// Now determine the real distance to the closest thing,
 	// to check for minimum hilight distance
-	if (index >= 0)
-	{
-		t = things[index];
-		double rdist = MathStuff::distance(t->point(), point);
-		if (rdist > min)
-			return -1;
-	}
+	int index = nearest[0];
+	double rdist = MathStuff::distance(things[index]->point(), point);
+	if (rdist > min)
+		return -1;
 
 	return index;
 }
@@ -2923,28 +3252,10 @@ int SLADEMap::nearestThing(fpoint2_t point, double min)
  *******************************************************************/
 vector<int> SLADEMap::nearestThingMulti(fpoint2_t point)
 {
-	// Go through things
-	vector<int> ret;
-	double min_dist = 999999999;
-	MapThing* t = nullptr;
-	double dist = 0;
-	for (unsigned a = 0; a < things.size(); a++)
-	{
-		t = things[a];
-
-		// Get 'quick' distance (no need to get real distance)
-		dist = point.taxicab_distance_to(t->point());
+	updateSpatialIndex();
 
-		// Check if it's nearer than the previous nearest
-		if (dist < min_dist)
-		{
-			ret.clear();
-			ret.push_back(a);
-			min_dist = dist;
-		}
-		else if (dist == min_dist)
-			ret.push_back(a);
-	}
+	vector<int> ret;
+	nearestObjects(grid_things, things, point, 999999999, ret);
 
 	return ret;
 }
@@ -2955,12 +3266,27 @@ vector<int> SLADEMap::nearestThingMulti(fpoint2_t point)
  *******************************************************************/
 int SLADEMap::sectorAt(fpoint2_t point)
 {
-	// Go through sectors
-	for (unsigned a = 0; a < sectors.size(); a++)
+	updateSpatialIndex();
+
+	// Get sectors with bounding boxes around the point
+	vector<MapObject*> list;
+	grid_sectors.getObjects(point.x, point.y, point.x, point.y, list);
+	vector<unsigned> candidates;
+	for (unsigned a = 0; a < list.size(); a++)
+	{
+		unsigned index = list[a]->index;
+		if (index < sectors.size() && sectors[index] == list[a])
+			candidates.push_back(index);
+	}
+
+	// Go through sectors (in index order, so the first one found is the
+	// same as if checking all sectors)
+	std::sort(candidates.begin(), candidates.end());
+	for (unsigned a = 0; a < candidates.size(); a++)
 	{
 		// Check if point is within sector
-		if (sectors[a]->isWithin(point))
-			return a;
+		if (sectors[candidates[a]]->isWithin(point))
+			return candidates[a];
 	}
 
 	// Not within a sector
@@ -3003,15 +3329,24 @@ bbox_t SLADEMap::getMapBBox()
  *******************************************************************/
 MapVertex* SLADEMap::vertexAt(double x, double y)
 {
-	// Go through all vertices
-	for (unsigned a = 0; a < vertices.size(); a++)
+	updateSpatialIndex();
+
+	// Go through vertices in the grid cell at [x,y]
+	vector<MapObject*> list;
+	grid_vertices.getObjects(x, y, x, y, list);
+	MapVertex* vertex = nullptr;
+	for (unsigned a = 0; a < list.size(); a++)
 	{
-		if (vertices[a]->x == x && vertices[a]->y == y)
-			return vertices[a];
+		MapVertex* v = (MapVertex*)list[a];
+		if (v->index >= vertices.size() || vertices[v->index] != v)
+			continue;
+
+		// Use the lowest index if there's more than one
+		if (v->x == x && v->y == y && (!vertex || v->index < vertex->index))
+			vertex = v;
 	}
 
-	// No vertex at [x,y]
-	return nullptr;
+	return vertex;
 }
 
 // Sorting functions for SLADEMap::cutLines
@@ -3135,33 +3470,73 @@ MapVertex* SLADEMap::lineCrossVertex(double x1, double y1, double x2, double y2)
  *******************************************************************/
 void SLADEMap::updateGeometryInfo(long modified_time)
 {
-	for (unsigned a = 0; a < vertices.size(); a++)
+	// Get vertices to check, only those modified since the last update
+	// unless everything was asked for or too much has changed
+	vector<MapVertex*> check;
+	if (modified_time <= 0 || geometry_dirty_all)
+		check = vertices;
+	else
 	{
-		if (vertices[a]->modifiedTime() > modified_time)
+		std::sort(geometry_dirty.begin(), geometry_dirty.end());
+		geometry_dirty.erase(std::unique(geometry_dirty.begin(), geometry_dirty.end()), geometry_dirty.end());
+		for (unsigned a = 0; a < geometry_dirty.size(); a++)
 		{
-			for (unsigned l = 0; l < vertices[a]->connected_lines.size(); l++)
+			MapVertex* vertex = geometry_dirty[a];
+			if (vertex->index < vertices.size() && vertices[vertex->index] == vertex)
+				check.push_back(vertex);
+		}
+	}
+	geometry_dirty.clear();
+	geometry_dirty_all = false;
+
+	// Get sectors adjacent to modified vertices, each sector is only
+	// updated once no matter how many of its vertices were modified
+	std::set<MapSector*> sectors;
+	for (unsigned a = 0; a < check.size(); a++)
+	{
+		if (check[a]->modifiedTime() > modified_time)
+		{
+			for (unsigned l = 0; l < check[a]->connected_lines.size(); l++)
 			{
-				MapLine* line = vertices[a]->connected_lines[l];
+				MapLine* line = check[a]->connected_lines[l];
 
 				// Update line geometry
 				line->resetInternals();
 
-				// Update front sector
 				if (line->frontSector())
-				{
-					line->frontSector()->resetPolygon();
-					line->frontSector()->updateBBox();
-				}
-
-				// Update back sector
+					sectors.insert(line->frontSector());
 				if (line->backSector())
-				{
-					line->backSector()->resetPolygon();
-					line->backSector()->updateBBox();
-				}
+					sectors.insert(line->backSector());
 			}
 		}
 	}
+
+	// Update sectors
+	for (std::set<MapSector*>::iterator i = sectors.begin(); i != sectors.end(); ++i)
+	{
+		(*i)->resetPolygon();
+		(*i)->updateBBox();
+	}
+}
+
+/* SLADEMap::precacheGeometry
+ * Calculates all lazily cached geometry info (line lengths and
+ * vectors, sector bounding boxes and the spatial index) up-front.
+ * After this, geometry queries won't modify the map, so it can be
+ * read from multiple threads at once as long as nothing edits it
+ *******************************************************************/
+void SLADEMap::precacheGeometry()
+{
+	for (unsigned a = 0; a < lines.size(); a++)
+	{
+		lines[a]->getLength();
+		lines[a]->frontVector();
+	}
+
+	for (unsigned a = 0; a < sectors.size(); a++)
+		sectors[a]->boundingBox();
+
+	updateSpatialIndex();
 }
 
 /* SLADEMap::linesIntersect
@@ -3242,12 +3617,69 @@ void SLADEMap::initSectorPolygons()
 {
 	UI::setSplashProgressMessage("Building sector polygons");
 	UI::setSplashProgress(0.0f);
+	updateSectorPolygons(true);
+	UI::setSplashProgress(1.0f);
+}
+
+/* SLADEMap::updateSectorPolygons
+ * Builds polygons for all sectors that need them (re)built, split
+ * across worker threads (map_polygon_threads, 0 = one per cpu) if
+ * there are enough of them. The polygons are only built here, VBO
+ * data is written by the renderer (in the main thread) as usual.
+ * Does nothing unless a sector polygon was reset since the last
+ * call. Updates splash window progress if [progress] is true
+ *******************************************************************/
+void SLADEMap::updateSectorPolygons(bool progress)
+{
+	// Nothing to do if no sectors have changed
+	if (!sector_polys_dirty)
+		return;
+	sector_polys_dirty = false;
+
+	PROFILE_SCOPE("Sector Polygons");
+
+	// Get sectors needing their polygon built
+	vector<MapSector*> update;
 	for (unsigned a = 0; a < sectors.size(); a++)
 	{
-		UI::setSplashProgress((float)a / (float)sectors.size());
-		sectors[a]->getPolygon();
+		if (sectors[a]->poly_needsupdate)
+			update.push_back(sectors[a]);
+	}
+
+	// Determine number of threads to use (including this one), not
+	// worth starting threads for only a few sectors
+	int count = map_polygon_threads;
+	if (count <= 0)
+		count = wxThread::GetCPUCount();
+	count = MIN(count, (int)(update.size() / SECTOR_POLY_BATCH));
+
+	// Start worker threads
+	SectorPolygonBuilder builder(update);
+	vector<wxThread*> threads;
+	for (int a = 1; a < count; a++)
+	{
+		wxThread* thread = new SectorPolygonThread(&builder);
+		if (thread->Run() != wxTHREAD_NO_ERROR)
+		{
+			delete thread;
+			continue;
+		}
+		threads.push_back(thread);
+	}
+
+	// Build polygons in this thread too until there are none left
+	while (builder.buildNext())
+	{
+		if (progress)
+			UI::setSplashProgress(builder.progress());
+	}
+
+	// Wait for worker threads to finish
+	for (unsigned a = 0; a < threads.size(); a++)
+	{
+		threads[a]->Wait();
+		delete threads[a];
 	}
-	UI::setSplashProgress(1.0f);
 }
 
 MapLine* SLADEMap::lineVectorIntersect(MapLine* line, bool front, double& hit_x, double& hit_y)
@@ -4076,7 +4508,7 @@ MapVertex* SLADEMap::createVertex(double x, double y, double split_dist)
 	}
 
 	// Create the vertex
-	MapVertex* nv = new MapVertex(x, y, this);
+	MapVertex* nv = new (pool_vertices.allocate()) MapVertex(x, y, this);
 	nv->index = vertices.size();
 	vertices.push_back(nv);
 
@@ -4158,7 +4590,7 @@ MapLine* SLADEMap::createLine(MapVertex* vertex1, MapVertex* vertex2, bool force
 	}
 
 	// Create new line between vertices
-	MapLine* nl = new MapLine(vertex1, vertex2, nullptr, nullptr, this);
+	MapLine* nl = new (pool_lines.allocate()) MapLine(vertex1, vertex2, nullptr, nullptr, this);
 	nl->index = lines.size();
 	lines.push_back(nl);
 
@@ -4178,7 +4610,7 @@ MapLine* SLADEMap::createLine(MapVertex* vertex1, MapVertex* vertex2, bool force
 MapThing* SLADEMap::createThing(double x, double y)
 {
 	// Create the thing
-	MapThing* nt = new MapThing(this);
+	MapThing* nt = new (pool_things.allocate()) MapThing(this);
 
 	// Setup initial values
 	nt->x = x;
@@ -4199,7 +4631,7 @@ MapThing* SLADEMap::createThing(double x, double y)
 MapSector* SLADEMap::createSector()
 {
 	// Create the sector
-	MapSector* ns = new MapSector(this);
+	MapSector* ns = new (pool_sectors.allocate()) MapSector(this);
 
 	// Setup initial values
 	ns->index = sectors.size();
@@ -4220,7 +4652,7 @@ MapSide* SLADEMap::createSide(MapSector* sector)
 		return nullptr;
 
 	// Create side
-	MapSide* side = new MapSide(sector, this);
+	MapSide* side = new (pool_sides.allocate()) MapSide(sector, this);
 
 	// Setup initial values
 	side->index = sides.size();
@@ -4320,30 +4752,37 @@ void SLADEMap::mergeVertices(unsigned vertex1, unsigned vertex2)
  *******************************************************************/
 MapVertex* SLADEMap::mergeVerticesPoint(double x, double y)
 {
-	// Go through all vertices
-	int merge = -1;
-	for (unsigned a = 0; a < vertices.size(); a++)
+	// Get vertices around the point
+	updateSpatialIndex();
+	vector<MapVertex*> list;
+	objectsInBox(grid_vertices, vertices, x, y, x, y, list);
+
+	// Go through them
+	MapVertex* merge = nullptr;
+	for (unsigned a = 0; a < list.size(); a++)
 	{
-		// Skip if vertex isn't on the point
-		if (vertices[a]->x != x || vertices[a]->y != y)
+		// Skip if vertex isn't on the point (or was already removed)
+		MapVertex* vertex = list[a];
+		if (vertex->x != x || vertex->y != y)
+			continue;
+		if (vertex->index >= vertices.size() || vertices[vertex->index] != vertex)
 			continue;
 
 		// Set as the merge target vertex if we don't have one already
-		if (merge < 0)
+		if (!merge)
 		{
-			merge = a;
+			merge = vertex;
 			continue;
 		}
 
 		// Otherwise, merge this vertex with the merge target
-		mergeVertices(merge, a);
-		a--;
+		mergeVertices(merge->index, vertex->index);
 	}
 
 	geometry_updated = App::runTimer();
 
 	// Return the final merged vertex
-	return getVertex(merge);
+	return merge;
 }
 
 /* SLADEMap::splitLine
@@ -4368,7 +4807,7 @@ MapLine* SLADEMap::splitLine(MapLine* l, MapVertex* v)
 	if (l->side1)
 	{
 		// Create side 1
-		s1 = new MapSide(this);
+		s1 = new (pool_sides.allocate()) MapSide(this);
 		s1->copy(l->side1);
 		s1->setSector(l->side1->sector);
 		if (s1->sector)
@@ -4389,7 +4828,7 @@ MapLine* SLADEMap::splitLine(MapLine* l, MapVertex* v)
 	if (l->side2)
 	{
 		// Create side 2
-		s2 = new MapSide(this);
+		s2 = new (pool_sides.allocate()) MapSide(this);
 		s2->copy(l->side2);
 		s2->setSector(l->side2->sector);
 		if (s2->sector)
@@ -4409,7 +4848,7 @@ MapLine* SLADEMap::splitLine(MapLine* l, MapVertex* v)
 	}
 
 	// Create and add new line
-	MapLine* nl = new MapLine(v, v2, s1, s2, this);
+	MapLine* nl = new (pool_lines.allocate()) MapLine(v, v2, s1, s2, this);
 	nl->copy(l);
 	nl->index = lines.size();
 	nl->setModified();
@@ -4450,18 +4889,23 @@ void SLADEMap::moveThing(unsigned thing, double nx, double ny)
  *******************************************************************/
 void SLADEMap::splitLinesAt(MapVertex* vertex, double split_dist)
 {
-	// Check if this vertex splits any lines (if needed)
-	unsigned nlines = lines.size();
-	for (unsigned a = 0; a < nlines; a++)
+	// Get lines near the vertex
+	updateSpatialIndex();
+	vector<MapLine*> list;
+	objectsInBox(grid_lines, lines, vertex->x - split_dist, vertex->y - split_dist, vertex->x + split_dist, vertex->y + split_dist, list);
+
+	// Check if this vertex splits any of them (if needed)
+	for (unsigned a = 0; a < list.size(); a++)
 	{
 		// Skip line if it shares the vertex
-		if (lines[a]->v1() == vertex || lines[a]->v2() == vertex)
+		MapLine* line = list[a];
+		if (line->v1() == vertex || line->v2() == vertex)
 			continue;
 
-		if (lines[a]->distanceTo(vertex->point()) < split_dist)
+		if (line->distanceTo(vertex->point()) < split_dist)
 		{
-			LOG_MESSAGE(2, "Vertex at (%1.2f,%1.2f) splits line %u", vertex->x, vertex->y, a);
-			splitLine(lines[a], vertex);
+			LOG_MESSAGE(2, "Vertex at (%1.2f,%1.2f) splits line %u", vertex->x, vertex->y, line->index);
+			splitLine(line, vertex);
 		}
 	}
 }
@@ -4664,17 +5108,30 @@ bool SLADEMap::mergeArch(vector<MapVertex*> vertices)
 	MapVertex* last_vertex = this->vertices.back();
 	MapLine* last_line = lines.back();
 
+	// Only objects near the merged vertices/lines are checked below (via
+	// the spatial index), so merging is quick even when a lot has moved
+	// on a large map. Vertices/lines are only added to each list once
+	std::set<MapVertex*> merged_set;
+	std::set<MapLine*> connected_set;
+
 	// Merge vertices
 	vector<MapVertex*> merged_vertices;
 	for (unsigned a = 0; a < vertices.size(); a++)
-		VECTOR_ADD_UNIQUE(merged_vertices, mergeVerticesPoint(vertices[a]->x, vertices[a]->y));
+	{
+		MapVertex* merged = mergeVerticesPoint(vertices[a]->x, vertices[a]->y);
+		if (merged_set.insert(merged).second)
+			merged_vertices.push_back(merged);
+	}
 
 	// Get all connected lines
 	vector<MapLine*> connected_lines;
 	for (unsigned a = 0; a < merged_vertices.size(); a++)
 	{
 		for (unsigned l = 0; l < merged_vertices[a]->connected_lines.size(); l++)
-			VECTOR_ADD_UNIQUE(connected_lines, merged_vertices[a]->connected_lines[l]);
+		{
+			if (connected_set.insert(merged_vertices[a]->connected_lines[l]).second)
+				connected_lines.push_back(merged_vertices[a]->connected_lines[l]);
+		}
 	}
 
 	// Split lines (by vertices)
@@ -4684,36 +5141,53 @@ bool SLADEMap::mergeArch(vector<MapVertex*> vertices)
 		splitLinesAt(merged_vertices[a], split_dist);
 
 	// Split lines that moved onto existing vertices
+	vector<MapVertex*> near_vertices;
 	for (unsigned a = 0; a < connected_lines.size(); a++)
 	{
-		unsigned nvertices = this->vertices.size();
-		for (unsigned b = 0; b < nvertices; b++)
+		MapLine* line = connected_lines[a];
+		updateSpatialIndex();
+		objectsInBox(
+			grid_vertices,
+			this->vertices,
+			MIN(line->x1(), line->x2()) - split_dist,
+			MIN(line->y1(), line->y2()) - split_dist,
+			MAX(line->x1(), line->x2()) + split_dist,
+			MAX(line->y1(), line->y2()) + split_dist,
+			near_vertices
+		);
+
+		for (unsigned b = 0; b < near_vertices.size(); b++)
 		{
-			MapVertex* vertex = this->vertices[b];
+			MapVertex* vertex = near_vertices[b];
 
 			// Skip line if it shares the vertex
-			if (connected_lines[a]->v1() == vertex || connected_lines[a]->v2() == vertex)
+			if (line->v1() == vertex || line->v2() == vertex)
 				continue;
 
-			if (connected_lines[a]->distanceTo(vertex->point()) < split_dist)
+			if (line->distanceTo(vertex->point()) < split_dist)
 			{
-				connected_lines.push_back(splitLine(connected_lines[a], vertex));
-				VECTOR_ADD_UNIQUE(merged_vertices, vertex);
+				connected_lines.push_back(splitLine(line, vertex));
+				if (merged_set.insert(vertex).second)
+					merged_vertices.push_back(vertex);
 			}
 		}
 	}
 
 	// Split lines (by lines)
 	fseg2_t seg1;
+	vector<MapLine*> near_lines;
 	for (unsigned a = 0; a < connected_lines.size(); a++)
 	{
 		MapLine* line1 = connected_lines[a];
 		seg1 = line1->seg();
 
-		unsigned n_lines = lines.size();
-		for (unsigned b = 0; b < n_lines; b++)
+		// Get lines that could intersect
+		updateSpatialIndex();
+		objectsInBox(grid_lines, lines, seg1.left(), seg1.top(), seg1.right(), seg1.bottom(), near_lines);
+
+		for (unsigned b = 0; b < near_lines.size(); b++)
 		{
-			MapLine* line2 = lines[b];
+			MapLine* line2 = near_lines[b];
 
 			// Can't intersect if they share a vertex
 			if (line1->vertex1 == line2->vertex1 ||
@@ -4729,6 +5203,7 @@ bool SLADEMap::mergeArch(vector<MapVertex*> vertices)
 				// Create split vertex
 				MapVertex* nv = createVertex(intersection.x, intersection.y);
 				merged_vertices.push_back(nv);
+				merged_set.insert(nv);
 
 				// Split lines
 				splitLine(line1, nv);
@@ -4746,40 +5221,61 @@ bool SLADEMap::mergeArch(vector<MapVertex*> vertices)
 
 	// Refresh connected lines
 	connected_lines.clear();
+	std::map<MapLine*, unsigned> connected_pos;
 	for (unsigned a = 0; a < merged_vertices.size(); a++)
 	{
 		for (unsigned l = 0; l < merged_vertices[a]->connected_lines.size(); l++)
-			VECTOR_ADD_UNIQUE(connected_lines, merged_vertices[a]->connected_lines[l]);
+		{
+			MapLine* line = merged_vertices[a]->connected_lines[l];
+			if (connected_pos.insert(std::make_pair(line, (unsigned)connected_lines.size())).second)
+				connected_lines.push_back(line);
+		}
 	}
 
-	// Find overlapping lines
+	// Find overlapping lines. Any line overlapping [line1] shares its
+	// first vertex, so only lines connected to that need checking (in
+	// the same order as they are in [connected_lines])
 	vector<MapLine*> remove_lines;
+	std::set<MapLine*> remove_set;
+	vector<unsigned> overlap;
 	for (unsigned a = 0; a < connected_lines.size(); a++)
 	{
 		MapLine* line1 = connected_lines[a];
 
 		// Skip if removing already
-		if (VECTOR_EXISTS(remove_lines, line1))
+		if (remove_set.count(line1))
 			continue;
 
-		for (unsigned l = a + 1; l < connected_lines.size(); l++)
+		// Get later connected lines sharing both vertices
+		overlap.clear();
+		for (unsigned l = 0; l < line1->vertex1->connected_lines.size(); l++)
 		{
-			MapLine* line2 = connected_lines[l];
-
-			// Skip if removing already
-			if (VECTOR_EXISTS(remove_lines, line2))
+			MapLine* line2 = line1->vertex1->connected_lines[l];
+			std::map<MapLine*, unsigned>::iterator pos = connected_pos.find(line2);
+			if (pos == connected_pos.end() || pos->second <= a)
 				continue;
 
 			if ((line1->vertex1 == line2->vertex1 && line1->vertex2 == line2->vertex2) ||
 				(line1->vertex1 == line2->vertex2 && line1->vertex2 == line2->vertex1))
-			{
-				MapLine* remove_line = mergeOverlappingLines(line2, line1);
-				VECTOR_ADD_UNIQUE(remove_lines, remove_line);
+				overlap.push_back(pos->second);
+		}
+		std::sort(overlap.begin(), overlap.end());
 
-				// Don't check against any more lines if we just decided to remove this one
-				if (remove_line == line1)
-					break;
-			}
+		for (unsigned l = 0; l < overlap.size(); l++)
+		{
+			MapLine* line2 = connected_lines[overlap[l]];
+
+			// Skip if removing already
+			if (remove_set.count(line2))
+				continue;
+
+			MapLine* remove_line = mergeOverlappingLines(line2, line1);
+			if (remove_set.insert(remove_line).second)
+				remove_lines.push_back(remove_line);
+
+			// Don't check against any more lines if we just decided to remove this one
+			if (remove_line == line1)
+				break;
 		}
 	}
 
@@ -4791,7 +5287,7 @@ bool SLADEMap::mergeArch(vector<MapVertex*> vertices)
 	}
 	for (unsigned a = 0; a < connected_lines.size(); a++)
 	{
-		if (VECTOR_EXISTS(remove_lines, connected_lines[a]))
+		if (remove_set.count(connected_lines[a]))
 		{
 			connected_lines[a] = connected_lines.back();
 			connected_lines.pop_back();
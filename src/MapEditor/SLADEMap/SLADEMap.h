@@ -7,6 +7,9 @@
 #include "MapSector.h"
 #include "MapVertex.h"
 #include "MapThing.h"
+#include "MapObjectGrid.h"
+#include "MapObjectPool.h"
+#include "UDMFReader.h"
 #include "Archive/Archive.h"
 #include "Utility/PropertyList/PropertyList.h"
 #include "MapEditor/MapSpecials.h"
@@ -26,19 +29,23 @@ struct mobj_holder_t
 	}
 };
 
+// A map object creation or deletion. Created objects are always added
+// to the end of their list, deleted objects are replaced by the last
+// object in the list, so the [index] is enough to restore list order
 struct mobj_cd_t
 {
 	unsigned	id;
 	bool		created;
+	unsigned	index;
 
-	mobj_cd_t(unsigned id, bool created)
+	mobj_cd_t(unsigned id, bool created, unsigned index)
 	{
 		this->id = id;
 		this->created = created;
+		this->index = index;
 	}
 };
 
-class ParseTreeNode;
 namespace Game { enum class TagType; }
 
 class SLADEMap
@@ -61,17 +68,45 @@ private:
 
 	// UDMF Extras
 	vector<ArchiveEntry*>	udmf_extra_entries;
+	vector<string>			udmf_extra_defs;	// Unknown TEXTMAP definitions, kept as-is
 
 	vector<mobj_holder_t>	all_objects;
+
+	// All map objects are allocated from these, objects of each type
+	// are kept together in memory and freed all at once in clearMap
+	MapObjectPool<MapVertex>	pool_vertices;
+	MapObjectPool<MapSide>		pool_sides;
+	MapObjectPool<MapLine>		pool_lines;
+	MapObjectPool<MapSector>	pool_sectors;
+	MapObjectPool<MapThing>		pool_things;
+
 	vector<unsigned>		deleted_objects;
 	vector<unsigned>		created_objects;
-	vector<mobj_cd_t>		created_deleted_objects;
+	vector<mobj_cd_t>		created_deleted_objects;	// Since the last clearCreatedDeleted
 
 	// The last time the map geometry was updated
 	long	geometry_updated;
 	// The last time the thing list was modified
 	long	things_updated;
 
+	// Spatial index for point queries (nearestVertex, sectorAt etc.)
+	MapObjectGrid		grid_vertices;
+	MapObjectGrid		grid_lines;
+	MapObjectGrid		grid_sectors;
+	MapObjectGrid		grid_things;
+	bool				grid_valid;
+	vector<MapObject*>	grid_dirty;
+
+	// Vertices modified since the last updateGeometryInfo (all of them
+	// are checked if too many were modified to keep track of)
+	vector<MapVertex*>	geometry_dirty;
+	bool				geometry_dirty_all;
+
+	// True if any sector may need its polygon (re)built
+	bool	sector_polys_dirty;
+
+	void	updateSpatialIndex();
+
 	// Usage counts
 	std::map<string, int>	usage_tex;
 	std::map<string, int>	usage_flat;
@@ -126,11 +161,11 @@ private:
 	bool	writeDoom64Things(ArchiveEntry* entry);
 
 	// UDMF
-	bool	addVertex(ParseTreeNode* def);
-	bool	addSide(ParseTreeNode* def);
-	bool	addLine(ParseTreeNode* def);
-	bool	addSector(ParseTreeNode* def);
-	bool	addThing(ParseTreeNode* def);
+	bool	addVertex(const UDMFReader::field_t* fields, unsigned n_fields);
+	bool	addSide(const UDMFReader::field_t* fields, unsigned n_fields);
+	bool	addLine(const UDMFReader::field_t* fields, unsigned n_fields);
+	bool	addSector(const UDMFReader::field_t* fields, unsigned n_fields);
+	bool	addThing(const UDMFReader::field_t* fields, unsigned n_fields);
 
 public:
 	SLADEMap();
@@ -172,8 +207,15 @@ public:
 	void		addMapObject(MapObject* object);
 	void		removeMapObject(MapObject* object);
 	MapObject*	getObjectById(unsigned id) { return all_objects[id].mobj; }
-	void		getObjectIdList(uint8_t type, vector<unsigned>& list);
-	void		restoreObjectIdList(uint8_t type, vector<unsigned>& list);
+	void		replayCreateDelete(const mobj_cd_t& cd, bool undo);
+	void		clearCreatedDeleted() { created_deleted_objects.clear(); }
+	size_t		objectMemoryUsage() const;
+
+	const vector<mobj_cd_t>&	createdDeletedObjects() const { return created_deleted_objects; }
+
+	// Spatial index
+	void	objectModified(MapObject* object);
+	void	invalidateSpatialIndex();
 
 	void	refreshIndices();
 	bool	readMap(Archive::MapDesc map);
@@ -217,9 +259,12 @@ public:
 	vector<fpoint2_t>	cutLines(double x1, double y1, double x2, double y2);
 	MapVertex*			lineCrossVertex(double x1, double y1, double x2, double y2);
 	void				updateGeometryInfo(long modified_time);
+	void				precacheGeometry();
 	bool				linesIntersect(MapLine* line1, MapLine* line2, double& x, double& y);
 	void				findSectorTextPoint(MapSector* sector);
 	void				initSectorPolygons();
+	void				updateSectorPolygons(bool progress = false);
+	void				setSectorPolygonsDirty() { sector_polys_dirty = true; }
 	MapLine*			lineVectorIntersect(MapLine* line, bool front, double& hit_x, double& hit_y);
 
 	// Tags/Ids
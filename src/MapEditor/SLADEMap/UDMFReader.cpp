@@ -0,0 +1,473 @@
+
+/*******************************************************************
+ * SLADE - It's a Doom Editor
+ * Copyright (C) 2008-2014 Simon Judd
+ *
+ * Email:       sirjuddington@gmail.com
+ * Web:         http://slade.mancubus.net
+ * Filename:    UDMFReader.cpp
+ * Description: UDMFReader class, a fast single-pass reader for UDMF
+ *              TEXTMAP data. Rather than parsing the whole text into
+ *              a ParseTreeNode tree first, it returns each top-level
+ *              definition as a list of name/value text ranges, which
+ *              SLADEMap converts directly into map objects
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *******************************************************************/
+
+
+/*******************************************************************
+ * INCLUDES
+ *******************************************************************/
+#include "Main.h"
+#include "UDMFReader.h"
+#include "Utility/MemChunk.h"
+
+
+/*******************************************************************
+ * FUNCTIONS
+ *******************************************************************/
+
+/* isSpecial
+ * Returns true if [c] is a character that is always a token on its
+ * own (same as the Tokenizer defaults)
+ *******************************************************************/
+static inline bool isSpecial(char c)
+{
+	return c == ';' || c == ',' || c == ':' || c == '|' || c == '=' || c == '{' || c == '}' || c == '/';
+}
+
+/* isWhitespace
+ * Returns true if [c] is a whitespace character
+ *******************************************************************/
+static inline bool isWhitespace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/* isDigits
+ * Returns true if [str] is one or more decimal digits (optionally
+ * with a leading sign if [sign] is true)
+ *******************************************************************/
+static bool isDigits(const char* str, bool sign)
+{
+	if (sign && (*str == '+' || *str == '-'))
+		str++;
+
+	if (!*str)
+		return false;
+
+	for (; *str; str++)
+	{
+		if (*str < '0' || *str > '9')
+			return false;
+	}
+
+	return true;
+}
+
+/* isHex
+ * Returns true if [str] is a hexadecimal number in 0x form
+ *******************************************************************/
+static bool isHex(const char* str)
+{
+	if (str[0] != '0' || str[1] != 'x' || !str[2])
+		return false;
+
+	for (str += 2; *str; str++)
+	{
+		if (!isxdigit((unsigned char)*str))
+			return false;
+	}
+
+	return true;
+}
+
+/* isFloat
+ * Returns true if [str] is a decimal floating point number, with
+ * optional sign, decimal point and exponent
+ *******************************************************************/
+static bool isFloat(const char* str)
+{
+	if (*str == '+' || *str == '-')
+		str++;
+
+	// Digits and decimal point (need at least one digit after it)
+	bool point = false;
+	int digits = 0;
+	for (; *str && *str != 'e' && *str != 'E'; str++)
+	{
+		if (*str == '.' && !point)
+		{
+			point = true;
+			digits = 0;
+		}
+		else if (*str >= '0' && *str <= '9')
+			digits++;
+		else
+			return false;
+	}
+	if (digits == 0)
+		return false;
+
+	// Exponent
+	if (*str)
+		return isDigits(str + 1, true);
+
+	return true;
+}
+
+
+/*******************************************************************
+ * UDMFREADER CLASS FUNCTIONS
+ *******************************************************************/
+
+/* UDMFReader::UDMFReader
+ * UDMFReader class constructor. [source_name] is used in error
+ * messages
+ *******************************************************************/
+UDMFReader::UDMFReader(const MemChunk& data, string source_name)
+{
+	// Keep a null-terminated copy of the text to read from
+	text.resize(data.getSize() + 1);
+	if (data.getSize() > 0)
+		memcpy(text.data(), data.getData(), data.getSize());
+	text.back() = 0;
+
+	current = text.data();
+	end = text.data() + data.getSize();
+	line = 1;
+	source = source_name;
+	tok = current;
+	tok_len = 0;
+	tok_quoted = false;
+
+	// Floats are parsed with strtod, which needs the "C" numeric locale
+	// for '.' decimal points (anything may have changed it since startup)
+	const char* locale = setlocale(LC_NUMERIC, nullptr);
+	old_locale = locale ? locale : "";
+	setlocale(LC_NUMERIC, "C");
+}
+
+/* UDMFReader::~UDMFReader
+ * UDMFReader class destructor, restores the previous numeric locale
+ *******************************************************************/
+UDMFReader::~UDMFReader()
+{
+	if (!old_locale.empty())
+		setlocale(LC_NUMERIC, old_locale.c_str());
+}
+
+/* UDMFReader::progress
+ * Returns how far through the text the reader is, from 0 to 1
+ *******************************************************************/
+float UDMFReader::progress() const
+{
+	if (end == text.data())
+		return 1.0f;
+
+	return (float)(current - text.data()) / (float)(end - text.data());
+}
+
+/* UDMFReader::setError
+ * Sets the error message to [message], adding the source name and
+ * current line number
+ *******************************************************************/
+void UDMFReader::setError(string message)
+{
+	error = S_FMT("%s in %s (line %d)", message, source, line);
+}
+
+/* UDMFReader::readToken
+ * Reads the next token, skipping whitespace and comments. Returns
+ * false if the end of the text was reached (or on error)
+ *******************************************************************/
+bool UDMFReader::readToken()
+{
+	tok_len = 0;
+	tok_quoted = false;
+
+	// Skip whitespace and comments
+	while (current < end)
+	{
+		if (isWhitespace(*current))
+		{
+			if (*current == '\n')
+				line++;
+			current++;
+		}
+		else if (current[0] == '/' && current[1] == '/')
+		{
+			while (current < end && *current != '\n')
+				current++;
+		}
+		else if (current[0] == '/' && current[1] == '*')
+		{
+			current += 2;
+			while (current < end && !(current[0] == '*' && current[1] == '/'))
+			{
+				if (*current == '\n')
+					line++;
+				current++;
+			}
+			current = MIN(current + 2, end);
+		}
+		else
+			break;
+	}
+
+	if (current >= end)
+	{
+		tok = end;
+		return false;
+	}
+
+	// Special character
+	tok = current;
+	if (isSpecial(*current))
+	{
+		tok_len = 1;
+		current++;
+		return true;
+	}
+
+	// Quoted string (escaped characters are handled in value())
+	if (*current == '\"')
+	{
+		tok = ++current;
+		while (current < end && *current != '\"')
+		{
+			if (*current == '\\' && current + 1 < end)
+				current++;
+			if (*current == '\n')
+				line++;
+			current++;
+		}
+		if (current >= end)
+		{
+			setError("Unterminated string");
+			return false;
+		}
+
+		tok_len = current - tok;
+		tok_quoted = true;
+		current++;
+		return true;
+	}
+
+	// Anything else, up to whitespace or a special character
+	while (current < end && !isWhitespace(*current) && !isSpecial(*current))
+		current++;
+	tok_len = current - tok;
+
+	return true;
+}
+
+/* UDMFReader::expect
+ * Reads the next token and returns true if it is the special
+ * character [c], otherwise sets an error and returns false
+ *******************************************************************/
+bool UDMFReader::expect(char c)
+{
+	if (readToken() && tokenIs(c))
+		return true;
+
+	if (!hasError())
+		setError(S_FMT("Expected \"%c\", got \"%s\"", c, string(tok, tok_len)));
+
+	return false;
+}
+
+/* UDMFReader::next
+ * Reads the next top-level definition into [def]. Returns false at
+ * the end of the text or if there was a syntax error (check
+ * hasError)
+ *******************************************************************/
+bool UDMFReader::next(def_t& def)
+{
+	def.fields.clear();
+
+	// Get definition type/name
+	if (!readToken())
+		return false;
+	if (tok_quoted || isSpecial(*tok))
+	{
+		setError(S_FMT("Unexpected \"%s\"", string(tok, tok_len)));
+		return false;
+	}
+	def.type = tok;
+	def.type_len = tok_len;
+	def.text = tok;
+
+	// Check what kind of definition it is
+	if (!readToken())
+	{
+		setError("Unexpected end of text");
+		return false;
+	}
+
+	field_t field;
+
+	// Assignment
+	if (tokenIs('='))
+	{
+		if (!readToken() || tokenIs(';'))
+		{
+			if (!hasError())
+				setError(S_FMT("Missing value for \"%s\"", string(def.type, def.type_len)));
+			return false;
+		}
+		field.name = def.type;
+		field.name_len = def.type_len;
+		field.value = tok;
+		field.value_len = tok_len;
+		field.quoted = tok_quoted;
+		def.fields.push_back(field);
+		def.block = false;
+
+		if (!expect(';'))
+			return false;
+	}
+
+	// Block
+	else if (tokenIs('{'))
+	{
+		def.block = true;
+		while (true)
+		{
+			if (!readToken())
+			{
+				if (!hasError())
+					setError(S_FMT("Unterminated \"%s\" block", string(def.type, def.type_len)));
+				return false;
+			}
+
+			// End of block
+			if (tokenIs('}'))
+				break;
+
+			// Field name
+			if (tok_quoted || isSpecial(*tok))
+			{
+				setError(S_FMT("Unexpected \"%s\"", string(tok, tok_len)));
+				return false;
+			}
+			field.name = tok;
+			field.name_len = tok_len;
+
+			// Value
+			if (!expect('='))
+				return false;
+			if (!readToken() || tokenIs(';'))
+			{
+				if (!hasError())
+					setError(S_FMT("Missing value for \"%s\"", string(field.name, field.name_len)));
+				return false;
+			}
+			field.value = tok;
+			field.value_len = tok_len;
+			field.quoted = tok_quoted;
+			def.fields.push_back(field);
+
+			if (!expect(';'))
+				return false;
+		}
+	}
+
+	else
+	{
+		setError(S_FMT("Expected \"=\" or \"{\" after \"%s\"", string(def.type, def.type_len)));
+		return false;
+	}
+
+	def.text_len = current - def.text;
+
+	return true;
+}
+
+/* UDMFReader::nameIs
+ * Returns true if the name [name] (of length [name_len]) matches
+ * [cmp], ignoring case
+ *******************************************************************/
+bool UDMFReader::nameIs(const char* name, unsigned name_len, const char* cmp)
+{
+	for (unsigned a = 0; a < name_len; a++)
+	{
+		if (!cmp[a] || tolower((unsigned char)name[a]) != tolower((unsigned char)cmp[a]))
+			return false;
+	}
+
+	return cmp[name_len] == 0;
+}
+
+/* UDMFReader::name
+ * Returns the name of [field] as a string
+ *******************************************************************/
+string UDMFReader::name(const field_t& field)
+{
+	return string(field.name, field.name_len);
+}
+
+/* UDMFReader::value
+ * Returns the value of [field] as a Property, with the type detected
+ * the same way as the generic Parser does (quoted string, boolean,
+ * integer, hex integer, float or unquoted string)
+ *******************************************************************/
+Property UDMFReader::value(const field_t& field)
+{
+	// Quoted string, remove escapes
+	if (field.quoted)
+	{
+		std::string str;
+		str.reserve(field.value_len);
+		for (unsigned a = 0; a < field.value_len; a++)
+		{
+			if (field.value[a] == '\\' && a + 1 < field.value_len)
+				a++;
+			str += field.value[a];
+		}
+
+		return Property(string(str.data(), str.size()));
+	}
+
+	// Numbers and booleans are never very long, anything
+	// longer than this can only be an unquoted string
+	char buf[64];
+	if (field.value_len >= sizeof(buf))
+		return Property(string(field.value, field.value_len));
+	memcpy(buf, field.value, field.value_len);
+	buf[field.value_len] = 0;
+
+	// Boolean
+	if (nameIs(field.value, field.value_len, "true"))
+		return Property(true);
+	if (nameIs(field.value, field.value_len, "false"))
+		return Property(false);
+
+	// Integer
+	if (isDigits(buf, true))
+		return Property((int)strtol(buf, nullptr, 10));
+
+	// Hex integer
+	if (isHex(buf))
+		return Property((int)strtol(buf, nullptr, 16));
+
+	// Float
+	if (isFloat(buf))
+		return Property(strtod(buf, nullptr));
+
+	// Unknown, treat as string
+	return Property(string(field.value, field.value_len));
+}
@@ -0,0 +1,75 @@
+
+#ifndef __UDMF_READER_H__
+#define __UDMF_READER_H__
+
+#include "Utility/PropertyList/Property.h"
+
+class MemChunk;
+
+// Reads UDMF (TEXTMAP) text in a single pass, one top-level definition
+// at a time. Tokens are read in place from a copy of the text, so no
+// parse tree (or string per token) is built. The "C" numeric locale is
+// set while a reader exists, so value() can parse floats with strtod
+class UDMFReader
+{
+public:
+	// An assignment (name = value;). The value is the raw text of the
+	// value token, without quotes if it was a quoted string
+	struct field_t
+	{
+		const char*	name;
+		unsigned	name_len;
+		const char*	value;
+		unsigned	value_len;
+		bool		quoted;
+	};
+
+	// A top-level definition, either a block (type { fields }) or a
+	// single assignment (in which case [fields] has one entry, with the
+	// same name as [type]). [text]/[text_len] is the full definition as
+	// it appeared in the source
+	struct def_t
+	{
+		const char*		type;
+		unsigned		type_len;
+		bool			block;
+		vector<field_t>	fields;
+		const char*		text;
+		unsigned		text_len;
+	};
+
+	UDMFReader(const MemChunk& data, string source_name);
+	~UDMFReader();
+
+	bool	next(def_t& def);
+	bool	hasError() const { return !error.IsEmpty(); }
+	string	errorMessage() const { return error; }
+	float	progress() const;
+
+	static bool		nameIs(const char* name, unsigned name_len, const char* cmp);
+	static bool		nameIs(const field_t& field, const char* cmp) { return nameIs(field.name, field.name_len, cmp); }
+	static bool		typeIs(const def_t& def, const char* cmp) { return nameIs(def.type, def.type_len, cmp); }
+	static string	name(const field_t& field);
+	static Property	value(const field_t& field);
+
+private:
+	vector<char>	text;		// Copy of the text, null terminated
+	std::string		old_locale;	// Numeric locale before the reader was created
+	const char*		current;
+	const char*		end;
+	unsigned		line;
+	string			source;
+	string			error;
+
+	// Last token read
+	const char*		tok;
+	unsigned		tok_len;
+	bool			tok_quoted;
+
+	bool	readToken();
+	bool	tokenIs(char c) const { return !tok_quoted && tok_len == 1 && tok[0] == c; }
+	bool	expect(char c);
+	void	setError(string message);
+};
+
+#endif//__UDMF_READER_H__
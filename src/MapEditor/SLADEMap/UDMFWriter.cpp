@@ -0,0 +1,310 @@
+
+/*******************************************************************
+ * SLADE - It's a Doom Editor
+ * Copyright (C) 2008-2014 Simon Judd
+ *
+ * Email:       sirjuddington@gmail.com
+ * Web:         http://slade.mancubus.net
+ * Filename:    UDMFWriter.cpp
+ * Description: UDMFWriter class, writes UDMF (TEXTMAP) text straight
+ *              into a memory buffer. Numbers are formatted by hand
+ *              where possible (rather than via S_FMT), which is a lot
+ *              quicker. The "C" numeric locale is set while a writer
+ *              exists, for floats that are written with printf
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *******************************************************************/
+
+
+/*******************************************************************
+ * INCLUDES
+ *******************************************************************/
+#include "Main.h"
+#include "UDMFWriter.h"
+#include "General/Console/Console.h"
+#include "MobjPropertyList.h"
+#include "UDMFReader.h"
+#include "Utility/MemChunk.h"
+
+
+/*******************************************************************
+ * UDMFWRITER CLASS FUNCTIONS
+ *******************************************************************/
+
+/* UDMFWriter::UDMFWriter
+ * UDMFWriter class constructor. [reserve] is the expected size of
+ * the output, in bytes
+ *******************************************************************/
+UDMFWriter::UDMFWriter(size_t reserve)
+{
+	buffer.reserve(reserve);
+
+	// Floats are written with printf, which needs the "C" numeric
+	// locale for '.' decimal points (anything may have changed it
+	// since startup)
+	const char* locale = setlocale(LC_NUMERIC, nullptr);
+	old_locale = locale ? locale : "";
+	setlocale(LC_NUMERIC, "C");
+}
+
+/* UDMFWriter::~UDMFWriter
+ * UDMFWriter class destructor, restores the previous numeric locale
+ *******************************************************************/
+UDMFWriter::~UDMFWriter()
+{
+	if (!old_locale.empty())
+		setlocale(LC_NUMERIC, old_locale.c_str());
+}
+
+/* UDMFWriter::appendInt
+ * Appends [value] in decimal to the buffer
+ *******************************************************************/
+void UDMFWriter::appendInt(long long value)
+{
+	char buf[24];
+	char* end = buf + sizeof(buf);
+	char* pos = end;
+
+	unsigned long long mag = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+	do
+	{
+		*--pos = '0' + (char)(mag % 10);
+		mag /= 10;
+	}
+	while (mag > 0);
+
+	if (value < 0)
+		*--pos = '-';
+
+	buffer.append(pos, end - pos);
+}
+
+/* UDMFWriter::appendFloat
+ * Appends [value] with [decimals] digits after the decimal point to
+ * the buffer, the same as printf's %.<decimals>f would
+ *******************************************************************/
+void UDMFWriter::appendFloat(double value, int decimals)
+{
+	// Whole numbers (the vast majority of map coordinates) can
+	// just be written as integers
+	if (value == floor(value) && fabs(value) < 1e15 && !(value == 0 && std::signbit(value)))
+	{
+		appendInt((long long)value);
+		buffer += '.';
+		buffer.append(decimals, '0');
+		return;
+	}
+
+	// Otherwise use printf
+	char buf[64];
+	int len = snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+	if (len >= 0 && len < (int)sizeof(buf))
+		buffer.append(buf, len);
+	else if (len > 0)
+	{
+		vector<char> big(len + 1);
+		snprintf(big.data(), big.size(), "%.*f", decimals, value);
+		buffer.append(big.data(), len);
+	}
+}
+
+/* UDMFWriter::appendText
+ * Appends [text] to the buffer as UTF-8. If [escape] is true, any
+ * quotes or backslashes are escaped with a backslash
+ *******************************************************************/
+void UDMFWriter::appendText(const string& text, bool escape)
+{
+	for (wxString::const_iterator i = text.begin(); i != text.end(); ++i)
+	{
+		uint32_t c = (*i).GetValue();
+		if (c < 0x80)
+		{
+			if (escape && (c == '\"' || c == '\\'))
+				buffer += '\\';
+			buffer += (char)c;
+		}
+		else if (c < 0x800)
+		{
+			buffer += (char)(0xC0 | (c >> 6));
+			buffer += (char)(0x80 | (c & 0x3F));
+		}
+		else if (c < 0x10000)
+		{
+			buffer += (char)(0xE0 | (c >> 12));
+			buffer += (char)(0x80 | ((c >> 6) & 0x3F));
+			buffer += (char)(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			buffer += (char)(0xF0 | (c >> 18));
+			buffer += (char)(0x80 | ((c >> 12) & 0x3F));
+			buffer += (char)(0x80 | ((c >> 6) & 0x3F));
+			buffer += (char)(0x80 | (c & 0x3F));
+		}
+	}
+}
+
+/* UDMFWriter::beginBlock
+ * Begins a new [type] definition block, commented with [index]
+ *******************************************************************/
+void UDMFWriter::beginBlock(const char* type, unsigned index)
+{
+	buffer.append(type);
+	buffer.append("//#", 3);
+	appendInt(index);
+	buffer.append("\n{\n", 3);
+}
+
+/* UDMFWriter::writeInt
+ * Writes an integer assignment of [value] to [name]
+ *******************************************************************/
+void UDMFWriter::writeInt(const char* name, int value)
+{
+	buffer.append(name);
+	buffer += '=';
+	appendInt(value);
+	buffer.append(";\n", 2);
+}
+
+/* UDMFWriter::writeFloat
+ * Writes a float assignment of [value] to [name], with 3 decimal
+ * places
+ *******************************************************************/
+void UDMFWriter::writeFloat(const char* name, double value)
+{
+	buffer.append(name);
+	buffer += '=';
+	appendFloat(value, 3);
+	buffer.append(";\n", 2);
+}
+
+/* UDMFWriter::writeString
+ * Writes a (quoted) string assignment of [value] to [name]
+ *******************************************************************/
+void UDMFWriter::writeString(const char* name, const string& value)
+{
+	buffer.append(name);
+	buffer.append("=\"", 2);
+	appendText(value, true);
+	buffer.append("\";\n", 3);
+}
+
+/* UDMFWriter::writeProperty
+ * Writes an assignment of [value] to [name], formatted according to
+ * the property type. Nothing is written if [value] has no value
+ *******************************************************************/
+void UDMFWriter::writeProperty(const string& name, const Property& value)
+{
+	if (!value.hasValue())
+		return;
+
+	appendText(name, false);
+	buffer += '=';
+
+	switch (value.getType())
+	{
+	case PROP_STRING:
+		buffer += '\"';
+		appendText(value.getStringValue(), true);
+		buffer += '\"';
+		break;
+	case PROP_INT:
+		appendInt(value.getIntValue()); break;
+	case PROP_UINT:
+		appendInt((int)value.getUnsignedValue()); break;
+	case PROP_FLOAT:
+		appendFloat(value.getFloatValue(), 6); break;
+	case PROP_BOOL:
+		buffer.append(value.getBoolValue() ? "true" : "false"); break;
+	case PROP_FLAG:
+		buffer += '1'; break;
+	default:
+		break;
+	}
+
+	buffer.append(";\n", 2);
+}
+
+/* UDMFWriter::writeProperties
+ * Writes all properties in [props]
+ *******************************************************************/
+void UDMFWriter::writeProperties(const MobjPropertyList& props)
+{
+	const vector<MobjPropertyList::prop_t>& list = props.allProperties();
+	for (unsigned a = 0; a < list.size(); a++)
+		writeProperty(list[a].name(), list[a].value);
+}
+
+
+/*******************************************************************
+ * CONSOLE COMMANDS
+ *******************************************************************/
+
+// Reads the first block in [text] into [props], and writes them back
+// out (for test_udmf_prop_order)
+static string udmfRoundTrip(const char* text, MobjPropertyList& props)
+{
+	MemChunk mc;
+	mc.importMem((const uint8_t*)text, strlen(text));
+	UDMFReader reader(mc, "test");
+	UDMFReader::def_t def;
+	if (!reader.next(def))
+		return "";
+
+	props.clear();
+	for (unsigned a = 0; a < def.fields.size(); a++)
+		props[UDMFReader::name(def.fields[a])] = UDMFReader::value(def.fields[a]);
+
+	UDMFWriter writer;
+	writer.writeProperties(props);
+	return string::FromUTF8(writer.data(), writer.size());
+}
+
+CONSOLE_COMMAND(test_udmf_prop_order, 0, false)
+{
+	// Intern the last key first, so key id order differs from file order
+	MobjPropertyList::keyId("test_order_c");
+	const char* text =
+		"thing\n{\ntest_order_a = 1;\ntest_order_b = 2.5;\n"
+		"test_order_c = \"c\";\ntest_order_d = true;\n}\n";
+	string expected =
+		"test_order_a=1;\ntest_order_b=2.500000;\n"
+		"test_order_c=\"c\";\ntest_order_d=true;\n";
+
+	MobjPropertyList props;
+	string first = udmfRoundTrip(text, props);
+
+	// Interning an unrelated key must not change the output
+	static int runs = 0;
+	MobjPropertyList::keyId(S_FMT("test_order_unrelated%d", runs++));
+	string second = udmfRoundTrip(text, props);
+
+	int failed = 0;
+	if (first != second)
+	{
+		Log::console("Output changed after interning an unrelated key:");
+		Log::console(first);
+		Log::console(second);
+		failed++;
+	}
+	if (first != expected)
+	{
+		Log::console("Output not in file order:");
+		Log::console(first);
+		failed++;
+	}
+
+	Log::console(S_FMT("Property order checks: %d failed", failed));
+}
@@ -0,0 +1,40 @@
+
+#ifndef __UDMF_WRITER_H__
+#define __UDMF_WRITER_H__
+
+#include "Utility/PropertyList/Property.h"
+
+class MobjPropertyList;
+
+// Writes UDMF (TEXTMAP) text directly into a memory buffer. The "C"
+// numeric locale is set while a writer exists, so floats are always
+// written with '.' decimal points
+class UDMFWriter
+{
+public:
+	UDMFWriter(size_t reserve = 0);
+	~UDMFWriter();
+
+	const char*	data() const { return buffer.data(); }
+	size_t		size() const { return buffer.size(); }
+
+	void	beginBlock(const char* type, unsigned index);
+	void	endBlock() { buffer.append("}\n\n", 3); }
+	void	writeInt(const char* name, int value);
+	void	writeFloat(const char* name, double value);
+	void	writeString(const char* name, const string& value);
+	void	writeProperty(const string& name, const Property& value);
+	void	writeProperties(const MobjPropertyList& props);
+	void	writeRaw(const char* text) { buffer.append(text); }
+	void	writeRaw(const string& text) { appendText(text, false); }
+
+private:
+	std::string	buffer;
+	std::string	old_locale;	// Numeric locale before the writer was created
+
+	void	appendInt(long long value);
+	void	appendFloat(double value, int decimals);
+	void	appendText(const string& text, bool escape);
+};
+
+#endif//__UDMF_WRITER_H__
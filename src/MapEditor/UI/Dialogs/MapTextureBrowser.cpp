@@ -94,6 +94,22 @@ bool MapTexBrowserItem::loadImage()
 		return false;
 }
 
+/* MapTexBrowserItem::thumbnailSource
+ * Gets the item's image entry data for loading its thumbnail in the
+ * background. Composite textures are left to load normally
+ *******************************************************************/
+bool MapTexBrowserItem::thumbnailSource(MemChunk& data, string& format_hint, Palette8bit& palette)
+{
+	ArchiveEntry* entry = MapEditor::textureManager().getImageEntry(name, type == "flat");
+	if (!BrowserThumbnailLoader::entrySource(entry, data, format_hint))
+		return false;
+
+	Palette8bit* pal = MapEditor::textureManager().getPalette();
+	if (pal)
+		palette.copyPalette(pal);
+	return true;
+}
+
 /* MapTexBrowserItem::itemInfo
  * Returns a string with extra information about the texture/flat
  *******************************************************************/
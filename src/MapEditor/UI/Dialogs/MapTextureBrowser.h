@@ -18,6 +18,7 @@ public:
 
 	bool	loadImage();
 	string	itemInfo();
+	bool	thumbnailSource(MemChunk& data, string& format_hint, Palette8bit& palette);
 	int		usageCount() { return usage_count; }
 	void	setUsage(int count) { usage_count = count; }
 };
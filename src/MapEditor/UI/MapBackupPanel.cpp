@@ -30,8 +30,8 @@
 #include "Main.h"
 #include "App.h"
 #include "MapBackupPanel.h"
-#include "Archive/Formats/WadArchive.h"
-#include "Archive/Formats/ZipArchive.h"
+#include "Archive/Archive.h"
+#include "MapEditor/MapEditor.h"
 #include "UI/Canvas/MapPreviewCanvas.h"
 
 
@@ -45,8 +45,6 @@
 MapBackupPanel::MapBackupPanel(wxWindow* parent) : wxPanel(parent, -1)
 {
 	// Init variables
-	archive_backups = new ZipArchive();
-	dir_current = NULL;
 	archive_mapdata = NULL;
 
 	// Setup Sizer
@@ -70,24 +68,19 @@ MapBackupPanel::MapBackupPanel(wxWindow* parent) : wxPanel(parent, -1)
  *******************************************************************/
 MapBackupPanel::~MapBackupPanel()
 {
-	delete archive_backups;
 }
 
 /* MapBackupPanel::loadBackups
- * Opens the map backup file for [map_name] in [archive_name] and
- * populates the list
+ * Gets the list of backups for [map_name] in [archive_name] and
+ * populates the list. The backed up map data itself is only read
+ * when a backup is selected
  *******************************************************************/
 bool MapBackupPanel::loadBackups(string archive_name, string map_name)
 {
-	// Open backup file
-	archive_name.Replace(".", "_");
-	string backup_file = App::path("backups", App::Dir::User) + "/" + archive_name + "_backup.zip";
-	if (!archive_backups->open(backup_file))
-		return false;
-
-	// Get backup dir for map
-	dir_current = archive_backups->getDir(map_name);
-	if (dir_current == archive_backups->rootDir() || !dir_current)
+	// Get backups for map
+	this->archive_name = archive_name;
+	backups.clear();
+	if (!MapEditor::backupManager().getBackups(archive_name, map_name, backups))
 		return false;
 
 	// Populate backups list
@@ -96,9 +89,9 @@ bool MapBackupPanel::loadBackups(string archive_name, string map_name)
 	list_backups->AppendColumn("Time");
 
 	int index = 0;
-	for (int a = dir_current->nChildren() - 1; a >= 0; a--)
+	for (int a = backups.size() - 1; a >= 0; a--)
 	{
-		string timestamp = dir_current->getChild(a)->getName();
+		string timestamp = backups[a].timestamp;
 		wxArrayString cols;
 
 		// Date
@@ -134,10 +127,9 @@ void MapBackupPanel::updateMapPreview()
 	// Load map data to temporary wad
 	if (archive_mapdata)
 		delete archive_mapdata;
-	archive_mapdata = new WadArchive();
-	ArchiveTreeNode* dir = (ArchiveTreeNode*)dir_current->getChild(selection);
-	for (unsigned a = 0; a < dir->numEntries(); a++)
-		archive_mapdata->addEntry(dir->entryAt(a), "", true);
+	archive_mapdata = MapEditor::backupManager().readBackup(archive_name, backups[selection]);
+	if (!archive_mapdata)
+		return;
 
 	// Open map preview
 	vector<Archive::MapDesc> maps = archive_mapdata->detectMaps();
@@ -4,19 +4,19 @@
 
 #include "common.h"
 #include "UI/Lists/ListView.h"
+#include "MapEditor/MapBackupManager.h"
 
 class MapPreviewCanvas;
 class Archive;
-class ZipArchive;
-class ArchiveTreeNode;
 class MapBackupPanel : public wxPanel
 {
 private:
 	MapPreviewCanvas*	canvas_map;
 	ListView*			list_backups;
-	ZipArchive*			archive_backups;
 	Archive*			archive_mapdata;
-	ArchiveTreeNode*	dir_current;
+	string				archive_name;
+
+	vector<MapBackupManager::backup_t>	backups;
 
 public:
 	MapBackupPanel(wxWindow* parent);
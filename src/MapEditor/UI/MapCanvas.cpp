@@ -35,10 +35,18 @@
 #include "MapEditor/SectorBuilder.h"
 #include "OpenGL/Drawing.h"
 #include "Utility/MathStuff.h"
+#include "Utility/Profiler.h"
 
 using MapEditor::Mode;
 
 
+/*******************************************************************
+ * EXTERNAL VARIABLES
+ *******************************************************************/
+EXTERN_CVAR(Bool, map_show_profiler)
+EXTERN_CVAR(Bool, map_profile_record)
+
+
 /*******************************************************************
  * MAPCANVAS CLASS FUNCTIONS
  *******************************************************************/
@@ -102,11 +110,16 @@ void MapCanvas::draw()
 	if (!IsEnabled())
 		return;
 
+	// Only time passes while the profiler overlay is shown or recording
+	Profiler::setEnabled(map_show_profiler || map_profile_record);
+
 	context_->renderer().draw();
 
 	SwapBuffers();
 
 	glFinish();
+
+	Profiler::endFrame();
 }
 
 /* MapCanvas::mouseToCenter
@@ -370,22 +370,32 @@ void MapChecksPanel::onBtnCheck(wxCommandEvent& e)
 	if (cb_obsolete_things->GetValue())
 		active_checks.push_back(MapCheck::obsoleteThingCheck(map));
 
-	// Run checks
-	for (unsigned a = 0; a < active_checks.size(); a++)
+	// Run checks (in parallel where possible), adding results to the
+	// list as each check completes
+	lb_errors->Show(true);
+	if (!active_checks.empty())
+		updateStatusText(active_checks[0]->progressText());
+	MapCheckRunner runner(map, active_checks);
+	runner.start();
+	int index;
+	while ((index = runner.waitNext()) >= 0)
 	{
-		// Check
-		updateStatusText(active_checks[a]->progressText());
-		active_checks[a]->doCheck();
+		MapCheck* check = active_checks[index];
+		LOG_MESSAGE(2, "%s took %ldms", check->progressText(), runner.checkTime(index));
 
 		// Add results to list
-		for (unsigned b = 0; b < active_checks[a]->nProblems(); b++)
+		for (unsigned b = 0; b < check->nProblems(); b++)
 		{
-			lb_errors->Append(active_checks[a]->problemDesc(b));
-			check_items.push_back(check_item_t(active_checks[a], b));
+			lb_errors->Append(check->problemDesc(b));
+			check_items.push_back(check_item_t(check, b));
 		}
-	}
+		lb_errors->Update();
 
-	lb_errors->Show(true);
+		// Show progress
+		if (index + 1 < (int)active_checks.size())
+			updateStatusText(S_FMT("%s (%d/%d)", active_checks[index + 1]->progressText(), index + 1, (int)active_checks.size()));
+	}
+	LOG_MESSAGE(2, "Map checks took %ldms", runner.totalTime());
 
 	if (lb_errors->GetCount() > 0)
 	{
@@ -895,7 +895,7 @@ void MapObjectPropsPanel::openObjects(vector<MapObject*>& objects)
 		for (unsigned a = 0; a < objects.size(); a++)
 		{
 			// Go through object properties
-			vector<MobjPropertyList::prop_t> objprops = objects[a]->props().allProperties();
+			const vector<MobjPropertyList::prop_t>& objprops = objects[a]->props().allProperties();
 			for (unsigned b = 0; b < objprops.size(); b++)
 			{
 				// Ignore unset properties
@@ -903,18 +903,18 @@ void MapObjectPropsPanel::openObjects(vector<MapObject*>& objects)
 					continue;
 
 				// Ignore side property
-				if (objprops[b].name.StartsWith("side1.") || objprops[b].name.StartsWith("side2."))
+				if (objprops[b].name().StartsWith("side1.") || objprops[b].name().StartsWith("side2."))
 					continue;
 
 				// Check if hidden
-				if (VECTOR_EXISTS(hide_props, objprops[b].name))
+				if (VECTOR_EXISTS(hide_props, objprops[b].name()))
 					continue;
 
 				// Check if property is already on the list
 				bool exists = false;
 				for (unsigned c = 0; c < properties.size(); c++)
 				{
-					if (properties[c]->getPropName() == objprops[b].name)
+					if (properties[c]->getPropName() == objprops[b].name())
 					{
 						exists = true;
 						break;
@@ -927,19 +927,19 @@ void MapObjectPropsPanel::openObjects(vector<MapObject*>& objects)
 					if (!group_custom)
 						group_custom = pg_properties->Append(new wxPropertyCategory("Custom"));
 
-					//LOG_MESSAGE(2, "Add custom property \"%s\"", objprops[b].name);
+					//LOG_MESSAGE(2, "Add custom property \"%s\"", objprops[b].name());
 
 					// Add property
 					switch (objprops[b].value.getType())
 					{
 					case PROP_BOOL:
-						addBoolProperty(group_custom, objprops[b].name, objprops[b].name); break;
+						addBoolProperty(group_custom, objprops[b].name(), objprops[b].name()); break;
 					case PROP_INT:
-						addIntProperty(group_custom, objprops[b].name, objprops[b].name); break;
+						addIntProperty(group_custom, objprops[b].name(), objprops[b].name()); break;
 					case PROP_FLOAT:
-						addFloatProperty(group_custom, objprops[b].name, objprops[b].name); break;
+						addFloatProperty(group_custom, objprops[b].name(), objprops[b].name()); break;
 					default:
-						addStringProperty(group_custom, objprops[b].name, objprops[b].name); break;
+						addStringProperty(group_custom, objprops[b].name(), objprops[b].name()); break;
 					}
 				}
 			}
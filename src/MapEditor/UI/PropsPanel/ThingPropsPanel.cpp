@@ -724,7 +724,7 @@ wxPanel* ThingPropsPanel::setupExtraFlagsTab()
 	for (unsigned a = 0; a < udmf_flags_extra.size(); a++)
 	{
 		UDMFProperty* prop = Game::configuration().getUDMFProperty(udmf_flags_extra[a], MOBJ_THING);
-		flags.push_back(prop->name());
+		flags.push_back(prop ? prop->name() : udmf_flags_extra[a]);
 	}
 
 	// Add flag checkboxes
@@ -2,9 +2,46 @@
 #include "Main.h"
 #include "SLADEMap/SLADEMap.h"
 #include "UndoSteps.h"
+#include "Utility/MemChunk.h"
 
 using namespace MapEditor;
 
+
+// Writes [backup] to [mc] in binary form
+static void writeBackup(MemChunk& mc, const mobj_backup_t* backup)
+{
+	uint32_t id = backup->id;
+	mc.write(&id, 4);
+	mc.write(&backup->type, 1);
+	backup->properties.write(mc);
+	backup->props_internal.write(mc);
+}
+
+// Reads a backup written by writeBackup from [mc]
+static mobj_backup_t* readBackup(MemChunk& mc)
+{
+	mobj_backup_t* backup = new mobj_backup_t();
+	uint32_t id;
+	if (!mc.read(&id, 4) ||
+		!mc.read(&backup->type, 1) ||
+		!backup->properties.read(mc) ||
+		!backup->props_internal.read(mc))
+	{
+		delete backup;
+		return nullptr;
+	}
+	backup->id = id;
+
+	return backup;
+}
+
+// Returns the memory used by [backup]
+static size_t backupMemoryUsage(const mobj_backup_t* backup)
+{
+	return sizeof(mobj_backup_t) + backup->properties.memoryUsage() + backup->props_internal.memoryUsage();
+}
+
+
 PropertyChangeUS::PropertyChangeUS(MapObject* object)
 {
 	backup = new mobj_backup_t();
@@ -41,185 +78,134 @@ bool PropertyChangeUS::doRedo()
 	return true;
 }
 
+bool PropertyChangeUS::writeFile(MemChunk& mc)
+{
+	writeBackup(mc, backup);
+	return true;
+}
+
+bool PropertyChangeUS::readFile(MemChunk& mc)
+{
+	delete backup;
+	backup = readBackup(mc);
+	return backup != nullptr;
+}
+
+size_t PropertyChangeUS::memoryUsage()
+{
+	return backup ? backupMemoryUsage(backup) : 0;
+}
+
+void PropertyChangeUS::unload()
+{
+	delete backup;
+	backup = nullptr;
+}
+
 
 MapObjectCreateDeleteUS::MapObjectCreateDeleteUS()
 {
-	SLADEMap* map = UndoRedo::currentMap();
-	map->getObjectIdList(MOBJ_VERTEX, vertices);
-	map->getObjectIdList(MOBJ_LINE, lines);
-	map->getObjectIdList(MOBJ_SIDE, sides);
-	map->getObjectIdList(MOBJ_SECTOR, sectors);
-	map->getObjectIdList(MOBJ_THING, things);
+	// Start recording created/deleted objects from here
+	UndoRedo::currentMap()->clearCreatedDeleted();
 }
 
-void MapObjectCreateDeleteUS::swapLists()
+MapObjectCreateDeleteUS::~MapObjectCreateDeleteUS()
 {
-	// Backup
-	vector<unsigned> vertices;
-	vector<unsigned> lines;
-	vector<unsigned> sides;
-	vector<unsigned> sectors;
-	vector<unsigned> things;
+}
+
+void MapObjectCreateDeleteUS::updateMap()
+{
+	// Update geometry info if any vertices or lines were added/removed
 	SLADEMap* map = UndoRedo::currentMap();
-	if (isValid(this->vertices))	map->getObjectIdList(MOBJ_VERTEX, vertices);
-	if (isValid(this->lines))		map->getObjectIdList(MOBJ_LINE, lines);
-	if (isValid(this->sides))		map->getObjectIdList(MOBJ_SIDE, sides);
-	if (isValid(this->sectors))		map->getObjectIdList(MOBJ_SECTOR, sectors);
-	if (isValid(this->things))		map->getObjectIdList(MOBJ_THING, things);
-
-	// Restore
-	if (isValid(this->vertices))
+	for (unsigned a = 0; a < changes.size(); a++)
 	{
-		map->restoreObjectIdList(MOBJ_VERTEX, this->vertices);
-		this->vertices = vertices;
-		map->updateGeometryInfo(0);
-	}
-	if (isValid(this->lines))
-	{
-		map->restoreObjectIdList(MOBJ_LINE, this->lines);
-		this->lines = lines;
-		map->updateGeometryInfo(0);
-	}
-	if (isValid(this->sides))
-	{
-		map->restoreObjectIdList(MOBJ_SIDE, this->sides);
-		this->sides = sides;
-	}
-	if (isValid(this->sectors))
-	{
-		map->restoreObjectIdList(MOBJ_SECTOR, this->sectors);
-		this->sectors = sectors;
-	}
-	if (isValid(this->things))
-	{
-		map->restoreObjectIdList(MOBJ_THING, this->things);
-		this->things = things;
+		MapObject* object = map->getObjectById(changes[a].id);
+		if (object && (object->getObjType() == MOBJ_VERTEX || object->getObjType() == MOBJ_LINE))
+		{
+			map->updateGeometryInfo(0);
+			break;
+		}
 	}
 }
 
 bool MapObjectCreateDeleteUS::doUndo()
 {
-	swapLists();
+	// Undo changes in reverse order
+	SLADEMap* map = UndoRedo::currentMap();
+	for (int a = (int)changes.size() - 1; a >= 0; a--)
+		map->replayCreateDelete(changes[a], true);
+
+	updateMap();
 	return true;
 }
 
 bool MapObjectCreateDeleteUS::doRedo()
 {
-	swapLists();
+	// Redo changes in order
+	SLADEMap* map = UndoRedo::currentMap();
+	for (unsigned a = 0; a < changes.size(); a++)
+		map->replayCreateDelete(changes[a], false);
+
+	updateMap();
 	return true;
 }
 
 void MapObjectCreateDeleteUS::checkChanges()
 {
+	// Get objects created/deleted since recording began
 	SLADEMap* map = UndoRedo::currentMap();
+	changes = map->createdDeletedObjects();
+	map->clearCreatedDeleted();
 
-	// Check vertices changed
-	bool vertices_changed = false;
-	if (map->nVertices() != vertices.size())
-		vertices_changed = true;
-	else
-		for (unsigned a = 0; a < map->nVertices(); a++)
-			if (map->getVertex(a)->getId() != vertices[a])
-			{
-				vertices_changed = true;
-				break;
-			}
-	if (!vertices_changed)
-	{
-		// No change, clear
-		vertices.clear();
-		vertices.push_back(0);
-		LOG_MESSAGE(3, "MapObjectCreateDeleteUS: No vertices added/deleted");
-	}
+	LOG_MESSAGE(3, "MapObjectCreateDeleteUS: %d objects added/deleted", (int)changes.size());
+}
 
-	// Check lines changed
-	bool lines_changed = false;
-	if (map->nLines() != lines.size())
-		lines_changed = true;
-	else
-		for (unsigned a = 0; a < map->nLines(); a++)
-			if (map->getLine(a)->getId() != lines[a])
-			{
-				lines_changed = true;
-				break;
-			}
-	if (!lines_changed)
+bool MapObjectCreateDeleteUS::writeFile(MemChunk& mc)
+{
+	uint32_t count = changes.size();
+	mc.write(&count, 4);
+	for (unsigned a = 0; a < changes.size(); a++)
 	{
-		// No change, clear
-		lines.clear();
-		lines.push_back(0);
-		LOG_MESSAGE(3, "MapObjectCreateDeleteUS: No lines added/deleted");
+		uint32_t id = changes[a].id;
+		uint32_t index = changes[a].index;
+		uint8_t created = changes[a].created ? 1 : 0;
+		mc.write(&id, 4);
+		mc.write(&index, 4);
+		mc.write(&created, 1);
 	}
 
-	// Check sides changed
-	bool sides_changed = false;
-	if (map->nSides() != sides.size())
-		sides_changed = true;
-	else
-		for (unsigned a = 0; a < map->nSides(); a++)
-			if (map->getSide(a)->getId() != sides[a])
-			{
-				sides_changed = true;
-				break;
-			}
-	if (!sides_changed)
-	{
-		// No change, clear
-		sides.clear();
-		sides.push_back(0);
-		LOG_MESSAGE(3, "MapObjectCreateDeleteUS: No sides added/deleted");
-	}
+	return true;
+}
 
-	// Check sectors changed
-	bool sectors_changed = false;
-	if (map->nSectors() != sectors.size())
-		sectors_changed = true;
-	else
-		for (unsigned a = 0; a < map->nSectors(); a++)
-			if (map->getSector(a)->getId() != sectors[a])
-			{
-				sectors_changed = true;
-				break;
-			}
-	if (!sectors_changed)
-	{
-		// No change, clear
-		sectors.clear();
-		sectors.push_back(0);
-		LOG_MESSAGE(3, "MapObjectCreateDeleteUS: No sectors added/deleted");
-	}
+bool MapObjectCreateDeleteUS::readFile(MemChunk& mc)
+{
+	changes.clear();
+
+	uint32_t count;
+	if (!mc.read(&count, 4))
+		return false;
 
-	// Check things changed
-	bool things_changed = false;
-	if (map->nThings() != things.size())
-		things_changed = true;
-	else
-		for (unsigned a = 0; a < map->nThings(); a++)
-			if (map->getThing(a)->getId() != things[a])
-			{
-				things_changed = true;
-				break;
-			}
-	if (!things_changed)
+	for (unsigned a = 0; a < count; a++)
 	{
-		// No change, clear
-		things.clear();
-		things.push_back(0);
-		LOG_MESSAGE(3, "MapObjectCreateDeleteUS: No things added/deleted");
+		uint32_t id, index;
+		uint8_t created;
+		if (!mc.read(&id, 4) || !mc.read(&index, 4) || !mc.read(&created, 1))
+			return false;
+
+		changes.push_back(mobj_cd_t(id, created != 0, index));
 	}
+
+	return true;
 }
 
-bool MapObjectCreateDeleteUS::isOk()
+size_t MapObjectCreateDeleteUS::memoryUsage()
 {
-	// Check for any changes at all
-	if (vertices.size() == 1 && vertices[0] == 0 &&
-		lines.size() == 1 && lines[0] == 0 &&
-		sides.size() == 1 && sides[0] == 0 &&
-		sectors.size() == 1 && sectors[0] == 0 &&
-		things.size() == 1 && things[0] == 0)
-		return false;
+	return changes.capacity() * sizeof(mobj_cd_t);
+}
 
-	return true;
+void MapObjectCreateDeleteUS::unload()
+{
+	vector<mobj_cd_t>().swap(changes);
 }
 
 
@@ -284,3 +270,49 @@ bool MultiMapObjectPropertyChangeUS::doRedo()
 
 	return true;
 }
+
+bool MultiMapObjectPropertyChangeUS::writeFile(MemChunk& mc)
+{
+	uint32_t count = backups.size();
+	mc.write(&count, 4);
+	for (unsigned a = 0; a < backups.size(); a++)
+		writeBackup(mc, backups[a]);
+
+	return true;
+}
+
+bool MultiMapObjectPropertyChangeUS::readFile(MemChunk& mc)
+{
+	unload();
+
+	uint32_t count;
+	if (!mc.read(&count, 4))
+		return false;
+
+	for (unsigned a = 0; a < count; a++)
+	{
+		mobj_backup_t* backup = readBackup(mc);
+		if (!backup)
+			return false;
+
+		backups.push_back(backup);
+	}
+
+	return true;
+}
+
+size_t MultiMapObjectPropertyChangeUS::memoryUsage()
+{
+	size_t size = backups.capacity() * sizeof(mobj_backup_t*);
+	for (unsigned a = 0; a < backups.size(); a++)
+		size += backupMemoryUsage(backups[a]);
+
+	return size;
+}
+
+void MultiMapObjectPropertyChangeUS::unload()
+{
+	for (unsigned a = 0; a < backups.size(); a++)
+		delete backups[a];
+	vector<mobj_backup_t*>().swap(backups);
+}
@@ -4,6 +4,7 @@
 
 class MapObject;
 struct mobj_backup_t;
+struct mobj_cd_t;
 
 namespace MapEditor
 {
@@ -14,9 +15,13 @@ namespace MapEditor
 		PropertyChangeUS(MapObject* object);
 		~PropertyChangeUS();
 
-		void doSwap(MapObject* obj);
-		bool doUndo();
-		bool doRedo();
+		void	doSwap(MapObject* obj);
+		bool	doUndo();
+		bool	doRedo();
+		bool	writeFile(MemChunk& mc);
+		bool	readFile(MemChunk& mc);
+		size_t	memoryUsage();
+		void	unload();
 
 	private:
 		mobj_backup_t*	backup;
@@ -27,21 +32,22 @@ namespace MapEditor
 	{
 	public:
 		MapObjectCreateDeleteUS();
-		~MapObjectCreateDeleteUS() {}
+		~MapObjectCreateDeleteUS();
 
-		bool isValid(vector<unsigned>& list) { return !(list.size() == 1 && list[0] == 0); }
-		void swapLists();
-		bool doUndo();
-		bool doRedo();
-		void checkChanges();
-		bool isOk();
+		void	updateMap();
+		bool	doUndo();
+		bool	doRedo();
+		void	checkChanges();
+		bool	isOk() { return !changes.empty(); }
+		bool	writeFile(MemChunk& mc);
+		bool	readFile(MemChunk& mc);
+		size_t	memoryUsage();
+		void	unload();
 
 	private:
-		vector<unsigned>	vertices;
-		vector<unsigned>	lines;
-		vector<unsigned>	sides;
-		vector<unsigned>	sectors;
-		vector<unsigned>	things;
+		// Only the objects actually created or deleted (in order) are
+		// recorded, not the whole map
+		vector<mobj_cd_t>	changes;
 	};
 
 	// UndoStep for when multiple MapObjects have properties changed
@@ -51,10 +57,14 @@ namespace MapEditor
 		MultiMapObjectPropertyChangeUS();
 		~MultiMapObjectPropertyChangeUS();
 
-		void doSwap(MapObject* obj, unsigned index);
-		bool doUndo();
-		bool doRedo();
-		bool isOk() { return !backups.empty(); }
+		void	doSwap(MapObject* obj, unsigned index);
+		bool	doUndo();
+		bool	doRedo();
+		bool	isOk() { return !backups.empty(); }
+		bool	writeFile(MemChunk& mc);
+		bool	readFile(MemChunk& mc);
+		size_t	memoryUsage();
+		void	unload();
 
 	private:
 		vector<mobj_backup_t*>	backups;
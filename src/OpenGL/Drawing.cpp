@@ -29,10 +29,14 @@
  *******************************************************************/
 #include "Main.h"
 #include "Drawing.h"
+#include "GLFont.h"
+#include "GLQuadBatch.h"
 #include "GLTexture.h"
+#include "GLTextureAtlas.h"
 #include "Archive/ArchiveManager.h"
 #include "General/Console/Console.h"
 #include "Utility/MathStuff.h"
+#include "Utility/Profiler.h"
 #include "General/Misc.h"
 #include "OpenGL.h"
 
@@ -57,6 +61,7 @@ CVAR(Bool, hud_center, 1, CVAR_SAVE)
 CVAR(Bool, hud_wide, 0, CVAR_SAVE)
 CVAR(Bool, hud_bob, 0, CVAR_SAVE)
 CVAR(Int, gl_font_size, 12, CVAR_SAVE)
+CVAR(Bool, gl_text_batching, true, CVAR_SAVE)
 
 namespace Drawing
 {
@@ -66,6 +71,12 @@ namespace Drawing
 #endif
 	double				text_outline_width = 0;
 	rgba_t				text_outline_colour = COL_BLACK;
+
+	// Text batching
+	GLTextureAtlas*		glyph_atlas = NULL;
+	vector<GLFont*>		batch_fonts;
+	GLQuadBatch			text_batch;
+	int					text_batch_depth = 0;
 };
 
 
@@ -335,6 +346,13 @@ FTFont* FontManager::getFont(int font)
 void Drawing::initFonts()
 {
 	theFontManager->initFonts();
+
+	// Clear batch fonts (they will be reloaded at the current size when needed)
+	for (unsigned a = 0; a < batch_fonts.size(); a++)
+		delete batch_fonts[a];
+	batch_fonts.clear();
+	if (glyph_atlas)
+		glyph_atlas->clear();
 }
 
 /* Drawing::drawLine
@@ -630,6 +648,138 @@ void Drawing::drawTextureWithin(GLTexture* tex, double x1, double y1, double x2,
 	glPopMatrix();
 }
 
+/*******************************************************************
+ * TEXT BATCHING FUNCTIONS
+ *******************************************************************/
+
+/* getBatchFont
+ * Returns the GLFont for [font] to lay out batched text with,
+ * loading it if needed. Returns NULL if the font couldn't be loaded
+ *******************************************************************/
+static GLFont* getBatchFont(int font)
+{
+	using namespace Drawing;
+
+	if (font < 0 || font > FONT_SMALL)
+		font = FONT_NORMAL;
+
+	// Load fonts if needed
+	if (batch_fonts.empty())
+	{
+		if (!glyph_atlas)
+			glyph_atlas = new GLTextureAtlas(512, 128);
+
+		// Same fonts and sizes as the FontManager uses
+		const char* files[] = { "dejavu_sans", "dejavu_sans_c", "dejavu_sans_b", "dejavu_sans_cb", "dejavu_mono", "dejavu_sans" };
+		for (int a = 0; a <= FONT_SMALL; a++)
+		{
+			GLFont* f = new GLFont(glyph_atlas);
+			int size = (a == FONT_SMALL) ? (gl_font_size * 0.6) + 1 : gl_font_size;
+			ArchiveEntry* entry = App::archiveManager().programResourceArchive()->entryAtPath(S_FMT("fonts/%s.ttf", files[a]));
+			if (entry)
+				f->open(entry->getData(), entry->getSize(), size);
+			batch_fonts.push_back(f);
+		}
+	}
+
+	if (!batch_fonts[font]->isLoaded())
+		return NULL;
+	return batch_fonts[font];
+}
+
+/* addRunQuads
+ * Adds quads for the glyphs in [run] at [x,y] to the text batch
+ *******************************************************************/
+static void addRunQuads(GLFont::run_t& run, float x, float y)
+{
+	for (unsigned a = 0; a < run.quads.size(); a++)
+	{
+		GLFont::glyph_quad_t& glyph = run.quads[a];
+		frect_t tc = glyph.tex->texCoords();
+		GLQuadBatch::vertex_t* quad = Drawing::text_batch.addQuad(glyph.tex);
+		quad[0].set(x + glyph.x1, y + glyph.y1, 0, tc.x1(), tc.y1());
+		quad[1].set(x + glyph.x1, y + glyph.y2, 0, tc.x1(), tc.y2());
+		quad[2].set(x + glyph.x2, y + glyph.y2, 0, tc.x2(), tc.y2());
+		quad[3].set(x + glyph.x2, y + glyph.y1, 0, tc.x2(), tc.y1());
+	}
+}
+
+/* addBatchText
+ * Adds [text] to the text batch, with the same layout as drawText.
+ * Returns false if the text can't be batched
+ *******************************************************************/
+static bool addBatchText(string& text, int x, int y, rgba_t colour, int font, int alignment, frect_t* bounds)
+{
+	using namespace Drawing;
+
+	GLFont* f = getBatchFont(font);
+	if (!f)
+		return false;
+	GLFont::run_t& run = f->layout(text);
+
+	// Setup alignment
+	int xpos = x;
+	if (alignment == ALIGN_CENTER)
+		xpos -= MathStuff::round(run.width*0.5);
+	else if (alignment == ALIGN_RIGHT)
+		xpos -= run.width;
+
+	// Set bounds rect
+	if (bounds)
+		bounds->set(xpos + run.left, y, xpos + run.left + run.width, y + f->lineHeight());
+
+	// Add outline (offset copies behind the text)
+	float tx = xpos - 0.375f;
+	float ty = y - 0.375f;
+	if (text_outline_width > 0)
+	{
+		static const float offsets[4][2] = { { -2, 1 }, { -2, -1 }, { 2, -1 }, { 2, 1 } };
+		text_batch.setColour(text_outline_colour.fr(), text_outline_colour.fg(), text_outline_colour.fb(), text_outline_colour.fa());
+		for (unsigned a = 0; a < 4; a++)
+			addRunQuads(run, tx + offsets[a][0], ty + offsets[a][1]);
+	}
+
+	// Add text
+	text_batch.setColour(colour.fr(), colour.fg(), colour.fb(), colour.fa());
+	addRunQuads(run, tx, ty);
+
+	return true;
+}
+
+/* Drawing::beginTextBatch
+ * Starts batching text. Until the matching endTextBatch call, text
+ * drawn with drawText is laid out from glyph atlas fonts and added
+ * to a single batch instead of being drawn immediately, so it must
+ * be drawn with the same projection/modelview as at endTextBatch.
+ * Batches can be nested, only the outermost endTextBatch draws
+ *******************************************************************/
+void Drawing::beginTextBatch()
+{
+	if (gl_text_batching)
+		text_batch_depth++;
+}
+
+/* Drawing::endTextBatch
+ * Ends text batching (see beginTextBatch), drawing all batched text
+ * with one draw call per font atlas page
+ *******************************************************************/
+void Drawing::endTextBatch()
+{
+	if (text_batch_depth == 0 || --text_batch_depth > 0)
+		return;
+
+	if (text_batch.isEmpty())
+		return;
+
+	PROFILE_SCOPE("Text");
+	bool tex_enabled = glIsEnabled(GL_TEXTURE_2D) != 0;
+	glEnable(GL_TEXTURE_2D);
+	text_batch.draw();
+	text_batch.clear();
+	if (!tex_enabled)
+		glDisable(GL_TEXTURE_2D);
+}
+
 #ifdef USE_SFML_RENDERWINDOW
 /*******************************************************************
  * SFML 2.x TEXT FUNCTION IMPLEMENTATIONS
@@ -641,6 +791,10 @@ void Drawing::drawTextureWithin(GLTexture* tex, double x1, double y1, double x2,
  *******************************************************************/
 void Drawing::drawText(string text, int x, int y, rgba_t colour, int font, int alignment, frect_t* bounds)
 {
+	// Add to text batch if batching
+	if (text_batch_depth > 0 && addBatchText(text, x, y, colour, font, alignment, bounds))
+		return;
+
 	// Setup SFML string
 	sf::Text sf_str;
 	sf_str.setString(UTF8(text));
@@ -728,6 +882,11 @@ void Drawing::drawText(string text, int x, int y, rgba_t colour, int font, int a
  *******************************************************************/
 fpoint2_t Drawing::textExtents(string text, int font)
 {
+	// Use the batch font if batching, so extents match what is drawn
+	GLFont* f = (text_batch_depth > 0) ? getBatchFont(font) : NULL;
+	if (f)
+		return fpoint2_t(f->layout(text).width, f->lineHeight());
+
 	// Setup SFML string
 	sf::Text sf_str;
 	sf_str.setString(CHR(text));
@@ -756,6 +915,10 @@ fpoint2_t Drawing::textExtents(string text, int font)
  *******************************************************************/
 void Drawing::drawText(string text, int x, int y, rgba_t colour, int font, int alignment, frect_t* bounds)
 {
+	// Add to text batch if batching
+	if (text_batch_depth > 0 && addBatchText(text, x, y, colour, font, alignment, bounds))
+		return;
+
 	// Get desired font
 	FTFont* ftgl_font = theFontManager->getFont(font);
 
@@ -813,6 +976,11 @@ void Drawing::drawText(string text, int x, int y, rgba_t colour, int font, int a
  *******************************************************************/
 fpoint2_t Drawing::textExtents(string text, int font)
 {
+	// Use the batch font if batching, so extents match what is drawn
+	GLFont* f = (text_batch_depth > 0) ? getBatchFont(font) : NULL;
+	if (f)
+		return fpoint2_t(f->layout(text).width, f->lineHeight());
+
 	// Get desired font
 	FTFont* ftgl_font = theFontManager->getFont(font);
 
@@ -1146,6 +1314,7 @@ void TextBox::draw(int x, int y, rgba_t colour, int alignment)
 	frect_t b;
 	Drawing::enableTextStateReset(false);
 	Drawing::setTextState(true);
+	Drawing::beginTextBatch();
 	for (unsigned a = 0; a < lines.size(); a++)
 	{
 		Drawing::drawText(lines[a], x, y, colour, font, alignment, &b);
@@ -1155,6 +1324,7 @@ void TextBox::draw(int x, int y, rgba_t colour, int alignment)
 		else
 			y += line_height;
 	}
+	Drawing::endTextBatch();
 	Drawing::enableTextStateReset(true);
 	Drawing::setTextState(false);
 }
@@ -58,6 +58,8 @@ namespace Drawing
 	void enableTextStateReset(bool enable = true);
 	void setTextState(bool set = true);
 	void setTextOutline(double thickness, rgba_t colour = COL_BLACK);
+	void beginTextBatch();
+	void endTextBatch();
 
 	// Specific
 	void drawHud();
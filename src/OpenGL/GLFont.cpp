@@ -0,0 +1,236 @@
+
+/*******************************************************************
+ * SLADE - It's a Doom Editor
+ * Copyright (C) 2008-2014 Simon Judd
+ *
+ * Email:       sirjuddington@gmail.com
+ * Web:         http://slade.mancubus.net
+ * Filename:    GLFont.cpp
+ * Description: GLFont class, renders glyphs with FreeType into a
+ *              texture atlas and lays out text as glyph quads, for
+ *              drawing lots of text in a single batch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *******************************************************************/
+
+
+/*******************************************************************
+ * INCLUDES
+ *******************************************************************/
+#include "Main.h"
+#include "GLFont.h"
+#include "GLTexture.h"
+#include "GLTextureAtlas.h"
+#include "Graphics/SImage/SImage.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+namespace
+{
+	FT_Library	ft_library = NULL;
+
+	// Laid out runs are cleared once there are this many cached
+	const unsigned RUN_CACHE_SIZE = 4096;
+}
+
+
+/*******************************************************************
+ * GLFONT CLASS FUNCTIONS
+ *******************************************************************/
+
+/* GLFont::GLFont
+ * GLFont class constructor. Glyphs are packed into [atlas]
+ *******************************************************************/
+GLFont::GLFont(GLTextureAtlas* atlas)
+{
+	this->atlas = atlas;
+	face = NULL;
+	pixel_size = 0;
+	line_height = 0;
+}
+
+/* GLFont::~GLFont
+ * GLFont class destructor
+ *******************************************************************/
+GLFont::~GLFont()
+{
+	clear();
+}
+
+/* GLFont::open
+ * Opens the font from [size] bytes of font file [data], with glyphs
+ * [pixel_size] pixels high. Returns false if the font couldn't be
+ * opened
+ *******************************************************************/
+bool GLFont::open(const uint8_t* data, unsigned size, int pixel_size)
+{
+	clear();
+
+	// Init FreeType if needed
+	if (!ft_library && FT_Init_FreeType(&ft_library) != 0)
+	{
+		ft_library = NULL;
+		return false;
+	}
+
+	// Open face (FreeType reads from the data as needed, so keep a copy)
+	this->data.importMem(data, size);
+	if (FT_New_Memory_Face(ft_library, this->data.getData(), size, 0, &face) != 0)
+	{
+		face = NULL;
+		return false;
+	}
+	FT_Set_Pixel_Sizes(face, 0, pixel_size);
+
+	this->pixel_size = pixel_size;
+	line_height = (face->size->metrics.height + 63) >> 6;
+
+	return true;
+}
+
+/* GLFont::clear
+ * Closes the font and deletes all glyph textures (their space in the
+ * atlas isn't reclaimed until the atlas itself is cleared)
+ *******************************************************************/
+void GLFont::clear()
+{
+	for (auto i = glyphs.begin(); i != glyphs.end(); ++i)
+		delete i->second.tex;
+	glyphs.clear();
+	runs.clear();
+
+	if (face)
+	{
+		FT_Done_Face(face);
+		face = NULL;
+	}
+	data.clear();
+}
+
+/* GLFont::getGlyph
+ * Returns the glyph for character [c], rendering it into the atlas
+ * if it hasn't been used yet
+ *******************************************************************/
+GLFont::glyph_t& GLFont::getGlyph(uint32_t c)
+{
+	auto i = glyphs.find(c);
+	if (i != glyphs.end())
+		return i->second;
+
+	glyph_t& glyph = glyphs[c];
+	glyph.tex = NULL;
+	glyph.left = glyph.top = 0;
+	glyph.width = glyph.height = 0;
+	glyph.advance = 0;
+	glyph.index = FT_Get_Char_Index(face, c);
+
+	// Render glyph
+	if (FT_Load_Glyph(face, glyph.index, FT_LOAD_RENDER) != 0)
+		return glyph;
+	FT_GlyphSlot slot = face->glyph;
+	FT_Bitmap& bitmap = slot->bitmap;
+	glyph.advance = slot->advance.x / 64.0f;
+	glyph.left = slot->bitmap_left;
+	glyph.top = slot->bitmap_top;
+	glyph.width = bitmap.width;
+	glyph.height = bitmap.rows;
+	if (glyph.width <= 0 || glyph.height <= 0 || bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
+		return glyph;
+
+	// Add to atlas (white, with the glyph coverage as alpha)
+	uint8_t* pixels = new uint8_t[glyph.width * glyph.height * 4];
+	for (int y = 0; y < glyph.height; y++)
+	{
+		const uint8_t* src = bitmap.buffer + y * bitmap.pitch;
+		uint8_t* dest = pixels + y * glyph.width * 4;
+		for (int x = 0; x < glyph.width; x++)
+		{
+			dest[x * 4] = dest[x * 4 + 1] = dest[x * 4 + 2] = 255;
+			dest[x * 4 + 3] = src[x];
+		}
+	}
+	SImage image;
+	image.setImageData(pixels, glyph.width, glyph.height, RGBA);
+	glyph.tex = atlas->addImage(&image);
+
+	return glyph;
+}
+
+/* GLFont::layout
+ * Returns the glyph quads for [text], laying it out if it isn't in
+ * the run cache
+ *******************************************************************/
+GLFont::run_t& GLFont::layout(string text)
+{
+	auto i = runs.find(text);
+	if (i != runs.end())
+		return i->second;
+
+	if (runs.size() >= RUN_CACHE_SIZE)
+		runs.clear();
+
+	run_t& run = runs[text];
+	run.left = 0;
+	run.width = 0;
+	if (!face)
+		return run;
+
+	// Add quads for each glyph, with the baseline [pixel_size] below the top
+	bool kerning = FT_HAS_KERNING(face) != 0;
+	float pen = 0;
+	float ink_left = 0;
+	float ink_right = 0;
+	unsigned prev = 0;
+	for (string::const_iterator c = text.begin(); c != text.end(); ++c)
+	{
+		glyph_t& glyph = getGlyph((*c).GetValue());
+
+		// Apply kerning
+		if (kerning && prev && glyph.index)
+		{
+			FT_Vector delta;
+			FT_Get_Kerning(face, prev, glyph.index, FT_KERNING_DEFAULT, &delta);
+			pen += delta.x / 64.0f;
+		}
+
+		if (glyph.tex)
+		{
+			glyph_quad_t quad;
+			quad.tex = glyph.tex;
+			quad.x1 = floor(pen + 0.5f) + glyph.left;
+			quad.y1 = pixel_size - glyph.top;
+			quad.x2 = quad.x1 + glyph.width;
+			quad.y2 = quad.y1 + glyph.height;
+
+			if (run.quads.empty() || quad.x1 < ink_left)
+				ink_left = quad.x1;
+			if (run.quads.empty() || quad.x2 > ink_right)
+				ink_right = quad.x2;
+			run.quads.push_back(quad);
+		}
+
+		pen += glyph.advance;
+		prev = glyph.index;
+	}
+
+	run.left = ink_left;
+	run.width = ink_right - ink_left;
+
+	return run;
+}
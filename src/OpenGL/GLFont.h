@@ -0,0 +1,63 @@
+
+#ifndef __GLFONT_H__
+#define __GLFONT_H__
+
+typedef struct FT_FaceRec_* FT_Face;
+
+class GLTexture;
+class GLTextureAtlas;
+
+// A font rendered with FreeType, with glyphs packed into a (shared)
+// GLTextureAtlas as they are first needed. Strings are laid out into
+// runs of glyph quads, which are cached so that strings drawn every
+// frame (eg. labels) don't need to be laid out again
+class GLFont
+{
+public:
+	struct glyph_quad_t
+	{
+		GLTexture*	tex;	// Atlas region for the glyph
+		float		x1, y1, x2, y2;
+	};
+
+	struct run_t
+	{
+		vector<glyph_quad_t>	quads;	// Relative to the top-left of the text
+		float					left;	// Left of the text's ink
+		float					width;	// Width of the text's ink
+	};
+
+	GLFont(GLTextureAtlas* atlas);
+	~GLFont();
+
+	bool	isLoaded() { return face != NULL; }
+	int		lineHeight() { return line_height; }
+
+	bool	open(const uint8_t* data, unsigned size, int pixel_size);
+	void	clear();
+	run_t&	layout(string text);
+
+private:
+	struct glyph_t
+	{
+		GLTexture*	tex;	// NULL if the glyph is blank (eg. space)
+		int			left;
+		int			top;
+		int			width;
+		int			height;
+		float		advance;
+		unsigned	index;
+	};
+
+	GLTextureAtlas*				atlas;
+	FT_Face						face;
+	MemChunk					data;
+	int							pixel_size;
+	int							line_height;
+	std::map<uint32_t, glyph_t>	glyphs;
+	std::map<string, run_t>		runs;
+
+	glyph_t&	getGlyph(uint32_t c);
+};
+
+#endif//__GLFONT_H__
@@ -0,0 +1,256 @@
+
+/*******************************************************************
+ * SLADE - It's a Doom Editor
+ * Copyright (C) 2008-2014 Simon Judd
+ *
+ * Email:       sirjuddington@gmail.com
+ * Web:         http://slade.mancubus.net
+ * Filename:    GLQuadBatch.cpp
+ * Description: GLQuadBatch class, collects textured quads grouped by
+ *              texture and draws each group with a single
+ *              glDrawArrays call from client-side vertex arrays
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *******************************************************************/
+
+
+/*******************************************************************
+ * INCLUDES
+ *******************************************************************/
+#include "Main.h"
+#include "GLQuadBatch.h"
+#include "GLTexture.h"
+#include "OpenGL.h"
+#include "Utility/MathStuff.h"
+
+
+/*******************************************************************
+ * GLQUADBATCH CLASS FUNCTIONS
+ *******************************************************************/
+
+/* GLQuadBatch::GLQuadBatch
+ * GLQuadBatch class constructor
+ *******************************************************************/
+GLQuadBatch::GLQuadBatch()
+{
+	last_group = 0;
+	n_quads = 0;
+	key = 0;
+	setColour(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+/* GLQuadBatch::~GLQuadBatch
+ * GLQuadBatch class destructor
+ *******************************************************************/
+GLQuadBatch::~GLQuadBatch()
+{
+}
+
+/* GLQuadBatch::setColour
+ * Sets the colour of any quads added after this
+ *******************************************************************/
+void GLQuadBatch::setColour(float r, float g, float b, float a)
+{
+	colour[0] = r;
+	colour[1] = g;
+	colour[2] = b;
+	colour[3] = a;
+}
+
+/* GLQuadBatch::addQuad
+ * Adds a quad using [tex] (or untextured if [tex] is null) to the
+ * group for [tex] and the current key. Returns a pointer to the quad's 4
+ * vertices, which have their colour set but their position and
+ * texture coordinates need to be set by the caller
+ *******************************************************************/
+GLQuadBatch::vertex_t* GLQuadBatch::addQuad(GLTexture* tex)
+{
+	unsigned id = tex ? tex->glId() : 0;
+
+	// Find group (usually the same as the last quad added)
+	if (last_group >= groups.size() || groups[last_group].tex != id || groups[last_group].key != key)
+	{
+		last_group = 0;
+		while (last_group < groups.size() && (groups[last_group].tex != id || groups[last_group].key != key))
+			last_group++;
+
+		// Add new group if needed
+		if (last_group == groups.size())
+		{
+			group_t group;
+			group.tex = id;
+			group.key = key;
+			groups.push_back(group);
+		}
+	}
+
+	// Add quad vertices
+	vector<vertex_t>& vertices = groups[last_group].vertices;
+	vertices.resize(vertices.size() + 4);
+	vertex_t* quad = &vertices[vertices.size() - 4];
+	for (unsigned a = 0; a < 4; a++)
+	{
+		quad[a].z = 0.0f;
+		quad[a].r = colour[0];
+		quad[a].g = colour[1];
+		quad[a].b = colour[2];
+		quad[a].a = colour[3];
+	}
+
+	n_quads++;
+	return quad;
+}
+
+/* GLQuadBatch::addRect
+ * Adds a 2d rectangle using [tex], centered at [x,y] with half-size
+ * [hw,hh] and texture coordinates [tc], rotated [angle] degrees
+ * anticlockwise about its centre. The bottom of the rectangle uses
+ * the bottom of [tc] (ie. the image is drawn upright in map space)
+ *******************************************************************/
+void GLQuadBatch::addRect(GLTexture* tex, double x, double y, double hw, double hh, frect_t tc, double angle)
+{
+	vertex_t* quad = addQuad(tex);
+
+	// Get corner offsets, rotated if needed
+	double cx[4] = { -hw, -hw, hw, hw };
+	double cy[4] = { -hh, hh, hh, -hh };
+	if (angle != 0)
+	{
+		double rad = angle * (PI / 180.0);
+		double c = cos(rad);
+		double s = sin(rad);
+		for (unsigned a = 0; a < 4; a++)
+		{
+			double rx = cx[a] * c - cy[a] * s;
+			cy[a] = cx[a] * s + cy[a] * c;
+			cx[a] = rx;
+		}
+	}
+
+	quad[0].set(x + cx[0], y + cy[0], 0, tc.x1(), tc.y2());
+	quad[1].set(x + cx[1], y + cy[1], 0, tc.x1(), tc.y1());
+	quad[2].set(x + cx[2], y + cy[2], 0, tc.x2(), tc.y1());
+	quad[3].set(x + cx[3], y + cy[3], 0, tc.x2(), tc.y2());
+}
+
+/* GLQuadBatch::clear
+ * Removes all quads from the batch. Groups that were used are kept
+ * (with their memory) for the next time the batch is built
+ *******************************************************************/
+void GLQuadBatch::clear()
+{
+	unsigned used = 0;
+	for (unsigned a = 0; a < groups.size(); a++)
+	{
+		if (groups[a].vertices.empty())
+			continue;
+
+		if (used != a)
+			groups[used].vertices.swap(groups[a].vertices);
+		groups[used].tex = groups[a].tex;
+		groups[used].key = groups[a].key;
+		groups[used].vertices.clear();
+		used++;
+	}
+	groups.resize(used);
+
+	key = 0;
+	last_group = 0;
+	n_quads = 0;
+}
+
+/* GLQuadBatch::beginDraw
+ * Sets up vertex arrays for drawing
+ *******************************************************************/
+void GLQuadBatch::beginDraw()
+{
+	// Vertex arrays are client-side, so make sure no VBO is bound
+	if (OpenGL::vboSupport())
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+}
+
+/* GLQuadBatch::endDraw
+ * Restores vertex array state after drawing
+ *******************************************************************/
+void GLQuadBatch::endDraw()
+{
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+}
+
+/* GLQuadBatch::drawVertices
+ * Binds [group]'s texture and draws its quads
+ *******************************************************************/
+void GLQuadBatch::drawVertices(group_t& group)
+{
+	if (group.vertices.empty())
+		return;
+
+	// Bind texture (or disable texturing for untextured quads)
+	if (group.tex > 0)
+		glBindTexture(GL_TEXTURE_2D, group.tex);
+	else
+		glDisable(GL_TEXTURE_2D);
+
+	// Draw
+	vertex_t* data = &group.vertices[0];
+	glVertexPointer(3, GL_FLOAT, sizeof(vertex_t), &data->x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(vertex_t), &data->u);
+	glColorPointer(4, GL_FLOAT, sizeof(vertex_t), &data->r);
+	glDrawArrays(GL_QUADS, 0, group.vertices.size());
+
+	if (group.tex == 0)
+		glEnable(GL_TEXTURE_2D);
+}
+
+/* GLQuadBatch::draw
+ * Draws all quads in the batch, one group at a time in key order.
+ * GL_TEXTURE_2D should be enabled beforehand
+ *******************************************************************/
+void GLQuadBatch::draw()
+{
+	if (n_quads == 0)
+		return;
+
+	// Get group draw order
+	vector<unsigned> order(groups.size());
+	for (unsigned a = 0; a < groups.size(); a++)
+		order[a] = a;
+	std::stable_sort(order.begin(), order.end(), [&](unsigned l, unsigned r) { return groups[l].key < groups[r].key; });
+
+	beginDraw();
+	for (unsigned a = 0; a < order.size(); a++)
+		drawVertices(groups[order[a]]);
+	endDraw();
+}
+
+/* GLQuadBatch::drawGroup
+ * Draws quads in the group at [index] only, for when some other
+ * state (identified by the group key) needs to be set up per group
+ *******************************************************************/
+void GLQuadBatch::drawGroup(unsigned index)
+{
+	if (index >= groups.size())
+		return;
+
+	beginDraw();
+	drawVertices(groups[index]);
+	endDraw();
+}
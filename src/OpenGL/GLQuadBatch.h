@@ -0,0 +1,68 @@
+
+#ifndef __GLQUAD_BATCH_H__
+#define __GLQUAD_BATCH_H__
+
+class GLTexture;
+
+// Collects textured, coloured quads grouped by OpenGL texture (and a
+// caller-defined key), so that large numbers of small quads (eg. thing
+// sprites) can be drawn with one glDrawArrays call per group rather
+// than a glBegin/glEnd (and texture bind) per quad. Groups are drawn
+// in key order, so keys can be used as layers. Quads within a group
+// are drawn in the order they were added
+class GLQuadBatch
+{
+public:
+	struct vertex_t
+	{
+		float	x, y, z;
+		float	u, v;
+		float	r, g, b, a;
+
+		void set(float x, float y, float z, float u, float v)
+		{
+			this->x = x;
+			this->y = y;
+			this->z = z;
+			this->u = u;
+			this->v = v;
+		}
+	};
+
+	GLQuadBatch();
+	~GLQuadBatch();
+
+	unsigned	nQuads() { return n_quads; }
+	unsigned	nGroups() { return groups.size(); }
+	unsigned	groupKey(unsigned index) { return groups[index].key; }
+	bool		isEmpty() { return n_quads == 0; }
+
+	void		setColour(float r, float g, float b, float a);
+	void		setKey(unsigned key) { this->key = key; }
+	vertex_t*	addQuad(GLTexture* tex);
+	void		addRect(GLTexture* tex, double x, double y, double hw, double hh, frect_t tc, double angle = 0);
+	void		clear();
+
+	void		draw();
+	void		drawGroup(unsigned index);
+
+private:
+	struct group_t
+	{
+		unsigned			tex;
+		unsigned			key;
+		vector<vertex_t>	vertices;
+	};
+
+	vector<group_t>	groups;
+	unsigned		last_group;
+	unsigned		n_quads;
+	float			colour[4];
+	unsigned		key;
+
+	void	beginDraw();
+	void	endDraw();
+	void	drawVertices(group_t& group);
+};
+
+#endif//__GLQUAD_BATCH_H__
@@ -57,6 +57,8 @@ GLTexture::GLTexture(bool allow_split)
 	this->tiling = true;
 	this->scale_x = 1.0;
 	this->scale_y = 1.0;
+	this->atlased = false;
+	this->tex_coords.set(0, 0, 1, 1);
 }
 
 /* GLTexture::~GLTexture
@@ -361,20 +363,52 @@ bool GLTexture::loadImagePortion(SImage* image, rect_t rect, Palette8bit* pal, b
 	return loadData(portion.getData(), rect.width(), rect.height(), add);
 }
 
+/* GLTexture::loadAtlasRegion
+ * Sets the texture up as a [width]x[height] region of the atlas page
+ * texture [page], at [tex_coords] within the page. The page itself
+ * is owned by the atlas and won't be deleted when this texture is
+ * cleared
+ *******************************************************************/
+bool GLTexture::loadAtlasRegion(gl_tex_t page, uint32_t width, uint32_t height, frect_t tex_coords)
+{
+	// Check page is valid
+	if (page.id == 0)
+		return false;
+
+	// Clear current texture
+	clear();
+
+	// Update variables
+	tex.push_back(page);
+	this->width = width;
+	this->height = height;
+	this->tex_coords = tex_coords;
+	tiling = false;
+	atlased = true;
+	loaded = true;
+
+	return true;
+}
+
 /* GLTexture::clear
  * Clears the texture and resets variables
  *******************************************************************/
 bool GLTexture::clear()
 {
-	// Delete texture(s)
-	for (size_t a = 0; a < tex.size(); a++)
-		glDeleteTextures(1, &tex[a].id);
+	// Delete texture(s) (atlas pages belong to the atlas)
+	if (!atlased)
+	{
+		for (size_t a = 0; a < tex.size(); a++)
+			glDeleteTextures(1, &tex[a].id);
+	}
 	tex.clear();
 
 	// Reset variables
 	width = 0;
 	height = 0;
 	loaded = false;
+	atlased = false;
+	tex_coords.set(0, 0, 1, 1);
 	scale_x = scale_y = 1.0;
 
 	return true;
@@ -478,7 +512,7 @@ bool GLTexture::draw2d(double x, double y, bool flipx, bool flipy)
 		y += height;
 
 	// If the texture isn't split, just draw it straight
-	if (OpenGL::validTexDimension(width) && OpenGL::validTexDimension(height))
+	if (atlased || (OpenGL::validTexDimension(width) && OpenGL::validTexDimension(height)))
 	{
 		// Bind the texture
 		glBindTexture(GL_TEXTURE_2D, tex[0].id);
@@ -495,10 +529,10 @@ bool GLTexture::draw2d(double x, double y, bool flipx, bool flipy)
 
 		// Draw
 		glBegin(GL_QUADS);
-		glTexCoord2d(0, 0);	glVertex2d(0, 0);
-		glTexCoord2d(0, 1);	glVertex2d(0, v);
-		glTexCoord2d(1, 1);	glVertex2d(h, v);
-		glTexCoord2d(1, 0); glVertex2d(h, 0);
+		glTexCoord2d(tex_coords.x1(), tex_coords.y1());	glVertex2d(0, 0);
+		glTexCoord2d(tex_coords.x1(), tex_coords.y2());	glVertex2d(0, v);
+		glTexCoord2d(tex_coords.x2(), tex_coords.y2());	glVertex2d(h, v);
+		glTexCoord2d(tex_coords.x2(), tex_coords.y1());	glVertex2d(h, 0);
 		glEnd();
 
 		glPopMatrix();
@@ -625,7 +659,16 @@ rgba_t GLTexture::averageColour(rect_t area)
 	if ((unsigned)area.br.y > height)	area.br.y = height;
 
 	// Get texture pixels
-	uint8_t* pixels = new uint8_t[width*height*8];
+	uint32_t tex_width = width;
+	if (atlased)
+	{
+		// Offset area to the region within the atlas page
+		int ox = tex_coords.x1() * tex[0].width;
+		int oy = tex_coords.y1() * tex[0].height;
+		area.set(area.tl.x + ox, area.tl.y + oy, area.br.x + ox, area.br.y + oy);
+		tex_width = tex[0].width;
+	}
+	uint8_t* pixels = new uint8_t[tex[0].width*tex[0].height*8];
 	glBindTexture(GL_TEXTURE_2D, tex[0].id);
 	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
 
@@ -640,7 +683,7 @@ rgba_t GLTexture::averageColour(rect_t area)
 		for (int x = area.tl.x; x < area.br.x; x++)
 		{
 			// Add pixel
-			unsigned c = (y * width * 4) + (x * 4);
+			unsigned c = (y * tex_width * 4) + (x * 4);
 			red += pixels[c++];
 			green += pixels[c++];
 			blue += pixels[c++];
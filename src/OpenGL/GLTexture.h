@@ -24,6 +24,8 @@ private:
 	bool				tiling;
 	double				scale_x;
 	double				scale_y;
+	bool				atlased;
+	frect_t				tex_coords;
 
 	// Some generic/global textures
 	static GLTexture	tex_background;	// Checkerboard background texture
@@ -56,6 +58,8 @@ public:
 	double		getScaleY() { return scale_y; }
 	bool		isTiling() { return tiling; }
 	unsigned	glId() { if (!tex.empty()) return tex[0].id; else return 0; }
+	bool		isAtlased() { return atlased; }
+	frect_t		texCoords() { return tex_coords; }
 
 	void		setFilter(int filter) { this->filter = filter; }
 	void		setTiling(bool tiling) { this->tiling = tiling; }
@@ -63,6 +67,7 @@ public:
 
 	bool	loadImage(SImage* image, Palette8bit* pal = NULL);
 	bool	loadRawData(const uint8_t* data, uint32_t width, uint32_t height);
+	bool	loadAtlasRegion(gl_tex_t page, uint32_t width, uint32_t height, frect_t tex_coords);
 
 	bool	clear();
 	bool	genChequeredTexture(uint8_t block_size, rgba_t col1, rgba_t col2);
@@ -0,0 +1,266 @@
+
+/*******************************************************************
+ * SLADE - It's a Doom Editor
+ * Copyright (C) 2008-2014 Simon Judd
+ *
+ * Email:       sirjuddington@gmail.com
+ * Web:         http://slade.mancubus.net
+ * Filename:    GLTextureAtlas.cpp
+ * Description: Packs small images (eg. thing sprites) into shared
+ *              OpenGL 'page' textures. Each packed image is given
+ *              back as a GLTexture referencing a region of a page,
+ *              so renderers can batch anything sharing a page
+ *              without rebinding
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *******************************************************************/
+
+
+/*******************************************************************
+ * INCLUDES
+ *******************************************************************/
+#include "Main.h"
+#include "GLTextureAtlas.h"
+#include "OpenGL.h"
+#include "Graphics/SImage/SImage.h"
+
+
+/*******************************************************************
+ * GLTEXTUREATLAS CLASS FUNCTIONS
+ *******************************************************************/
+
+/* GLTextureAtlas::GLTextureAtlas
+ * GLTextureAtlas class constructor. Images larger than [max_size]
+ * in either dimension won't be packed
+ *******************************************************************/
+GLTextureAtlas::GLTextureAtlas(uint32_t page_size, uint32_t max_size)
+{
+	this->page_size = page_size;
+	this->max_size = max_size;
+	this->filter = GLTexture::NEAREST;
+}
+
+/* GLTextureAtlas::~GLTextureAtlas
+ * GLTextureAtlas class destructor
+ *******************************************************************/
+GLTextureAtlas::~GLTextureAtlas()
+{
+	clear();
+}
+
+/* GLTextureAtlas::applyFilter
+ * Applies the current filter to the page texture [id]. Mipmapping
+ * isn't supported for pages (it would bleed between neighbouring
+ * images), so mipmap filters fall back to their non-mipmap
+ * equivalents
+ *******************************************************************/
+void GLTextureAtlas::applyFilter(unsigned id)
+{
+	GLint filter_mag = GL_NEAREST;
+	GLint filter_min = GL_NEAREST;
+	if (filter == GLTexture::LINEAR || filter == GLTexture::MIPMAP || filter == GLTexture::LINEAR_MIPMAP)
+		filter_mag = filter_min = GL_LINEAR;
+	else if (filter == GLTexture::NEAREST_LINEAR_MIN || filter == GLTexture::NEAREST_MIPMAP)
+		filter_min = GL_LINEAR;
+
+	glBindTexture(GL_TEXTURE_2D, id);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_mag);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_min);
+}
+
+/* GLTextureAtlas::setFilter
+ * Sets the filter used for all pages. Existing pages are updated
+ * in place, so textures already packed remain valid
+ *******************************************************************/
+void GLTextureAtlas::setFilter(int filter)
+{
+	if (this->filter == filter)
+		return;
+
+	this->filter = filter;
+	if (pages.empty())
+		return;
+
+	// Keep the current binding intact
+	GLint bound = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound);
+	for (unsigned a = 0; a < pages.size(); a++)
+		applyFilter(pages[a].tex.id);
+	glBindTexture(GL_TEXTURE_2D, bound);
+}
+
+/* GLTextureAtlas::canFit
+ * Returns true if an image of [width]x[height] can be packed into
+ * the atlas
+ *******************************************************************/
+bool GLTextureAtlas::canFit(uint32_t width, uint32_t height)
+{
+	if (width == 0 || height == 0)
+		return false;
+
+	// Leave room for the 1px border around each image
+	uint32_t size = min(page_size, (uint32_t)OpenGL::maxTextureSize());
+	return width <= max_size && height <= max_size && width + 2 <= size && height + 2 <= size;
+}
+
+/* GLTextureAtlas::newPage
+ * Creates a new (empty) page texture. Returns false if the texture
+ * couldn't be created
+ *******************************************************************/
+bool GLTextureAtlas::newPage()
+{
+	if (!OpenGL::isInitialised())
+		return false;
+
+	page_t page;
+	page.tex.width = page.tex.height = min(page_size, (uint32_t)OpenGL::maxTextureSize());
+	page.shelf_x = 0;
+	page.shelf_y = 0;
+	page.shelf_height = 0;
+
+	// Create blank page texture
+	glGenTextures(1, &page.tex.id);
+	if (page.tex.id == 0)
+		return false;
+	glBindTexture(GL_TEXTURE_2D, page.tex.id);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	applyFilter(page.tex.id);
+	vector<uint8_t> blank(page.tex.width * page.tex.height * 4, 0);
+	glTexImage2D(GL_TEXTURE_2D, 0, 4, page.tex.width, page.tex.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, blank.data());
+
+	pages.push_back(page);
+	return true;
+}
+
+/* GLTextureAtlas::findSpace
+ * Finds space for a [width]x[height] block on an existing page,
+ * using simple shelf packing. Returns the page and writes the
+ * block's position to [x,y], or returns NULL if no page has room
+ *******************************************************************/
+GLTextureAtlas::page_t* GLTextureAtlas::findSpace(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y)
+{
+	for (unsigned a = 0; a < pages.size(); a++)
+	{
+		page_t& page = pages[a];
+
+		// Current shelf
+		if (page.shelf_x + width <= page.tex.width && page.shelf_y + max(height, page.shelf_height) <= page.tex.height)
+		{
+			x = page.shelf_x;
+			y = page.shelf_y;
+			page.shelf_x += width;
+			page.shelf_height = max(page.shelf_height, height);
+			return &page;
+		}
+
+		// New shelf below the current one
+		uint32_t top = page.shelf_y + page.shelf_height;
+		if (width <= page.tex.width && top + height <= page.tex.height)
+		{
+			x = 0;
+			y = top;
+			page.shelf_x = width;
+			page.shelf_y = top;
+			page.shelf_height = height;
+			return &page;
+		}
+	}
+
+	return NULL;
+}
+
+/* GLTextureAtlas::addImage
+ * Packs [image] into the atlas and returns a new GLTexture for it
+ * (which the caller is responsible for deleting), or NULL if the
+ * image is invalid or can't be packed
+ *******************************************************************/
+GLTexture* GLTextureAtlas::addImage(SImage* image, Palette8bit* pal)
+{
+	// Check image
+	if (!image || !image->isValid() || !canFit(image->getWidth(), image->getHeight()))
+		return NULL;
+
+	// Keep the current binding intact, so renderers batching by page
+	// don't need to know a page was modified
+	GLint bound = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound);
+
+	// Find space for the image plus a 1px border
+	uint32_t width = image->getWidth();
+	uint32_t height = image->getHeight();
+	uint32_t x, y;
+	page_t* page = findSpace(width + 2, height + 2, x, y);
+	if (!page)
+	{
+		if (newPage())
+			page = findSpace(width + 2, height + 2, x, y);
+		if (!page)
+		{
+			glBindTexture(GL_TEXTURE_2D, bound);
+			return NULL;
+		}
+	}
+
+	// Get RGBA image data
+	MemChunk rgba;
+	image->getRGBAData(rgba, pal);
+	const uint8_t* data = rgba.getData();
+
+	// Build bordered block, duplicating the image's edge pixels into
+	// the border so filtering doesn't pick up neighbouring images
+	uint32_t bw = width + 2;
+	uint32_t bh = height + 2;
+	vector<uint8_t> block(bw * bh * 4);
+	for (uint32_t by = 0; by < bh; by++)
+	{
+		uint32_t sy = by == 0 ? 0 : (by > height ? height - 1 : by - 1);
+		uint8_t* row = &block[by * bw * 4];
+		memcpy(row + 4, data + sy * width * 4, width * 4);
+		memcpy(row, row + 4, 4);
+		memcpy(row + (bw - 1) * 4, row + width * 4, 4);
+	}
+
+	// Upload block to page
+	glBindTexture(GL_TEXTURE_2D, page->tex.id);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, bw, bh, GL_RGBA, GL_UNSIGNED_BYTE, block.data());
+	glBindTexture(GL_TEXTURE_2D, bound);
+
+	// Create region texture
+	double ps_x = page->tex.width;
+	double ps_y = page->tex.height;
+	GLTexture* tex = new GLTexture(false);
+	tex->setFilter(filter);
+	tex->loadAtlasRegion(
+		page->tex,
+		width,
+		height,
+		frect_t((x + 1) / ps_x, (y + 1) / ps_y, (x + 1 + width) / ps_x, (y + 1 + height) / ps_y)
+	);
+
+	return tex;
+}
+
+/* GLTextureAtlas::clear
+ * Deletes all page textures. Any GLTextures previously returned by
+ * addImage should not be used after this
+ *******************************************************************/
+void GLTextureAtlas::clear()
+{
+	for (unsigned a = 0; a < pages.size(); a++)
+		glDeleteTextures(1, &pages[a].tex.id);
+	pages.clear();
+}
@@ -0,0 +1,45 @@
+
+#ifndef __GLTEXTURE_ATLAS_H__
+#define __GLTEXTURE_ATLAS_H__
+
+#include "GLTexture.h"
+
+class SImage;
+class Palette8bit;
+
+// Packs small images into shared 'page' textures, so that anything
+// drawn from the same page can be rendered without rebinding
+class GLTextureAtlas
+{
+private:
+	struct page_t
+	{
+		gl_tex_t	tex;
+		uint32_t	shelf_x;		// Next free x position on the current shelf
+		uint32_t	shelf_y;		// Top of the current shelf
+		uint32_t	shelf_height;	// Height of the current shelf
+	};
+
+	vector<page_t>	pages;
+	uint32_t		page_size;
+	uint32_t		max_size;
+	int				filter;
+
+	page_t*	findSpace(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y);
+	bool	newPage();
+	void	applyFilter(unsigned id);
+
+public:
+	GLTextureAtlas(uint32_t page_size = 1024, uint32_t max_size = 256);
+	~GLTextureAtlas();
+
+	unsigned	nPages() { return pages.size(); }
+	int			getFilter() { return filter; }
+	void		setFilter(int filter);
+
+	bool		canFit(uint32_t width, uint32_t height);
+	GLTexture*	addImage(SImage* image, Palette8bit* pal = NULL);
+	void		clear();
+};
+
+#endif//__GLTEXTURE_ATLAS_H__
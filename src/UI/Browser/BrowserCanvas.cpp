@@ -40,6 +40,8 @@
  *******************************************************************/
 CVAR(Int, browser_bg_type, false, CVAR_SAVE)
 CVAR(Int, browser_item_size, 96, CVAR_SAVE)
+CVAR(Bool, browser_thumb_async, true, CVAR_SAVE)
+CVAR(Int, browser_thumb_upload_ms, 8, CVAR_SAVE)
 DEFINE_EVENT_TYPE(wxEVT_BROWSERCANVAS_SELECTION_CHANGED)
 
 
@@ -63,12 +65,14 @@ BrowserCanvas::BrowserCanvas(wxWindow* parent) : OGLCanvas(parent, -1)
 	item_type = ITEMS_NORMAL;
 	longest_text = -1;
 	num_cols = -1;
+	thumbnails = new BrowserThumbnailLoader(this);
 
 	// Bind events
 	Bind(wxEVT_SIZE, &BrowserCanvas::onSize, this);
 	Bind(wxEVT_MOUSEWHEEL, &BrowserCanvas::onMouseEvent, this);
 	Bind(wxEVT_LEFT_DOWN, &BrowserCanvas::onMouseEvent, this);
 	Bind(wxEVT_KEY_DOWN, &BrowserCanvas::onKeyDown, this);
+	Bind(wxEVT_COMMAND_BROWSER_THUMBNAIL_READY, &BrowserCanvas::onThumbnailReady, this);
 	//Bind(wxEVT_CHAR, &BrowserCanvas::onKeyChar, this);
 }
 
@@ -77,6 +81,8 @@ BrowserCanvas::BrowserCanvas(wxWindow* parent) : OGLCanvas(parent, -1)
  *******************************************************************/
 BrowserCanvas::~BrowserCanvas()
 {
+	delete thumbnails;
+	thumbnails = NULL;
 }
 
 /* BrowserCanvas::getViewedIndex
@@ -213,7 +219,13 @@ void BrowserCanvas::draw()
 	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 	glLineWidth(2.0f);
 
+	// Upload any thumbnails that have finished loading
+	bool thumbs_waiting = false;
+	if (browser_thumb_async)
+		thumbs_waiting = thumbnails->uploadResults(browser_thumb_upload_ms);
+
 	// Draw items
+	int last_drawn = -1;
 	int x = item_border;
 	int y = item_border;
 	int col_width = GetSize().x / num_cols;
@@ -281,7 +293,12 @@ void BrowserCanvas::draw()
 			glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 		}
 
+		// Request thumbnail to be loaded in the background
+		if (browser_thumb_async)
+			thumbnails->request(items[items_filter[a]]);
+
 		// Draw item
+		last_drawn = a;
 		if (item_size <= 0)
 			items[items_filter[a]]->draw(browser_item_size, x, y - yoff, font, show_names, item_type, col_text, text_shadow);
 		else
@@ -300,8 +317,21 @@ void BrowserCanvas::draw()
 		}
 	}
 
+	if (browser_thumb_async && num_cols > 0)
+	{
+		// Prefetch thumbnails for the next page of items
+		unsigned prefetch = (GetSize().y / fullItemSizeY() + 1) * num_cols;
+		for (unsigned a = last_drawn + 1; a < items_filter.size() && a <= last_drawn + prefetch; a++)
+			thumbnails->request(items[items_filter[a]]);
+		thumbnails->submitRequests();
+	}
+
 	// Swap Buffers
 	SwapBuffers();
+
+	// Keep uploading thumbnails if we ran out of time
+	if (thumbs_waiting)
+		Refresh();
 }
 
 /* BrowserCanvas::setScrollBar
@@ -822,3 +852,11 @@ void BrowserCanvas::onKeyChar(wxKeyEvent& e)
 		e.Skip();
 	}
 }
+
+/* BrowserCanvas::onThumbnailReady
+ * Called when thumbnails have finished loading in the background
+ *******************************************************************/
+void BrowserCanvas::onThumbnailReady(wxThreadEvent& e)
+{
+	Refresh();
+}
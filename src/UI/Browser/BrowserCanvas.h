@@ -4,6 +4,7 @@
 
 #include "UI/Canvas/OGLCanvas.h"
 #include "BrowserItem.h"
+#include "BrowserThumbnailLoader.h"
 
 class wxScrollBar;
 class BrowserCanvas : public OGLCanvas
@@ -14,6 +15,7 @@ private:
 	wxScrollBar*			scrollbar;
 	string					search;
 	BrowserItem*			item_selected;
+	BrowserThumbnailLoader*	thumbnails;
 
 	// Display
 	int	yoff;
@@ -64,6 +66,7 @@ public:
 	void					setItemSize(int size) { this->item_size = size; }
 	void					setItemViewType(int type) { this->item_type = type; }
 	int						longestItemTextWidth();
+	BrowserThumbnailLoader*	thumbnailLoader() { return thumbnails; }
 
 	// Events
 	void	onSize(wxSizeEvent& e);
@@ -75,6 +78,7 @@ public:
 	void	onMouseEvent(wxMouseEvent& e);
 	void	onKeyDown(wxKeyEvent& e);
 	void	onKeyChar(wxKeyEvent& e);
+	void	onThumbnailReady(wxThreadEvent& e);
 };
 
 DECLARE_EVENT_TYPE(wxEVT_BROWSERCANVAS_SELECTION_CHANGED, -1)
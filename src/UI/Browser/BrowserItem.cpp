@@ -51,6 +51,11 @@ BrowserItem::BrowserItem(string name, unsigned index, string type)
 	this->image = NULL;
 	this->blank = false;
 	this->text_box = NULL;
+	this->parent = NULL;
+	this->thumbnail = NULL;
+	this->thumb_state = THUMB_NONE;
+	this->thumb_width = 0;
+	this->thumb_height = 0;
 }
 
 /* BrowserItem::~BrowserItem
@@ -60,6 +65,11 @@ BrowserItem::~BrowserItem()
 {
 	if (text_box)
 		delete text_box;
+
+	// Any pending thumbnail request must already have been cancelled
+	// by the browser (see BrowserWindow::clearItems)
+	if (thumbnail)
+		delete thumbnail;
 }
 
 /* BrowserItem::loadImage
@@ -115,42 +125,59 @@ void BrowserItem::draw(int size, int x, int y, int font, int nametype, int viewt
 	if (blank)
 		return;
 
-	// Try to load image if it isn't already
-	if (!image || (image && !image->isLoaded()))
-		loadImage();
-
-	// If it still isn't just draw a red box with an X
-	if (!image || (image && !image->isLoaded()))
+	// Use the thumbnail if it has been loaded in the background
+	GLTexture* tex = image;
+	double width, height;
+	if (thumb_state == THUMB_READY && !imageLoaded())
+	{
+		tex = thumbnail;
+		width = thumb_width;
+		height = thumb_height;
+	}
+	else
 	{
-		glPushAttrib(GL_ENABLE_BIT|GL_CURRENT_BIT);
+		// Thumbnail is still loading, draw nothing for now
+		if (thumb_state == THUMB_PENDING)
+			return;
+
+		// Try to load image if it isn't already
+		if (!imageLoaded())
+			loadImage();
 
-		glColor3f(1, 0, 0);
-		glDisable(GL_TEXTURE_2D);
+		// If it still isn't just draw a red box with an X
+		if (!imageLoaded())
+		{
+			glPushAttrib(GL_ENABLE_BIT|GL_CURRENT_BIT);
 
-		// Outline
-		glBegin(GL_LINE_LOOP);
-		glVertex2i(x, y);
-		glVertex2i(x, y+size);
-		glVertex2i(x+size, y+size);
-		glVertex2i(x+size, y);
-		glEnd();
+			glColor3f(1, 0, 0);
+			glDisable(GL_TEXTURE_2D);
 
-		// X
-		glBegin(GL_LINES);
-		glVertex2i(x, y);
-		glVertex2i(x+size, y+size);
-		glVertex2i(x, y+size);
-		glVertex2i(x+size, y);
-		glEnd();
+			// Outline
+			glBegin(GL_LINE_LOOP);
+			glVertex2i(x, y);
+			glVertex2i(x, y+size);
+			glVertex2i(x+size, y+size);
+			glVertex2i(x+size, y);
+			glEnd();
 
-		glPopAttrib();
+			// X
+			glBegin(GL_LINES);
+			glVertex2i(x, y);
+			glVertex2i(x+size, y+size);
+			glVertex2i(x, y+size);
+			glVertex2i(x+size, y);
+			glEnd();
 
-		return;
-	}
+			glPopAttrib();
 
-	// Determine texture dimensions
-	double width = image->getWidth();
-	double height = image->getHeight();
+			return;
+		}
+
+		// Determine texture dimensions
+		tex = image;
+		width = image->getWidth();
+		height = image->getHeight();
+	}
 
 	// Scale up if size > 128
 	if (size > 128)
@@ -186,14 +213,15 @@ void BrowserItem::draw(int size, int x, int y, int font, int nametype, int viewt
 	double left = x + ((double)size * 0.5) - (width * 0.5);
 
 	// Draw
-	image->bind();
+	frect_t tc = tex->texCoords();
+	tex->bind();
 	OpenGL::setColour(COL_WHITE, false);
 
 	glBegin(GL_QUADS);
-	glTexCoord2f(0.0f, 0.0f);	glVertex2d(left, top);
-	glTexCoord2f(0.0f, 1.0f);	glVertex2d(left, top + height);
-	glTexCoord2f(1.0f, 1.0f);	glVertex2d(left + width, top + height);
-	glTexCoord2f(1.0f, 0.0f);	glVertex2d(left + width, top);
+	glTexCoord2d(tc.x1(), tc.y1());	glVertex2d(left, top);
+	glTexCoord2d(tc.x1(), tc.y2());	glVertex2d(left, top + height);
+	glTexCoord2d(tc.x2(), tc.y2());	glVertex2d(left + width, top + height);
+	glTexCoord2d(tc.x2(), tc.y1());	glVertex2d(left + width, top);
 	glEnd();
 }
 
@@ -203,4 +231,36 @@ void BrowserItem::draw(int size, int x, int y, int font, int nametype, int viewt
 void BrowserItem::clearImage()
 {
 	if (image) image->clear();
+	clearThumbnail();
+}
+
+/* BrowserItem::setThumbnail
+ * Sets the item thumbnail to [tex], for an image of [width]x[height]
+ * (the thumbnail itself may be smaller)
+ *******************************************************************/
+void BrowserItem::setThumbnail(GLTexture* tex, int width, int height)
+{
+	if (thumbnail)
+		delete thumbnail;
+
+	thumbnail = tex;
+	thumb_width = width;
+	thumb_height = height;
+	thumb_state = THUMB_READY;
+}
+
+/* BrowserItem::clearThumbnail
+ * Clears the item thumbnail, cancelling it if it is still loading
+ *******************************************************************/
+void BrowserItem::clearThumbnail()
+{
+	if (thumb_state == THUMB_PENDING && parent)
+		parent->cancelThumbnail(this);
+
+	if (thumbnail)
+	{
+		delete thumbnail;
+		thumbnail = NULL;
+	}
+	thumb_state = THUMB_NONE;
 }
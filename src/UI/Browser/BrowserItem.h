@@ -6,6 +6,8 @@
 
 class BrowserWindow;
 class TextBox;
+class MemChunk;
+class Palette8bit;
 class BrowserItem
 {
 	friend class BrowserWindow;
@@ -18,10 +20,24 @@ protected:
 	bool			blank;
 	TextBox*		text_box;
 
+	// Background-loaded thumbnail
+	GLTexture*		thumbnail;
+	int				thumb_state;
+	int				thumb_width;
+	int				thumb_height;
+
 public:
 	BrowserItem(string name, unsigned index = 0, string type = "item");
 	virtual ~BrowserItem();
 
+	enum
+	{
+		THUMB_NONE,
+		THUMB_PENDING,
+		THUMB_READY,
+		THUMB_FAILED,
+	};
+
 	string		getName() { return name; }
 	unsigned	getIndex() { return index; }
 
@@ -29,6 +45,14 @@ public:
 	void			draw(int size, int x, int y, int font, int nametype = 0, int viewtype = 0, rgba_t colour = COL_WHITE, bool text_shadow = true);
 	void			clearImage();
 	virtual string	itemInfo() { return ""; }
+
+	// Thumbnails
+	virtual bool	thumbnailSource(MemChunk& data, string& format_hint, Palette8bit& palette) { return false; }
+	bool			imageLoaded() { return image && image->isLoaded(); }
+	int				thumbnailState() { return thumb_state; }
+	void			setThumbnailState(int state) { thumb_state = state; }
+	void			setThumbnail(GLTexture* tex, int width, int height);
+	void			clearThumbnail();
 };
 
 #endif//__BROWSER_ITEM_H__
@@ -0,0 +1,576 @@
+
+/*******************************************************************
+ * SLADE - It's a Doom Editor
+ * Copyright (C) 2008-2014 Simon Judd
+ *
+ * Email:       sirjuddington@gmail.com
+ * Web:         http://slade.mancubus.net
+ * Filename:    BrowserThumbnailLoader.cpp
+ * Description: Loads browser item thumbnails in the background.
+ *              Image data is fetched from resources on the main
+ *              thread, decoded (or read from the on-disk thumbnail
+ *              cache) on worker threads, and finally uploaded to
+ *              OpenGL textures on the main thread, a few at a time
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *******************************************************************/
+
+
+/*******************************************************************
+ * INCLUDES
+ *******************************************************************/
+#include "Main.h"
+#include "App.h"
+#include "BrowserThumbnailLoader.h"
+#include "BrowserItem.h"
+#include "Archive/ArchiveEntry.h"
+#include "Archive/EntryType/EntryType.h"
+#include "General/Misc.h"
+#include "Graphics/SImage/SImage.h"
+#include "OpenGL/GLTexture.h"
+
+
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+CVAR(Bool, browser_thumb_cache, true, CVAR_SAVE)
+CVAR(Int, browser_thumb_threads, 2, CVAR_SAVE)
+wxDEFINE_EVENT(wxEVT_COMMAND_BROWSER_THUMBNAIL_READY, wxThreadEvent);
+
+namespace
+{
+	// Thumbnails are never larger than this in either dimension
+	const int THUMB_MAX_SIZE = 256;
+
+	// Bump this if the cache file format (or thumbnail generation) changes
+	const uint32_t THUMB_CACHE_VERSION = 1;
+}
+
+
+/*******************************************************************
+ * BROWSERTHUMBNAILTHREAD CLASS
+ *******************************************************************
+ * Worker thread that processes thumbnail jobs until the loader is
+ * shut down
+ */
+class BrowserThumbnailThread : public wxThread
+{
+private:
+	BrowserThumbnailLoader*	loader;
+
+public:
+	BrowserThumbnailThread(BrowserThumbnailLoader* loader) : wxThread(wxTHREAD_JOINABLE), loader(loader) {}
+	~BrowserThumbnailThread() {}
+
+	ExitCode Entry()
+	{
+		while (true)
+		{
+			BrowserThumbnailLoader::job_t* job = loader->nextJob();
+			if (!job)
+				break;
+
+			BrowserThumbnailLoader::result_t* result = BrowserThumbnailLoader::processJob(job);
+			delete job;
+			loader->addResult(result);
+		}
+
+		return NULL;
+	}
+};
+
+
+/*******************************************************************
+ * BROWSERTHUMBNAILLOADER CLASS FUNCTIONS
+ *******************************************************************/
+
+/* BrowserThumbnailLoader::BrowserThumbnailLoader
+ * BrowserThumbnailLoader class constructor. [handler] is sent a
+ * wxEVT_COMMAND_BROWSER_THUMBNAIL_READY event when new results are
+ * ready to upload
+ *******************************************************************/
+BrowserThumbnailLoader::BrowserThumbnailLoader(wxEvtHandler* handler) : jobs_cond(jobs_mutex)
+{
+	this->handler = handler;
+	this->stopping = false;
+	this->next_serial = 0;
+}
+
+/* BrowserThumbnailLoader::~BrowserThumbnailLoader
+ * BrowserThumbnailLoader class destructor
+ *******************************************************************/
+BrowserThumbnailLoader::~BrowserThumbnailLoader()
+{
+	// Stop worker threads
+	{
+		wxMutexLocker lock(jobs_mutex);
+		stopping = true;
+		jobs_cond.Broadcast();
+	}
+	for (unsigned a = 0; a < threads.size(); a++)
+	{
+		threads[a]->Wait();
+		delete threads[a];
+	}
+
+	// Clean up anything left over
+	for (unsigned a = 0; a < jobs.size(); a++)
+		delete jobs[a];
+	for (unsigned a = 0; a < batch.size(); a++)
+		delete batch[a];
+	for (unsigned a = 0; a < results.size(); a++)
+		delete results[a];
+}
+
+/* BrowserThumbnailLoader::startThreads
+ * Starts the worker threads (and creates the cache directory) if
+ * they aren't already running
+ *******************************************************************/
+void BrowserThumbnailLoader::startThreads()
+{
+	if (!threads.empty())
+		return;
+
+	// Create cache directory
+	if (browser_thumb_cache && !wxDirExists(App::path("thumbcache", App::Dir::User)))
+		wxMkdir(App::path("thumbcache", App::Dir::User));
+
+	int count = browser_thumb_threads;
+	if (count < 1)
+		count = 1;
+	for (int a = 0; a < count; a++)
+	{
+		wxThread* thread = new BrowserThumbnailThread(this);
+		if (thread->Run() != wxTHREAD_NO_ERROR)
+		{
+			delete thread;
+			continue;
+		}
+		threads.push_back(thread);
+	}
+}
+
+/* BrowserThumbnailLoader::request
+ * Requests a thumbnail for [item], if it doesn't already have one
+ * or one isn't already on its way. If the item can't provide source
+ * data for a thumbnail, it is flagged as such (and will load its
+ * image normally). Requests are queued until submitRequests is
+ * called. Returns true if a request was made
+ *******************************************************************/
+bool BrowserThumbnailLoader::request(BrowserItem* item)
+{
+	// Check if a thumbnail is needed
+	if (!item || item->thumbnailState() != BrowserItem::THUMB_NONE || item->imageLoaded())
+		return false;
+
+	// Get source data from the item
+	job_t* job = new job_t();
+	if (!item->thumbnailSource(job->data, job->format_hint, job->palette) || !job->data.hasData())
+	{
+		delete job;
+		item->setThumbnailState(BrowserItem::THUMB_FAILED);
+		return false;
+	}
+
+	// Build cache filename from the content hash (data, palette and format)
+	if (browser_thumb_cache)
+	{
+		MemChunk pal;
+		job->palette.saveMem(pal);
+		string key = S_FMT("%08x%08x%08x%08x%02x",
+			job->data.crc(),
+			job->data.getSize(),
+			pal.crc(),
+			Misc::crc((const uint8_t*)CHR(job->format_hint), job->format_hint.length()),
+			THUMB_CACHE_VERSION);
+		job->cache_file = App::path(S_FMT("thumbcache/%s.thm", key), App::Dir::User);
+	}
+
+	job->item = item;
+	job->serial = next_serial++;
+	requests[item] = job->serial;
+	item->setThumbnailState(BrowserItem::THUMB_PENDING);
+	batch.push_back(job);
+
+	return true;
+}
+
+/* BrowserThumbnailLoader::submitRequests
+ * Sends all requests made since the last call to the worker threads.
+ * The newest batch is processed first (in the order requested), so
+ * whatever is currently on screen takes priority over anything that
+ * was scrolled past
+ *******************************************************************/
+void BrowserThumbnailLoader::submitRequests()
+{
+	if (batch.empty())
+		return;
+
+	startThreads();
+
+	wxMutexLocker lock(jobs_mutex);
+	jobs.insert(jobs.begin(), batch.begin(), batch.end());
+	batch.clear();
+	jobs_cond.Broadcast();
+}
+
+/* BrowserThumbnailLoader::cancel
+ * Cancels any pending thumbnail request for [item]
+ *******************************************************************/
+void BrowserThumbnailLoader::cancel(BrowserItem* item)
+{
+	if (requests.erase(item) == 0)
+		return;
+
+	// Remove unsubmitted request
+	for (unsigned a = 0; a < batch.size(); a++)
+	{
+		if (batch[a]->item == item)
+		{
+			delete batch[a];
+			batch.erase(batch.begin() + a);
+			return;
+		}
+	}
+
+	// Remove queued job (if it's already being processed, the result
+	// will be ignored since the request no longer exists)
+	wxMutexLocker lock(jobs_mutex);
+	for (auto i = jobs.begin(); i != jobs.end(); ++i)
+	{
+		if ((*i)->item == item)
+		{
+			delete *i;
+			jobs.erase(i);
+			return;
+		}
+	}
+}
+
+/* BrowserThumbnailLoader::cancelAll
+ * Cancels all pending thumbnail requests and discards any results
+ * waiting to be uploaded. Must be called before items with pending
+ * requests are deleted
+ *******************************************************************/
+void BrowserThumbnailLoader::cancelAll()
+{
+	requests.clear();
+
+	// Remove unsubmitted requests
+	for (unsigned a = 0; a < batch.size(); a++)
+		delete batch[a];
+	batch.clear();
+
+	// Remove queued jobs (results of any being processed will be
+	// ignored since their requests no longer exist)
+	{
+		wxMutexLocker lock(jobs_mutex);
+		for (unsigned a = 0; a < jobs.size(); a++)
+			delete jobs[a];
+		jobs.clear();
+	}
+
+	// Discard results waiting to be uploaded
+	wxCriticalSectionLocker lock(results_lock);
+	for (unsigned a = 0; a < results.size(); a++)
+		delete results[a];
+	results.clear();
+}
+
+/* BrowserThumbnailLoader::nextJob
+ * Waits for and returns the next job to process, or NULL if the
+ * loader is shutting down. Called from worker threads
+ *******************************************************************/
+BrowserThumbnailLoader::job_t* BrowserThumbnailLoader::nextJob()
+{
+	wxMutexLocker lock(jobs_mutex);
+	while (jobs.empty() && !stopping)
+		jobs_cond.Wait();
+
+	if (stopping)
+		return NULL;
+
+	job_t* job = jobs.front();
+	jobs.pop_front();
+	return job;
+}
+
+/* BrowserThumbnailLoader::addResult
+ * Adds a processed [result] to be uploaded, and notifies the handler
+ * if it's the first result waiting. Called from worker threads
+ *******************************************************************/
+void BrowserThumbnailLoader::addResult(result_t* result)
+{
+	bool notify;
+	{
+		wxCriticalSectionLocker lock(results_lock);
+		notify = results.empty();
+		results.push_back(result);
+	}
+
+	if (notify && handler)
+		wxQueueEvent(handler, new wxThreadEvent(wxEVT_COMMAND_BROWSER_THUMBNAIL_READY));
+}
+
+/* BrowserThumbnailLoader::hasResults
+ * Returns true if there are any processed results waiting to be
+ * uploaded
+ *******************************************************************/
+bool BrowserThumbnailLoader::hasResults()
+{
+	wxCriticalSectionLocker lock(results_lock);
+	return !results.empty();
+}
+
+/* BrowserThumbnailLoader::uploadResults
+ * Uploads processed thumbnails to their items, stopping once
+ * [time_budget] milliseconds have passed. Returns true if there are
+ * results still waiting
+ *******************************************************************/
+bool BrowserThumbnailLoader::uploadResults(long time_budget)
+{
+	wxStopWatch timer;
+	while (timer.Time() < time_budget || time_budget <= 0)
+	{
+		// Get next result
+		result_t* result;
+		{
+			wxCriticalSectionLocker lock(results_lock);
+			if (results.empty())
+				return false;
+			result = results.front();
+			results.pop_front();
+		}
+
+		// Ignore if the request was cancelled (or superseded)
+		auto req = requests.find(result->item);
+		if (req == requests.end() || req->second != result->serial)
+		{
+			delete result;
+			continue;
+		}
+		requests.erase(req);
+
+		// Upload
+		if (result->valid)
+		{
+			GLTexture* tex = new GLTexture();
+			if (tex->loadRawData(result->rgba.getData(), result->thumb_width, result->thumb_height))
+				result->item->setThumbnail(tex, result->width, result->height);
+			else
+			{
+				delete tex;
+				result->item->setThumbnailState(BrowserItem::THUMB_FAILED);
+			}
+		}
+		else
+			result->item->setThumbnailState(BrowserItem::THUMB_FAILED);
+
+		delete result;
+	}
+
+	return hasResults();
+}
+
+/* BrowserThumbnailLoader::entrySource
+ * Writes the image data of [entry] to [data] and the image format
+ * hint for its type to [format_hint], for use as a thumbnail source.
+ * Returns false if the entry isn't an image that can be decoded in
+ * the background (eg. fonts and jaguar graphics, which need other
+ * entries or special handling)
+ *******************************************************************/
+bool BrowserThumbnailLoader::entrySource(ArchiveEntry* entry, MemChunk& data, string& format_hint)
+{
+	if (!entry)
+		return false;
+
+	// Detect entry type if it isn't already
+	if (entry->getType() == EntryType::unknownType())
+		EntryType::detectEntryType(entry);
+
+	// Check it's a 'regular' image
+	EntryType* type = entry->getType();
+	if (!type->extraProps().propertyExists("image"))
+		return false;
+	string format = type->getFormat();
+	if (format.StartsWith("font_") || format.StartsWith("img_jaguar"))
+		return false;
+
+	// Get image format hint from type, if any
+	format_hint = "";
+	if (type->extraProps().propertyExists("image_format"))
+		format_hint = type->extraProps()["image_format"].getStringValue();
+
+	return data.importMem(entry->getData(), entry->getSize());
+}
+
+
+/*******************************************************************
+ * BROWSERTHUMBNAILLOADER STATIC FUNCTIONS
+ *******************************************************************
+ * These are called from worker threads, so must not touch anything
+ * outside of the given job/result
+ */
+
+/* BrowserThumbnailLoader::processJob
+ * Generates a thumbnail result for [job], either from the thumbnail
+ * cache or by decoding the job's image data
+ *******************************************************************/
+BrowserThumbnailLoader::result_t* BrowserThumbnailLoader::processJob(job_t* job)
+{
+	result_t* result = new result_t();
+	result->item = job->item;
+	result->serial = job->serial;
+	result->valid = false;
+	result->width = result->height = 0;
+	result->thumb_width = result->thumb_height = 0;
+
+	// Check cache
+	if (!job->cache_file.IsEmpty() && readCacheFile(job->cache_file, result))
+	{
+		// Mark as recently used, so it is kept when the cache is pruned
+		wxFileName(job->cache_file).Touch();
+		return result;
+	}
+
+	// Decode image
+	SImage image;
+	if (!image.open(job->data, 0, job->format_hint) || !image.isValid())
+		return result;
+	MemChunk full;
+	if (!image.getRGBAData(full, &job->palette))
+		return result;
+
+	int width = image.getWidth();
+	int height = image.getHeight();
+	result->width = width;
+	result->height = height;
+
+	// Scale down if needed (box filter)
+	if (width <= THUMB_MAX_SIZE && height <= THUMB_MAX_SIZE)
+	{
+		result->thumb_width = width;
+		result->thumb_height = height;
+		result->rgba.importMem(full.getData(), full.getSize());
+	}
+	else
+	{
+		double scale = (double)THUMB_MAX_SIZE / (double)max(width, height);
+		int tw = max(1, (int)(width * scale));
+		int th = max(1, (int)(height * scale));
+		result->thumb_width = tw;
+		result->thumb_height = th;
+		result->rgba.reSize(tw * th * 4, false);
+
+		const uint8_t* src = full.getData();
+		uint8_t* dest = &result->rgba[0];
+		for (int y = 0; y < th; y++)
+		{
+			int sy1 = y * height / th;
+			int sy2 = max(sy1 + 1, (y + 1) * height / th);
+			for (int x = 0; x < tw; x++)
+			{
+				int sx1 = x * width / tw;
+				int sx2 = max(sx1 + 1, (x + 1) * width / tw);
+
+				unsigned total[4] = { 0, 0, 0, 0 };
+				for (int sy = sy1; sy < sy2; sy++)
+				{
+					const uint8_t* p = src + (sy * width + sx1) * 4;
+					for (int sx = sx1; sx < sx2; sx++, p += 4)
+					{
+						total[0] += p[0];
+						total[1] += p[1];
+						total[2] += p[2];
+						total[3] += p[3];
+					}
+				}
+
+				unsigned count = (sy2 - sy1) * (sx2 - sx1);
+				for (int c = 0; c < 4; c++)
+					*dest++ = total[c] / count;
+			}
+		}
+	}
+	result->valid = true;
+
+	// Write to cache
+	if (!job->cache_file.IsEmpty())
+		writeCacheFile(job->cache_file, result);
+
+	return result;
+}
+
+/* BrowserThumbnailLoader::readCacheFile
+ * Reads a cached thumbnail from [filename] into [result]. Returns
+ * false if the file doesn't exist or is invalid
+ *******************************************************************/
+bool BrowserThumbnailLoader::readCacheFile(string filename, result_t* result)
+{
+	if (!wxFileExists(filename))
+		return false;
+
+	MemChunk mc;
+	if (!mc.importFile(filename) || mc.getSize() < 24)
+		return false;
+
+	// Check header
+	char magic[4];
+	uint32_t version, dims[4];
+	mc.seek(0, SEEK_SET);
+	mc.read(magic, 4);
+	mc.read(&version, 4);
+	mc.read(dims, 16);
+	if (memcmp(magic, "STHM", 4) != 0 || wxUINT32_SWAP_ON_BE(version) != THUMB_CACHE_VERSION)
+		return false;
+	for (unsigned a = 0; a < 4; a++)
+		dims[a] = wxUINT32_SWAP_ON_BE(dims[a]);
+	if (dims[2] == 0 || dims[3] == 0 || mc.getSize() != 24 + dims[2] * dims[3] * 4)
+		return false;
+
+	result->width = dims[0];
+	result->height = dims[1];
+	result->thumb_width = dims[2];
+	result->thumb_height = dims[3];
+	result->rgba.importMem(mc.getData() + 24, dims[2] * dims[3] * 4);
+	result->valid = true;
+
+	return true;
+}
+
+/* BrowserThumbnailLoader::writeCacheFile
+ * Writes the thumbnail in [result] to cache file [filename]
+ *******************************************************************/
+void BrowserThumbnailLoader::writeCacheFile(string filename, result_t* result)
+{
+	MemChunk mc;
+	uint32_t version = wxUINT32_SWAP_ON_BE(THUMB_CACHE_VERSION);
+	uint32_t dims[4] =
+	{
+		wxUINT32_SWAP_ON_BE((uint32_t)result->width),
+		wxUINT32_SWAP_ON_BE((uint32_t)result->height),
+		wxUINT32_SWAP_ON_BE((uint32_t)result->thumb_width),
+		wxUINT32_SWAP_ON_BE((uint32_t)result->thumb_height)
+	};
+	mc.write("STHM", 4);
+	mc.write(&version, 4);
+	mc.write(dims, 16);
+	mc.write(result->rgba.getData(), result->rgba.getSize());
+
+	// Write to a temp file first so other threads never see a partial file
+	string temp = filename + S_FMT(".%lu", wxThread::GetCurrentId());
+	if (mc.exportFile(temp))
+		wxRenameFile(temp, filename, true);
+}
@@ -0,0 +1,77 @@
+
+#ifndef __BROWSER_THUMBNAIL_LOADER_H__
+#define __BROWSER_THUMBNAIL_LOADER_H__
+
+#include "common.h"
+#include "Graphics/Palette/Palette.h"
+#include <deque>
+
+wxDECLARE_EVENT(wxEVT_COMMAND_BROWSER_THUMBNAIL_READY, wxThreadEvent);
+
+class BrowserItem;
+class ArchiveEntry;
+
+// Decodes browser item images on worker threads (with a persistent
+// on-disk thumbnail cache), then uploads the results as GL textures
+// on the main thread within a per-frame time budget
+class BrowserThumbnailLoader
+{
+	friend class BrowserThumbnailThread;
+public:
+	BrowserThumbnailLoader(wxEvtHandler* handler);
+	~BrowserThumbnailLoader();
+
+	bool	request(BrowserItem* item);
+	void	submitRequests();
+	void	cancel(BrowserItem* item);
+	void	cancelAll();
+	bool	uploadResults(long time_budget);
+	bool	hasResults();
+
+	static bool	entrySource(ArchiveEntry* entry, MemChunk& data, string& format_hint);
+
+private:
+	struct job_t
+	{
+		BrowserItem*	item;	// Only used to identify the request, never dereferenced by workers
+		unsigned		serial;
+		MemChunk		data;
+		string			format_hint;
+		Palette8bit		palette;
+		string			cache_file;
+	};
+
+	struct result_t
+	{
+		BrowserItem*	item;
+		unsigned		serial;
+		bool			valid;
+		int				width;
+		int				height;
+		int				thumb_width;
+		int				thumb_height;
+		MemChunk		rgba;
+	};
+
+	wxEvtHandler*						handler;
+	vector<wxThread*>					threads;
+	wxMutex								jobs_mutex;
+	wxCondition							jobs_cond;
+	std::deque<job_t*>					jobs;
+	bool								stopping;
+	vector<job_t*>						batch;
+	wxCriticalSection					results_lock;
+	std::deque<result_t*>				results;
+	std::map<BrowserItem*, unsigned>	requests;
+	unsigned							next_serial;
+
+	void		startThreads();
+	job_t*		nextJob();
+	void		addResult(result_t* result);
+
+	static result_t*	processJob(job_t* job);
+	static bool			readCacheFile(string filename, result_t* result);
+	static void			writeCacheFile(string filename, result_t* result);
+};
+
+#endif//__BROWSER_THUMBNAIL_LOADER_H__
@@ -239,6 +239,10 @@ BrowserWindow::~BrowserWindow()
 	browser_maximised = IsMaximized();
 	if (!IsMaximized())
 		Misc::setWindowInfo("browser", GetClientSize().x, GetClientSize().y, GetPosition().x, GetPosition().y);
+
+	// Cancel thumbnail requests while the canvas (and its loader) still exists
+	if (canvas)
+		canvas->thumbnailLoader()->cancelAll();
 }
 
 /* BrowserWindow::addItem
@@ -277,6 +281,24 @@ void BrowserWindow::clearItems(BrowserTreeNode* node)
 	if (!node)
 		node = items_root;
 
+	// Cancel any pending thumbnails before the items are deleted
+	if (node == items_root && canvas)
+	{
+		canvas->thumbnailLoader()->cancelAll();
+
+		// (Global items are kept, so they need to request again)
+		for (unsigned a = 0; a < items_global.size(); a++)
+		{
+			if (items_global[a]->thumbnailState() == BrowserItem::THUMB_PENDING)
+				items_global[a]->setThumbnailState(BrowserItem::THUMB_NONE);
+		}
+	}
+	else
+	{
+		for (unsigned a = 0; a < node->nItems(); a++)
+			cancelThumbnail(node->getItem(a));
+	}
+
 	// Clear all items from node
 	node->clearItems();
 
@@ -309,6 +331,15 @@ void BrowserWindow::reloadItems(BrowserTreeNode* node)
 		reloadItems((BrowserTreeNode*)node->getChild(a));
 }
 
+/* BrowserWindow::cancelThumbnail
+ * Cancels any pending background thumbnail load for [item]
+ *******************************************************************/
+void BrowserWindow::cancelThumbnail(BrowserItem* item)
+{
+	if (canvas)
+		canvas->thumbnailLoader()->cancel(item);
+}
+
 BrowserItem* BrowserWindow::getSelectedItem()
 {
 	return canvas->getSelectedItem();
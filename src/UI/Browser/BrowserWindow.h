@@ -72,6 +72,7 @@ public:
 	void			addGlobalItem(BrowserItem* item);
 	void			clearItems(BrowserTreeNode* node = NULL);
 	void			reloadItems(BrowserTreeNode* node = NULL);
+	void			cancelThumbnail(BrowserItem* item);
 	BrowserItem*	getSelectedItem();
 	bool			selectItem(string name, BrowserTreeNode* root = NULL);
 
@@ -7,7 +7,11 @@
  * Web:         http://slade.mancubus.net
  * Filename:    MapPreviewCanvas.cpp
  * Description: OpenGL Canvas that shows a basic map preview, can
- *              also save the preview to an image
+ *              also save the preview to an image. Map lines are
+ *              rendered in software (so images can be created
+ *              without OpenGL), and previews are shown from
+ *              thumbnails generated in the background and cached
+ *              on disk by map content
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU General Public License
@@ -29,10 +33,12 @@
  * INCLUDES
  *******************************************************************/
 #include "Main.h"
+#include "App.h"
 #include "MapPreviewCanvas.h"
 #include "Archive/ArchiveManager.h"
 #include "Archive/Formats/WadArchive.h"
 #include "General/ColourConfiguration.h"
+#include "General/Misc.h"
 #include "Graphics/SImage/SIFormat.h"
 #include "Graphics/SImage/SImage.h"
 #include "MapEditor/SLADEMap/MapLine.h"
@@ -47,6 +53,189 @@
  *******************************************************************/
 CVAR(Float, map_image_thickness, 1.5, CVAR_SAVE)
 CVAR(Bool, map_view_things, true, CVAR_SAVE)
+CVAR(Bool, map_preview_thumbs, true, CVAR_SAVE)
+CVAR(Bool, map_thumb_cache, true, CVAR_SAVE)
+wxDEFINE_EVENT(wxEVT_COMMAND_MAP_THUMBNAIL_READY, wxThreadEvent);
+
+namespace
+{
+	// Thumbnails are generated at power-of-two sizes (longest side)
+	// between these, big enough to fill the canvas
+	const int THUMB_MIN_SIZE = 256;
+	const int THUMB_MAX_SIZE = 4096;
+
+	// Line thickness (in pixels) of thumbnail lines
+	const double THUMB_LINE_THICKNESS = 1.5;
+
+	// Bump this if thumbnail generation changes
+	const uint32_t THUMB_CACHE_VERSION = 1;
+}
+
+
+/*******************************************************************
+ * FUNCTIONS
+ *******************************************************************/
+
+/* blendPixel
+ * Blends [colour] onto the pixel at [x,y] in RGBA [data] (of size
+ * [width]x[height]), scaling its alpha by [coverage]
+ *******************************************************************/
+static inline void blendPixel(uint8_t* data, int width, int height, int x, int y, const rgba_t& colour, double coverage)
+{
+	if (x < 0 || y < 0 || x >= width || y >= height || coverage <= 0)
+		return;
+
+	double alpha = coverage * (colour.a / 255.0);
+	if (alpha > 1.0)
+		alpha = 1.0;
+
+	uint8_t* pixel = data + (y * width + x) * 4;
+	pixel[0] = (uint8_t)(pixel[0] + (colour.r - pixel[0]) * alpha + 0.5);
+	pixel[1] = (uint8_t)(pixel[1] + (colour.g - pixel[1]) * alpha + 0.5);
+	pixel[2] = (uint8_t)(pixel[2] + (colour.b - pixel[2]) * alpha + 0.5);
+	pixel[3] = (uint8_t)(pixel[3] + (255 - pixel[3]) * alpha + 0.5);
+}
+
+/* coverage
+ * Returns how much of the pixel span [p,p+1] is covered by the span
+ * [s1,s2]
+ *******************************************************************/
+static inline double coverage(int p, double s1, double s2)
+{
+	double c = min<double>(p + 1, s2) - max<double>(p, s1);
+	return c > 0 ? c : 0;
+}
+
+/* drawLine
+ * Draws an antialiased line [thickness] pixels wide from [x1,y1] to
+ * [x2,y2] (in pixel coordinates) in RGBA [data]. The line is walked
+ * along its major axis, and each pixel across it is given the
+ * portion of it covered by the line
+ *******************************************************************/
+static void drawLine(uint8_t* data, int width, int height, double x1, double y1, double x2, double y2, const rgba_t& colour, double thickness)
+{
+	// Walk along x if the line is mostly horizontal, y otherwise
+	bool steep = fabs(y2 - y1) > fabs(x2 - x1);
+	if (steep)
+	{
+		std::swap(x1, y1);
+		std::swap(x2, y2);
+	}
+	if (x1 > x2)
+	{
+		std::swap(x1, x2);
+		std::swap(y1, y2);
+	}
+	int major_size = steep ? height : width;
+	int minor_size = steep ? width : height;
+
+	// Lines thinner than a pixel are drawn a pixel wide but fainter
+	double strength = min(thickness, 1.0);
+	thickness = max(thickness, 1.0);
+
+	// Get half-width of the line across the minor axis
+	double gradient = (x2 > x1) ? (y2 - y1) / (x2 - x1) : 0;
+	double half_width = thickness * 0.5 * sqrt(1.0 + gradient * gradient);
+
+	// Extend ends by half a pixel so that connected lines join up
+	double m1 = x1 - 0.5;
+	double m2 = x2 + 0.5;
+	int start = max(0, (int)floor(m1));
+	int end = min(major_size - 1, (int)floor(m2));
+	for (int m = start; m <= end; m++)
+	{
+		double c_major = coverage(m, m1, m2) * strength;
+
+		// Get minor axis span of the line at the middle of this pixel
+		double mid = y1 + gradient * ((m + 0.5) - x1);
+		if (mid + half_width < 0 || mid - half_width > minor_size)
+			continue;
+		int n1 = max(0, (int)floor(mid - half_width));
+		int n2 = min(minor_size - 1, (int)floor(mid + half_width));
+		for (int n = n1; n <= n2; n++)
+		{
+			double c = c_major * coverage(n, mid - half_width, mid + half_width);
+			if (steep)
+				blendPixel(data, width, height, n, m, colour, c);
+			else
+				blendPixel(data, width, height, m, n, colour, c);
+		}
+	}
+}
+
+
+/*******************************************************************
+ * MAPTHUMBNAILTHREAD CLASS
+ *******************************************************************
+ * Worker thread that generates a map preview thumbnail (or reads it
+ * from the thumbnail cache), then notifies the canvas
+ */
+class MapThumbnailThread : public wxThread
+{
+public:
+	wxEvtHandler*			handler;
+	unsigned				serial;
+	vector<mep_vertex_t>	verts;
+	vector<mep_line_t>		lines;
+	int						width;
+	int						height;
+	mep_colours_t			colours;
+	string					cache_file;
+	frect_t					rect;
+	SImage*					image;
+	bool					valid;
+
+	MapThumbnailThread(wxEvtHandler* handler, unsigned serial) : wxThread(wxTHREAD_JOINABLE)
+	{
+		this->handler = handler;
+		this->serial = serial;
+		width = height = 0;
+		image = new SImage();
+		valid = false;
+	}
+
+	~MapThumbnailThread()
+	{
+		delete image;
+	}
+
+	ExitCode Entry()
+	{
+		// Check cache
+		if (!cache_file.IsEmpty() && wxFileExists(cache_file))
+		{
+			MemChunk mc;
+			if (mc.importFile(cache_file) && image->open(mc, 0, "png"))
+				valid = (image->getWidth() == width && image->getHeight() == height);
+
+			// Mark as recently used, so it is kept when the cache is pruned
+			if (valid)
+				wxFileName(cache_file).Touch();
+		}
+
+		// Render
+		if (!valid)
+		{
+			MapPreviewCanvas::renderImage(*image, verts, lines, width, height, colours, THUMB_LINE_THICKNESS);
+			valid = image->isValid();
+
+			// Write to cache (via a temp file so other threads never see a partial file)
+			MemChunk mc;
+			if (valid && !cache_file.IsEmpty() && SIFormat::getFormat("png")->saveImage(*image, mc))
+			{
+				string temp = cache_file + S_FMT(".%lu", wxThread::GetCurrentId());
+				if (mc.exportFile(temp))
+					wxRenameFile(temp, cache_file, true);
+			}
+		}
+
+		wxThreadEvent* event = new wxThreadEvent(wxEVT_COMMAND_MAP_THUMBNAIL_READY);
+		event->SetInt(serial);
+		wxQueueEvent(handler, event);
+
+		return NULL;
+	}
+};
 
 
 /*******************************************************************
@@ -66,6 +255,13 @@ MapPreviewCanvas::MapPreviewCanvas(wxWindow* parent) : OGLCanvas(parent, -1)
 	tex_loaded = false;
 	n_sides = 0;
 	n_sectors = 0;
+	tex_thumb = NULL;
+	thumb_image = NULL;
+	thumb_size = 0;
+	thumb_serial = 0;
+
+	// Bind events
+	Bind(wxEVT_COMMAND_MAP_THUMBNAIL_READY, &MapPreviewCanvas::onThumbnailReady, this);
 }
 
 /* MapPreviewCanvas::~MapPreviewCanvas
@@ -73,7 +269,16 @@ MapPreviewCanvas::MapPreviewCanvas(wxWindow* parent) : OGLCanvas(parent, -1)
  *******************************************************************/
 MapPreviewCanvas::~MapPreviewCanvas()
 {
+	// Wait for any thumbnails still being generated
+	for (unsigned a = 0; a < thumb_threads.size(); a++)
+	{
+		thumb_threads[a]->Wait();
+		delete thumb_threads[a];
+	}
+
 	if (tex_thing) delete tex_thing;
+	if (tex_thumb) delete tex_thumb;
+	if (thumb_image) delete thumb_image;
 }
 
 /* MapPreviewCanvas::addVertex
@@ -115,6 +320,20 @@ bool MapPreviewCanvas::openMap(Archive::MapDesc map)
 	// All errors = invalid map
 	Global::error = "Invalid map";
 
+	// Get content hash of the map entries (to identify its thumbnail)
+	clearThumbnail();
+	vector<uint32_t> crcs;
+	uint32_t total_size = 0;
+	for (ArchiveEntry* entry = map.head; entry; entry = entry->nextEntry())
+	{
+		crcs.push_back(entry->getMCData().crc());
+		total_size += entry->getSize();
+		if (entry == map.end)
+			break;
+	}
+	if (!crcs.empty())
+		map_hash = S_FMT("%08x%08x", Misc::crc((const uint8_t*)&crcs[0], crcs.size() * 4), total_size);
+
 	// Check if this map is a pk3 map
 	bool map_archive = false;
 	if (map.archive)
@@ -597,6 +816,25 @@ void MapPreviewCanvas::clearMap()
 	things.clear();
 	n_sides = 0;
 	n_sectors = 0;
+	clearThumbnail();
+}
+
+/* MapPreviewCanvas::clearThumbnail
+ * Clears the current map thumbnail, any thumbnails still being
+ * generated will be ignored when they are finished
+ *******************************************************************/
+void MapPreviewCanvas::clearThumbnail()
+{
+	map_hash = "";
+	thumb_size = 0;
+	thumb_serial++;
+	if (tex_thumb)
+		tex_thumb->clear();
+	if (thumb_image)
+	{
+		delete thumb_image;
+		thumb_image = NULL;
+	}
 }
 
 /* MapPreviewCanvas::showMap
@@ -683,34 +921,37 @@ void MapPreviewCanvas::draw()
 	glLineWidth(1.5f);
 	glEnable(GL_LINE_SMOOTH);
 
-	// Draw lines
-	for (unsigned a = 0; a < lines.size(); a++)
+	// Draw lines (from the map thumbnail if it's ready)
+	if (!drawThumbnail())
 	{
-		mep_line_t line = lines[a];
-
-		// Check ends
-		if (line.v1 >= verts.size() || line.v2 >= verts.size())
-			continue;
-
-		// Get vertices
-		mep_vertex_t v1 = verts[lines[a].v1];
-		mep_vertex_t v2 = verts[lines[a].v2];
-
-		// Set colour
-		if (line.special)
-			OpenGL::setColour(col_view_line_special);
-		else if (line.macro)
-			OpenGL::setColour(col_view_line_macro);
-		else if (line.twosided)
-			OpenGL::setColour(col_view_line_2s);
-		else
-			OpenGL::setColour(col_view_line_1s);
+		for (unsigned a = 0; a < lines.size(); a++)
+		{
+			mep_line_t line = lines[a];
+
+			// Check ends
+			if (line.v1 >= verts.size() || line.v2 >= verts.size())
+				continue;
+
+			// Get vertices
+			mep_vertex_t v1 = verts[lines[a].v1];
+			mep_vertex_t v2 = verts[lines[a].v2];
+
+			// Set colour
+			if (line.special)
+				OpenGL::setColour(col_view_line_special);
+			else if (line.macro)
+				OpenGL::setColour(col_view_line_macro);
+			else if (line.twosided)
+				OpenGL::setColour(col_view_line_2s);
+			else
+				OpenGL::setColour(col_view_line_1s);
 
-		// Draw line
-		glBegin(GL_LINES);
-		glVertex2d(v1.x, v1.y);
-		glVertex2d(v2.x, v2.y);
-		glEnd();
+			// Draw line
+			glBegin(GL_LINES);
+			glVertex2d(v1.x, v1.y);
+			glVertex2d(v2.x, v2.y);
+			glEnd();
+		}
 	}
 
 	// Load thing texture if needed
@@ -774,29 +1015,15 @@ void MapPreviewCanvas::draw()
 
 
 /* MapPreviewCanvas::createImage
- * Draws the map in an image
- * TODO: Factorize code with normal draw() and showMap() functions.
- * TODO: Find a way to generate an arbitrary-sized image through
- * tiled rendering.
+ * Draws the map in an image, and writes it to [ae] as a PNG. If
+ * [width] or [height] is negative, the map is scaled down by that
+ * factor in that dimension (0 = 1/5 scale)
  *******************************************************************/
 void MapPreviewCanvas::createImage(ArchiveEntry& ae, int width, int height)
 {
-	// Find extents of map
-	mep_vertex_t m_min(999999.0, 999999.0);
-	mep_vertex_t m_max(-999999.0, -999999.0);
-	for (unsigned a = 0; a < verts.size(); a++)
-	{
-		if (verts[a].x < m_min.x)
-			m_min.x = verts[a].x;
-		if (verts[a].x > m_max.x)
-			m_max.x = verts[a].x;
-		if (verts[a].y < m_min.y)
-			m_min.y = verts[a].y;
-		if (verts[a].y > m_max.y)
-			m_max.y = verts[a].y;
-	}
-	double mapwidth = m_max.x - m_min.x;
-	double mapheight = m_max.y - m_min.y;
+	// Get map size
+	double mapwidth = getWidth();
+	double mapheight = getHeight();
 
 	if (width == 0) width = -5;
 	if (height == 0) height = -5;
@@ -806,153 +1033,19 @@ void MapPreviewCanvas::createImage(ArchiveEntry& ae, int width, int height)
 		height = mapheight / abs(height);
 
 	// Setup colours
-	rgba_t col_save_background = ColourConfiguration::getColour("map_image_background");
-	rgba_t col_save_line_1s = ColourConfiguration::getColour("map_image_line_1s");
-	rgba_t col_save_line_2s = ColourConfiguration::getColour("map_image_line_2s");
-	rgba_t col_save_line_special = ColourConfiguration::getColour("map_image_line_special");
-	rgba_t col_save_line_macro = ColourConfiguration::getColour("map_image_line_macro");
-
-	// Setup OpenGL rigmarole
-	GLuint texID, fboID;
-	if (GLEW_ARB_framebuffer_object)
-	{
-		glGenTextures(1, &texID);
-		glBindTexture(GL_TEXTURE_2D, texID);
-		// We don't use mipmaps, but OpenGL will refuse to attach
-		// the texture to the framebuffer if they are not present
-		glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glGenFramebuffersEXT(1, &fboID);
-		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fboID);
-		glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, texID, 0);
-		GLenum status = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
-	}
-
-	glViewport(0, 0, width, height);
-
-	// Setup the screen projection
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	glOrtho(0, width, 0, height, -1, 1);
-
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-
-	// Clear
-	glClearColor(((double)col_save_background.r)/255.f, ((double)col_save_background.g)/255.f,
-	             ((double)col_save_background.b)/255.f, ((double)col_save_background.a)/255.f);
-	glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
-
-	// Translate to inside of pixel (otherwise inaccuracies can occur on certain gl implementations)
-	if (OpenGL::accuracyTweak())
-		glTranslatef(0.375f, 0.375f, 0);
-
-	// Zoom/offset to show full map
-	// Offset to center of map
-	offset_x = m_min.x + (mapwidth * 0.5);
-	offset_y = m_min.y + (mapheight * 0.5);
-
-	// Zoom to fit whole map
-	double x_scale = ((double)width) / mapwidth;
-	double y_scale = ((double)height) / mapheight;
-	zoom = MIN(x_scale, y_scale);
-	zoom *= 0.95;
-
-	// Translate to middle of canvas
-	glTranslated(width>>1, height>>1, 0);
-
-	// Zoom
-	glScaled(zoom, zoom, 1);
-
-	// Translate to offset
-	glTranslated(-offset_x, -offset_y, 0);
-
-	// Setup drawing
-	glDisable(GL_TEXTURE_2D);
-	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
-	glLineWidth(map_image_thickness);
-	glEnable(GL_LINE_SMOOTH);
-
-	// Draw 2s lines
-	for (unsigned a = 0; a < lines.size(); a++)
-	{
-		mep_line_t line = lines[a];
-
-		if (!line.twosided)
-			continue;
-
-		// Check ends
-		if (line.v1 >= verts.size() || line.v2 >= verts.size())
-			continue;
-
-		// Get vertices
-		mep_vertex_t v1 = verts[lines[a].v1];
-		mep_vertex_t v2 = verts[lines[a].v2];
-
-		// Set colour
-		if (line.special)
-			OpenGL::setColour(col_save_line_special);
-		else if (line.macro)
-			OpenGL::setColour(col_save_line_macro);
-		else if (line.twosided)
-			OpenGL::setColour(col_save_line_2s);
-		else
-			OpenGL::setColour(col_save_line_1s);
-
-		// Draw line
-		glBegin(GL_LINES);
-		glVertex2d(v1.x, v1.y);
-		glVertex2d(v2.x, v2.y);
-		glEnd();
-	}
-
-	// Draw 1s lines
-	for (unsigned a = 0; a < lines.size(); a++)
-	{
-		mep_line_t line = lines[a];
-
-		if (line.twosided)
-			continue;
-
-		// Check ends
-		if (line.v1 >= verts.size() || line.v2 >= verts.size())
-			continue;
-
-		// Get vertices
-		mep_vertex_t v1 = verts[lines[a].v1];
-		mep_vertex_t v2 = verts[lines[a].v2];
-
-		// Set colour
-		if (line.special)
-			OpenGL::setColour(col_save_line_special);
-		else if (line.macro)
-			OpenGL::setColour(col_save_line_macro);
-		else
-			OpenGL::setColour(col_save_line_1s);
-
-		// Draw line
-		glBegin(GL_LINES);
-		glVertex2d(v1.x, v1.y);
-		glVertex2d(v2.x, v2.y);
-		glEnd();
-	}
-
-	glLineWidth(1.0f);
-	glDisable(GL_LINE_SMOOTH);
-
-	uint8_t* ImageBuffer = new uint8_t[width * height * 4];
-	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, ImageBuffer);
-
-	if (GLEW_ARB_framebuffer_object)
-	{
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glDeleteTextures( 1, &texID );
-		glDeleteFramebuffersEXT( 1, &fboID );
-	}
+	mep_colours_t colours;
+	colours.background = ColourConfiguration::getColour("map_image_background");
+	colours.line_1s = ColourConfiguration::getColour("map_image_line_1s");
+	colours.line_2s = ColourConfiguration::getColour("map_image_line_2s");
+	colours.line_special = ColourConfiguration::getColour("map_image_line_special");
+	colours.line_macro = ColourConfiguration::getColour("map_image_line_macro");
+
+	// Draw map
 	SImage img;
-	img.setImageData(ImageBuffer, width, height, RGBA);
-	img.mirror(true);
+	renderImage(img, verts, lines, width, height, colours, map_image_thickness);
+	if (!img.isValid())
+		return;
+
 	MemChunk mc;
 	SIFormat::getFormat("png")->saveImage(img, mc);
 	ae.importMemChunk(mc);
@@ -1053,3 +1146,269 @@ unsigned MapPreviewCanvas::getHeight()
 
 	return max_y - min_y;
 }
+
+/* MapPreviewCanvas::requestThumbnail
+ * Starts generating a thumbnail of the map's lines in the background,
+ * with its longest side [size] pixels. The thumbnail is read from the
+ * thumbnail cache instead if it was generated previously
+ *******************************************************************/
+void MapPreviewCanvas::requestThumbnail(int size)
+{
+	thumb_size = size;
+	thumb_serial++;
+
+	// Get thumbnail dimensions (same aspect as the map)
+	MapThumbnailThread* thread = new MapThumbnailThread(this, thumb_serial);
+	double mapwidth = max<unsigned>(getWidth(), 1);
+	double mapheight = max<unsigned>(getHeight(), 1);
+	if (mapwidth >= mapheight)
+	{
+		thread->width = size;
+		thread->height = max(1, (int)ceil(size * mapheight / mapwidth));
+	}
+	else
+	{
+		thread->width = max(1, (int)ceil(size * mapwidth / mapheight));
+		thread->height = size;
+	}
+	thread->verts = verts;
+	thread->lines = lines;
+
+	// Setup colours
+	thread->colours.background = ColourConfiguration::getColour("map_view_background");
+	thread->colours.line_1s = ColourConfiguration::getColour("map_view_line_1s");
+	thread->colours.line_2s = ColourConfiguration::getColour("map_view_line_2s");
+	thread->colours.line_special = ColourConfiguration::getColour("map_view_line_special");
+	thread->colours.line_macro = ColourConfiguration::getColour("map_view_line_macro");
+
+	// Get the map area covered by the thumbnail
+	double zoom, centre_x, centre_y;
+	fitView(verts, thread->width, thread->height, zoom, centre_x, centre_y);
+	double half_width = thread->width * 0.5 / zoom;
+	double half_height = thread->height * 0.5 / zoom;
+	thread->rect = frect_t(centre_x - half_width, centre_y - half_height, centre_x + half_width, centre_y + half_height);
+
+	// Build cache filename from the map content hash, size and colours
+	if (map_thumb_cache)
+	{
+		if (!wxDirExists(App::path("thumbcache", App::Dir::User)))
+			wxMkdir(App::path("thumbcache", App::Dir::User));
+
+		rgba_t* cols[5] =
+		{
+			&thread->colours.background,
+			&thread->colours.line_1s,
+			&thread->colours.line_2s,
+			&thread->colours.line_special,
+			&thread->colours.line_macro
+		};
+		uint8_t col_data[20];
+		for (unsigned a = 0; a < 5; a++)
+		{
+			col_data[a * 4] = cols[a]->r;
+			col_data[a * 4 + 1] = cols[a]->g;
+			col_data[a * 4 + 2] = cols[a]->b;
+			col_data[a * 4 + 3] = cols[a]->a;
+		}
+
+		string key = S_FMT("%s%04x%04x%08x%02x", map_hash, thread->width, thread->height, Misc::crc(col_data, 20), THUMB_CACHE_VERSION);
+		thread->cache_file = App::path(S_FMT("thumbcache/map%s.png", key), App::Dir::User);
+	}
+
+	if (thread->Run() != wxTHREAD_NO_ERROR)
+	{
+		delete thread;
+		return;
+	}
+	thumb_threads.push_back(thread);
+}
+
+/* MapPreviewCanvas::drawThumbnail
+ * Draws the map thumbnail (if it's ready), requesting a new one if
+ * needed. Returns false if there is no thumbnail to draw
+ *******************************************************************/
+bool MapPreviewCanvas::drawThumbnail()
+{
+	if (!map_preview_thumbs || map_hash.IsEmpty() || verts.empty())
+		return false;
+
+	// Request a new thumbnail if the current one is too small for the canvas
+	int max_size = min<int>(THUMB_MAX_SIZE, OpenGL::maxTextureSize());
+	int size = THUMB_MIN_SIZE;
+	while (size < max(GetSize().x, GetSize().y) && size * 2 <= max_size)
+		size *= 2;
+	if (size > thumb_size)
+		requestThumbnail(size);
+
+	// Upload new thumbnail if one is waiting
+	if (thumb_image)
+	{
+		if (!tex_thumb)
+		{
+			tex_thumb = new GLTexture(false);
+			tex_thumb->setFilter(GLTexture::MIPMAP);
+		}
+		tex_thumb->loadImage(thumb_image);
+		delete thumb_image;
+		thumb_image = NULL;
+	}
+
+	if (!tex_thumb || !tex_thumb->isLoaded())
+		return false;
+
+	// Draw thumbnail over the map area it covers (first row is the top)
+	glEnable(GL_TEXTURE_2D);
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+	tex_thumb->bind();
+	glBegin(GL_QUADS);
+	glTexCoord2f(0.0f, 0.0f);	glVertex2d(thumb_rect.x1(), thumb_rect.y2());
+	glTexCoord2f(0.0f, 1.0f);	glVertex2d(thumb_rect.x1(), thumb_rect.y1());
+	glTexCoord2f(1.0f, 1.0f);	glVertex2d(thumb_rect.x2(), thumb_rect.y1());
+	glTexCoord2f(1.0f, 0.0f);	glVertex2d(thumb_rect.x2(), thumb_rect.y2());
+	glEnd();
+	glDisable(GL_TEXTURE_2D);
+
+	return true;
+}
+
+
+/*******************************************************************
+ * MAPPREVIEWCANVAS CLASS EVENTS
+ *******************************************************************/
+
+/* MapPreviewCanvas::onThumbnailReady
+ * Called when a thumbnail has finished generating in the background
+ *******************************************************************/
+void MapPreviewCanvas::onThumbnailReady(wxThreadEvent& e)
+{
+	for (unsigned a = 0; a < thumb_threads.size(); a++)
+	{
+		MapThumbnailThread* thread = thumb_threads[a];
+		if (thread->serial != (unsigned)e.GetInt())
+			continue;
+
+		// Use the thumbnail if it's for the latest request
+		thread->Wait();
+		if (thread->serial == thumb_serial && thread->valid)
+		{
+			delete thumb_image;
+			thumb_image = thread->image;
+			thread->image = NULL;
+			thumb_rect = thread->rect;
+			Refresh();
+		}
+
+		delete thread;
+		thumb_threads.erase(thumb_threads.begin() + a);
+		return;
+	}
+}
+
+
+/*******************************************************************
+ * MAPPREVIEWCANVAS STATIC FUNCTIONS
+ *******************************************************************
+ * These don't use OpenGL and may be called from worker threads
+ */
+
+/* MapPreviewCanvas::fitView
+ * Gets the [zoom] and centre to show all of [verts] in an image of
+ * [width]x[height] pixels
+ *******************************************************************/
+void MapPreviewCanvas::fitView(vector<mep_vertex_t>& verts, int width, int height, double& zoom, double& centre_x, double& centre_y)
+{
+	// Find extents of map
+	mep_vertex_t m_min(999999.0, 999999.0);
+	mep_vertex_t m_max(-999999.0, -999999.0);
+	for (unsigned a = 0; a < verts.size(); a++)
+	{
+		if (verts[a].x < m_min.x)
+			m_min.x = verts[a].x;
+		if (verts[a].x > m_max.x)
+			m_max.x = verts[a].x;
+		if (verts[a].y < m_min.y)
+			m_min.y = verts[a].y;
+		if (verts[a].y > m_max.y)
+			m_max.y = verts[a].y;
+	}
+	if (verts.empty())
+		m_min = m_max = mep_vertex_t(0, 0);
+
+	// Centre of map
+	double mapwidth = m_max.x - m_min.x;
+	double mapheight = m_max.y - m_min.y;
+	centre_x = m_min.x + (mapwidth * 0.5);
+	centre_y = m_min.y + (mapheight * 0.5);
+
+	// Zoom to fit whole map
+	double x_scale = ((double)width) / max(mapwidth, 1.0);
+	double y_scale = ((double)height) / max(mapheight, 1.0);
+	zoom = MIN(x_scale, y_scale);
+	zoom *= 0.95;
+}
+
+/* MapPreviewCanvas::renderImage
+ * Draws [lines] into [image] (created as a [width]x[height] RGBA
+ * image), scaled to fit the whole map. Lines are drawn [thickness]
+ * pixels wide and antialiased, in software
+ *******************************************************************/
+void MapPreviewCanvas::renderImage(SImage& image, vector<mep_vertex_t>& verts, vector<mep_line_t>& lines, int width, int height, mep_colours_t& colours, double thickness)
+{
+	if (width <= 0 || height <= 0)
+	{
+		image.clear();
+		return;
+	}
+
+	// Fill background
+	uint8_t* data = new uint8_t[width * height * 4];
+	for (int a = 0; a < width * height * 4; a += 4)
+	{
+		data[a] = colours.background.r;
+		data[a + 1] = colours.background.g;
+		data[a + 2] = colours.background.b;
+		data[a + 3] = colours.background.a;
+	}
+
+	// Zoom/offset to show full map
+	double zoom, centre_x, centre_y;
+	fitView(verts, width, height, zoom, centre_x, centre_y);
+	double mid_x = width * 0.5;
+	double mid_y = height * 0.5;
+
+	// Draw 2s lines, then 1s lines over them
+	for (unsigned pass = 0; pass < 2; pass++)
+	{
+		for (unsigned a = 0; a < lines.size(); a++)
+		{
+			mep_line_t& line = lines[a];
+			if (line.twosided != (pass == 0))
+				continue;
+
+			// Check ends
+			if (line.v1 >= verts.size() || line.v2 >= verts.size())
+				continue;
+
+			// Get colour
+			rgba_t* colour;
+			if (line.special)
+				colour = &colours.line_special;
+			else if (line.macro)
+				colour = &colours.line_macro;
+			else if (line.twosided)
+				colour = &colours.line_2s;
+			else
+				colour = &colours.line_1s;
+
+			// Draw line (image y is top-down)
+			mep_vertex_t& v1 = verts[line.v1];
+			mep_vertex_t& v2 = verts[line.v2];
+			drawLine(data, width, height,
+			         mid_x + (v1.x - centre_x) * zoom, mid_y - (v1.y - centre_y) * zoom,
+			         mid_x + (v2.x - centre_x) * zoom, mid_y - (v2.y - centre_y) * zoom,
+			         *colour, thickness);
+		}
+	}
+
+	image.setImageData(data, width, height, RGBA);
+}
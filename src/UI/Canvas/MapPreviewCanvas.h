@@ -5,6 +5,8 @@
 #include "OGLCanvas.h"
 #include "Archive/Archive.h"
 
+wxDECLARE_EVENT(wxEVT_COMMAND_MAP_THUMBNAIL_READY, wxThreadEvent);
+
 // Structs for basic map features
 struct mep_vertex_t
 {
@@ -30,7 +32,19 @@ struct mep_thing_t
 	double	y;
 };
 
+// Colours to draw map lines with (see MapPreviewCanvas::renderImage)
+struct mep_colours_t
+{
+	rgba_t	background;
+	rgba_t	line_1s;
+	rgba_t	line_2s;
+	rgba_t	line_special;
+	rgba_t	line_macro;
+};
+
 class GLTexture;
+class SImage;
+class MapThumbnailThread;
 class MapPreviewCanvas : public OGLCanvas
 {
 private:
@@ -46,6 +60,21 @@ private:
 	GLTexture*				tex_thing;
 	bool					tex_loaded;
 
+	// Map thumbnail (lines rendered in software, in the background)
+	string						map_hash;
+	int							thumb_size;
+	GLTexture*					tex_thumb;
+	SImage*						thumb_image;
+	frect_t						thumb_rect;
+	unsigned					thumb_serial;
+	vector<MapThumbnailThread*>	thumb_threads;
+
+	void	clearThumbnail();
+	void	requestThumbnail(int size);
+	bool	drawThumbnail();
+
+	static void	fitView(vector<mep_vertex_t>& verts, int width, int height, double& zoom, double& centre_x, double& centre_y);
+
 public:
 	MapPreviewCanvas(wxWindow* parent);
 	~MapPreviewCanvas();
@@ -69,6 +98,10 @@ public:
 	unsigned	nThings();
 	unsigned	getWidth();
 	unsigned	getHeight();
+
+	void	onThumbnailReady(wxThreadEvent& e);
+
+	static void	renderImage(SImage& image, vector<mep_vertex_t>& verts, vector<mep_line_t>& lines, int width, int height, mep_colours_t& colours, double thickness);
 };
 
 #endif//__MAP_PREVIEW_CANVAS_H__
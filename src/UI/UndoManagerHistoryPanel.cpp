@@ -222,13 +222,21 @@ void UndoManagerHistoryPanel::onMenu(wxCommandEvent& e)
 	if (index <= manager->getCurrentIndex())
 	{
 		while (index <= manager->getCurrentIndex())
-			manager->undo();
+		{
+			if (manager->undo() == "")
+				break;
+		}
 	}
 	else
 	{
 		while (manager->getCurrentIndex() < index)
 		{
-			manager->redo();
+			if (manager->redo() == "")
+				break;
 		}
 	}
+
+	// Let the user know if a level couldn't be read back from the journal
+	if (manager->lastFailed())
+		wxMessageBox("Unable to read undo data from the undo journal, see the console log for details", "Undo Failed", wxICON_ERROR);
 }
@@ -127,7 +127,7 @@ bool MemChunk::reSize(uint32_t new_size, bool preserve_data)
 	// Preserve existing data if specified
 	if (preserve_data)
 	{
-		memcpy(ndata, data, size * sizeof(uint8_t));
+		memcpy(ndata, data, MIN(size, new_size) * sizeof(uint8_t));
 		delete[] data;
 		data = ndata;
 	}
@@ -445,6 +445,35 @@ bool MemChunk::readMC(MemChunk& mc, uint32_t size)
 		return false;
 }
 
+/* MemChunk::writeString
+ * Writes [str] as UTF-8 text, preceded by its length in bytes
+ *******************************************************************/
+bool MemChunk::writeString(const string& str)
+{
+	wxScopedCharBuffer utf8 = str.ToUTF8();
+	uint32_t len = utf8.length();
+	if (!write(&len, 4))
+		return false;
+
+	return len == 0 || write(utf8.data(), len);
+}
+
+/* MemChunk::readString
+ * Reads a string written by writeString into [str]. Returns false if
+ * attempting to read outside the chunk, true otherwise
+ *******************************************************************/
+bool MemChunk::readString(string& str)
+{
+	uint32_t len;
+	if (!read(&len, 4) || cur_ptr + len > size)
+		return false;
+
+	str = wxString::FromUTF8((const char*)data + cur_ptr, len);
+	cur_ptr += len;
+
+	return true;
+}
+
 /* MemChunk::fillData
  * Overwrites all data bytes with [val] (basically is memset).
  * Returns false if no data exists, true otherwise
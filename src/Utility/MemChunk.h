@@ -45,6 +45,8 @@ public:
 
 	// Extended C-style reading/writing
 	bool	readMC(MemChunk& mc, uint32_t size);
+	bool	writeString(const string& str);
+	bool	readString(string& str);
 
 	// Misc
 	bool		fillData(uint8_t val);
@@ -1,6 +1,7 @@
 
 #include "Main.h"
 #include "Polygon2D.h"
+#include "PolygonTriangulator.h"
 #include "OpenGL/GLTexture.h"
 #include "MapEditor/SLADEMap/SLADEMap.h"
 #include "MathStuff.h"
@@ -99,30 +100,19 @@ bool Polygon2D::openSector(MapSector* sector)
 		return false;
 
 	// Init
-	PolygonSplitter splitter;
+	PolygonTriangulator triangulator;
 	clear();
 
-	// Get list of sides connected to this sector
-	vector<MapSide*>& sides = sector->connectedSides();
-
-	// Go through sides
-	MapLine* line;
-	for (unsigned a = 0; a < sides.size(); a++)
-	{
-		line = sides[a]->getParentLine();
-
-		// Ignore this side if its parent line has the same sector on both sides
-		if (!line || line->doubleSector())
-			continue;
-
-		// Add the edge to the splitter (direction depends on what side of the line this is)
-		if (line->s1() == sides[a])
-			splitter.addEdge(line->v1()->xPos(), line->v1()->yPos(), line->v2()->xPos(), line->v2()->yPos());
-		else
-			splitter.addEdge(line->v2()->xPos(), line->v2()->yPos(), line->v1()->xPos(), line->v1()->yPos());
-	}
+	// Split the sector into convex sub-polygons
+	triangulator.openSector(sector);
+	if (triangulator.triangulate(this))
+		return true;
 
-	// Split the polygon into convex sub-polygons
+	// If that failed (the sector lines probably overlap or cross), fall
+	// back to the polygon splitter, which copes better with broken sectors
+	clear();
+	PolygonSplitter splitter;
+	splitter.openSector(sector);
 	return splitter.doSplitting(this);
 }
 
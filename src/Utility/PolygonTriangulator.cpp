@@ -0,0 +1,879 @@
+
+/*******************************************************************
+ * SLADE - It's a Doom Editor
+ * Copyright (C) 2008-2014 Simon Judd
+ *
+ * Email:       sirjuddington@gmail.com
+ * Web:         http://slade.mancubus.net
+ * Filename:    PolygonTriangulator.cpp
+ * Description: PolygonTriangulator class, splits polygon outlines
+ *              (eg. sectors) into convex sub-polygons via monotone
+ *              decomposition and triangulation
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *******************************************************************/
+
+
+/*******************************************************************
+ * INCLUDES
+ *******************************************************************/
+#include "Main.h"
+#include "PolygonTriangulator.h"
+#include "MapEditor/SLADEMap/SLADEMap.h"
+#include "Polygon2D.h"
+
+
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+namespace
+{
+	// Distance corners at the same position are moved apart by (see
+	// separateCorners), far smaller than anything in a real map
+	const double CORNER_SEPARATION = 0.000001;
+
+	// Sweep status probe, compares as the current sweep position
+	const int SWEEP_PROBE = INT_MAX;
+
+	// Sweep vertex types
+	enum
+	{
+		VERTEX_START,
+		VERTEX_END,
+		VERTEX_SPLIT,
+		VERTEX_MERGE,
+		VERTEX_REGULAR,
+	};
+}
+
+
+/*******************************************************************
+ * FUNCTIONS
+ *******************************************************************/
+
+/* turn
+ * Returns > 0 if [a]->[b]->[c] turns left, < 0 if it turns right
+ * and 0 if the points are collinear
+ *******************************************************************/
+static inline double turn(double ax, double ay, double bx, double by, double cx, double cy)
+{
+	return (bx - ax) * (cy - by) - (by - ay) * (cx - bx);
+}
+
+/* clockwiseAngle
+ * Returns the clockwise angle from direction [from] to [to] (both
+ * in radians), in the range (0, 2*PI]
+ *******************************************************************/
+static inline double clockwiseAngle(double from, double to)
+{
+	double angle = from - to;
+	while (angle <= 0)
+		angle += 2 * PI;
+	while (angle > 2 * PI)
+		angle -= 2 * PI;
+
+	return angle;
+}
+
+
+/*******************************************************************
+ * POLYGONTRIANGULATOR CLASS FUNCTIONS
+ *******************************************************************/
+
+/* PolygonTriangulator::status_cmp_t::operator()
+ * Returns true if sweep status edge [left] is left of [right] on the
+ * current sweep line
+ *******************************************************************/
+bool PolygonTriangulator::status_cmp_t::operator()(int left, int right) const
+{
+	double xl = t->sweepX(left);
+	double xr = t->sweepX(right);
+	if (xl != xr)
+		return xl < xr;
+
+	return left < right;
+}
+
+/* PolygonTriangulator::PolygonTriangulator
+ * PolygonTriangulator class constructor
+ *******************************************************************/
+PolygonTriangulator::PolygonTriangulator()
+{
+	area = 0;
+	sweep_corner = 0;
+}
+
+/* PolygonTriangulator::~PolygonTriangulator
+ * PolygonTriangulator class destructor
+ *******************************************************************/
+PolygonTriangulator::~PolygonTriangulator()
+{
+}
+
+/* PolygonTriangulator::clear
+ * Clears all outline and triangulation data
+ *******************************************************************/
+void PolygonTriangulator::clear()
+{
+	vertices.clear();
+	edges.clear();
+	vertex_map.clear();
+	corners.clear();
+	diagonals.clear();
+	tris.clear();
+	area = 0;
+}
+
+/* PolygonTriangulator::addVertex
+ * Adds a vertex at [x,y] if one doesn't already exist there, and
+ * returns its index
+ *******************************************************************/
+int PolygonTriangulator::addVertex(double x, double y)
+{
+	auto ins = vertex_map.insert(std::make_pair(std::make_pair(x, y), (int)vertices.size()));
+	if (ins.second)
+		vertices.push_back(vertex_t(x, y));
+
+	return ins.first->second;
+}
+
+/* PolygonTriangulator::addEdge
+ * Adds an outline edge from [x1,y1] to [x2,y2]. The polygon interior
+ * should be on the right side of the edge (as with sector sides)
+ *******************************************************************/
+void PolygonTriangulator::addEdge(double x1, double y1, double x2, double y2)
+{
+	addEdge(addVertex(x1, y1), addVertex(x2, y2));
+}
+
+/* PolygonTriangulator::addEdge
+ * Adds an outline edge from vertex [v1] to [v2]. The polygon
+ * interior should be on the right side of the edge
+ *******************************************************************/
+void PolygonTriangulator::addEdge(int v1, int v2)
+{
+	if (v1 == v2)
+		return;
+
+	// Edges are stored reversed (interior on the left), which is
+	// what all the triangulation steps below expect
+	edge_t edge;
+	edge.v1 = v2;
+	edge.v2 = v1;
+	edges.push_back(edge);
+}
+
+/* PolygonTriangulator::openSector
+ * Adds outline edges for all sides of [sector]
+ *******************************************************************/
+bool PolygonTriangulator::openSector(MapSector* sector)
+{
+	// Check sector was given
+	if (!sector)
+		return false;
+
+	// Init
+	clear();
+
+	// Go through sides
+	vector<MapSide*>& sides = sector->connectedSides();
+	for (unsigned a = 0; a < sides.size(); a++)
+	{
+		MapLine* line = sides[a]->getParentLine();
+
+		// Ignore this side if its parent line has the same sector on both sides
+		if (!line || line->doubleSector())
+			continue;
+
+		// Add the edge (direction depends on what side of the line this is)
+		if (line->s1() == sides[a])
+			addEdge(line->v1()->xPos(), line->v1()->yPos(), line->v2()->xPos(), line->v2()->yPos());
+		else
+			addEdge(line->v2()->xPos(), line->v2()->yPos(), line->v1()->xPos(), line->v1()->yPos());
+	}
+
+	return true;
+}
+
+/* PolygonTriangulator::traceOutlines
+ * Traces closed outlines from the edges, building the list of
+ * corners. Edges that aren't part of a closed outline are ignored.
+ * Where more than one outline meets at a vertex, the outline always
+ * turns as sharply left (into the interior) as it can, so outlines
+ * touching at a vertex are kept separate
+ *******************************************************************/
+bool PolygonTriangulator::traceOutlines()
+{
+	// Remove duplicate edges, and edges that exist in both directions
+	// (interior on both sides, so not really part of the outline)
+	std::sort(edges.begin(), edges.end());
+	edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+	vector<edge_t> valid;
+	for (unsigned a = 0; a < edges.size(); a++)
+	{
+		edge_t reverse;
+		reverse.v1 = edges[a].v2;
+		reverse.v2 = edges[a].v1;
+		if (!std::binary_search(edges.begin(), edges.end(), reverse))
+			valid.push_back(edges[a]);
+	}
+	edges.swap(valid);
+
+	// Edges are sorted by first vertex, so get the range of edges
+	// going out of each vertex
+	vector<int> out_start(vertices.size() + 1, 0);
+	for (unsigned a = 0; a < edges.size(); a++)
+		out_start[edges[a].v1 + 1]++;
+	for (unsigned a = 0; a < vertices.size(); a++)
+		out_start[a + 1] += out_start[a];
+
+	// Trace outlines. This walks edges depth-first, backing up past
+	// any edge that leads to a dead end (and ignoring it from then on),
+	// so each edge is only visited once
+	enum { EDGE_FREE, EDGE_TRACING, EDGE_DONE };
+	vector<uint8_t> state(edges.size(), EDGE_FREE);
+	vector<int> pos(edges.size(), 0);
+	vector<int> path;
+	for (unsigned start = 0; start < edges.size(); start++)
+	{
+		if (state[start] != EDGE_FREE)
+			continue;
+
+		state[start] = EDGE_TRACING;
+		pos[start] = 0;
+		path.push_back(start);
+		while (!path.empty())
+		{
+			// Find the next edge, turning as sharply left as possible
+			const edge_t& edge = edges[path.back()];
+			const vertex_t& v1 = vertices[edge.v1];
+			const vertex_t& v2 = vertices[edge.v2];
+			double back = -1;
+			double min_angle = 3 * PI;
+			int next = -1;
+			for (int e = out_start[edge.v2]; e < out_start[edge.v2 + 1]; e++)
+			{
+				if (state[e] == EDGE_DONE)
+					continue;
+
+				// Only need to compare angles if there is more than one option
+				if (next >= 0 && back < 0)
+				{
+					back = atan2(v1.y - v2.y, v1.x - v2.x);
+					const vertex_t& vn = vertices[edges[next].v2];
+					min_angle = clockwiseAngle(back, atan2(vn.y - v2.y, vn.x - v2.x));
+				}
+				if (next >= 0)
+				{
+					const vertex_t& ve = vertices[edges[e].v2];
+					double angle = clockwiseAngle(back, atan2(ve.y - v2.y, ve.x - v2.x));
+					if (angle >= min_angle)
+						continue;
+					min_angle = angle;
+				}
+
+				next = e;
+			}
+
+			// Dead end, ignore this edge and back up
+			if (next < 0)
+			{
+				state[path.back()] = EDGE_DONE;
+				path.pop_back();
+				continue;
+			}
+
+			// Not at an edge already traced, continue
+			if (state[next] == EDGE_FREE)
+			{
+				state[next] = EDGE_TRACING;
+				pos[next] = path.size();
+				path.push_back(next);
+				continue;
+			}
+
+			// Otherwise we have a closed outline, add corners for it
+			int first = corners.size();
+			int n_corners = path.size() - pos[next];
+			for (int a = 0; a < n_corners; a++)
+			{
+				int e = path[pos[next] + a];
+				corner_t corner;
+				corner.vertex = edges[e].v1;
+				corner.next = first + (a + 1) % n_corners;
+				corner.prev = first + (a + n_corners - 1) % n_corners;
+				corner.x = vertices[corner.vertex].x;
+				corner.y = vertices[corner.vertex].y;
+				corners.push_back(corner);
+
+				// Add to total area
+				const vertex_t& p1 = vertices[edges[e].v1];
+				const vertex_t& p2 = vertices[edges[e].v2];
+				area += (p1.x * p2.y - p2.x * p1.y) * 0.5;
+
+				state[e] = EDGE_DONE;
+			}
+			path.resize(pos[next]);
+		}
+	}
+
+	return !corners.empty();
+}
+
+/* PolygonTriangulator::separateCorners
+ * Moves corners that are at the same position as another corner (ie.
+ * where outlines touch) a tiny distance into their own interior, so
+ * the sweep never has to deal with two corners at the same point.
+ * The original vertex positions are still used for the final
+ * polygons
+ *******************************************************************/
+void PolygonTriangulator::separateCorners()
+{
+	// Count corners at each vertex
+	vector<int> count(vertices.size(), 0);
+	for (unsigned a = 0; a < corners.size(); a++)
+		count[corners[a].vertex]++;
+
+	// Move shared corners along the bisector of their interior angle
+	for (unsigned a = 0; a < corners.size(); a++)
+	{
+		corner_t& corner = corners[a];
+		if (count[corner.vertex] < 2)
+			continue;
+
+		const vertex_t& v = vertices[corner.vertex];
+		const vertex_t& vn = vertices[corners[corner.next].vertex];
+		const vertex_t& vp = vertices[corners[corner.prev].vertex];
+		double out = atan2(vn.y - v.y, vn.x - v.x);
+		double back = atan2(vp.y - v.y, vp.x - v.x);
+		double bisector = out + clockwiseAngle(back, out) * 0.5;
+
+		corner.x = v.x + cos(bisector) * CORNER_SEPARATION;
+		corner.y = v.y + sin(bisector) * CORNER_SEPARATION;
+	}
+}
+
+/* PolygonTriangulator::above
+ * Returns true if corner [c1] comes before [c2] in sweep order (top
+ * to bottom, then left to right)
+ *******************************************************************/
+bool PolygonTriangulator::above(int c1, int c2)
+{
+	const corner_t& p1 = corners[c1];
+	const corner_t& p2 = corners[c2];
+	if (p1.y != p2.y)
+		return p1.y > p2.y;
+	if (p1.x != p2.x)
+		return p1.x < p2.x;
+
+	return c1 < c2;
+}
+
+/* PolygonTriangulator::sweepX
+ * Returns the x position where the sweep status edge starting at
+ * corner [edge] crosses the current sweep line
+ *******************************************************************/
+double PolygonTriangulator::sweepX(int edge)
+{
+	const corner_t& sweep = corners[sweep_corner];
+	if (edge == SWEEP_PROBE)
+		return sweep.x;
+
+	const corner_t& upper = corners[edge];
+	const corner_t& lower = corners[upper.next];
+
+	// Horizontal edge, the sweep line meets it at the sweep position
+	if (upper.y == lower.y)
+		return MAX(MIN(sweep.x, MAX(upper.x, lower.x)), MIN(upper.x, lower.x));
+
+	return upper.x + (sweep.y - upper.y) * (lower.x - upper.x) / (lower.y - upper.y);
+}
+
+/* PolygonTriangulator::makeMonotone
+ * Sweeps down through the corners, adding diagonals that split the
+ * outlines into y-monotone pieces. Returns false if the outlines
+ * turned out to be invalid (eg. overlapping)
+ *******************************************************************/
+bool PolygonTriangulator::makeMonotone()
+{
+	// Sort corners into sweep order
+	vector<int> order(corners.size());
+	for (unsigned a = 0; a < corners.size(); a++)
+		order[a] = a;
+	std::sort(order.begin(), order.end(), [&](int l, int r) { return above(l, r); });
+
+	// The sweep status holds the edges (by upper corner) that have the
+	// interior to their right, ordered left to right
+	typedef std::set<int, status_cmp_t> status_t;
+	status_t status(status_cmp_t(this));
+	vector<status_t::iterator> status_it(corners.size());
+	vector<uint8_t> in_status(corners.size(), 0);
+	vector<int> helper(corners.size(), -1);
+	vector<uint8_t> type(corners.size(), VERTEX_REGULAR);
+
+	for (unsigned a = 0; a < order.size(); a++)
+	{
+		int c = order[a];
+		int prev = corners[c].prev;
+		int next = corners[c].next;
+		sweep_corner = c;
+
+		// Determine vertex type
+		bool prev_below = above(c, prev);
+		bool next_below = above(c, next);
+		bool convex = turn(corners[prev].x, corners[prev].y, corners[c].x, corners[c].y, corners[next].x, corners[next].y) >= 0;
+		if (prev_below && next_below)
+			type[c] = convex ? VERTEX_START : VERTEX_SPLIT;
+		else if (!prev_below && !next_below)
+			type[c] = convex ? VERTEX_END : VERTEX_MERGE;
+		else
+			type[c] = VERTEX_REGULAR;
+
+		// End of the edge above (end, merge and regular vertices on the left)
+		if (type[c] == VERTEX_END || type[c] == VERTEX_MERGE || (type[c] == VERTEX_REGULAR && !prev_below))
+		{
+			if (!in_status[prev])
+				return false;
+			if (type[helper[prev]] == VERTEX_MERGE)
+			{
+				diagonals.push_back(c);
+				diagonals.push_back(helper[prev]);
+			}
+			status.erase(status_it[prev]);
+			in_status[prev] = 0;
+		}
+
+		// Update edge to the left (split, merge and regular vertices on the right)
+		if (type[c] == VERTEX_SPLIT || type[c] == VERTEX_MERGE || (type[c] == VERTEX_REGULAR && prev_below))
+		{
+			status_t::iterator i = status.lower_bound(SWEEP_PROBE);
+			if (i == status.begin())
+				return false;
+			int left = *(--i);
+
+			if (type[c] == VERTEX_SPLIT || type[helper[left]] == VERTEX_MERGE)
+			{
+				diagonals.push_back(c);
+				diagonals.push_back(helper[left]);
+			}
+			helper[left] = c;
+		}
+
+		// Start of the edge below (start, split and regular vertices on the left)
+		if (type[c] == VERTEX_START || type[c] == VERTEX_SPLIT || (type[c] == VERTEX_REGULAR && !prev_below))
+		{
+			status_it[c] = status.insert(c).first;
+			in_status[c] = 1;
+			helper[c] = c;
+		}
+	}
+
+	return true;
+}
+
+/* PolygonTriangulator::triangulateFaces
+ * Splits the outlines into faces along the diagonals added by
+ * makeMonotone, and triangulates each of them
+ *******************************************************************/
+bool PolygonTriangulator::triangulateFaces()
+{
+	// Half-edges are [corner] -> [corner.next] for the outlines, then
+	// both directions of each diagonal
+	unsigned n_corners = corners.size();
+	unsigned n_halfedges = n_corners + diagonals.size();
+	vector<int> origin(n_halfedges);
+	vector<int> dest(n_halfedges);
+	for (unsigned a = 0; a < n_corners; a++)
+	{
+		origin[a] = a;
+		dest[a] = corners[a].next;
+	}
+	for (unsigned a = 0; a < diagonals.size(); a += 2)
+	{
+		origin[n_corners + a] = diagonals[a];
+		dest[n_corners + a] = diagonals[a + 1];
+		origin[n_corners + a + 1] = diagonals[a + 1];
+		dest[n_corners + a + 1] = diagonals[a];
+	}
+
+	// Get diagonal half-edges going out of each corner
+	vector<int> diag_start(n_corners + 1, 0);
+	vector<int> diag_out(diagonals.size());
+	for (unsigned a = 0; a < diagonals.size(); a++)
+		diag_start[diagonals[a] + 1]++;
+	for (unsigned a = 0; a < n_corners; a++)
+		diag_start[a + 1] += diag_start[a];
+	vector<int> diag_fill(diag_start.begin(), diag_start.end() - 1);
+	for (unsigned a = 0; a < diagonals.size(); a++)
+		diag_out[diag_fill[diagonals[a]]++] = n_corners + a;
+
+	// Trace faces
+	vector<uint8_t> visited(n_halfedges, 0);
+	vector<int> face;
+	for (unsigned start = 0; start < n_halfedges; start++)
+	{
+		if (visited[start])
+			continue;
+
+		face.clear();
+		int h = start;
+		while (!visited[h])
+		{
+			visited[h] = 1;
+			face.push_back(origin[h]);
+
+			// Next half-edge is the one at the end of this turning
+			// as sharply left as possible
+			int d = dest[h];
+			int next = d;
+			if (diag_start[d] != diag_start[d + 1])
+			{
+				const corner_t& cd = corners[d];
+				double back = atan2(corners[origin[h]].y - cd.y, corners[origin[h]].x - cd.x);
+				double min_angle = clockwiseAngle(back, atan2(corners[cd.next].y - cd.y, corners[cd.next].x - cd.x));
+				for (int a = diag_start[d]; a < diag_start[d + 1]; a++)
+				{
+					const corner_t& co = corners[dest[diag_out[a]]];
+					double angle = clockwiseAngle(back, atan2(co.y - cd.y, co.x - cd.x));
+					if (angle < min_angle)
+					{
+						min_angle = angle;
+						next = diag_out[a];
+					}
+				}
+			}
+
+			h = next;
+		}
+
+		// Faces should always close where they started
+		if (h != (int)start)
+			return false;
+
+		triangulateMonotone(face);
+	}
+
+	return true;
+}
+
+/* PolygonTriangulator::triangulateMonotone
+ * Triangulates the y-monotone polygon [face] (corners anticlockwise)
+ *******************************************************************/
+void PolygonTriangulator::triangulateMonotone(vector<int>& face)
+{
+	unsigned n = face.size();
+	if (n < 3)
+		return;
+	if (n == 3)
+	{
+		addTriangle(face[0], face[1], face[2]);
+		return;
+	}
+
+	// Find top and bottom corners
+	unsigned top = 0;
+	unsigned bottom = 0;
+	for (unsigned a = 1; a < n; a++)
+	{
+		if (above(face[a], face[top]))
+			top = a;
+		if (above(face[bottom], face[a]))
+			bottom = a;
+	}
+
+	// Get the left chain (top to bottom, going forwards) and right
+	// chain (bottom to top, going backwards)
+	vector<int> chain_left;
+	vector<int> chain_right;
+	for (unsigned a = top; a != bottom; a = (a + 1) % n)
+		chain_left.push_back(face[a]);
+	for (unsigned a = (top + n - 1) % n; ; a = (a + n - 1) % n)
+	{
+		chain_right.push_back(face[a]);
+		if (a == bottom)
+			break;
+	}
+
+	// Merge the chains into sweep order
+	vector<int> sorted;
+	vector<uint8_t> left;
+	sorted.reserve(n);
+	left.reserve(n);
+	unsigned l = 0;
+	unsigned r = 0;
+	while (l < chain_left.size() || r < chain_right.size())
+	{
+		if (r == chain_right.size() || (l < chain_left.size() && above(chain_left[l], chain_right[r])))
+		{
+			sorted.push_back(chain_left[l++]);
+			left.push_back(1);
+		}
+		else
+		{
+			sorted.push_back(chain_right[r++]);
+			left.push_back(0);
+		}
+	}
+
+	// Triangulate
+	vector<unsigned> stack;
+	stack.push_back(0);
+	stack.push_back(1);
+	for (unsigned j = 2; j < n - 1; j++)
+	{
+		if (left[j] != left[stack.back()])
+		{
+			// Opposite chain, fan to everything on the stack
+			while (stack.size() > 1)
+			{
+				unsigned s = stack.back();
+				stack.pop_back();
+				addTriangle(sorted[j], sorted[s], sorted[stack.back()]);
+			}
+			stack.clear();
+			stack.push_back(j - 1);
+			stack.push_back(j);
+		}
+		else
+		{
+			// Same chain, cut off convex corners
+			unsigned last = stack.back();
+			stack.pop_back();
+			while (!stack.empty())
+			{
+				const corner_t& cj = corners[sorted[j]];
+				const corner_t& cl = corners[sorted[last]];
+				const corner_t& ct = corners[sorted[stack.back()]];
+				double t = left[j] ? turn(ct.x, ct.y, cl.x, cl.y, cj.x, cj.y) : turn(cj.x, cj.y, cl.x, cl.y, ct.x, ct.y);
+				if (t <= 0)
+					break;
+
+				addTriangle(sorted[j], sorted[last], sorted[stack.back()]);
+				last = stack.back();
+				stack.pop_back();
+			}
+			stack.push_back(last);
+			stack.push_back(j);
+		}
+	}
+
+	// Fan from the bottom corner to what's left on the stack
+	while (stack.size() > 1)
+	{
+		unsigned s = stack.back();
+		stack.pop_back();
+		addTriangle(sorted[n - 1], sorted[s], sorted[stack.back()]);
+	}
+}
+
+/* PolygonTriangulator::addTriangle
+ * Adds a triangle with corners [c1], [c2] and [c3] (made
+ * anticlockwise if needed)
+ *******************************************************************/
+void PolygonTriangulator::addTriangle(int c1, int c2, int c3)
+{
+	const corner_t& p1 = corners[c1];
+	const corner_t& p2 = corners[c2];
+	const corner_t& p3 = corners[c3];
+	if (turn(p1.x, p1.y, p2.x, p2.y, p3.x, p3.y) < 0)
+		std::swap(c2, c3);
+
+	tris.push_back(c1);
+	tris.push_back(c2);
+	tris.push_back(c3);
+}
+
+/* PolygonTriangulator::buildConvexPolys
+ * Merges adjacent triangles wherever the result is still convex, and
+ * adds the resulting convex polygons to [poly] as sub-polygons
+ *******************************************************************/
+void PolygonTriangulator::buildConvexPolys(Polygon2D* poly)
+{
+	// Each triangle corner is a node in a (circular) linked list for
+	// the polygon it's part of, node n is the polygon edge from its
+	// corner to the next node's corner
+	unsigned n_nodes = tris.size();
+	vector<int> next(n_nodes);
+	vector<int> prev(n_nodes);
+	for (unsigned a = 0; a < n_nodes; a++)
+	{
+		unsigned base = a - (a % 3);
+		next[a] = base + (a % 3 + 1) % 3;
+		prev[a] = base + (a % 3 + 2) % 3;
+	}
+
+	// Find edges shared by two triangles, by sorting nodes by edge
+	vector<std::pair<int, int>> keys(n_nodes);
+	vector<unsigned> order(n_nodes);
+	for (unsigned a = 0; a < n_nodes; a++)
+	{
+		int c1 = tris[a];
+		int c2 = tris[next[a]];
+		keys[a] = std::make_pair(MIN(c1, c2), MAX(c1, c2));
+		order[a] = a;
+	}
+	std::sort(order.begin(), order.end(), [&](unsigned l, unsigned r) { return keys[l] < keys[r]; });
+
+	// When a node is removed by a merge, [alias] is the node that
+	// now starts the same polygon edge
+	vector<int> alias(n_nodes, -1);
+	auto findNode = [&](int node)
+	{
+		while (alias[node] >= 0)
+			node = alias[node];
+		return node;
+	};
+
+	// Polygon each node is part of (union-find by triangle)
+	vector<int> group(n_nodes / 3);
+	for (unsigned a = 0; a < group.size(); a++)
+		group[a] = a;
+	auto findGroup = [&](int node)
+	{
+		int g = node / 3;
+		while (group[g] != g)
+		{
+			group[g] = group[group[g]];
+			g = group[g];
+		}
+		return g;
+	};
+
+	// Merge across shared edges where the result is convex
+	for (unsigned a = 0; a + 1 < n_nodes; a++)
+	{
+		// Needs to be exactly two (opposite) edges
+		if (keys[order[a]] != keys[order[a + 1]])
+			continue;
+		if (a + 2 < n_nodes && keys[order[a + 1]] == keys[order[a + 2]])
+		{
+			while (a + 1 < n_nodes && keys[order[a]] == keys[order[a + 1]])
+				a++;
+			continue;
+		}
+
+		int na = findNode(order[a]);
+		int nb = findNode(order[a + 1]);
+		a++;
+		if (tris[na] == tris[nb])
+			continue;
+		int ga = findGroup(na);
+		int gb = findGroup(nb);
+		if (ga == gb)
+			continue;
+
+		// [na] is a->b in one polygon, [nb] is b->a in the other
+		int nb_a = next[na];	// b in na's polygon
+		int na_b = next[nb];	// a in nb's polygon
+		const corner_t& ca = corners[tris[na]];
+		const corner_t& cb = corners[tris[nb]];
+		const corner_t& ca_prev = corners[tris[prev[na]]];
+		const corner_t& ca_next = corners[tris[next[na_b]]];
+		const corner_t& cb_prev = corners[tris[prev[nb]]];
+		const corner_t& cb_next = corners[tris[next[nb_a]]];
+		if (turn(ca_prev.x, ca_prev.y, ca.x, ca.y, ca_next.x, ca_next.y) < 0 ||
+			turn(cb_prev.x, cb_prev.y, cb.x, cb.y, cb_next.x, cb_next.y) < 0)
+			continue;
+
+		// Merge
+		int after_a = next[na_b];
+		int after_b = next[nb_a];
+		next[na] = after_a;
+		prev[after_a] = na;
+		next[nb] = after_b;
+		prev[after_b] = nb;
+		alias[na_b] = na;
+		alias[nb_a] = nb;
+		group[gb] = ga;
+	}
+
+	// Add polygons
+	vector<uint8_t> done(n_nodes, 0);
+	vector<int> verts;
+	for (unsigned a = 0; a < n_nodes; a++)
+	{
+		if (done[a] || alias[a] >= 0)
+			continue;
+
+		verts.clear();
+		int node = a;
+		while (!done[node])
+		{
+			done[node] = 1;
+			verts.push_back(corners[tris[node]].vertex);
+			node = next[node];
+		}
+
+		if (verts.size() < 3)
+			continue;
+
+		// Add sub-polygon (clockwise, the same as the polygon outline)
+		poly->addSubPoly();
+		gl_polygon_t* subpoly = poly->getSubPoly(poly->nSubPolys() - 1);
+		subpoly->n_vertices = verts.size();
+		subpoly->vertices = new gl_vertex_t[verts.size()];
+		for (unsigned v = 0; v < verts.size(); v++)
+		{
+			subpoly->vertices[v].x = vertices[verts[verts.size() - 1 - v]].x;
+			subpoly->vertices[v].y = vertices[verts[verts.size() - 1 - v]].y;
+		}
+	}
+}
+
+/* PolygonTriangulator::triangulate
+ * Splits the outline into convex sub-polygons and adds them to
+ * [poly]. Returns false if the outline couldn't be split properly,
+ * in which case nothing is added to [poly]
+ *******************************************************************/
+bool PolygonTriangulator::triangulate(Polygon2D* poly)
+{
+	// Init
+	corners.clear();
+	diagonals.clear();
+	tris.clear();
+	area = 0;
+
+	// Trace outlines, nothing to do if there are none
+	if (!traceOutlines())
+		return true;
+
+	// Interior area should be positive (holes can't be bigger than
+	// the outer outlines)
+	if (area <= 0)
+		return false;
+
+	// Split into monotone pieces and triangulate them
+	separateCorners();
+	if (!makeMonotone() || !triangulateFaces())
+		return false;
+
+	// Check the triangles cover exactly the area of the outlines, if
+	// not the outlines overlap or cross (or something else is wrong)
+	double tri_area = 0;
+	for (unsigned a = 0; a < tris.size(); a += 3)
+	{
+		const corner_t& p1 = corners[tris[a]];
+		const corner_t& p2 = corners[tris[a + 1]];
+		const corner_t& p3 = corners[tris[a + 2]];
+		tri_area += turn(p1.x, p1.y, p2.x, p2.y, p3.x, p3.y) * 0.5;
+	}
+	if (fabs(tri_area - area) > area * 0.000001 + 0.001)
+		return false;
+
+	// Build convex polygons from the triangles
+	buildConvexPolys(poly);
+
+	return true;
+}
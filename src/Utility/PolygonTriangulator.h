@@ -0,0 +1,85 @@
+
+#ifndef __POLYGON_TRIANGULATOR_H__
+#define __POLYGON_TRIANGULATOR_H__
+
+class MapSector;
+class Polygon2D;
+
+// Splits a polygon outline (that may have holes, and outlines touching
+// at vertices) into convex sub-polygons in O(n log n). The outline is
+// first split into y-monotone pieces with a sweep line, these are then
+// triangulated and adjacent triangles merged back together wherever
+// the result stays convex (so there are fewer, larger sub-polygons to
+// draw as triangle fans). The result is checked against the area of
+// the outline, so triangulate() fails rather than giving a broken
+// polygon if the outline is invalid (eg. unclosed or overlapping)
+class PolygonTriangulator
+{
+public:
+	PolygonTriangulator();
+	~PolygonTriangulator();
+
+	void	clear();
+	int		addVertex(double x, double y);
+	void	addEdge(double x1, double y1, double x2, double y2);
+	void	addEdge(int v1, int v2);
+	bool	openSector(MapSector* sector);
+
+	bool		triangulate(Polygon2D* poly);
+	unsigned	nTriangles() { return tris.size() / 3; }
+
+private:
+	struct vertex_t
+	{
+		double	x, y;
+		vertex_t(double x, double y) { this->x = x; this->y = y; }
+	};
+
+	struct edge_t
+	{
+		int	v1, v2;
+		bool operator<(const edge_t& right) const { return v1 < right.v1 || (v1 == right.v1 && v2 < right.v2); }
+		bool operator==(const edge_t& right) const { return v1 == right.v1 && v2 == right.v2; }
+	};
+
+	// A vertex of an outline. Vertices shared between outlines (or
+	// visited twice by the same outline) have a corner for each visit
+	struct corner_t
+	{
+		int		vertex;
+		int		next;
+		int		prev;
+		double	x, y;	// Position used for the sweep (see separateCorners)
+	};
+
+	// Orders sweep status edges (identified by their upper corner) by
+	// x position along the current sweep line
+	struct status_cmp_t
+	{
+		PolygonTriangulator* t;
+		status_cmp_t(PolygonTriangulator* t) { this->t = t; }
+		bool operator()(int left, int right) const;
+	};
+
+	vector<vertex_t>	vertices;
+	vector<edge_t>		edges;
+	std::map<std::pair<double, double>, int>	vertex_map;
+
+	vector<corner_t>	corners;
+	double				area;
+	vector<int>			diagonals;	// Corner pairs
+	vector<int>			tris;		// Corner triples
+	int					sweep_corner;
+
+	bool	traceOutlines();
+	void	separateCorners();
+	bool	above(int c1, int c2);
+	double	sweepX(int edge);
+	bool	makeMonotone();
+	bool	triangulateFaces();
+	void	triangulateMonotone(vector<int>& face);
+	void	addTriangle(int c1, int c2, int c3);
+	void	buildConvexPolys(Polygon2D* poly);
+};
+
+#endif//__POLYGON_TRIANGULATOR_H__
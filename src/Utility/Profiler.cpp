@@ -0,0 +1,300 @@
+
+/*******************************************************************
+ * SLADE - It's a Doom Editor
+ * Copyright (C) 2008-2014 Simon Judd
+ *
+ * Email:       sirjuddington@gmail.com
+ * Web:         http://slade.mancubus.net
+ * Filename:    Profiler.cpp
+ * Description: Profiler namespace, times nested passes with scoped
+ *              timers and keeps rolling per-frame statistics for
+ *              each of them
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *******************************************************************/
+
+
+/*******************************************************************
+ * INCLUDES
+ *******************************************************************/
+#include "Main.h"
+#include "Profiler.h"
+
+
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+namespace Profiler
+{
+	struct pass_t
+	{
+		const char*	name;
+		int			depth;
+		vector<int>	children;
+
+		// Current frame
+		int64_t		frame_us;
+		unsigned	frame_calls;
+
+		// Last [HISTORY_SIZE] frames, calls is 0 if the pass wasn't run
+		float		history_ms[HISTORY_SIZE];
+		unsigned	history_calls[HISTORY_SIZE];
+	};
+
+	struct scope_timer_t
+	{
+		int		pass;
+		int64_t	start;
+	};
+
+	bool			enabled = false;
+	sf::Clock		clock;
+	vector<pass_t>	passes;
+	vector<int>		roots;
+	vector<scope_timer_t>	stack;
+	unsigned		frame_count = 0;
+	int64_t			frame_start = 0;
+	float			frame_history_ms[HISTORY_SIZE];
+}
+
+
+/*******************************************************************
+ * PROFILER NAMESPACE FUNCTIONS
+ *******************************************************************/
+
+/* Profiler::isEnabled
+ * Returns true if passes are currently being timed
+ *******************************************************************/
+bool Profiler::isEnabled()
+{
+	return enabled;
+}
+
+/* Profiler::setEnabled
+ * Enables or disables timing. Statistics gathered so far are kept
+ * while disabled
+ *******************************************************************/
+void Profiler::setEnabled(bool enable)
+{
+	if (enable == enabled)
+		return;
+
+	enabled = enable;
+	stack.clear();
+
+	// Don't count the time spent disabled as part of a frame
+	frame_start = clock.getElapsedTime().asMicroseconds();
+	for (unsigned a = 0; a < passes.size(); a++)
+	{
+		passes[a].frame_us = 0;
+		passes[a].frame_calls = 0;
+	}
+}
+
+/* Profiler::reset
+ * Clears all passes and statistics
+ *******************************************************************/
+void Profiler::reset()
+{
+	passes.clear();
+	roots.clear();
+	stack.clear();
+	frame_count = 0;
+	frame_start = clock.getElapsedTime().asMicroseconds();
+}
+
+/* Profiler::begin
+ * Starts timing pass [name], within the pass currently being timed
+ * (if any)
+ *******************************************************************/
+void Profiler::begin(const char* name)
+{
+	if (!enabled)
+		return;
+
+	// Find pass within the current parent
+	vector<int>& siblings = stack.empty() ? roots : passes[stack.back().pass].children;
+	int pass = -1;
+	for (unsigned a = 0; a < siblings.size(); a++)
+	{
+		if (passes[siblings[a]].name == name || strcmp(passes[siblings[a]].name, name) == 0)
+		{
+			pass = siblings[a];
+			break;
+		}
+	}
+
+	// Add it if it hasn't been run here before
+	if (pass < 0)
+	{
+		pass_t p;
+		p.name = name;
+		p.depth = stack.size();
+		p.frame_us = 0;
+		p.frame_calls = 0;
+		memset(p.history_ms, 0, sizeof(p.history_ms));
+		memset(p.history_calls, 0, sizeof(p.history_calls));
+
+		pass = passes.size();
+		siblings.push_back(pass);	// (Before adding to [passes], which may move [siblings])
+		passes.push_back(p);
+	}
+
+	scope_timer_t timer;
+	timer.pass = pass;
+	timer.start = clock.getElapsedTime().asMicroseconds();
+	stack.push_back(timer);
+}
+
+/* Profiler::end
+ * Stops timing the most recently begun pass
+ *******************************************************************/
+void Profiler::end()
+{
+	if (stack.empty())
+		return;
+
+	pass_t& pass = passes[stack.back().pass];
+	pass.frame_us += clock.getElapsedTime().asMicroseconds() - stack.back().start;
+	pass.frame_calls++;
+	stack.pop_back();
+}
+
+/* Profiler::endFrame
+ * Adds the timings for the current frame to the history of each
+ * pass and starts a new frame
+ *******************************************************************/
+void Profiler::endFrame()
+{
+	if (!enabled)
+		return;
+
+	int64_t now = clock.getElapsedTime().asMicroseconds();
+	unsigned slot = frame_count % HISTORY_SIZE;
+	frame_history_ms[slot] = (now - frame_start) * 0.001f;
+	frame_start = now;
+
+	for (unsigned a = 0; a < passes.size(); a++)
+	{
+		passes[a].history_ms[slot] = passes[a].frame_us * 0.001f;
+		passes[a].history_calls[slot] = passes[a].frame_calls;
+		passes[a].frame_us = 0;
+		passes[a].frame_calls = 0;
+	}
+
+	frame_count++;
+}
+
+/* Profiler::frameTime
+ * Returns the average frame time (ms) over the frame history
+ *******************************************************************/
+double Profiler::frameTime()
+{
+	unsigned frames = std::min(frame_count, HISTORY_SIZE);
+	if (frames == 0)
+		return 0;
+
+	double total = 0;
+	for (unsigned a = 0; a < frames; a++)
+		total += frame_history_ms[a];
+
+	return total / frames;
+}
+
+namespace Profiler
+{
+	// Adds statistics for [pass] and its children (depth-first) to [stats]
+	void addStats(int pass, string path, vector<stats_t>& stats)
+	{
+		pass_t& p = passes[pass];
+		path += p.name;
+
+		// Get statistics over the frames the pass was run in
+		stats_t s;
+		s.frames = 0;
+		s.calls = 0;
+		s.avg_ms = s.min_ms = s.max_ms = 0;
+		unsigned n_frames = std::min(frame_count, HISTORY_SIZE);
+		for (unsigned a = 0; a < n_frames; a++)
+		{
+			if (p.history_calls[a] == 0)
+				continue;
+
+			double ms = p.history_ms[a];
+			if (s.frames == 0 || ms < s.min_ms)
+				s.min_ms = ms;
+			if (s.frames == 0 || ms > s.max_ms)
+				s.max_ms = ms;
+			s.avg_ms += ms;
+			s.calls += p.history_calls[a];
+			s.frames++;
+		}
+
+		// Ignore passes that haven't been run recently (along with their children)
+		if (s.frames == 0)
+			return;
+
+		s.path = path;
+		s.name = p.name;
+		s.depth = p.depth;
+		s.avg_ms /= s.frames;
+		s.calls /= s.frames;
+		unsigned last = (frame_count + HISTORY_SIZE - 1) % HISTORY_SIZE;
+		s.last_ms = p.history_calls[last] > 0 ? p.history_ms[last] : 0;
+		stats.push_back(s);
+
+		for (unsigned a = 0; a < p.children.size(); a++)
+			addStats(p.children[a], path + "/", stats);
+	}
+}
+
+/* Profiler::getStats
+ * Adds statistics for all passes run within the frame history to
+ * [stats], with each pass followed by its children
+ *******************************************************************/
+void Profiler::getStats(vector<stats_t>& stats)
+{
+	for (unsigned a = 0; a < roots.size(); a++)
+		addStats(roots[a], "", stats);
+}
+
+/* Profiler::statsCSV
+ * Returns statistics for all passes run within the frame history
+ * as CSV text, one pass per line
+ *******************************************************************/
+string Profiler::statsCSV()
+{
+	vector<stats_t> stats;
+	getStats(stats);
+
+	string csv = "pass,depth,frames,calls_per_frame,avg_ms,min_ms,max_ms,last_ms\n";
+	csv += S_FMT("Frame,0,%d,1,%1.4f,,,\n", std::min(frame_count, HISTORY_SIZE), frameTime());
+	for (unsigned a = 0; a < stats.size(); a++)
+	{
+		csv += S_FMT(
+			"%s,%d,%d,%1.2f,%1.4f,%1.4f,%1.4f,%1.4f\n",
+			stats[a].path,
+			stats[a].depth,
+			stats[a].frames,
+			stats[a].calls,
+			stats[a].avg_ms,
+			stats[a].min_ms,
+			stats[a].max_ms,
+			stats[a].last_ms
+		);
+	}
+
+	return csv;
+}
@@ -0,0 +1,58 @@
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+// A lightweight hierarchical frame profiler. Named passes are timed
+// with scoped timers (see PROFILE_SCOPE), nested within whatever pass
+// is currently being timed, and totalled for each frame. The last
+// few frames of timings for each pass are kept so that rolling
+// statistics can be shown on screen or dumped. Timing is only done
+// while the profiler is enabled, and only from the main thread
+namespace Profiler
+{
+	struct stats_t
+	{
+		string		path;		// Full path to the pass, eg. "Render/2D/Lines"
+		string		name;
+		int			depth;		// 0 for top-level passes
+		unsigned	frames;		// Number of frames (in history) the pass was run in
+		double		calls;		// Average times run per frame
+		double		avg_ms;
+		double		min_ms;
+		double		max_ms;
+		double		last_ms;
+	};
+
+	// Maximum number of frames kept in each pass' history
+	const unsigned HISTORY_SIZE = 120;
+
+	bool	isEnabled();
+	void	setEnabled(bool enable);
+	void	reset();
+
+	void	begin(const char* name);
+	void	end();
+	void	endFrame();
+
+	double	frameTime();
+	void	getStats(vector<stats_t>& stats);
+	string	statsCSV();
+
+	// Times the enclosing scope as pass [name] (which must be a string
+	// that remains valid, eg. a literal)
+	class Scope
+	{
+	public:
+		Scope(const char* name) { active = isEnabled(); if (active) begin(name); }
+		~Scope() { if (active) end(); }
+
+	private:
+		bool	active;
+	};
+}
+
+#define PROFILE_SCOPE_CONCAT2(a, b) a##b
+#define PROFILE_SCOPE_CONCAT(a, b) PROFILE_SCOPE_CONCAT2(a, b)
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILE_SCOPE_CONCAT(profile_scope_, __LINE__)(name)
+
+#endif//__PROFILER_H__